@@ -18,6 +18,9 @@ defmodule ExNVR.Elements.CVSBufferer do
   alias ExNVR.Utils
   alias Membrane.{H264, H265}
 
+  # snapshots are rare, release the decoder resources when it's not used
+  @decoder_idle_timeout :timer.seconds(30)
+
   def_input_pad :input,
     flow_control: :auto,
     accepted_format:
@@ -29,7 +32,7 @@ defmodule ExNVR.Elements.CVSBufferer do
 
   @impl true
   def handle_init(_ctx, _options) do
-    {[], %{cvs: [], decoder: nil, width: 0, height: 0}}
+    {[], %{cvs: [], decoder: nil, width: 0, height: 0, hibernate_timer: nil}}
   end
 
   @impl true
@@ -40,7 +43,7 @@ defmodule ExNVR.Elements.CVSBufferer do
         %H265{} -> :hevc
       end
 
-    {[], %{state | decoder: Decoder.new(codec, out_format: :yuvj420p)}}
+    {[], %{state | decoder: Decoder.new(codec)}}
   end
 
   @impl true
@@ -61,6 +64,21 @@ defmodule ExNVR.Elements.CVSBufferer do
       |> ExNVR.MediaUtils.decode_last(state.decoder)
       |> VideoProcessor.encode_to_jpeg()
 
-    {[notify_parent: {:snapshot, snapshot}], state}
+    {[notify_parent: {:snapshot, snapshot}], schedule_hibernation(state)}
+  end
+
+  @impl true
+  def handle_info(:hibernate_decoder, _ctx, state) do
+    Decoder.hibernate(state.decoder)
+    {[], %{state | hibernate_timer: nil}}
+  end
+
+  @impl true
+  def handle_info(_message, _ctx, state), do: {[], state}
+
+  defp schedule_hibernation(state) do
+    if state.hibernate_timer, do: Process.cancel_timer(state.hibernate_timer)
+    timer = Process.send_after(self(), :hibernate_decoder, @decoder_idle_timeout)
+    %{state | hibernate_timer: timer}
   end
 end
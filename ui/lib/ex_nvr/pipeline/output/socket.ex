@@ -21,21 +21,55 @@ defmodule ExNVR.Pipeline.Output.Socket do
     |                                                               |
     +-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+-+
   ```
+
+  When `frame_ring` is set, the snapshots are published to a shared memory ring
+  (see `ExNVR.AV.FrameRing`) and the snapshot data is replaced by the slot index
+  (32 bits) and its sequence number (64 bits). A reader checks the sequence of the
+  slot before and after reading it.
   """
 
   use Membrane.Sink
 
   require ExNVR.Utils
 
-  alias ExNVR.AV.Decoder
+  alias ExNVR.AV.{Decoder, FrameRing}
   alias Membrane.{H264, H265}
   alias Membrane.Time
 
   def_input_pad :input, accepted_format: any_of(%H264{alignment: :au}, %H265{alignment: :au})
 
+  def_options fps: [
+                spec: number() | nil,
+                default: nil,
+                description: """
+                Maximum number of snapshots sent per second.
+
+                The other frames are decoded but never converted to rgb.
+                Defaults to `nil`, all the frames are sent.
+                """
+              ],
+              frame_ring: [
+                spec: String.t() | nil,
+                default: nil,
+                description: """
+                Name of the shared memory object the snapshots are published to.
+
+                Defaults to `nil`, the snapshots are sent through the socket.
+                """
+              ]
+
   @impl true
-  def handle_init(_ctx, _opts) do
-    {[], %{decoder: nil, sockets: [], pts_to_datetime: %{}, keyframe?: false}}
+  def handle_init(_ctx, opts) do
+    state = %{
+      decoder: nil,
+      sockets: [],
+      pts_to_datetime: %{},
+      keyframe?: false,
+      fps: opts.fps,
+      frame_ring: opts.frame_ring
+    }
+
+    {[], state}
   end
 
   @impl true
@@ -50,6 +84,8 @@ defmodule ExNVR.Pipeline.Output.Socket do
       end
 
     decoder = Decoder.new(codec, out_format: :rgb24)
+    if state.fps, do: Decoder.set_output_rate(decoder, fps: state.fps, time_base: {1, 90_000})
+    if state.frame_ring, do: Decoder.enable_frame_ring(decoder, name: state.frame_ring)
 
     {actions, state} =
       if state.decoder do
@@ -98,7 +134,7 @@ defmodule ExNVR.Pipeline.Output.Socket do
   defp send_frame(frame, state) do
     {timestamp, pts_to_datetime} = Map.pop!(state.pts_to_datetime, frame.pts)
 
-    message = <<timestamp::64, frame.width::16, frame.height::16, 3::8, frame.data::binary>>
+    message = <<timestamp::64, frame.width::16, frame.height::16, 3::8, payload(frame)::binary>>
 
     sockets =
       Enum.reduce(state.sockets, [], fn socket, open_sockets ->
@@ -116,6 +152,9 @@ defmodule ExNVR.Pipeline.Output.Socket do
     end
   end
 
+  defp payload(%FrameRing.Slot{slot: slot, sequence: sequence}), do: <<slot::32, sequence::64>>
+  defp payload(frame), do: frame.data
+
   defp buffer_timestamp(nil), do: System.os_time(:millisecond)
   defp buffer_timestamp(datetime), do: datetime
 
@@ -36,6 +36,17 @@ defmodule ExNVR.Pipeline.Output.Thumbnailer do
               dest: [
                 spec: Path.t(),
                 description: "The destination folder where the thumbnails will be stored"
+              ],
+              decoder_idle_timeout: [
+                spec: timeout() | nil,
+                default: nil,
+                description: """
+                Hibernate the decoder if no thumbnail is generated for this amount of time (in ms).
+                The decoder is re-opened on the next keyframe.
+
+                Must be longer than the interval, otherwise the decoder is re-opened for
+                each thumbnail. Defaults to twice the interval.
+                """
               ]
 
   @impl true
@@ -43,10 +54,12 @@ defmodule ExNVR.Pipeline.Output.Thumbnailer do
     state =
       options
       |> Map.from_struct()
+      |> Map.put(:decoder_idle_timeout, decoder_idle_timeout(options))
       |> Map.merge(%{
         thumbnail_height: nil,
         decoder: nil,
-        last_buffer_pts: nil
+        last_buffer_pts: nil,
+        hibernate_timer: nil
       })
 
     Process.set_label(:thumbnailer)
@@ -89,7 +102,7 @@ defmodule ExNVR.Pipeline.Output.Thumbnailer do
     with [decoded] <- Decoder.decode(state.decoder, to_annexb(buffer.payload)),
          jpeg_image <- VideoProcessor.encode_to_jpeg(decoded),
          :ok <- File.write(image_path(state.dest, buffer), jpeg_image) do
-      {[], %{state | last_buffer_pts: buffer.pts}}
+      {[], schedule_hibernation(%{state | last_buffer_pts: buffer.pts})}
     else
       error ->
         Membrane.Logger.error("Failed to generate thumbnail: #{inspect(error)}")
@@ -97,6 +110,38 @@ defmodule ExNVR.Pipeline.Output.Thumbnailer do
     end
   end
 
+  @impl true
+  def handle_info(:hibernate_decoder, _ctx, state) do
+    Decoder.hibernate(state.decoder)
+    {[], %{state | hibernate_timer: nil}}
+  end
+
+  @impl true
+  def handle_info(_message, _ctx, state), do: {[], state}
+
+  defp decoder_idle_timeout(%{decoder_idle_timeout: nil, interval: interval}),
+    do: :timer.seconds(2 * interval)
+
+  defp decoder_idle_timeout(%{decoder_idle_timeout: :infinity}), do: :infinity
+
+  defp decoder_idle_timeout(%{decoder_idle_timeout: timeout, interval: interval}) do
+    if timeout <= :timer.seconds(interval) do
+      raise ArgumentError,
+            "decoder_idle_timeout (#{timeout} ms) must be longer than the interval " <>
+              "(#{interval} s)"
+    end
+
+    timeout
+  end
+
+  defp schedule_hibernation(%{decoder_idle_timeout: :infinity} = state), do: state
+
+  defp schedule_hibernation(state) do
+    if state.hibernate_timer, do: Process.cancel_timer(state.hibernate_timer)
+    timer = Process.send_after(self(), :hibernate_decoder, state.decoder_idle_timeout)
+    %{state | hibernate_timer: timer}
+  end
+
   defp image_path(dest_folder, buffer) do
     filename =
       if Application.get_env(:ex_nvr, :env) == :test,
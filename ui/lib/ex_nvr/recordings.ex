@@ -6,7 +6,7 @@ defmodule ExNVR.Recordings do
 
   alias __MODULE__.VideoAssembler
   alias Ecto.Multi
-  alias ExMP4.{BitStreamFilter, Reader}
+  alias ExMP4.Reader
   alias ExNVR.{AV, Repo}
   alias ExNVR.Model.{Device, Recording, Run}
   alias Phoenix.PubSub
@@ -113,26 +113,19 @@ defmodule ExNVR.Recordings do
           {:ok, binary()} | {:error, any()}
   def snapshot(device, recording, datetime, opts \\ []) do
     path = recording_path(device, recording.stream, recording)
-    offset = DateTime.diff(datetime, recording.start_date, :microsecond)
+    offset = max(DateTime.diff(datetime, recording.start_date, :microsecond), 0)
     method = Keyword.get(opts, :method, :before)
 
-    with {:ok, reader} <- ExMP4.Reader.new(path) do
-      track = ExMP4.Reader.track(reader, :video)
-      offset = ExMP4.Helper.timescalify(offset, :microsecond, track.timescale)
-
-      reader
-      |> read_samples(track, offset, method)
-      |> ExNVR.MediaUtils.decode_last(AV.Decoder.new(track.media, out_format: :yuvj420p))
-      |> then(fn frame ->
-        datetime =
-          DateTime.add(
-            recording.start_date,
-            ExMP4.Helper.timescalify(frame.pts, track.timescale, :microsecond),
-            :microsecond
-          )
-
-        {:ok, datetime, AV.VideoProcessor.encode_to_jpeg(frame)}
-      end)
+    # the recording is demuxed and decoded natively, only the needed group of
+    # pictures is read from the file
+    snapshot_opts =
+      case method == :before && open_keyframe_index(path) do
+        {:ok, index} -> [method: method, index: index]
+        _other -> [method: method]
+      end
+
+    with {:ok, pts, jpeg} <- AV.VideoProcessor.recording_snapshot(path, offset, snapshot_opts) do
+      {:ok, DateTime.add(recording.start_date, pts, :microsecond), jpeg}
     end
   end
 
@@ -221,11 +214,10 @@ defmodule ExNVR.Recordings do
         )
 
       new_rec = ExNVR.Repo.update!(changeset)
+      path = ExNVR.Recordings.recording_path(device, rec)
 
-      File.rename!(
-        ExNVR.Recordings.recording_path(device, rec),
-        ExNVR.Recordings.recording_path(device, new_rec)
-      )
+      File.rename!(path, ExNVR.Recordings.recording_path(device, new_rec))
+      File.rm(keyframe_index_path(path))
     end)
 
     run
@@ -251,6 +243,7 @@ defmodule ExNVR.Recordings do
 
     delete_file = fn filename ->
       if File.exists?(filename), do: File.rm!(filename)
+      File.rm(keyframe_index_path(filename))
       :ok
     end
 
@@ -329,29 +322,15 @@ defmodule ExNVR.Recordings do
     PubSub.broadcast(ExNVR.PubSub, @recordings_topic, {event, nil})
   end
 
-  # get snapshot private functions
-  defp read_samples(reader, track, offset, method) do
-    {:ok, bit_stream_filter} = BitStreamFilter.MP4ToAnnexb.init(track, [])
-
-    Reader.stream(reader, tracks: [track.id])
-    |> Enum.reduce_while([], fn sample_metadata, samples ->
-      cond do
-        sample_metadata.dts > offset and method == :precise ->
-          {:halt, [sample_metadata | samples]}
+  # the keyframe index is a sidecar of the recording built on first use
+  defp keyframe_index_path(path), do: Path.rootname(path) <> ".kfi"
 
-        sample_metadata.sync? ->
-          {:cont, [sample_metadata]}
+  defp open_keyframe_index(path) do
+    index_path = keyframe_index_path(path)
 
-        sample_metadata.dts > offset ->
-          {:halt, [List.last(samples)]}
-
-        true ->
-          {:cont, [sample_metadata | samples]}
-      end
-    end)
-    |> Enum.reverse()
-    |> Enum.map(&Reader.read_sample(reader, &1))
-    |> Enum.map_reduce(bit_stream_filter, &BitStreamFilter.MP4ToAnnexb.filter(&2, &1))
-    |> elem(0)
+    with {:error, _reason} <- AV.KeyframeIndex.open(index_path),
+         :ok <- AV.KeyframeIndex.build(path, index_path) do
+      AV.KeyframeIndex.open(index_path)
+    end
   end
 end
@@ -1,22 +1,25 @@
 defmodule ExNVR.MediaUtils do
   @moduledoc false
 
-  alias ExNVR.AV.Decoder
+  alias ExNVR.AV.{Decoder, Frame, Packet}
   alias Membrane.Buffer
 
   @default_video_timescale 90_000
 
-  @spec decode_last(Enumerable.t(Buffer.t() | ExMP4.Sample.t()), Decoder.t()) :: Buffer.t()
+  @spec decode_last(Enumerable.t(Buffer.t() | ExMP4.Sample.t()), Decoder.t()) :: Frame.t()
   def decode_last(buffers, decoder) do
-    buffers
-    |> Stream.transform(
-      fn -> decoder end,
-      &{Decoder.decode(&2, &1.payload, pts: &1.pts), &2},
-      &{Decoder.flush(&1), &1},
-      &Function.identity/1
-    )
-    |> Enum.reverse()
-    |> hd()
+    buffers = Enum.to_list(buffers)
+    decode_until(buffers, decoder, buffers |> Enum.map(& &1.pts) |> Enum.max())
+  end
+
+  @doc """
+  Decode the buffers of a group of pictures and return the frame closest to `target_pts`.
+  """
+  @spec decode_until(Enumerable.t(Buffer.t() | ExMP4.Sample.t()), Decoder.t(), integer()) ::
+          Frame.t() | nil
+  def decode_until(buffers, decoder, target_pts) do
+    packets = Enum.map(buffers, &Packet.new(data: &1.payload, pts: &1.pts, dts: &1.dts))
+    Decoder.decode_until(decoder, packets, target_pts)
   end
 
   @spec track_from_stream_format(module()) :: ExMP4.Track.t()
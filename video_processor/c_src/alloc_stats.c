@@ -0,0 +1,76 @@
+#include "alloc_stats.h"
+#include <string.h>
+
+// call sites are registered on their first use, the list only grows
+static struct NvrAllocSite *sites = NULL;
+
+int nvr_alloc_stats_enabled(void) {
+#ifdef NVR_ALLOC_STATS
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+void nvr_alloc_stats_record(struct NvrAllocSite *site, uint64_t bytes) {
+  if (!__atomic_load_n(&site->registered, __ATOMIC_ACQUIRE) &&
+      !__atomic_exchange_n(&site->registered, 1, __ATOMIC_ACQ_REL)) {
+    struct NvrAllocSite *head = __atomic_load_n(&sites, __ATOMIC_RELAXED);
+    do {
+      site->next = head;
+    } while (!__atomic_compare_exchange_n(&sites, &head, site, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  }
+
+  __atomic_fetch_add(&site->count, 1, __ATOMIC_RELAXED);
+  __atomic_fetch_add(&site->bytes, bytes, __ATOMIC_RELAXED);
+}
+
+void nvr_alloc_stats_reset(void) {
+  struct NvrAllocSite *site = __atomic_load_n(&sites, __ATOMIC_ACQUIRE);
+  for (; site != NULL; site = site->next) {
+    __atomic_store_n(&site->count, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&site->bytes, 0, __ATOMIC_RELAXED);
+  }
+}
+
+// Returns a list of {file, line, function, kind, count, bytes}, sites that
+// were not used since the last reset are skipped.
+ERL_NIF_TERM nvr_alloc_stats_to_term(ErlNifEnv *env) {
+  ERL_NIF_TERM list = enif_make_list(env, 0);
+  struct NvrAllocSite *site = __atomic_load_n(&sites, __ATOMIC_ACQUIRE);
+
+  for (; site != NULL; site = site->next) {
+    uint64_t count = __atomic_load_n(&site->count, __ATOMIC_RELAXED);
+    if (count == 0) {
+      continue;
+    }
+
+    ERL_NIF_TERM file_term;
+    int length = strlen(site->file);
+    // not counted, reading the stats doesn't change them
+    memcpy((enif_make_new_binary)(env, length, &file_term), site->file,
+           length);
+
+    ERL_NIF_TERM site_term = enif_make_tuple6(
+        env, file_term, enif_make_int(env, site->line),
+        enif_make_atom(env, site->function),
+        enif_make_atom(env, site->kind == NVR_ALLOC_HEAP ? "heap" : "binary"),
+        enif_make_uint64(env, count),
+        enif_make_uint64(env,
+                         __atomic_load_n(&site->bytes, __ATOMIC_RELAXED)));
+
+    list = enif_make_list_cell(env, site_term, list);
+  }
+
+  return list;
+}
+
+uint64_t nvr_frame_buffer_size(const AVFrame *frame) {
+  uint64_t size = 0;
+  for (int i = 0; i < AV_NUM_DATA_POINTERS && frame->buf[i]; i++) {
+    size += frame->buf[i]->size;
+  }
+
+  return size;
+}
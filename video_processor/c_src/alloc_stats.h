@@ -0,0 +1,98 @@
+#pragma once
+
+#include <erl_nif.h>
+#include <libavutil/frame.h>
+#include <libavutil/mem.h>
+#include <stdint.h>
+
+// Counters of the heap allocations and of the binaries created by the native
+// code, kept per call site. They're only collected when built with
+// NVR_ALLOC_STATS, the allocation functions are then redefined as macros so
+// this header is included last by utils.h. Allocations made inside libav are
+// not counted, only the calls made by this library.
+
+enum NvrAllocKind {
+  // enif_alloc, enif_realloc, av_malloc, av_mallocz, av_frame_get_buffer
+  NVR_ALLOC_HEAP,
+  // enif_alloc_binary, enif_make_new_binary, the bytes are copied to the BEAM
+  NVR_ALLOC_BINARY
+};
+
+struct NvrAllocSite {
+  const char *file;
+  int line;
+  const char *function;
+  enum NvrAllocKind kind;
+  uint64_t count;
+  uint64_t bytes;
+  int registered;
+  struct NvrAllocSite *next;
+};
+
+int nvr_alloc_stats_enabled(void);
+void nvr_alloc_stats_record(struct NvrAllocSite *site, uint64_t bytes);
+void nvr_alloc_stats_reset(void);
+ERL_NIF_TERM nvr_alloc_stats_to_term(ErlNifEnv *env);
+uint64_t nvr_frame_buffer_size(const AVFrame *frame);
+
+#ifdef NVR_ALLOC_STATS
+
+#define NVR_ALLOC_SITE(name, kind, bytes)                                      \
+  do {                                                                         \
+    static struct NvrAllocSite nvr_site_ = {__FILE__, __LINE__, name, kind,    \
+                                            0,        0,        0,    NULL};   \
+    nvr_alloc_stats_record(&nvr_site_, (bytes));                               \
+  } while (0)
+
+#define enif_alloc(size)                                                       \
+  ({                                                                           \
+    size_t nvr_size_ = (size);                                                 \
+    NVR_ALLOC_SITE("enif_alloc", NVR_ALLOC_HEAP, nvr_size_);                   \
+    enif_alloc(nvr_size_);                                                     \
+  })
+
+#define enif_realloc(ptr, size)                                                \
+  ({                                                                           \
+    size_t nvr_size_ = (size);                                                 \
+    NVR_ALLOC_SITE("enif_realloc", NVR_ALLOC_HEAP, nvr_size_);                 \
+    enif_realloc((ptr), nvr_size_);                                            \
+  })
+
+#define av_malloc(size)                                                        \
+  ({                                                                           \
+    size_t nvr_size_ = (size);                                                 \
+    NVR_ALLOC_SITE("av_malloc", NVR_ALLOC_HEAP, nvr_size_);                    \
+    av_malloc(nvr_size_);                                                      \
+  })
+
+#define av_mallocz(size)                                                       \
+  ({                                                                           \
+    size_t nvr_size_ = (size);                                                 \
+    NVR_ALLOC_SITE("av_mallocz", NVR_ALLOC_HEAP, nvr_size_);                   \
+    av_mallocz(nvr_size_);                                                     \
+  })
+
+#define av_frame_get_buffer(frame, align)                                      \
+  ({                                                                           \
+    AVFrame *nvr_frame_ = (frame);                                             \
+    int nvr_ret_ = av_frame_get_buffer(nvr_frame_, (align));                   \
+    NVR_ALLOC_SITE("av_frame_get_buffer", NVR_ALLOC_HEAP,                      \
+                   nvr_frame_buffer_size(nvr_frame_));                         \
+    nvr_ret_;                                                                  \
+  })
+
+#define enif_alloc_binary(size, bin)                                           \
+  ({                                                                           \
+    size_t nvr_size_ = (size);                                                 \
+    NVR_ALLOC_SITE("enif_alloc_binary", NVR_ALLOC_BINARY, nvr_size_);          \
+    enif_alloc_binary(nvr_size_, (bin));                                       \
+  })
+
+#define enif_make_new_binary(env, size, term)                                  \
+  ({                                                                           \
+    size_t nvr_size_ = (size);                                                 \
+    NVR_ALLOC_SITE("enif_make_new_binary", NVR_ALLOC_BINARY, nvr_size_);       \
+    enif_make_new_binary((env), nvr_size_, (term));                            \
+  })
+
+#endif
@@ -0,0 +1,202 @@
+#include "box_scale.h"
+#include "simd.h"
+
+#define BOX_SCALE_MAX_SHIFT 3
+
+static void box_scale_row_c(const uint8_t *src, int stride, uint8_t *dst,
+                            int width, int shift) {
+  int factor = 1 << shift;
+  int round = 1 << (2 * shift - 1);
+
+  for (int x = 0; x < width; x++) {
+    const uint8_t *block = src + x * factor;
+    int sum = 0;
+
+    for (int j = 0; j < factor; j++) {
+      for (int i = 0; i < factor; i++) {
+        sum += block[j * stride + i];
+      }
+    }
+
+    dst[x] = (sum + round) >> (2 * shift);
+  }
+}
+
+#ifdef NVR_HAVE_X86
+// sums of the horizontal pairs of all the rows of the block
+NVR_TARGET_AVX2 static inline __m256i pair_sums_avx2(const uint8_t *src,
+                                                     int stride, int rows) {
+  __m256i ones = _mm256_set1_epi8(1);
+  __m256i sum = _mm256_setzero_si256();
+
+  for (int j = 0; j < rows; j++) {
+    __m256i row = _mm256_loadu_si256((const __m256i *)(src + j * stride));
+    sum = _mm256_add_epi16(sum, _mm256_maddubs_epi16(row, ones));
+  }
+
+  return sum;
+}
+
+NVR_TARGET_AVX2 static void box_scale_row_avx2(const uint8_t *src,
+                                               int stride, uint8_t *dst,
+                                               int width, int shift) {
+  int x = 0;
+
+  if (shift == 1) {
+    for (; x + 16 <= width; x += 16) {
+      __m256i sum = pair_sums_avx2(src + 2 * x, stride, 2);
+      sum = _mm256_srli_epi16(_mm256_add_epi16(sum, _mm256_set1_epi16(2)), 2);
+      __m256i packed = _mm256_packus_epi16(sum, sum);
+
+      _mm_storeu_si128((__m128i *)(dst + x),
+                       _mm256_castsi256_si128(
+                           _mm256_permute4x64_epi64(packed, 0x08)));
+    }
+  } else if (shift == 2) {
+    __m256i order = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+
+    for (; x + 8 <= width; x += 8) {
+      __m256i sum = pair_sums_avx2(src + 4 * x, stride, 4);
+      sum = _mm256_madd_epi16(sum, _mm256_set1_epi16(1));
+      sum = _mm256_srli_epi32(_mm256_add_epi32(sum, _mm256_set1_epi32(8)), 4);
+      sum = _mm256_packs_epi32(sum, sum);
+      sum = _mm256_packus_epi16(sum, sum);
+
+      _mm_storel_epi64((__m128i *)(dst + x),
+                       _mm256_castsi256_si128(
+                           _mm256_permutevar8x32_epi32(sum, order)));
+    }
+  } else {
+    __m256i zero = _mm256_setzero_si256();
+    uint64_t out[4];
+
+    for (; x + 4 <= width; x += 4) {
+      __m256i sum = zero;
+      for (int j = 0; j < 8; j++) {
+        __m256i row =
+            _mm256_loadu_si256((const __m256i *)(src + 8 * x + j * stride));
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(row, zero));
+      }
+
+      sum = _mm256_srli_epi64(_mm256_add_epi64(sum, _mm256_set1_epi64x(32)), 6);
+      _mm256_storeu_si256((__m256i *)out, sum);
+
+      dst[x] = out[0];
+      dst[x + 1] = out[1];
+      dst[x + 2] = out[2];
+      dst[x + 3] = out[3];
+    }
+  }
+
+  box_scale_row_c(src + (x << shift), stride, dst + x, width - x, shift);
+}
+#endif
+
+#ifdef NVR_HAVE_NEON
+static inline uint16x8_t pair_sums_neon(const uint8_t *src, int stride,
+                                        int rows) {
+  uint16x8_t sum = vdupq_n_u16(0);
+
+  for (int j = 0; j < rows; j++) {
+    sum = vpadalq_u8(sum, vld1q_u8(src + j * stride));
+  }
+
+  return sum;
+}
+
+static void box_scale_row_neon(const uint8_t *src, int stride, uint8_t *dst,
+                               int width, int shift) {
+  int x = 0;
+
+  if (shift == 1) {
+    for (; x + 8 <= width; x += 8) {
+      vst1_u8(dst + x, vrshrn_n_u16(pair_sums_neon(src + 2 * x, stride, 2), 2));
+    }
+  } else if (shift == 2) {
+    for (; x + 4 <= width; x += 4) {
+      uint32x4_t sum = vpaddlq_u16(pair_sums_neon(src + 4 * x, stride, 4));
+      uint16x4_t mean = vrshrn_n_u32(sum, 4);
+
+      dst[x] = vget_lane_u16(mean, 0);
+      dst[x + 1] = vget_lane_u16(mean, 1);
+      dst[x + 2] = vget_lane_u16(mean, 2);
+      dst[x + 3] = vget_lane_u16(mean, 3);
+    }
+  } else {
+    for (; x + 2 <= width; x += 2) {
+      uint64x2_t sum =
+          vpaddlq_u32(vpaddlq_u16(pair_sums_neon(src + 8 * x, stride, 8)));
+      uint32x2_t mean = vrshrn_n_u64(sum, 6);
+
+      dst[x] = vget_lane_u32(mean, 0);
+      dst[x + 1] = vget_lane_u32(mean, 1);
+    }
+  }
+
+  box_scale_row_c(src + (x << shift), stride, dst + x, width - x, shift);
+}
+#endif
+
+BoxScaleRowFn box_scale_row_fn(void) {
+#ifdef NVR_HAVE_X86
+  if (nvr_cpu_has_avx2()) {
+    return box_scale_row_avx2;
+  }
+#endif
+#ifdef NVR_HAVE_NEON
+  if (nvr_cpu_has_neon()) {
+    return box_scale_row_neon;
+  }
+#endif
+  return box_scale_row_c;
+}
+
+int box_scale_shift(enum AVPixelFormat format, int in_width, int in_height,
+                    int out_width, int out_height) {
+  const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+  if (!desc || desc->flags & (AV_PIX_FMT_FLAG_RGB | AV_PIX_FMT_FLAG_HWACCEL |
+                              AV_PIX_FMT_FLAG_BITSTREAM |
+                              AV_PIX_FMT_FLAG_PAL)) {
+    return 0;
+  }
+
+  // one 8 bits component per plane
+  if (av_pix_fmt_count_planes(format) != desc->nb_components) {
+    return 0;
+  }
+
+  for (int i = 0; i < desc->nb_components; i++) {
+    if (desc->comp[i].depth != 8 || desc->comp[i].step != 1) {
+      return 0;
+    }
+  }
+
+  for (int shift = BOX_SCALE_MAX_SHIFT; shift > 0; shift--) {
+    int w_mask = (1 << (shift + desc->log2_chroma_w)) - 1;
+    int h_mask = (1 << (shift + desc->log2_chroma_h)) - 1;
+
+    if ((in_width >> shift) >= out_width &&
+        (in_height >> shift) >= out_height && !(in_width & w_mask) &&
+        !(in_height & h_mask)) {
+      return shift;
+    }
+  }
+
+  return 0;
+}
+
+void box_scale(BoxScaleRowFn row, const AVPixFmtDescriptor *desc,
+               const uint8_t *const src[4], const int src_linesize[4],
+               uint8_t *const dst[4], const int dst_linesize[4], int out_width,
+               int out_height, int shift) {
+  for (int i = 0; i < desc->nb_components; i++) {
+    int chroma = i == 1 || i == 2;
+    int width = chroma ? out_width >> desc->log2_chroma_w : out_width;
+    int height = chroma ? out_height >> desc->log2_chroma_h : out_height;
+
+    for (int y = 0; y < height; y++) {
+      row(src[i] + (y << shift) * src_linesize[i], src_linesize[i],
+          dst[i] + y * dst_linesize[i], width, shift);
+    }
+  }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <libavutil/frame.h>
+#include <libavutil/pixdesc.h>
+#include <stdint.h>
+
+// Downscales 8 bits planar formats by 2, 4 or 8 with a box filter, each output
+// sample is the rounded mean of a factor x factor block of the input plane.
+// An output row only reads input rows at or after its own, so the input
+// planes may also be the output.
+
+// Reduces `width` samples of the `1 << shift` input rows starting at src
+typedef void (*BoxScaleRowFn)(const uint8_t *src, int stride, uint8_t *dst,
+                              int width, int shift);
+
+BoxScaleRowFn box_scale_row_fn(void);
+
+// log2 of the largest factor that keeps the input at least as big as the
+// output and divides all the planes, 0 if there's none
+int box_scale_shift(enum AVPixelFormat format, int in_width, int in_height,
+                    int out_width, int out_height);
+
+// out_width and out_height are the dimensions of the reduced luma plane
+void box_scale(BoxScaleRowFn row, const AVPixFmtDescriptor *desc,
+               const uint8_t *const src[4], const int src_linesize[4],
+               uint8_t *const dst[4], const int dst_linesize[4], int out_width,
+               int out_height, int shift);
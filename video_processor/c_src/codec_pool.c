@@ -0,0 +1,114 @@
+#include "codec_pool.h"
+
+typedef struct CodecPoolEntry CodecPoolEntry;
+
+struct CodecPoolEntry {
+  struct CodecPoolKey key;
+  void *item;
+  CodecPoolEntry *next;
+};
+
+struct CodecPool {
+  ErlNifMutex *lock;
+  CodecPoolFreeFn free_fn;
+  CodecPoolEntry *head;
+  int size;
+  int max_size;
+  int max_per_key;
+};
+
+CodecPool *codec_pool_alloc(int max_size, int max_per_key,
+                            CodecPoolFreeFn free_fn) {
+  CodecPool *pool = (CodecPool *)enif_alloc(sizeof(CodecPool));
+
+  pool->lock = enif_mutex_create("nvr_codec_pool");
+  pool->free_fn = free_fn;
+  pool->head = NULL;
+  pool->size = 0;
+  pool->max_size = max_size;
+  pool->max_per_key = max_per_key;
+
+  return pool;
+}
+
+void *codec_pool_get(CodecPool *pool, const struct CodecPoolKey *key) {
+  void *item = NULL;
+
+  enif_mutex_lock(pool->lock);
+
+  CodecPoolEntry **entry = &pool->head;
+  while (*entry != NULL) {
+    if (memcmp(&(*entry)->key, key, sizeof(struct CodecPoolKey)) == 0) {
+      CodecPoolEntry *found = *entry;
+      *entry = found->next;
+      item = found->item;
+      pool->size--;
+      enif_free(found);
+      break;
+    }
+
+    entry = &(*entry)->next;
+  }
+
+  enif_mutex_unlock(pool->lock);
+
+  return item;
+}
+
+int codec_pool_put(CodecPool *pool, const struct CodecPoolKey *key,
+                   void *item) {
+  int count = 0;
+
+  enif_mutex_lock(pool->lock);
+
+  for (CodecPoolEntry *entry = pool->head; entry != NULL;
+       entry = entry->next) {
+    if (memcmp(&entry->key, key, sizeof(struct CodecPoolKey)) == 0) {
+      count++;
+    }
+  }
+
+  if (pool->size >= pool->max_size || count >= pool->max_per_key) {
+    enif_mutex_unlock(pool->lock);
+    NVR_LOG_DEBUG("Codec pool is full, dropping item");
+    pool->free_fn(item);
+    return 0;
+  }
+
+  CodecPoolEntry *entry =
+      (CodecPoolEntry *)enif_alloc(sizeof(CodecPoolEntry));
+  entry->key = *key;
+  entry->item = item;
+  entry->next = pool->head;
+  pool->head = entry;
+  pool->size++;
+
+  enif_mutex_unlock(pool->lock);
+
+  return 1;
+}
+
+int codec_pool_size(CodecPool *pool) {
+  enif_mutex_lock(pool->lock);
+  int size = pool->size;
+  enif_mutex_unlock(pool->lock);
+
+  return size;
+}
+
+void codec_pool_free(CodecPool **pool) {
+  CodecPool *p = *pool;
+  if (p != NULL) {
+    CodecPoolEntry *entry = p->head;
+    while (entry != NULL) {
+      CodecPoolEntry *next = entry->next;
+      p->free_fn(entry->item);
+      enif_free(entry);
+      entry = next;
+    }
+
+    enif_mutex_destroy(p->lock);
+    enif_free(p);
+    *pool = NULL;
+  }
+}
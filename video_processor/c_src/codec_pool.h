@@ -0,0 +1,24 @@
+#pragma once
+
+#include "utils.h"
+
+typedef struct CodecPool CodecPool;
+typedef void (*CodecPoolFreeFn)(void *item);
+
+// Identifies interchangeable codec contexts. Keys are compared byte by byte,
+// they must be zero-initialized before being filled.
+struct CodecPoolKey {
+  enum AVCodecID codec_id;
+  int width;
+  int height;
+  enum AVPixelFormat format;
+  int extra[8];
+  char options[64];
+};
+
+CodecPool *codec_pool_alloc(int max_size, int max_per_key,
+                            CodecPoolFreeFn free_fn);
+void *codec_pool_get(CodecPool *pool, const struct CodecPoolKey *key);
+int codec_pool_put(CodecPool *pool, const struct CodecPoolKey *key, void *item);
+int codec_pool_size(CodecPool *pool);
+void codec_pool_free(CodecPool **pool);
@@ -1,33 +1,37 @@
 #include "decoder.h"
 
+#define DECODER_INITIAL_FRAMES 8
+
+static void alloc_frames(Decoder *decoder, int count);
+static void free_frames(Decoder *decoder);
 static void realloc_frames(Decoder *decoder);
 static int receive_frames(Decoder *decoder, int break_code);
+static int open_context(Decoder *decoder);
+static void apply_options(Decoder *decoder);
+static int find_nal_unit(Decoder *decoder, const uint8_t *data, int size,
+                         int (*match)(enum AVCodecID, uint8_t));
+static int is_random_access_unit(enum AVCodecID codec_id, uint8_t header);
+static int is_non_reference_unit(enum AVCodecID codec_id, uint8_t header);
+static int get_nal_length_size(enum AVCodecID codec_id,
+                               const AVCodecParameters *params);
 
 Decoder *decoder_alloc() {
   Decoder *decoder = (Decoder *)enif_alloc(sizeof(Decoder));
 
   decoder->codec = NULL;
+  decoder->params = NULL;
   decoder->c = NULL;
-  decoder->max_frames = 8;
-  decoder->count_frames = 0;
-  decoder->frames =
-      (AVFrame **)enif_alloc(sizeof(AVFrame *) * decoder->max_frames);
-  for (int i = 0; i < decoder->max_frames; i++) {
-    decoder->frames[i] = av_frame_alloc();
-  }
+  decoder->nal_length_size = 0;
+  decoder->export_mvs = 0;
+  decoder->skip_pixels = 0;
+  alloc_frames(decoder, DECODER_INITIAL_FRAMES);
 
   return decoder;
 }
 
 int decoder_init(Decoder *decoder, const AVCodec *codec) {
   decoder->codec = codec;
-
-  decoder->c = avcodec_alloc_context3(decoder->codec);
-  if (!decoder->c) {
-    return -1;
-  }
-
-  return avcodec_open2(decoder->c, decoder->codec, NULL);
+  return open_context(decoder);
 }
 
 int decoder_init_by_parameters(Decoder *decoder, const AVCodecParameters *codec_params) {
@@ -37,20 +41,36 @@ int decoder_init_by_parameters(Decoder *decoder, const AVCodecParameters *codec_
     }
 
     decoder->codec = codec;
-    decoder->c = avcodec_alloc_context3(decoder->codec);
-    if (!decoder->c) {
+    decoder->params = avcodec_parameters_alloc();
+    if (!decoder->params) {
         return -1;
     }
 
-    if (avcodec_parameters_to_context(decoder->c, codec_params) < 0) {
+    if (avcodec_parameters_copy(decoder->params, codec_params) < 0) {
         return -1;
     }
 
-    return avcodec_open2(decoder->c, decoder->codec, NULL);
+    decoder->nal_length_size = get_nal_length_size(codec->id, codec_params);
+
+    return open_context(decoder);
 }
 
 int decoder_decode(Decoder *decoder, AVPacket *pkt) {
-  int ret;
+  if (decoder->c == NULL) {
+    // a hibernated decoder drops everything until the next random access
+    // point, the packets in between cannot be decoded anyway.
+    decoder->count_frames = 0;
+    if (!find_nal_unit(decoder, pkt->data, pkt->size,
+                       is_random_access_unit)) {
+      return 0;
+    }
+
+    NVR_LOG_DEBUG("Waking up hibernated decoder");
+    if (open_context(decoder) < 0) {
+      return -1;
+    }
+  }
+
   if (avcodec_send_packet(decoder->c, pkt) < 0) {
     return -1;
   }
@@ -59,6 +79,11 @@ int decoder_decode(Decoder *decoder, AVPacket *pkt) {
 }
 
 int decoder_flush(struct Decoder *decoder) {
+  if (decoder->c == NULL) {
+    decoder->count_frames = 0;
+    return 0;
+  }
+
   int ret = avcodec_send_packet(decoder->c, NULL);
   if (ret != 0) {
     return ret;
@@ -67,6 +92,50 @@ int decoder_flush(struct Decoder *decoder) {
   return receive_frames(decoder, AVERROR_EOF);
 }
 
+void decoder_reset(Decoder *decoder) {
+  if (decoder->c != NULL) {
+    avcodec_flush_buffers(decoder->c);
+  }
+
+  for (int i = 0; i < decoder->count_frames; i++) {
+    av_frame_unref(decoder->frames[i]);
+  }
+
+  decoder->count_frames = 0;
+}
+
+int decoder_is_keyframe(Decoder *decoder, const uint8_t *data, int size) {
+  return find_nal_unit(decoder, data, size, is_random_access_unit);
+}
+
+int decoder_is_discardable(Decoder *decoder, const uint8_t *data, int size) {
+  return find_nal_unit(decoder, data, size, is_non_reference_unit);
+}
+
+void decoder_export_motion_vectors(Decoder *decoder, int enable,
+                                   int skip_pixels) {
+  decoder->export_mvs = enable;
+  decoder->skip_pixels = enable && skip_pixels;
+
+  if (decoder->c != NULL) {
+    apply_options(decoder);
+  }
+}
+
+int decoder_hibernate(Decoder *decoder) {
+  NVR_LOG_DEBUG("Hibernating Decoder object");
+  if (decoder->c != NULL) {
+    avcodec_free_context(&decoder->c);
+  }
+
+  // the frames array only grows while decoding, give it back its initial size
+  free_frames(decoder);
+  alloc_frames(decoder, DECODER_INITIAL_FRAMES);
+  return 0;
+}
+
+int decoder_is_hibernated(Decoder *decoder) { return decoder->c == NULL; }
+
 void decoder_free(Decoder **decoder) {
   NVR_LOG_DEBUG("Freeing Decoder object");
   if (*decoder != NULL) {
@@ -76,20 +145,41 @@ void decoder_free(Decoder **decoder) {
       avcodec_free_context(&d->c);
     }
 
-    if (d->frames != NULL) {
-      for (int i = 0; i < d->max_frames; i++) {
-        if (d->frames[i] != NULL) {
-          av_frame_free(&d->frames[i]);
-        }
-      }
-      enif_free(d->frames);
+    if (d->params != NULL) {
+      avcodec_parameters_free(&d->params);
     }
 
+    free_frames(d);
     enif_free(d);
     *decoder = NULL;
   }
 }
 
+// On failure the context is freed, the decoder stays hibernated and the next
+// keyframe tries to open it again.
+static int open_context(Decoder *decoder) {
+  decoder->c = avcodec_alloc_context3(decoder->codec);
+  if (!decoder->c) {
+    return -1;
+  }
+
+  int ret = 0;
+  if (decoder->params != NULL) {
+    ret = avcodec_parameters_to_context(decoder->c, decoder->params);
+  }
+
+  if (ret >= 0) {
+    apply_options(decoder);
+    ret = avcodec_open2(decoder->c, decoder->codec, NULL);
+  }
+
+  if (ret < 0) {
+    avcodec_free_context(&decoder->c);
+  }
+
+  return ret;
+}
+
 static int receive_frames(Decoder *decoder, int break_code) {
   int ret;
   decoder->count_frames = 0;
@@ -110,6 +200,27 @@ static int receive_frames(Decoder *decoder, int break_code) {
   return 0;
 }
 
+static void alloc_frames(Decoder *decoder, int count) {
+  decoder->max_frames = count;
+  decoder->count_frames = 0;
+  decoder->frames = (AVFrame **)enif_alloc(sizeof(AVFrame *) * count);
+  for (int i = 0; i < count; i++) {
+    decoder->frames[i] = av_frame_alloc();
+  }
+}
+
+static void free_frames(Decoder *decoder) {
+  if (decoder->frames != NULL) {
+    for (int i = 0; i < decoder->max_frames; i++) {
+      if (decoder->frames[i] != NULL) {
+        av_frame_free(&decoder->frames[i]);
+      }
+    }
+    enif_free(decoder->frames);
+    decoder->frames = NULL;
+  }
+}
+
 static void realloc_frames(Decoder *decoder) {
   decoder->max_frames *= 2;
   decoder->frames = (AVFrame **)enif_realloc(
@@ -118,3 +229,109 @@ static void realloc_frames(Decoder *decoder) {
     decoder->frames[i] = av_frame_alloc();
   }
 }
+
+static int find_nal_unit(Decoder *decoder, const uint8_t *data, int size,
+                         int (*match)(enum AVCodecID, uint8_t)) {
+  enum AVCodecID codec_id = decoder->codec->id;
+  int length_size = decoder->nal_length_size;
+
+  if (data == NULL) {
+    return 0;
+  }
+
+  if (length_size > 0) {
+    int pos = 0;
+    while (pos + length_size < size) {
+      uint32_t nal_size = 0;
+      for (int i = 0; i < length_size; i++) {
+        nal_size = (nal_size << 8) | data[pos + i];
+      }
+
+      pos += length_size;
+      // a corrupt length would overflow pos or read past the packet
+      if (nal_size > (uint32_t)(size - pos)) {
+        break;
+      }
+
+      if (nal_size > 0 && match(codec_id, data[pos])) {
+        return 1;
+      }
+
+      pos += nal_size;
+    }
+
+    return 0;
+  }
+
+  for (int i = 0; i + 3 < size; i++) {
+    if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1) {
+      continue;
+    }
+
+    if (match(codec_id, data[i + 3])) {
+      return 1;
+    }
+
+    i += 2;
+  }
+
+  return 0;
+}
+
+static int is_random_access_unit(enum AVCodecID codec_id, uint8_t header) {
+  if (codec_id == AV_CODEC_ID_H264) {
+    return (header & 0x1F) == 5;
+  }
+
+  if (codec_id == AV_CODEC_ID_HEVC) {
+    int nal_type = (header >> 1) & 0x3F;
+    return nal_type >= 16 && nal_type <= 23;
+  }
+
+  return 0;
+}
+
+// Only h264 is handled: hevc sub-layer non-reference pictures may still be
+// referenced by pictures of higher temporal layers.
+static int is_non_reference_unit(enum AVCodecID codec_id, uint8_t header) {
+  if (codec_id == AV_CODEC_ID_H264) {
+    int nal_type = header & 0x1F;
+    return nal_type >= 1 && nal_type <= 5 && (header & 0x60) == 0;
+  }
+
+  return 0;
+}
+
+// avcC and hvcC records carry the size of the nal units length prefix, annex b
+// extradata starts with a start code.
+static int get_nal_length_size(enum AVCodecID codec_id,
+                               const AVCodecParameters *params) {
+  const uint8_t *extradata = params->extradata;
+  int size = params->extradata_size;
+
+  if (codec_id == AV_CODEC_ID_H264 && size >= 7 && extradata[0] == 1) {
+    return (extradata[4] & 0x03) + 1;
+  }
+
+  if (codec_id == AV_CODEC_ID_HEVC && size >= 23 &&
+      (extradata[0] || extradata[1] || extradata[2] > 1)) {
+    return (extradata[21] & 0x03) + 1;
+  }
+
+  return 0;
+}
+
+static void apply_options(Decoder *decoder) {
+  AVCodecContext *c = decoder->c;
+
+  if (decoder->export_mvs) {
+    c->export_side_data |= AV_CODEC_EXPORT_DATA_MVS;
+  } else {
+    c->export_side_data &= ~AV_CODEC_EXPORT_DATA_MVS;
+  }
+
+  enum AVDiscard discard =
+      decoder->skip_pixels ? AVDISCARD_ALL : AVDISCARD_DEFAULT;
+  c->skip_idct = discard;
+  c->skip_loop_filter = discard;
+}
@@ -7,7 +7,15 @@ typedef struct Decoder Decoder;
 
 struct Decoder {
   const AVCodec *codec;
+  AVCodecParameters *params;
+  // NULL while the decoder is hibernated
   AVCodecContext *c;
+  // size of the length prefix of the nal units when the extradata is an
+  // avcC/hvcC record, 0 for annex b streams
+  int nal_length_size;
+  // applied every time the context is (re)opened
+  int export_mvs;
+  int skip_pixels;
   int max_frames;
   int count_frames;
   AVFrame **frames;
@@ -18,4 +26,13 @@ int decoder_init(Decoder *decoder, const AVCodec *codec);
 int decoder_init_by_parameters(Decoder *decoder, const AVCodecParameters *codec_params);
 int decoder_decode(Decoder *decoder, AVPacket *pkt);
 int decoder_flush(Decoder *decoder);
+void decoder_reset(Decoder *decoder);
+int decoder_is_keyframe(Decoder *decoder, const uint8_t *data, int size);
+// whether the access unit is a non-reference picture, no other picture depends
+// on it and it can be dropped without affecting the rest of the stream.
+int decoder_is_discardable(Decoder *decoder, const uint8_t *data, int size);
+void decoder_export_motion_vectors(Decoder *decoder, int enable,
+                                   int skip_pixels);
+int decoder_hibernate(Decoder *decoder);
+int decoder_is_hibernated(Decoder *decoder);
 void decoder_free(Decoder **decoder);
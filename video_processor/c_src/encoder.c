@@ -1,11 +1,17 @@
 #include "encoder.h"
 
+static int is_jpeg_format(enum AVPixelFormat format) {
+  return format == AV_PIX_FMT_YUVJ420P || format == AV_PIX_FMT_YUVJ422P ||
+         format == AV_PIX_FMT_YUVJ444P;
+}
+
 Encoder *encoder_alloc() {
   Encoder *encoder = enif_alloc(sizeof(Encoder));
   encoder->c = NULL;
   encoder->codec = NULL;
   encoder->num_packets = 0;
   encoder->max_num_packets = 4;
+  encoder->flushed = 0;
   encoder->packets = enif_alloc(encoder->max_num_packets * sizeof(AVPacket *));
 
   for (int i = 0; i < encoder->max_num_packets; i++) {
@@ -49,17 +55,50 @@ int encoder_init(Encoder *encoder, struct EncoderConfig *config) {
     av_dict_set(&opts, "tune", config->tune, 0);
   }
 
+  if (config->quality > 0) {
+    encoder->c->flags |= AV_CODEC_FLAG_QSCALE;
+    encoder->c->global_quality = config->quality * FF_QP2LAMBDA;
+  }
+
+  if (config->threads > 0 &&
+      encoder->codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) {
+    encoder->c->thread_count = config->threads;
+    encoder->c->thread_type = FF_THREAD_SLICE;
+  }
+
+  if (config->color_range != AVCOL_RANGE_UNSPECIFIED) {
+    encoder->c->color_range = config->color_range;
+  }
+
+  // limited range yuv is not part of the jpeg standard, it's flagged in the
+  // comment of the image and only understood by libav based decoders
+  if (encoder->codec->id == AV_CODEC_ID_MJPEG &&
+      encoder->c->color_range != AVCOL_RANGE_JPEG &&
+      !is_jpeg_format(config->format)) {
+    encoder->c->strict_std_compliance = FF_COMPLIANCE_UNOFFICIAL;
+  }
+
   int ret = avcodec_open2(encoder->c, encoder->codec, &opts);
   av_dict_free(&opts);
   return ret;
 }
 
 int encoder_encode(Encoder *encoder, AVFrame *frame) {
+  // with a fixed quantizer, the scale is taken from each frame
+  if (frame != NULL && frame->quality == 0 &&
+      encoder->c->flags & AV_CODEC_FLAG_QSCALE) {
+    frame->quality = encoder->c->global_quality;
+  }
+
   int ret = avcodec_send_frame(encoder->c, frame);
   if (ret < 0) {
     return ret;
   }
 
+  if (frame == NULL) {
+    encoder->flushed = 1;
+  }
+
   encoder->num_packets = 0;
 
   while (1) {
@@ -84,6 +123,22 @@ int encoder_encode(Encoder *encoder, AVFrame *frame) {
   return 0;
 }
 
+int encoder_reset(Encoder *encoder) {
+  if (encoder->codec->capabilities & AV_CODEC_CAP_ENCODER_FLUSH) {
+    avcodec_flush_buffers(encoder->c);
+    encoder->flushed = 0;
+    return 0;
+  }
+
+  // encoders without delay never hold frames, they can be reused as long as
+  // they were not drained.
+  if (!encoder->flushed && !(encoder->codec->capabilities & AV_CODEC_CAP_DELAY)) {
+    return 0;
+  }
+
+  return -1;
+}
+
 void encoder_free(Encoder *encoder) {
   if (!encoder) {
     return;
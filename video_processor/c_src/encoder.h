@@ -13,6 +13,7 @@ struct Encoder {
   AVPacket **packets;
   int num_packets;
   int max_num_packets;
+  int flushed;
 };
 
 struct EncoderConfig {
@@ -27,11 +28,18 @@ struct EncoderConfig {
   int profile;
   char *preset;
   char *tune;
+  // fixed quantizer scale (1-31, lower is better), 0 keeps the rate control
+  int quality;
+  // slice threads, 0 keeps the codec default
+  int threads;
+  // unspecified keeps the range implied by the format
+  enum AVColorRange color_range;
 };
 
 Encoder *encoder_alloc();
 int encoder_init(Encoder *encoder, struct EncoderConfig *config);
 int encoder_encode(Encoder *encoder, AVFrame *frame);
+int encoder_reset(Encoder *encoder);
 void encoder_free(Encoder *encoder);
 
 #endif // ENCODER_H
\ No newline at end of file
@@ -0,0 +1,185 @@
+#include "frame_ring.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <libavutil/pixdesc.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static int create_ring(FrameRing *ring);
+
+FrameRing *frame_ring_alloc() {
+  FrameRing *ring = (FrameRing *)enif_alloc(sizeof(FrameRing));
+
+  ring->name = NULL;
+  ring->num_slots = 0;
+  ring->slot_size = 0;
+  ring->mode = 0640;
+  ring->fd = -1;
+  ring->data = NULL;
+  ring->size = 0;
+  ring->header = NULL;
+
+  return ring;
+}
+
+int frame_ring_init(FrameRing *ring, const char *name, int num_slots,
+                    int64_t slot_size, int mode) {
+  int length = strlen(name);
+
+  // a portable name is a single component starting with a slash
+  if (length < 2 || length > 255 || name[0] != '/' ||
+      strchr(name + 1, '/') != NULL || num_slots < 1 || num_slots > 1024 ||
+      slot_size < 0 || (mode & ~0777) != 0) {
+    return FRAME_RING_INVALID;
+  }
+
+  ring->name = enif_alloc(length + 1);
+  memcpy(ring->name, name, length + 1);
+  ring->num_slots = num_slots;
+  ring->slot_size = slot_size;
+  ring->mode = mode;
+
+  // an existing object may still be read, or be owned by someone else
+  ring->fd = shm_open(ring->name, O_CREAT | O_EXCL | O_RDWR, mode);
+  if (ring->fd < 0) {
+    return errno == EEXIST ? FRAME_RING_EXISTS : FRAME_RING_FAILED;
+  }
+
+  // the mode given to shm_open is masked by the umask
+  if (fchmod(ring->fd, mode) < 0) {
+    return FRAME_RING_FAILED;
+  }
+
+  if (slot_size > 0 && create_ring(ring) < 0) {
+    return FRAME_RING_FAILED;
+  }
+
+  return 0;
+}
+
+int frame_ring_publish(FrameRing *ring, AVFrame *frame,
+                       struct FrameRingEntry *entry) {
+  int size =
+      av_image_get_buffer_size(frame->format, frame->width, frame->height, 1);
+  if (size < 0) {
+    return -1;
+  }
+
+  if (ring->data == NULL) {
+    ring->slot_size = size;
+    if (create_ring(ring) < 0) {
+      return -1;
+    }
+  }
+
+  if (size > ring->slot_size) {
+    return 0;
+  }
+
+  struct FrameRingHeader *header = ring->header;
+  uint64_t frame_number = header->write_count;
+  int index = frame_number % ring->num_slots;
+  uint8_t *slot_data = ring->data + sizeof(struct FrameRingHeader) +
+                       index * header->slot_stride;
+  struct FrameRingSlot *slot = (struct FrameRingSlot *)slot_data;
+  uint64_t sequence = slot->sequence;
+
+  __atomic_store_n(&slot->sequence, sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+
+  av_image_copy_to_buffer(slot_data + sizeof(struct FrameRingSlot), size,
+                          (const uint8_t *const *)frame->data,
+                          (const int *)frame->linesize, frame->format,
+                          frame->width, frame->height, 1);
+
+  const char *format_name = av_get_pix_fmt_name(frame->format);
+  memset(slot->format_name, 0, sizeof(slot->format_name));
+  strncpy(slot->format_name, format_name ? format_name : "",
+          sizeof(slot->format_name) - 1);
+
+  slot->pts = frame->pts;
+  slot->frame_number = frame_number;
+  slot->width = frame->width;
+  slot->height = frame->height;
+  slot->size = size;
+  slot->format = frame->format;
+
+  __atomic_store_n(&slot->sequence, sequence + 2, __ATOMIC_RELEASE);
+  __atomic_store_n(&header->write_count, frame_number + 1, __ATOMIC_RELEASE);
+
+  entry->slot = index;
+  entry->sequence = sequence + 2;
+  entry->frame_number = frame_number;
+  entry->size = size;
+
+  return 1;
+}
+
+void frame_ring_free(FrameRing **ring) {
+  FrameRing *r = *ring;
+  if (r != NULL) {
+    if (r->data != NULL) {
+      __atomic_store_n(&r->header->closed, 1, __ATOMIC_RELEASE);
+      munmap(r->data, r->size);
+    }
+
+    if (r->fd >= 0) {
+      // the name may already be used by a newer ring, only remove our own
+      struct stat own, current;
+      int fd = shm_open(r->name, O_RDONLY, 0);
+
+      if (fd >= 0 && fstat(r->fd, &own) == 0 && fstat(fd, &current) == 0 &&
+          own.st_dev == current.st_dev && own.st_ino == current.st_ino) {
+        shm_unlink(r->name);
+      }
+
+      if (fd >= 0) {
+        close(fd);
+      }
+
+      close(r->fd);
+    }
+
+    if (r->name != NULL) {
+      enif_free(r->name);
+    }
+
+    enif_free(r);
+    *ring = NULL;
+  }
+}
+
+// Sizes and maps the object opened by init.
+static int create_ring(FrameRing *ring) {
+  int64_t stride = FFALIGN(sizeof(struct FrameRingSlot) + ring->slot_size,
+                           FRAME_RING_ALIGN);
+
+  ring->size = sizeof(struct FrameRingHeader) + stride * ring->num_slots;
+
+  if (ftruncate(ring->fd, ring->size) < 0) {
+    return -1;
+  }
+
+  void *data = mmap(NULL, ring->size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                    ring->fd, 0);
+  if (data == MAP_FAILED) {
+    return -1;
+  }
+
+  // ftruncate zero fills the object, all the slots start unwritten
+  ring->data = data;
+  ring->header = (struct FrameRingHeader *)data;
+  ring->header->version = FRAME_RING_VERSION;
+  ring->header->num_slots = ring->num_slots;
+  ring->header->slot_size = ring->slot_size;
+  ring->header->slot_stride = stride;
+  ring->header->write_count = 0;
+  ring->header->closed = 0;
+
+  // the magic is written last, readers wait for it before using the header
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  memcpy(ring->header->magic, FRAME_RING_MAGIC, 8);
+
+  return 0;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "utils.h"
+
+// Ring of converted frames in a named POSIX shared memory object, so local
+// processes can read the decoded frames in place. The object is a header
+// followed by `num_slots` slots, each slot is a header followed by the frame
+// planes packed without padding. All the fields are in host byte order.
+//
+// There's a single writer. The sequence of a slot is odd while the slot is
+// written and incremented again once done, readers load the sequence, read
+// the frame then check the sequence didn't change, the frame was overwritten
+// otherwise. `write_count` is the number of frames published so far, the last
+// one is in slot (write_count - 1) % num_slots. A closed ring is never written
+// again, readers re-open the name to get the new one.
+
+#define FRAME_RING_MAGIC "NVRRING1"
+#define FRAME_RING_VERSION 1
+#define FRAME_RING_ALIGN 64
+
+typedef struct FrameRing FrameRing;
+
+enum FrameRingError {
+  FRAME_RING_INVALID = -1,
+  // an object with the same name exists, it's never replaced
+  FRAME_RING_EXISTS = -2,
+  FRAME_RING_FAILED = -3
+};
+
+struct FrameRingHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_slots;
+  // maximum size of a frame and distance between two slots
+  uint64_t slot_size;
+  uint64_t slot_stride;
+  uint64_t write_count;
+  uint32_t closed;
+  uint8_t reserved[20];
+};
+
+struct FrameRingSlot {
+  uint64_t sequence;
+  int64_t pts;
+  // number of frames published before this one
+  uint64_t frame_number;
+  int32_t width;
+  int32_t height;
+  uint32_t size;
+  int32_t format;
+  // pixel format name as given by libavutil, nul terminated
+  char format_name[16];
+  uint8_t reserved[8];
+};
+
+// metadata of a published frame
+struct FrameRingEntry {
+  int slot;
+  uint64_t sequence;
+  uint64_t frame_number;
+  uint32_t size;
+};
+
+struct FrameRing {
+  char *name;
+  int num_slots;
+  int64_t slot_size;
+  // permissions of the shared memory object
+  int mode;
+  int fd;
+  uint8_t *data;
+  int64_t size;
+  struct FrameRingHeader *header;
+};
+
+FrameRing *frame_ring_alloc();
+// The object is created right away. slot_size may be 0, the object is then
+// empty until the first published frame and sized after it.
+int frame_ring_init(FrameRing *ring, const char *name, int num_slots,
+                    int64_t slot_size, int mode);
+// Copies the frame to the next slot. Returns 0 if the frame doesn't fit in a
+// slot, 1 once published.
+int frame_ring_publish(FrameRing *ring, AVFrame *frame,
+                       struct FrameRingEntry *entry);
+void frame_ring_free(FrameRing **ring);
@@ -0,0 +1,131 @@
+#include "glyph_atlas.h"
+#include "text_font.h"
+
+#define GLYPH_ATLAS_NUM_GLYPHS (TEXT_FONT_LAST - TEXT_FONT_FIRST + 1)
+
+static ErlNifMutex *cache_lock = NULL;
+static GlyphAtlas *cache = NULL;
+
+static void rasterize(GlyphAtlas *atlas);
+
+void glyph_atlas_cache_init(void) {
+  cache_lock = enif_mutex_create("nvr_glyph_atlas");
+}
+
+void glyph_atlas_cache_free(void) {
+  while (cache != NULL) {
+    GlyphAtlas *atlas = cache;
+    cache = atlas->next;
+    enif_free(atlas->alpha);
+    enif_free(atlas);
+  }
+
+  if (cache_lock) {
+    enif_mutex_destroy(cache_lock);
+    cache_lock = NULL;
+  }
+}
+
+GlyphAtlas *glyph_atlas_get(int size) {
+  if (size < GLYPH_ATLAS_MIN_SIZE || size > GLYPH_ATLAS_MAX_SIZE) {
+    return NULL;
+  }
+
+  enif_mutex_lock(cache_lock);
+
+  GlyphAtlas *atlas = cache;
+  while (atlas != NULL && atlas->size != size) {
+    atlas = atlas->next;
+  }
+
+  if (atlas == NULL) {
+    atlas = (GlyphAtlas *)enif_alloc(sizeof(GlyphAtlas));
+    atlas->size = size;
+    atlas->cell_width = FFMAX(
+        (size * TEXT_FONT_WIDTH + TEXT_FONT_HEIGHT / 2) / TEXT_FONT_HEIGHT, 1);
+    atlas->refs = 0;
+    rasterize(atlas);
+
+    atlas->next = cache;
+    cache = atlas;
+  }
+
+  atlas->refs++;
+  enif_mutex_unlock(cache_lock);
+
+  return atlas;
+}
+
+void glyph_atlas_release(GlyphAtlas **atlas) {
+  if (*atlas == NULL) {
+    return;
+  }
+
+  enif_mutex_lock(cache_lock);
+
+  if (--(*atlas)->refs == 0) {
+    GlyphAtlas **entry = &cache;
+    while (*entry != *atlas) {
+      entry = &(*entry)->next;
+    }
+
+    *entry = (*atlas)->next;
+    enif_free((*atlas)->alpha);
+    enif_free(*atlas);
+  }
+
+  enif_mutex_unlock(cache_lock);
+  *atlas = NULL;
+}
+
+const uint8_t *glyph_atlas_glyph(const GlyphAtlas *atlas, char c) {
+  if (c < TEXT_FONT_FIRST || c > TEXT_FONT_LAST) {
+    c = '?';
+  }
+
+  return atlas->alpha +
+         (c - TEXT_FONT_FIRST) * atlas->cell_width * atlas->size;
+}
+
+// Overlap of [start, end) with the font pixel i
+static inline double overlap(double start, double end, int i) {
+  return FFMAX(FFMIN(end, i + 1) - FFMAX(start, i), 0);
+}
+
+// The alpha of a pixel is the area of its footprint in the font cell covered
+// by the glyph, this antialiases downscaled glyphs and smooths the edges of
+// upscaled ones.
+static void rasterize(GlyphAtlas *atlas) {
+  int width = atlas->cell_width, height = atlas->size;
+  double sx = (double)TEXT_FONT_WIDTH / width;
+  double sy = (double)TEXT_FONT_HEIGHT / height;
+
+  atlas->alpha =
+      (uint8_t *)enif_alloc(GLYPH_ATLAS_NUM_GLYPHS * width * height);
+
+  for (int g = 0; g < GLYPH_ATLAS_NUM_GLYPHS; g++) {
+    const uint32_t *rows = text_font_rows[g];
+    uint8_t *dst = atlas->alpha + g * width * height;
+
+    for (int y = 0; y < height; y++) {
+      double y0 = y * sy, y1 = (y + 1) * sy;
+
+      for (int x = 0; x < width; x++) {
+        double x0 = x * sx, x1 = (x + 1) * sx;
+        double covered = 0;
+
+        for (int j = (int)y0; j < y1 && j < TEXT_FONT_HEIGHT; j++) {
+          double wy = overlap(y0, y1, j);
+
+          for (int i = (int)x0; i < x1 && i < TEXT_FONT_WIDTH; i++) {
+            if (rows[j] & (1u << (31 - i))) {
+              covered += wy * overlap(x0, x1, i);
+            }
+          }
+        }
+
+        dst[y * width + x] = (uint8_t)(255 * covered / (sx * sy) + 0.5);
+      }
+    }
+  }
+}
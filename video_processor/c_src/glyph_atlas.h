@@ -0,0 +1,34 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "utils.h"
+
+#define GLYPH_ATLAS_MIN_SIZE 8
+#define GLYPH_ATLAS_MAX_SIZE 128
+
+// Antialiased glyphs of the printable ascii characters for one text size,
+// rasterized from the embedded font. Atlases are shared by all the users of
+// a size and freed when the last one releases it.
+typedef struct GlyphAtlas GlyphAtlas;
+
+struct GlyphAtlas {
+  // height of the glyph cells in pixels
+  int size;
+  int cell_width;
+  // alpha of the glyphs one after the other, cell_width * size bytes each
+  uint8_t *alpha;
+  int refs;
+  GlyphAtlas *next;
+};
+
+// must be called before any other function, once
+void glyph_atlas_cache_init(void);
+void glyph_atlas_cache_free(void);
+
+// NULL if the size is out of bounds
+GlyphAtlas *glyph_atlas_get(int size);
+void glyph_atlas_release(GlyphAtlas **atlas);
+
+// alpha of the glyph of c, unknown characters are drawn as '?'
+const uint8_t *glyph_atlas_glyph(const GlyphAtlas *atlas, char c);
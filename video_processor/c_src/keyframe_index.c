@@ -0,0 +1,236 @@
+#include "keyframe_index.h"
+#include <libavutil/intreadwrite.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define KEYFRAME_INDEX_CODEC_H264 1
+#define KEYFRAME_INDEX_CODEC_HEVC 2
+
+static int write_file(const char *path, const uint8_t *data, int64_t size);
+
+int keyframe_index_write(AVFormatContext *format_ctx, int stream_index,
+                         const char *path) {
+  AVStream *stream = format_ctx->streams[stream_index];
+  AVCodecParameters *codecpar = stream->codecpar;
+  AVPacket *packet = av_packet_alloc();
+  int count = 0, max_count = 64, codec, ret = 0;
+
+  switch (codecpar->codec_id) {
+  case AV_CODEC_ID_H264:
+    codec = KEYFRAME_INDEX_CODEC_H264;
+    break;
+  case AV_CODEC_ID_HEVC:
+    codec = KEYFRAME_INDEX_CODEC_HEVC;
+    break;
+  default:
+    av_packet_free(&packet);
+    return -1;
+  }
+
+  struct KeyframeIndexEntry *entries =
+      enif_alloc(max_count * sizeof(struct KeyframeIndexEntry));
+
+  // the keyframe pts are not in the demuxer index, the packets are read once
+  while ((ret = av_read_frame(format_ctx, packet)) >= 0) {
+    if (packet->stream_index != stream_index) {
+      av_packet_unref(packet);
+      continue;
+    }
+
+    // without a timestamp the keyframe can't be searched, its packets are
+    // counted in the previous group of pictures
+    int64_t pts = packet->pts != AV_NOPTS_VALUE ? packet->pts : packet->dts;
+
+    if ((packet->flags & AV_PKT_FLAG_KEY) && pts != AV_NOPTS_VALUE) {
+      if (count == max_count) {
+        max_count *= 2;
+        entries = enif_realloc(entries,
+                               max_count * sizeof(struct KeyframeIndexEntry));
+      }
+
+      entries[count].timestamp =
+          av_rescale_q(pts, stream->time_base, AV_TIME_BASE_Q);
+      entries[count].offset = packet->pos;
+      entries[count].size = packet->size;
+      entries[count].gop_length = 0;
+      count++;
+    }
+
+    if (count > 0) {
+      entries[count - 1].gop_length++;
+    }
+
+    av_packet_unref(packet);
+  }
+
+  av_packet_free(&packet);
+
+  if (ret != AVERROR_EOF) {
+    enif_free(entries);
+    return -1;
+  }
+
+  int64_t size = KEYFRAME_INDEX_HEADER_SIZE +
+                 (int64_t)count * KEYFRAME_INDEX_ENTRY_SIZE +
+                 codecpar->extradata_size;
+  uint8_t *data = enif_alloc(size);
+  uint8_t *ptr = data + KEYFRAME_INDEX_HEADER_SIZE;
+
+  memset(data, 0, KEYFRAME_INDEX_HEADER_SIZE);
+  memcpy(data, KEYFRAME_INDEX_MAGIC, 8);
+  AV_WL32(data + 8, KEYFRAME_INDEX_VERSION);
+  AV_WL32(data + 12, codec);
+  AV_WL32(data + 16, count);
+  AV_WL32(data + 20, codecpar->extradata_size);
+
+  for (int i = 0; i < count; i++, ptr += KEYFRAME_INDEX_ENTRY_SIZE) {
+    AV_WL64(ptr, entries[i].timestamp);
+    AV_WL64(ptr + 8, entries[i].offset);
+    AV_WL32(ptr + 16, entries[i].size);
+    AV_WL32(ptr + 20, entries[i].gop_length);
+  }
+
+  if (codecpar->extradata_size > 0) {
+    memcpy(ptr, codecpar->extradata, codecpar->extradata_size);
+  }
+
+  ret = write_file(path, data, size);
+
+  enif_free(entries);
+  enif_free(data);
+
+  return ret;
+}
+
+KeyframeIndex *keyframe_index_alloc() {
+  KeyframeIndex *index = (KeyframeIndex *)enif_alloc(sizeof(KeyframeIndex));
+
+  index->data = NULL;
+  index->size = 0;
+  index->codec_id = AV_CODEC_ID_NONE;
+  index->count = 0;
+  index->entries = NULL;
+  index->extradata = NULL;
+  index->extradata_size = 0;
+
+  return index;
+}
+
+int keyframe_index_open(KeyframeIndex *index, const char *path) {
+  if (nvr_map_file(path, &index->data, &index->size) < 0) {
+    return -1;
+  }
+
+  const uint8_t *data = index->data;
+  if (index->size < KEYFRAME_INDEX_HEADER_SIZE ||
+      memcmp(data, KEYFRAME_INDEX_MAGIC, 8) != 0 ||
+      AV_RL32(data + 8) != KEYFRAME_INDEX_VERSION) {
+    return -1;
+  }
+
+  switch (AV_RL32(data + 12)) {
+  case KEYFRAME_INDEX_CODEC_H264:
+    index->codec_id = AV_CODEC_ID_H264;
+    break;
+  case KEYFRAME_INDEX_CODEC_HEVC:
+    index->codec_id = AV_CODEC_ID_HEVC;
+    break;
+  default:
+    return -1;
+  }
+
+  uint32_t count = AV_RL32(data + 16);
+  uint32_t extradata_size = AV_RL32(data + 20);
+
+  if (index->size != KEYFRAME_INDEX_HEADER_SIZE +
+                         (int64_t)count * KEYFRAME_INDEX_ENTRY_SIZE +
+                         extradata_size) {
+    return -1;
+  }
+
+  index->count = count;
+  index->entries = data + KEYFRAME_INDEX_HEADER_SIZE;
+  index->extradata =
+      index->entries + (int64_t)count * KEYFRAME_INDEX_ENTRY_SIZE;
+  index->extradata_size = extradata_size;
+
+  return 0;
+}
+
+void keyframe_index_entry(KeyframeIndex *index, int position,
+                          struct KeyframeIndexEntry *entry) {
+  const uint8_t *ptr =
+      index->entries + (int64_t)position * KEYFRAME_INDEX_ENTRY_SIZE;
+
+  entry->timestamp = AV_RL64(ptr);
+  entry->offset = AV_RL64(ptr + 8);
+  entry->size = AV_RL32(ptr + 16);
+  entry->gop_length = AV_RL32(ptr + 20);
+}
+
+int keyframe_index_search(KeyframeIndex *index, int64_t timestamp) {
+  int low = 0, high = index->count - 1, position = -1;
+
+  while (low <= high) {
+    int mid = low + (high - low) / 2;
+    int64_t mid_timestamp = (int64_t)AV_RL64(
+        index->entries + (int64_t)mid * KEYFRAME_INDEX_ENTRY_SIZE);
+
+    if (mid_timestamp <= timestamp) {
+      position = mid;
+      low = mid + 1;
+    } else {
+      high = mid - 1;
+    }
+  }
+
+  return position;
+}
+
+void keyframe_index_free(KeyframeIndex **index) {
+  KeyframeIndex *i = *index;
+  if (i != NULL) {
+    if (i->data != NULL) {
+      munmap(i->data, i->size);
+    }
+
+    enif_free(i);
+    *index = NULL;
+  }
+}
+
+// written to a temporary file first, a partial index is never visible. The
+// temporary name is unique, concurrent builds of the same index each publish
+// a complete file.
+static int write_file(const char *path, const uint8_t *data, int64_t size) {
+  char *tmp_path = enif_alloc(strlen(path) + 8);
+  sprintf(tmp_path, "%s.XXXXXX", path);
+
+  int ret = -1;
+  int fd = mkstemp(tmp_path);
+  FILE *file = NULL;
+
+  if (fd >= 0) {
+    // mkstemp creates the file readable by its owner only
+    fchmod(fd, 0644);
+    file = fdopen(fd, "wb");
+    if (file == NULL) {
+      close(fd);
+      remove(tmp_path);
+    }
+  }
+
+  if (file != NULL) {
+    ret = fwrite(data, 1, size, file) == (size_t)size ? 0 : -1;
+    if (fclose(file) != 0 || ret < 0 || rename(tmp_path, path) < 0) {
+      remove(tmp_path);
+      ret = -1;
+    }
+  }
+
+  enif_free(tmp_path);
+  return ret;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "utils.h"
+#include <libavformat/avformat.h>
+
+// Sidecar index of the keyframes of a recording. The file is a fixed size
+// header followed by one fixed width entry per keyframe sorted by timestamp,
+// so it can be mapped and binary searched without parsing the mp4 sample
+// tables, then the codec extradata. All the fields are little endian.
+//
+//   header: magic (8), version (4), codec (4), count (4), extradata size (4),
+//           reserved (8)
+//   entry:  timestamp (8), offset (8), size (4), gop length (4)
+
+#define KEYFRAME_INDEX_MAGIC "NVRKFIDX"
+#define KEYFRAME_INDEX_VERSION 1
+#define KEYFRAME_INDEX_HEADER_SIZE 32
+#define KEYFRAME_INDEX_ENTRY_SIZE 24
+
+typedef struct KeyframeIndex KeyframeIndex;
+
+struct KeyframeIndexEntry {
+  // pts in microseconds from the start of the stream
+  int64_t timestamp;
+  // position and size of the access unit in the recording
+  int64_t offset;
+  uint32_t size;
+  // number of access units up to the next keyframe
+  uint32_t gop_length;
+};
+
+struct KeyframeIndex {
+  uint8_t *data;
+  int64_t size;
+  enum AVCodecID codec_id;
+  int count;
+  const uint8_t *entries;
+  const uint8_t *extradata;
+  int extradata_size;
+};
+
+// reads the packets of the stream once and writes its index to `path`
+int keyframe_index_write(AVFormatContext *format_ctx, int stream_index,
+                         const char *path);
+KeyframeIndex *keyframe_index_alloc();
+int keyframe_index_open(KeyframeIndex *index, const char *path);
+void keyframe_index_entry(KeyframeIndex *index, int position,
+                          struct KeyframeIndexEntry *entry);
+// position of the last keyframe at or before `timestamp`, -1 if none
+int keyframe_index_search(KeyframeIndex *index, int64_t timestamp);
+void keyframe_index_free(KeyframeIndex **index);
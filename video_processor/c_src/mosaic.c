@@ -0,0 +1,187 @@
+#include "mosaic.h"
+
+static int place_frames(Mosaic *mosaic);
+static void clear_canvas(AVFrame *canvas);
+
+void mosaic_config_default(struct MosaicConfig *config) {
+  config->columns = 4;
+  config->rows = 1;
+  config->tile_width = 160;
+  config->tile_height = 90;
+}
+
+Mosaic *mosaic_alloc() {
+  Mosaic *mosaic = (Mosaic *)enif_alloc(sizeof(Mosaic));
+
+  mosaic_config_default(&mosaic->config);
+  mosaic->decoder = NULL;
+  mosaic->encoder = NULL;
+  mosaic->sws_ctx = NULL;
+  mosaic->canvas = NULL;
+  mosaic->num_tiles = 0;
+
+  return mosaic;
+}
+
+int mosaic_config_valid(struct MosaicConfig *config) {
+  return config->columns >= 1 && config->rows >= 1 &&
+         config->tile_width >= 2 && config->tile_height >= 2 &&
+         config->tile_width % 2 == 0 && config->tile_height % 2 == 0 &&
+         (int64_t)config->columns * config->tile_width <= 16384 &&
+         (int64_t)config->rows * config->tile_height <= 16384;
+}
+
+int mosaic_init(Mosaic *mosaic, enum AVCodecID codec_id,
+                struct MosaicConfig *config) {
+  if (!mosaic_config_valid(config)) {
+    return -1;
+  }
+
+  mosaic->config = *config;
+
+  const AVCodec *codec = avcodec_find_decoder(codec_id);
+  if (!codec) {
+    return -1;
+  }
+
+  mosaic->decoder = decoder_alloc();
+  if (decoder_init(mosaic->decoder, codec) < 0) {
+    return -1;
+  }
+
+  // only keyframes end up in the mosaic, don't spend time on the others
+  mosaic->decoder->c->skip_frame = AVDISCARD_NONKEY;
+
+  mosaic->canvas = av_frame_alloc();
+  if (!mosaic->canvas) {
+    return -1;
+  }
+
+  mosaic->canvas->format = AV_PIX_FMT_YUVJ420P;
+  mosaic->canvas->width = config->columns * config->tile_width;
+  mosaic->canvas->height = config->rows * config->tile_height;
+  mosaic->canvas->pts = 0;
+
+  if (av_frame_get_buffer(mosaic->canvas, 0) < 0) {
+    return -1;
+  }
+
+  clear_canvas(mosaic->canvas);
+
+  struct EncoderConfig encoder_config = {
+      .media_type = AVMEDIA_TYPE_VIDEO,
+      .codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG),
+      .width = mosaic->canvas->width,
+      .height = mosaic->canvas->height,
+      .format = AV_PIX_FMT_YUVJ420P,
+      .time_base = (AVRational){1, 1},
+      .gop_size = -1,
+      .max_b_frames = -1,
+      .profile = FF_PROFILE_UNKNOWN,
+      .preset = NULL,
+      .tune = NULL};
+
+  if (!encoder_config.codec) {
+    return -1;
+  }
+
+  mosaic->encoder = encoder_alloc();
+  return encoder_init(mosaic->encoder, &encoder_config);
+}
+
+int mosaic_add_packet(Mosaic *mosaic, AVPacket *packet) {
+  if (decoder_decode(mosaic->decoder, packet) < 0) {
+    return -1;
+  }
+
+  return place_frames(mosaic);
+}
+
+// Drains the decoder and encodes the canvas, the jpeg is the first packet of
+// the encoder.
+int mosaic_encode(Mosaic *mosaic) {
+  if (decoder_flush(mosaic->decoder) < 0 || place_frames(mosaic) < 0) {
+    return -1;
+  }
+
+  if (encoder_encode(mosaic->encoder, mosaic->canvas) < 0) {
+    return -1;
+  }
+
+  if (mosaic->encoder->num_packets == 0 &&
+      encoder_encode(mosaic->encoder, NULL) < 0) {
+    return -1;
+  }
+
+  return mosaic->encoder->num_packets > 0 ? 0 : -1;
+}
+
+void mosaic_free(Mosaic **mosaic) {
+  Mosaic *m = *mosaic;
+  if (m != NULL) {
+    decoder_free(&m->decoder);
+    encoder_free(m->encoder);
+
+    if (m->sws_ctx != NULL) {
+      sws_freeContext(m->sws_ctx);
+    }
+
+    if (m->canvas != NULL) {
+      av_frame_free(&m->canvas);
+    }
+
+    enif_free(m);
+    *mosaic = NULL;
+  }
+}
+
+// Scales the decoded frames straight into their tile, frames that don't fit
+// in the grid are dropped.
+static int place_frames(Mosaic *mosaic) {
+  struct MosaicConfig *config = &mosaic->config;
+  AVFrame *canvas = mosaic->canvas;
+  Decoder *decoder = mosaic->decoder;
+
+  for (int i = 0; i < decoder->count_frames; i++) {
+    AVFrame *frame = decoder->frames[i];
+
+    if (mosaic->num_tiles < config->columns * config->rows) {
+      mosaic->sws_ctx = sws_getCachedContext(
+          mosaic->sws_ctx, frame->width, frame->height, frame->format,
+          config->tile_width, config->tile_height, canvas->format,
+          SWS_BILINEAR, NULL, NULL, NULL);
+
+      if (!mosaic->sws_ctx) {
+        return -1;
+      }
+
+      int x = (mosaic->num_tiles % config->columns) * config->tile_width;
+      int y = (mosaic->num_tiles / config->columns) * config->tile_height;
+
+      uint8_t *dst[4] = {
+          canvas->data[0] + y * canvas->linesize[0] + x,
+          canvas->data[1] + (y / 2) * canvas->linesize[1] + x / 2,
+          canvas->data[2] + (y / 2) * canvas->linesize[2] + x / 2, NULL};
+
+      sws_scale(mosaic->sws_ctx, (const uint8_t *const *)frame->data,
+                frame->linesize, 0, frame->height, dst, canvas->linesize);
+
+      mosaic->num_tiles++;
+    }
+
+    av_frame_unref(frame);
+  }
+
+  return 0;
+}
+
+static void clear_canvas(AVFrame *canvas) {
+  for (int y = 0; y < canvas->height; y++) {
+    memset(canvas->data[0] + y * canvas->linesize[0], 0, canvas->width);
+  }
+
+  for (int y = 0; y < canvas->height / 2; y++) {
+    memset(canvas->data[1] + y * canvas->linesize[1], 128, canvas->width / 2);
+    memset(canvas->data[2] + y * canvas->linesize[2], 128, canvas->width / 2);
+  }
+}
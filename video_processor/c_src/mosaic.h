@@ -0,0 +1,34 @@
+#pragma once
+
+#include "decoder.h"
+#include "encoder.h"
+#include "utils.h"
+#include <libswscale/swscale.h>
+
+typedef struct Mosaic Mosaic;
+
+struct MosaicConfig {
+  int columns;
+  int rows;
+  // size of each tile, must be even
+  int tile_width;
+  int tile_height;
+};
+
+struct Mosaic {
+  struct MosaicConfig config;
+  Decoder *decoder;
+  Encoder *encoder;
+  struct SwsContext *sws_ctx;
+  AVFrame *canvas;
+  int num_tiles;
+};
+
+void mosaic_config_default(struct MosaicConfig *config);
+Mosaic *mosaic_alloc();
+int mosaic_config_valid(struct MosaicConfig *config);
+int mosaic_init(Mosaic *mosaic, enum AVCodecID codec_id,
+                struct MosaicConfig *config);
+int mosaic_add_packet(Mosaic *mosaic, AVPacket *packet);
+int mosaic_encode(Mosaic *mosaic);
+void mosaic_free(Mosaic **mosaic);
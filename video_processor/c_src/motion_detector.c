@@ -0,0 +1,459 @@
+#include "motion_detector.h"
+#include <libavutil/intreadwrite.h>
+#include "simd.h"
+
+static int setup_buffers(MotionDetector *detector, int width, int height);
+static void free_buffers(MotionDetector *detector);
+static void downscale_plane(const uint8_t *src, int src_stride, uint8_t *dst,
+                            int dst_width, int dst_height, int factor);
+static void downscale_plane_16(const uint8_t *src, int src_stride,
+                               uint8_t *dst, int dst_width, int dst_height,
+                               int factor, int shift);
+static int find_regions(MotionDetector *detector, struct MotionResult *result);
+
+// Adds the sum of absolute differences of every group of 8 bytes to sums,
+// n is a multiple of 8.
+static void sad_row_c(const uint8_t *a, const uint8_t *b, int n,
+                      uint32_t *sums) {
+  for (int i = 0; i < n; i += 8) {
+    uint32_t sum = 0;
+    for (int j = i; j < i + 8; j++) {
+      sum += a[j] > b[j] ? a[j] - b[j] : b[j] - a[j];
+    }
+    sums[i >> 3] += sum;
+  }
+}
+
+// Moves the background towards the current frame, the step is rounded away
+// from zero so the background always converges.
+static void update_background_c(uint8_t *background, const uint8_t *current,
+                                int n, int shift) {
+  int round = (1 << shift) - 1;
+  for (int i = 0; i < n; i++) {
+    int diff = current[i] - background[i];
+    background[i] += diff > 0 ? (diff + round) >> shift : diff >> shift;
+  }
+}
+
+#ifdef NVR_HAVE_X86
+NVR_TARGET_AVX2 static void sad_row_avx2(const uint8_t *a, const uint8_t *b,
+                                         int n, uint32_t *sums) {
+  uint64_t out[4];
+  int i = 0;
+
+  for (; i + 32 <= n; i += 32) {
+    __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+    __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+    _mm256_storeu_si256((__m256i *)out, _mm256_sad_epu8(va, vb));
+
+    uint32_t *dst = sums + (i >> 3);
+    dst[0] += out[0];
+    dst[1] += out[1];
+    dst[2] += out[2];
+    dst[3] += out[3];
+  }
+
+  sad_row_c(a + i, b + i, n - i, sums + (i >> 3));
+}
+
+NVR_TARGET_AVX2 static void update_background_avx2(uint8_t *background,
+                                                   const uint8_t *current,
+                                                   int n, int shift) {
+  __m256i zero = _mm256_setzero_si256();
+  __m256i round = _mm256_set1_epi16((1 << shift) - 1);
+  __m128i count = _mm_cvtsi32_si128(shift);
+  int i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    __m256i bg = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128((const __m128i *)(background + i)));
+    __m256i cur =
+        _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(current + i)));
+
+    __m256i diff = _mm256_sub_epi16(cur, bg);
+    __m256i bias = _mm256_and_si256(_mm256_cmpgt_epi16(diff, zero), round);
+    __m256i step = _mm256_sra_epi16(_mm256_add_epi16(diff, bias), count);
+    __m256i packed = _mm256_packus_epi16(_mm256_add_epi16(bg, step), zero);
+
+    _mm_storeu_si128((__m128i *)(background + i),
+                     _mm256_castsi256_si128(
+                         _mm256_permute4x64_epi64(packed, 0x08)));
+  }
+
+  update_background_c(background + i, current + i, n - i, shift);
+}
+#endif
+
+#ifdef NVR_HAVE_NEON
+static void sad_row_neon(const uint8_t *a, const uint8_t *b, int n,
+                         uint32_t *sums) {
+  int i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t diff = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+    uint64x2_t sad = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(diff)));
+
+    uint32_t *dst = sums + (i >> 3);
+    dst[0] += vgetq_lane_u64(sad, 0);
+    dst[1] += vgetq_lane_u64(sad, 1);
+  }
+
+  sad_row_c(a + i, b + i, n - i, sums + (i >> 3));
+}
+
+static void update_background_neon(uint8_t *background,
+                                   const uint8_t *current, int n, int shift) {
+  int16x8_t zero = vdupq_n_s16(0);
+  int16x8_t round = vdupq_n_s16((1 << shift) - 1);
+  int16x8_t count = vdupq_n_s16(-shift);
+  int i = 0;
+
+  for (; i + 8 <= n; i += 8) {
+    int16x8_t bg = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(background + i)));
+    int16x8_t cur = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(current + i)));
+
+    int16x8_t diff = vsubq_s16(cur, bg);
+    int16x8_t bias =
+        vandq_s16(vreinterpretq_s16_u16(vcgtq_s16(diff, zero)), round);
+    int16x8_t step = vshlq_s16(vaddq_s16(diff, bias), count);
+
+    vst1_u8(background + i, vqmovun_s16(vaddq_s16(bg, step)));
+  }
+
+  update_background_c(background + i, current + i, n - i, shift);
+}
+#endif
+
+void motion_config_default(struct MotionConfig *config) {
+  config->downscale = 4;
+  config->block_size = 16;
+  config->threshold = 10;
+  config->learning_shift = 4;
+  config->max_regions = 16;
+}
+
+MotionDetector *motion_detector_alloc() {
+  MotionDetector *detector =
+      (MotionDetector *)enif_alloc(sizeof(MotionDetector));
+
+  motion_config_default(&detector->config);
+  detector->width = 0;
+  detector->height = 0;
+  detector->has_background = 0;
+  detector->current = NULL;
+  detector->background = NULL;
+  detector->sads = NULL;
+  detector->mask = NULL;
+  detector->stack = NULL;
+
+  detector->sad_row = sad_row_c;
+  detector->update_background = update_background_c;
+
+#ifdef NVR_HAVE_X86
+  if (nvr_cpu_has_avx2()) {
+    detector->sad_row = sad_row_avx2;
+    detector->update_background = update_background_avx2;
+  }
+#endif
+
+#ifdef NVR_HAVE_NEON
+  if (nvr_cpu_has_neon()) {
+    detector->sad_row = sad_row_neon;
+    detector->update_background = update_background_neon;
+  }
+#endif
+
+  return detector;
+}
+
+int motion_detector_init(MotionDetector *detector,
+                         struct MotionConfig *config) {
+  if (config->downscale < 1 || config->block_size < 8 ||
+      config->block_size % 8 != 0 || config->threshold < 0 ||
+      config->threshold > 255 || config->learning_shift < 0 ||
+      config->learning_shift > 7 || config->max_regions < 0 ||
+      config->max_regions > MOTION_MAX_REGIONS) {
+    return -1;
+  }
+
+  detector->config = *config;
+  // buffers are allocated from the geometry of the first frame
+  free_buffers(detector);
+  return 0;
+}
+
+int motion_detector_process(MotionDetector *detector, AVFrame *frame,
+                            struct MotionResult *result) {
+  const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+  if (!desc || (desc->flags & AV_PIX_FMT_FLAG_RGB)) {
+    return -1;
+  }
+
+  // high bit depth luma is reduced to 8 bits, only little endian 16 bits
+  // samples are supported
+  int high_depth = desc->comp[0].depth > 8;
+  if (high_depth && (desc->comp[0].step != 2 || desc->comp[0].depth > 16 ||
+                     (desc->flags & AV_PIX_FMT_FLAG_BE))) {
+    return -1;
+  }
+
+  if (frame->width != detector->width || frame->height != detector->height) {
+    if (setup_buffers(detector, frame->width, frame->height) < 0) {
+      return -1;
+    }
+  }
+
+  struct MotionConfig *config = &detector->config;
+  int block_size = config->block_size;
+  int row_size = detector->blocks_x * block_size;
+  int groups_x = row_size >> 3;
+  int groups_per_block = block_size >> 3;
+
+  result->score = 0.0;
+  result->num_regions = 0;
+
+  if (high_depth) {
+    downscale_plane_16(frame->data[0], frame->linesize[0], detector->current,
+                       detector->ds_width, detector->ds_height,
+                       config->downscale,
+                       desc->comp[0].shift + desc->comp[0].depth - 8);
+  } else {
+    downscale_plane(frame->data[0], frame->linesize[0], detector->current,
+                    detector->ds_width, detector->ds_height, config->downscale);
+  }
+
+  if (!detector->has_background) {
+    memcpy(detector->background, detector->current,
+           detector->ds_width * detector->ds_height);
+    detector->has_background = 1;
+    return 0;
+  }
+
+  memset(detector->sads, 0,
+         sizeof(uint32_t) * groups_x * detector->blocks_y);
+
+  for (int by = 0; by < detector->blocks_y; by++) {
+    uint32_t *sums = detector->sads + by * groups_x;
+    for (int y = by * block_size; y < (by + 1) * block_size; y++) {
+      int offset = y * detector->ds_width;
+      detector->sad_row(detector->current + offset,
+                        detector->background + offset, row_size, sums);
+    }
+  }
+
+  uint32_t block_threshold = config->threshold * block_size * block_size;
+  int active = 0;
+
+  for (int by = 0; by < detector->blocks_y; by++) {
+    for (int bx = 0; bx < detector->blocks_x; bx++) {
+      uint32_t *sums = detector->sads + by * groups_x + bx * groups_per_block;
+      uint32_t sad = 0;
+      for (int g = 0; g < groups_per_block; g++) {
+        sad += sums[g];
+      }
+
+      int is_active = sad > block_threshold;
+      detector->mask[by * detector->blocks_x + bx] = is_active;
+      active += is_active;
+    }
+  }
+
+  detector->update_background(detector->background, detector->current,
+                              detector->ds_width * detector->ds_height,
+                              config->learning_shift);
+
+  result->score =
+      (double)active / (double)(detector->blocks_x * detector->blocks_y);
+
+  if (active > 0) {
+    find_regions(detector, result);
+  }
+
+  return 0;
+}
+
+void motion_detector_free(MotionDetector **detector) {
+  MotionDetector *d = *detector;
+  if (d != NULL) {
+    free_buffers(d);
+    enif_free(d);
+    *detector = NULL;
+  }
+}
+
+static int setup_buffers(MotionDetector *detector, int width, int height) {
+  struct MotionConfig *config = &detector->config;
+
+  free_buffers(detector);
+
+  detector->ds_width = width / config->downscale;
+  detector->ds_height = height / config->downscale;
+  detector->blocks_x = detector->ds_width / config->block_size;
+  detector->blocks_y = detector->ds_height / config->block_size;
+
+  if (detector->blocks_x == 0 || detector->blocks_y == 0) {
+    return -1;
+  }
+
+  int plane_size = detector->ds_width * detector->ds_height;
+  int num_blocks = detector->blocks_x * detector->blocks_y;
+  int groups_x = detector->blocks_x * (config->block_size >> 3);
+
+  detector->current = (uint8_t *)enif_alloc(plane_size);
+  detector->background = (uint8_t *)enif_alloc(plane_size);
+  detector->sads =
+      (uint32_t *)enif_alloc(sizeof(uint32_t) * groups_x * detector->blocks_y);
+  detector->mask = (uint8_t *)enif_alloc(num_blocks);
+  detector->stack = (int *)enif_alloc(sizeof(int) * num_blocks);
+
+  detector->width = width;
+  detector->height = height;
+  detector->has_background = 0;
+
+  return 0;
+}
+
+static void free_buffers(MotionDetector *detector) {
+  uint8_t **planes[] = {&detector->current, &detector->background,
+                        &detector->mask};
+  for (int i = 0; i < 3; i++) {
+    if (*planes[i] != NULL) {
+      enif_free(*planes[i]);
+      *planes[i] = NULL;
+    }
+  }
+
+  if (detector->sads != NULL) {
+    enif_free(detector->sads);
+    detector->sads = NULL;
+  }
+
+  if (detector->stack != NULL) {
+    enif_free(detector->stack);
+    detector->stack = NULL;
+  }
+
+  detector->width = 0;
+  detector->height = 0;
+  detector->has_background = 0;
+}
+
+static void downscale_plane(const uint8_t *src, int src_stride, uint8_t *dst,
+                            int dst_width, int dst_height, int factor) {
+  if (factor == 1) {
+    for (int y = 0; y < dst_height; y++) {
+      memcpy(dst + y * dst_width, src + y * src_stride, dst_width);
+    }
+    return;
+  }
+
+  int area = factor * factor;
+  for (int y = 0; y < dst_height; y++) {
+    const uint8_t *row = src + y * factor * src_stride;
+    for (int x = 0; x < dst_width; x++) {
+      const uint8_t *p = row + x * factor;
+      int sum = 0;
+      for (int j = 0; j < factor; j++) {
+        for (int i = 0; i < factor; i++) {
+          sum += p[j * src_stride + i];
+        }
+      }
+      dst[y * dst_width + x] = sum / area;
+    }
+  }
+}
+
+// Same as downscale_plane for 16 bits samples, the averages are shifted down
+// to 8 bits.
+static void downscale_plane_16(const uint8_t *src, int src_stride,
+                               uint8_t *dst, int dst_width, int dst_height,
+                               int factor, int shift) {
+  int area = factor * factor;
+  for (int y = 0; y < dst_height; y++) {
+    const uint8_t *row = src + y * factor * src_stride;
+    for (int x = 0; x < dst_width; x++) {
+      const uint8_t *p = row + x * factor * 2;
+      int64_t sum = 0;
+      for (int j = 0; j < factor; j++) {
+        for (int i = 0; i < factor; i++) {
+          sum += AV_RL16(p + j * src_stride + i * 2);
+        }
+      }
+      dst[y * dst_width + x] = av_clip_uint8((sum / area) >> shift);
+    }
+  }
+}
+
+// Groups active blocks into 8-connected regions, only the largest regions are
+// kept when there's more than max_regions.
+static int find_regions(MotionDetector *detector,
+                        struct MotionResult *result) {
+  int blocks_x = detector->blocks_x;
+  int blocks_y = detector->blocks_y;
+  int scale = detector->config.block_size * detector->config.downscale;
+  int areas[MOTION_MAX_REGIONS];
+  uint8_t *mask = detector->mask;
+
+  for (int start = 0; start < blocks_x * blocks_y; start++) {
+    if (mask[start] != 1) {
+      continue;
+    }
+
+    int min_x = blocks_x, min_y = blocks_y, max_x = 0, max_y = 0, area = 0;
+    int top = 0;
+
+    detector->stack[top++] = start;
+    mask[start] = 2;
+
+    while (top > 0) {
+      int idx = detector->stack[--top];
+      int bx = idx % blocks_x, by = idx / blocks_x;
+
+      area++;
+      min_x = FFMIN(min_x, bx);
+      max_x = FFMAX(max_x, bx);
+      min_y = FFMIN(min_y, by);
+      max_y = FFMAX(max_y, by);
+
+      for (int dy = -1; dy <= 1; dy++) {
+        for (int dx = -1; dx <= 1; dx++) {
+          int nx = bx + dx, ny = by + dy;
+          if (nx < 0 || ny < 0 || nx >= blocks_x || ny >= blocks_y) {
+            continue;
+          }
+
+          int neighbour = ny * blocks_x + nx;
+          if (mask[neighbour] == 1) {
+            mask[neighbour] = 2;
+            detector->stack[top++] = neighbour;
+          }
+        }
+      }
+    }
+
+    int slot = result->num_regions;
+    if (slot >= detector->config.max_regions) {
+      slot = -1;
+      for (int i = 0; i < result->num_regions; i++) {
+        if (areas[i] < area && (slot == -1 || areas[i] < areas[slot])) {
+          slot = i;
+        }
+      }
+
+      if (slot == -1) {
+        continue;
+      }
+    } else {
+      result->num_regions++;
+    }
+
+    struct MotionRegion *region = &result->regions[slot];
+    areas[slot] = area;
+    region->x = min_x * scale;
+    region->y = min_y * scale;
+    region->width = FFMIN((max_x + 1) * scale, detector->width) - region->x;
+    region->height = FFMIN((max_y + 1) * scale, detector->height) - region->y;
+  }
+
+  return result->num_regions;
+}
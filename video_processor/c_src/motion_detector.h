@@ -0,0 +1,63 @@
+#pragma once
+
+#include "utils.h"
+
+#define MOTION_MAX_REGIONS 32
+
+typedef struct MotionDetector MotionDetector;
+
+typedef void (*MotionSadRowFn)(const uint8_t *a, const uint8_t *b, int n,
+                               uint32_t *sums);
+typedef void (*MotionUpdateFn)(uint8_t *background, const uint8_t *current,
+                               int n, int shift);
+
+struct MotionConfig {
+  // the luma plane is reduced by this factor before analysis
+  int downscale;
+  // size of the analysis blocks in downscaled pixels, multiple of 8
+  int block_size;
+  // mean absolute difference above which a block is considered active
+  int threshold;
+  // the background moves towards the current frame by 1 / 2^learning_shift
+  int learning_shift;
+  int max_regions;
+};
+
+struct MotionRegion {
+  int x;
+  int y;
+  int width;
+  int height;
+};
+
+struct MotionResult {
+  double score;
+  int num_regions;
+  struct MotionRegion regions[MOTION_MAX_REGIONS];
+};
+
+struct MotionDetector {
+  struct MotionConfig config;
+  int width;
+  int height;
+  int ds_width;
+  int ds_height;
+  int blocks_x;
+  int blocks_y;
+  int has_background;
+  uint8_t *current;
+  uint8_t *background;
+  uint32_t *sads;
+  uint8_t *mask;
+  int *stack;
+  MotionSadRowFn sad_row;
+  MotionUpdateFn update_background;
+};
+
+void motion_config_default(struct MotionConfig *config);
+MotionDetector *motion_detector_alloc();
+int motion_detector_init(MotionDetector *detector,
+                         struct MotionConfig *config);
+int motion_detector_process(MotionDetector *detector, AVFrame *frame,
+                            struct MotionResult *result);
+void motion_detector_free(MotionDetector **detector);
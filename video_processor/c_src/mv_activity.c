@@ -0,0 +1,115 @@
+#include "mv_activity.h"
+#include <math.h>
+
+void mv_activity_config_default(struct MvActivityConfig *config) {
+  config->grid_width = 16;
+  config->grid_height = 9;
+  config->min_magnitude = 1;
+  config->skip_pixels = 1;
+}
+
+MvActivity *mv_activity_alloc() {
+  MvActivity *activity = (MvActivity *)enif_alloc(sizeof(MvActivity));
+
+  mv_activity_config_default(&activity->config);
+  activity->cells = NULL;
+  activity->score = 0.0;
+  activity->count = 0;
+
+  return activity;
+}
+
+int mv_activity_init(MvActivity *activity, struct MvActivityConfig *config) {
+  if (config->grid_width < 1 || config->grid_width > MV_ACTIVITY_MAX_GRID ||
+      config->grid_height < 1 || config->grid_height > MV_ACTIVITY_MAX_GRID ||
+      config->min_magnitude < 0) {
+    return -1;
+  }
+
+  if (activity->cells != NULL) {
+    enif_free(activity->cells);
+  }
+
+  activity->config = *config;
+  int num_cells = config->grid_width * config->grid_height;
+  activity->cells = (float *)enif_alloc(sizeof(float) * num_cells);
+  return 0;
+}
+
+// Aggregates the motion vectors exported by the decoder, frames without
+// vectors (intra frames) have a score of 0.
+int mv_activity_process(MvActivity *activity, AVFrame *frame) {
+  int grid_width = activity->config.grid_width;
+  int grid_height = activity->config.grid_height;
+  double min_magnitude = activity->config.min_magnitude;
+
+  memset(activity->cells, 0, sizeof(float) * grid_width * grid_height);
+  activity->score = 0.0;
+  activity->count = 0;
+
+  if (frame->width <= 0 || frame->height <= 0) {
+    return -1;
+  }
+
+  AVFrameSideData *side_data =
+      av_frame_get_side_data(frame, AV_FRAME_DATA_MOTION_VECTORS);
+  if (side_data == NULL) {
+    return 0;
+  }
+
+  const AVMotionVector *mvs = (const AVMotionVector *)side_data->data;
+  int count = side_data->size / sizeof(AVMotionVector);
+  double moving_area = 0.0;
+
+  for (int i = 0; i < count; i++) {
+    const AVMotionVector *mv = &mvs[i];
+    double dx, dy;
+
+    if (mv->motion_scale != 0) {
+      dx = (double)mv->motion_x / mv->motion_scale;
+      dy = (double)mv->motion_y / mv->motion_scale;
+    } else {
+      dx = mv->dst_x - mv->src_x;
+      dy = mv->dst_y - mv->src_y;
+    }
+
+    double magnitude = sqrt(dx * dx + dy * dy);
+    if (magnitude < min_magnitude || magnitude == 0.0) {
+      continue;
+    }
+
+    int area = mv->w * mv->h;
+    int cx = av_clip(mv->dst_x * grid_width / frame->width, 0, grid_width - 1);
+    int cy =
+        av_clip(mv->dst_y * grid_height / frame->height, 0, grid_height - 1);
+
+    activity->cells[cy * grid_width + cx] += magnitude * area;
+    moving_area += area;
+  }
+
+  double cell_area =
+      (double)frame->width * frame->height / (grid_width * grid_height);
+  for (int i = 0; i < grid_width * grid_height; i++) {
+    activity->cells[i] /= cell_area;
+  }
+
+  // bi-predicted blocks carry two vectors, the covered area may exceed the
+  // frame size.
+  activity->score =
+      FFMIN(1.0, moving_area / ((double)frame->width * frame->height));
+  activity->count = count;
+
+  return count;
+}
+
+void mv_activity_free(MvActivity **activity) {
+  MvActivity *a = *activity;
+  if (a != NULL) {
+    if (a->cells != NULL) {
+      enif_free(a->cells);
+    }
+
+    enif_free(a);
+    *activity = NULL;
+  }
+}
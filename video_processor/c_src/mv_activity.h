@@ -0,0 +1,34 @@
+#pragma once
+
+#include "utils.h"
+#include <libavutil/motion_vector.h>
+
+#define MV_ACTIVITY_MAX_GRID 64
+
+typedef struct MvActivity MvActivity;
+
+struct MvActivityConfig {
+  // number of columns and rows of the activity grid
+  int grid_width;
+  int grid_height;
+  // vectors shorter than this, in pixels, are ignored
+  int min_magnitude;
+  // skip the inverse transform and the loop filter, the decoded pixels are
+  // unusable but motion vectors are still exported.
+  int skip_pixels;
+};
+
+struct MvActivity {
+  struct MvActivityConfig config;
+  // mean displacement in pixels of each cell of the grid, row major
+  float *cells;
+  // fraction of the frame covered by moving blocks
+  double score;
+  int count;
+};
+
+void mv_activity_config_default(struct MvActivityConfig *config);
+MvActivity *mv_activity_alloc();
+int mv_activity_init(MvActivity *activity, struct MvActivityConfig *config);
+int mv_activity_process(MvActivity *activity, AVFrame *frame);
+void mv_activity_free(MvActivity **activity);
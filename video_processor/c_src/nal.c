@@ -0,0 +1,223 @@
+#include "nal.h"
+#include "simd.h"
+
+#define NAL_INITIAL_UNITS 8
+
+static int find_start_code_c(const uint8_t *data, int size, int offset) {
+  for (int i = offset; i + 2 < size; i++) {
+    // the third byte of a start code is 1, most positions are skipped
+    // without looking at the two zeros.
+    if (data[i + 2] > 1) {
+      i += 2;
+    } else if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
+      return i;
+    }
+  }
+
+  return size;
+}
+
+#ifdef NVR_HAVE_X86
+NVR_TARGET_AVX2 static int find_start_code_avx2(const uint8_t *data, int size,
+                                                int offset) {
+  __m256i zero = _mm256_setzero_si256();
+  __m256i one = _mm256_set1_epi8(1);
+  int i = offset;
+
+  for (; i + 34 <= size; i += 32) {
+    __m256i b0 = _mm256_loadu_si256((const __m256i *)(data + i));
+    __m256i b1 = _mm256_loadu_si256((const __m256i *)(data + i + 1));
+    __m256i b2 = _mm256_loadu_si256((const __m256i *)(data + i + 2));
+
+    __m256i match = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpeq_epi8(b0, zero),
+                         _mm256_cmpeq_epi8(b1, zero)),
+        _mm256_cmpeq_epi8(b2, one));
+
+    unsigned int mask = _mm256_movemask_epi8(match);
+    if (mask != 0) {
+      return i + __builtin_ctz(mask);
+    }
+  }
+
+  return find_start_code_c(data, size, i);
+}
+#endif
+
+#ifdef NVR_HAVE_NEON
+static int find_start_code_neon(const uint8_t *data, int size, int offset) {
+  uint8x16_t zero = vdupq_n_u8(0);
+  uint8x16_t one = vdupq_n_u8(1);
+  int i = offset;
+
+  for (; i + 18 <= size; i += 16) {
+    uint8x16_t match =
+        vandq_u8(vandq_u8(vceqq_u8(vld1q_u8(data + i), zero),
+                          vceqq_u8(vld1q_u8(data + i + 1), zero)),
+                 vceqq_u8(vld1q_u8(data + i + 2), one));
+
+    uint64x2_t lanes = vreinterpretq_u64_u8(match);
+    if (vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) {
+      return find_start_code_c(data, size, i);
+    }
+  }
+
+  return find_start_code_c(data, size, i);
+}
+#endif
+
+// Returns the position of the next 3 bytes start code at or after offset, or
+// size if there's none.
+int nal_find_start_code(const uint8_t *data, int size, int offset) {
+#ifdef NVR_HAVE_X86
+  if (nvr_cpu_has_avx2()) {
+    return find_start_code_avx2(data, size, offset);
+  }
+#endif
+
+#ifdef NVR_HAVE_NEON
+  if (nvr_cpu_has_neon()) {
+    return find_start_code_neon(data, size, offset);
+  }
+#endif
+
+  return find_start_code_c(data, size, offset);
+}
+
+int nal_unit_type(enum AVCodecID codec_id, const uint8_t *nal) {
+  if (codec_id == AV_CODEC_ID_HEVC) {
+    return (nal[0] >> 1) & 0x3F;
+  }
+
+  return nal[0] & 0x1F;
+}
+
+static struct NalUnit *add_unit(struct NalUnit *units, int count,
+                                int *capacity) {
+  if (count >= *capacity) {
+    *capacity *= 2;
+    units = enif_realloc(units, sizeof(struct NalUnit) * *capacity);
+  }
+
+  return units;
+}
+
+// Splits an annex b access unit, the zero byte of 4 bytes start codes and
+// trailing zeros are not part of the units.
+int nal_parse_annexb(const uint8_t *data, int size, enum AVCodecID codec_id,
+                     struct NalUnit **units) {
+  int capacity = NAL_INITIAL_UNITS, count = 0;
+  struct NalUnit *result = enif_alloc(sizeof(struct NalUnit) * capacity);
+
+  int start = nal_find_start_code(data, size, 0);
+  while (start < size) {
+    int offset = start + 3;
+    int next = nal_find_start_code(data, size, offset);
+    int end = next;
+
+    while (end > offset && data[end - 1] == 0) {
+      end--;
+    }
+
+    if (end > offset) {
+      result = add_unit(result, count, &capacity);
+      result[count].type = nal_unit_type(codec_id, data + offset);
+      result[count].offset = offset;
+      result[count].size = end - offset;
+      count++;
+    }
+
+    start = next;
+  }
+
+  *units = result;
+  return count;
+}
+
+// Splits length prefixed nal units, returns -1 if a unit goes past the end
+// of the data.
+int nal_parse_avcc(const uint8_t *data, int size, int length_size,
+                   enum AVCodecID codec_id, struct NalUnit **units) {
+  int capacity = NAL_INITIAL_UNITS, count = 0;
+  struct NalUnit *result = enif_alloc(sizeof(struct NalUnit) * capacity);
+  int pos = 0;
+
+  while (pos + length_size <= size) {
+    uint32_t nal_size = 0;
+    for (int i = 0; i < length_size; i++) {
+      nal_size = (nal_size << 8) | data[pos + i];
+    }
+
+    pos += length_size;
+    if (nal_size > (uint32_t)(size - pos)) {
+      enif_free(result);
+      return -1;
+    }
+
+    if (nal_size > 0) {
+      result = add_unit(result, count, &capacity);
+      result[count].type = nal_unit_type(codec_id, data + pos);
+      result[count].offset = pos;
+      result[count].size = nal_size;
+      count++;
+    }
+
+    pos += nal_size;
+  }
+
+  if (pos != size) {
+    enif_free(result);
+    return -1;
+  }
+
+  *units = result;
+  return count;
+}
+
+int nal_annexb_size(struct NalUnit *units, int count) {
+  return nal_avcc_size(units, count, 4);
+}
+
+int nal_avcc_size(struct NalUnit *units, int count, int length_size) {
+  int size = 0;
+  for (int i = 0; i < count; i++) {
+    size += length_size + units[i].size;
+  }
+
+  return size;
+}
+
+// Copies the units after a 4 bytes start code, the offsets of the units are
+// updated to point to the output.
+void nal_write_annexb(const uint8_t *data, struct NalUnit *units, int count,
+                      uint8_t *out) {
+  int pos = 0;
+  for (int i = 0; i < count; i++) {
+    out[pos] = 0;
+    out[pos + 1] = 0;
+    out[pos + 2] = 0;
+    out[pos + 3] = 1;
+    pos += 4;
+
+    memcpy(out + pos, data + units[i].offset, units[i].size);
+    units[i].offset = pos;
+    pos += units[i].size;
+  }
+}
+
+void nal_write_avcc(const uint8_t *data, struct NalUnit *units, int count,
+                    int length_size, uint8_t *out) {
+  int pos = 0;
+  for (int i = 0; i < count; i++) {
+    uint32_t nal_size = units[i].size;
+    for (int j = length_size - 1; j >= 0; j--) {
+      out[pos + j] = nal_size & 0xFF;
+      nal_size >>= 8;
+    }
+    pos += length_size;
+
+    memcpy(out + pos, data + units[i].offset, units[i].size);
+    units[i].offset = pos;
+    pos += units[i].size;
+  }
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "utils.h"
+
+struct NalUnit {
+  int type;
+  // position of the nal header, the start code or length prefix excluded
+  int offset;
+  int size;
+};
+
+int nal_find_start_code(const uint8_t *data, int size, int offset);
+int nal_unit_type(enum AVCodecID codec_id, const uint8_t *nal);
+int nal_parse_annexb(const uint8_t *data, int size, enum AVCodecID codec_id,
+                     struct NalUnit **units);
+int nal_parse_avcc(const uint8_t *data, int size, int length_size,
+                   enum AVCodecID codec_id, struct NalUnit **units);
+int nal_annexb_size(struct NalUnit *units, int count);
+int nal_avcc_size(struct NalUnit *units, int count, int length_size);
+void nal_write_annexb(const uint8_t *data, struct NalUnit *units, int count,
+                      uint8_t *out);
+void nal_write_avcc(const uint8_t *data, struct NalUnit *units, int count,
+                    int length_size, uint8_t *out);
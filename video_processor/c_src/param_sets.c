@@ -0,0 +1,578 @@
+#include "param_sets.h"
+#include "nal.h"
+#include <libavutil/rational.h>
+
+#define RBSP_PADDING 8
+#define HEVC_MAX_SHORT_TERM_RPS 64
+// widest picture any level allows, bigger sizes come from corrupt parameter
+// sets
+#define MAX_CODED_SIZE 16888
+
+typedef struct BitReader {
+  uint8_t *data;
+  int size;
+  // position in bits
+  int64_t pos;
+} BitReader;
+
+// Copies the nal unit payload without the emulation prevention bytes, the
+// buffer is zero padded so the reader can always load 8 bytes.
+static int bit_reader_init(BitReader *br, const uint8_t *nal, int size,
+                           int header_size) {
+  br->data = enif_alloc(size + RBSP_PADDING);
+  br->size = 0;
+  br->pos = 0;
+
+  for (int i = header_size; i < size; i++) {
+    if (i + 2 < size && nal[i] == 0 && nal[i + 1] == 0 && nal[i + 2] == 3) {
+      br->data[br->size++] = 0;
+      br->data[br->size++] = 0;
+      i += 2;
+      continue;
+    }
+
+    br->data[br->size++] = nal[i];
+  }
+
+  memset(br->data + br->size, 0, RBSP_PADDING);
+  return br->size > 0 ? 0 : -1;
+}
+
+static void bit_reader_free(BitReader *br) { enif_free(br->data); }
+
+static inline int bit_reader_overrun(BitReader *br) {
+  return br->pos > (int64_t)br->size * 8;
+}
+
+static inline uint32_t peek_bits32(BitReader *br) {
+  int64_t byte = br->pos >> 3;
+  if (byte >= br->size) {
+    return 0;
+  }
+
+  const uint8_t *p = br->data + byte;
+  uint64_t cache = ((uint64_t)p[0] << 32) | ((uint64_t)p[1] << 24) |
+                   ((uint64_t)p[2] << 16) | ((uint64_t)p[3] << 8) | p[4];
+
+  return (uint32_t)(cache >> (8 - (br->pos & 7)));
+}
+
+static inline uint32_t read_bits(BitReader *br, int n) {
+  if (n == 0) {
+    return 0;
+  }
+
+  uint32_t value = peek_bits32(br) >> (32 - n);
+  br->pos += n;
+  return value;
+}
+
+static inline void skip_bits(BitReader *br, int n) { br->pos += n; }
+
+// Exp-Golomb codes are decoded from a single 32 bits window when the prefix
+// is short enough, which covers almost every value in parameter sets.
+static inline uint32_t read_ue(BitReader *br) {
+  uint32_t window = peek_bits32(br);
+  if (window == 0) {
+    // longer than what a parameter set may contain
+    br->pos = ((int64_t)br->size + 1) * 8;
+    return 0;
+  }
+
+  int leading_zeros = __builtin_clz(window);
+  if (leading_zeros < 16) {
+    br->pos += 2 * leading_zeros + 1;
+    return (window >> (31 - 2 * leading_zeros)) - 1;
+  }
+
+  skip_bits(br, leading_zeros);
+  return read_bits(br, leading_zeros + 1) - 1;
+}
+
+static inline int32_t read_se(BitReader *br) {
+  uint32_t value = read_ue(br);
+  return value & 1 ? (int32_t)((value + 1) >> 1) : -(int32_t)(value >> 1);
+}
+
+static void skip_h264_scaling_list(BitReader *br, int size) {
+  int last = 8, next = 8;
+  for (int i = 0; i < size && next != 0; i++) {
+    next = (last + read_se(br) + 256) % 256;
+    last = next == 0 ? last : next;
+  }
+}
+
+static void crop_units(int chroma_format, int *unit_x, int *unit_y) {
+  *unit_x = chroma_format == 1 || chroma_format == 2 ? 2 : 1;
+  *unit_y = chroma_format == 1 ? 2 : 1;
+}
+
+// Size of the cropped picture, -1 if the coded size or the crop is out of
+// range. The values are read from the bitstream and may be anything.
+static int cropped_size(uint64_t coded, int unit, uint32_t crop_start,
+                        uint32_t crop_end) {
+  if (coded > MAX_CODED_SIZE) {
+    return -1;
+  }
+
+  int64_t size = (int64_t)coded - unit * ((int64_t)crop_start + crop_end);
+  return size > 0 ? (int)size : -1;
+}
+
+int param_sets_parse_h264_sps(const uint8_t *nal, int size,
+                              struct StreamInfo *info) {
+  BitReader br;
+  if (bit_reader_init(&br, nal, size, 1) < 0) {
+    bit_reader_free(&br);
+    return -1;
+  }
+
+  info->profile = read_bits(&br, 8);
+  skip_bits(&br, 8);
+  info->level = read_bits(&br, 8);
+  read_ue(&br);
+
+  info->chroma_format = 1;
+  info->bit_depth = 8;
+
+  switch (info->profile) {
+  case 100: case 110: case 122: case 244: case 44: case 83:
+  case 86: case 118: case 128: case 138: case 139: case 134: case 135: {
+    // checked before narrowing, huge values would turn negative
+    uint32_t chroma_format = read_ue(&br);
+    if (chroma_format > 3) {
+      bit_reader_free(&br);
+      return -1;
+    }
+
+    info->chroma_format = chroma_format;
+    if (info->chroma_format == 3) {
+      skip_bits(&br, 1);
+    }
+
+    uint32_t bit_depth = read_ue(&br);
+    if (bit_depth > 8) {
+      bit_reader_free(&br);
+      return -1;
+    }
+
+    info->bit_depth = bit_depth + 8;
+    read_ue(&br);
+    skip_bits(&br, 1);
+
+    if (read_bits(&br, 1)) {
+      int count = info->chroma_format == 3 ? 12 : 8;
+      for (int i = 0; i < count; i++) {
+        if (read_bits(&br, 1)) {
+          skip_h264_scaling_list(&br, i < 6 ? 16 : 64);
+        }
+      }
+    }
+    break;
+  }
+  }
+
+  read_ue(&br);
+  uint32_t poc_type = read_ue(&br);
+  if (poc_type == 0) {
+    read_ue(&br);
+  } else if (poc_type == 1) {
+    skip_bits(&br, 1);
+    read_se(&br);
+    read_se(&br);
+    uint32_t cycle = read_ue(&br);
+    for (uint32_t i = 0; i < cycle && !bit_reader_overrun(&br); i++) {
+      read_se(&br);
+    }
+  }
+
+  read_ue(&br);
+  skip_bits(&br, 1);
+
+  uint64_t width_mbs = (uint64_t)read_ue(&br) + 1;
+  uint64_t height_map_units = (uint64_t)read_ue(&br) + 1;
+  int frame_mbs_only = read_bits(&br, 1);
+  if (!frame_mbs_only) {
+    skip_bits(&br, 1);
+  }
+  skip_bits(&br, 1);
+
+  uint32_t crop_left = 0, crop_right = 0, crop_top = 0, crop_bottom = 0;
+  if (read_bits(&br, 1)) {
+    crop_left = read_ue(&br);
+    crop_right = read_ue(&br);
+    crop_top = read_ue(&br);
+    crop_bottom = read_ue(&br);
+  }
+
+  int unit_x, unit_y;
+  crop_units(info->chroma_format, &unit_x, &unit_y);
+  if (info->chroma_format == 0) {
+    unit_x = 1;
+    unit_y = 1;
+  }
+  unit_y *= 2 - frame_mbs_only;
+
+  info->width = cropped_size(width_mbs * 16, unit_x, crop_left, crop_right);
+  info->height = cropped_size((2 - frame_mbs_only) * height_map_units * 16,
+                              unit_y, crop_top, crop_bottom);
+
+  info->full_range = 0;
+  info->frame_rate_num = 0;
+  info->frame_rate_den = 0;
+
+  if (read_bits(&br, 1)) {
+    if (read_bits(&br, 1) && read_bits(&br, 8) == 255) {
+      skip_bits(&br, 32);
+    }
+
+    if (read_bits(&br, 1)) {
+      skip_bits(&br, 1);
+    }
+
+    if (read_bits(&br, 1)) {
+      skip_bits(&br, 3);
+      info->full_range = read_bits(&br, 1);
+      if (read_bits(&br, 1)) {
+        skip_bits(&br, 24);
+      }
+    }
+
+    if (read_bits(&br, 1)) {
+      read_ue(&br);
+      read_ue(&br);
+    }
+
+    if (read_bits(&br, 1)) {
+      uint32_t num_units_in_tick = read_bits(&br, 32);
+      uint32_t time_scale = read_bits(&br, 32);
+      if (num_units_in_tick > 0 && time_scale > 0 &&
+          !bit_reader_overrun(&br)) {
+        // a frame is made of two fields
+        int64_t den = 2 * (int64_t)num_units_in_tick;
+        av_reduce(&info->frame_rate_num, &info->frame_rate_den, time_scale,
+                  den, INT32_MAX);
+      }
+    }
+  }
+
+  int ret = bit_reader_overrun(&br) || info->width <= 0 || info->height <= 0
+                ? -1
+                : 0;
+  bit_reader_free(&br);
+  return ret;
+}
+
+static void parse_hevc_profile_tier_level(BitReader *br, int max_sub_layers,
+                                          struct StreamInfo *info) {
+  skip_bits(br, 3);
+  info->profile = read_bits(br, 5);
+  skip_bits(br, 32 + 48);
+  info->level = read_bits(br, 8);
+
+  int sub_layer_profile[8] = {0}, sub_layer_level[8] = {0};
+  for (int i = 0; i < max_sub_layers - 1; i++) {
+    sub_layer_profile[i] = read_bits(br, 1);
+    sub_layer_level[i] = read_bits(br, 1);
+  }
+
+  if (max_sub_layers > 1) {
+    skip_bits(br, 2 * (9 - max_sub_layers));
+  }
+
+  for (int i = 0; i < max_sub_layers - 1; i++) {
+    if (sub_layer_profile[i]) {
+      skip_bits(br, 88);
+    }
+
+    if (sub_layer_level[i]) {
+      skip_bits(br, 8);
+    }
+  }
+}
+
+static void skip_hevc_scaling_list_data(BitReader *br) {
+  for (int size_id = 0; size_id < 4; size_id++) {
+    for (int matrix_id = 0; matrix_id < 6; matrix_id += size_id == 3 ? 3 : 1) {
+      if (!read_bits(br, 1)) {
+        read_ue(br);
+        continue;
+      }
+
+      int coef_num = FFMIN(64, 1 << (4 + (size_id << 1)));
+      if (size_id > 1) {
+        read_se(br);
+      }
+
+      for (int i = 0; i < coef_num; i++) {
+        read_se(br);
+      }
+    }
+  }
+}
+
+static int skip_hevc_short_term_rps(BitReader *br, int idx,
+                                    int *num_delta_pocs) {
+  if (idx != 0 && read_bits(br, 1)) {
+    skip_bits(br, 1);
+    read_ue(br);
+
+    int ref_idx = idx - 1;
+    int count = 0;
+    for (int j = 0; j <= num_delta_pocs[ref_idx]; j++) {
+      int used = read_bits(br, 1);
+      int use_delta = used ? 1 : read_bits(br, 1);
+      count += use_delta;
+    }
+
+    num_delta_pocs[idx] = count;
+    return 0;
+  }
+
+  uint32_t num_negative = read_ue(br);
+  uint32_t num_positive = read_ue(br);
+  if (num_negative > 16 || num_positive > 16) {
+    return -1;
+  }
+
+  for (uint32_t i = 0; i < num_negative + num_positive; i++) {
+    read_ue(br);
+    skip_bits(br, 1);
+  }
+
+  num_delta_pocs[idx] = num_negative + num_positive;
+  return 0;
+}
+
+int param_sets_parse_hevc_sps(const uint8_t *nal, int size,
+                              struct StreamInfo *info) {
+  BitReader br;
+  int num_delta_pocs[HEVC_MAX_SHORT_TERM_RPS];
+  int ret = -1;
+
+  if (bit_reader_init(&br, nal, size, 2) < 0) {
+    goto clean;
+  }
+
+  skip_bits(&br, 4);
+  int max_sub_layers = read_bits(&br, 3) + 1;
+  skip_bits(&br, 1);
+  parse_hevc_profile_tier_level(&br, max_sub_layers, info);
+  read_ue(&br);
+
+  uint32_t chroma_format = read_ue(&br);
+  if (chroma_format > 3) {
+    goto clean;
+  }
+
+  info->chroma_format = chroma_format;
+  if (info->chroma_format == 3) {
+    skip_bits(&br, 1);
+  }
+
+  uint32_t coded_width = read_ue(&br);
+  uint32_t coded_height = read_ue(&br);
+  uint32_t crop[4] = {0};
+
+  if (read_bits(&br, 1)) {
+    for (int i = 0; i < 4; i++) {
+      crop[i] = read_ue(&br);
+    }
+  }
+
+  int unit_x, unit_y;
+  crop_units(info->chroma_format, &unit_x, &unit_y);
+  info->width = cropped_size(coded_width, unit_x, crop[0], crop[1]);
+  info->height = cropped_size(coded_height, unit_y, crop[2], crop[3]);
+
+  uint32_t bit_depth = read_ue(&br);
+  if (bit_depth > 8) {
+    goto clean;
+  }
+
+  info->bit_depth = bit_depth + 8;
+  read_ue(&br);
+  int log2_max_poc_lsb = read_ue(&br) + 4;
+
+  int ordering_info = read_bits(&br, 1);
+  for (int i = ordering_info ? 0 : max_sub_layers - 1; i < max_sub_layers;
+       i++) {
+    read_ue(&br);
+    read_ue(&br);
+    read_ue(&br);
+  }
+
+  for (int i = 0; i < 6; i++) {
+    read_ue(&br);
+  }
+
+  if (read_bits(&br, 1) && read_bits(&br, 1)) {
+    skip_hevc_scaling_list_data(&br);
+  }
+
+  skip_bits(&br, 2);
+  if (read_bits(&br, 1)) {
+    skip_bits(&br, 8);
+    read_ue(&br);
+    read_ue(&br);
+    skip_bits(&br, 1);
+  }
+
+  uint32_t num_short_term_rps = read_ue(&br);
+  if (num_short_term_rps > HEVC_MAX_SHORT_TERM_RPS) {
+    goto clean;
+  }
+
+  for (uint32_t i = 0; i < num_short_term_rps; i++) {
+    if (skip_hevc_short_term_rps(&br, i, num_delta_pocs) < 0) {
+      goto clean;
+    }
+  }
+
+  if (read_bits(&br, 1)) {
+    uint32_t num_long_term = read_ue(&br);
+    for (uint32_t i = 0; i < num_long_term && !bit_reader_overrun(&br); i++) {
+      skip_bits(&br, log2_max_poc_lsb + 1);
+    }
+  }
+
+  skip_bits(&br, 2);
+
+  info->full_range = 0;
+  if (read_bits(&br, 1)) {
+    if (read_bits(&br, 1) && read_bits(&br, 8) == 255) {
+      skip_bits(&br, 32);
+    }
+
+    if (read_bits(&br, 1)) {
+      skip_bits(&br, 1);
+    }
+
+    if (read_bits(&br, 1)) {
+      skip_bits(&br, 3);
+      info->full_range = read_bits(&br, 1);
+      if (read_bits(&br, 1)) {
+        skip_bits(&br, 24);
+      }
+    }
+
+    if (read_bits(&br, 1)) {
+      read_ue(&br);
+      read_ue(&br);
+    }
+
+    skip_bits(&br, 3);
+    if (read_bits(&br, 1)) {
+      for (int i = 0; i < 4; i++) {
+        read_ue(&br);
+      }
+    }
+
+    if (read_bits(&br, 1)) {
+      uint32_t num_units_in_tick = read_bits(&br, 32);
+      uint32_t time_scale = read_bits(&br, 32);
+      if (num_units_in_tick > 0 && time_scale > 0 &&
+          !bit_reader_overrun(&br)) {
+        av_reduce(&info->frame_rate_num, &info->frame_rate_den, time_scale,
+                  num_units_in_tick, INT32_MAX);
+      }
+    }
+  }
+
+  ret = bit_reader_overrun(&br) || info->width <= 0 || info->height <= 0
+            ? -1
+            : 0;
+
+clean:
+  bit_reader_free(&br);
+  return ret;
+}
+
+// Only the timing information is read from the vps, it's used when the sps
+// doesn't have it.
+int param_sets_parse_hevc_vps(const uint8_t *nal, int size,
+                              struct StreamInfo *info) {
+  BitReader br;
+  int ret = -1;
+
+  if (bit_reader_init(&br, nal, size, 2) < 0) {
+    goto clean;
+  }
+
+  skip_bits(&br, 12);
+  int max_sub_layers = read_bits(&br, 3) + 1;
+  skip_bits(&br, 17);
+
+  struct StreamInfo ptl;
+  parse_hevc_profile_tier_level(&br, max_sub_layers, &ptl);
+
+  int ordering_info = read_bits(&br, 1);
+  for (int i = ordering_info ? 0 : max_sub_layers - 1; i < max_sub_layers;
+       i++) {
+    read_ue(&br);
+    read_ue(&br);
+    read_ue(&br);
+  }
+
+  int max_layer_id = read_bits(&br, 6);
+  uint32_t num_layer_sets = read_ue(&br) + 1;
+  if (num_layer_sets > 1024) {
+    goto clean;
+  }
+
+  skip_bits(&br, (num_layer_sets - 1) * (max_layer_id + 1));
+
+  if (read_bits(&br, 1)) {
+    uint32_t num_units_in_tick = read_bits(&br, 32);
+    uint32_t time_scale = read_bits(&br, 32);
+    if (num_units_in_tick > 0 && time_scale > 0 && !bit_reader_overrun(&br)) {
+      av_reduce(&info->frame_rate_num, &info->frame_rate_den, time_scale,
+                num_units_in_tick, INT32_MAX);
+    }
+  }
+
+  ret = bit_reader_overrun(&br) ? -1 : 0;
+
+clean:
+  bit_reader_free(&br);
+  return ret;
+}
+
+// Looks for the parameter sets in an annex b buffer, the sps is required.
+int param_sets_parse(const uint8_t *data, int size, enum AVCodecID codec_id,
+                     struct StreamInfo *info) {
+  struct NalUnit *units;
+  int count = nal_parse_annexb(data, size, codec_id, &units);
+  int found_sps = 0, ret = 0;
+
+  info->frame_rate_num = 0;
+  info->frame_rate_den = 0;
+
+  for (int i = 0; i < count && ret == 0; i++) {
+    const uint8_t *nal = data + units[i].offset;
+    int nal_size = units[i].size;
+
+    if (codec_id == AV_CODEC_ID_H264 && units[i].type == 7 && !found_sps) {
+      ret = param_sets_parse_h264_sps(nal, nal_size, info);
+      found_sps = 1;
+    } else if (codec_id == AV_CODEC_ID_HEVC && units[i].type == 33 &&
+               !found_sps) {
+      // the frame rate read from the vps is kept if the sps has none
+      ret = param_sets_parse_hevc_sps(nal, nal_size, info);
+      found_sps = 1;
+    } else if (codec_id == AV_CODEC_ID_HEVC && units[i].type == 32 &&
+               info->frame_rate_num == 0) {
+      // a broken vps doesn't prevent reading the sps
+      param_sets_parse_hevc_vps(nal, nal_size, info);
+    }
+  }
+
+  enif_free(units);
+
+  if (ret < 0 || !found_sps || info->chroma_format > 3 ||
+      info->bit_depth > 16) {
+    return -1;
+  }
+
+  return 0;
+}
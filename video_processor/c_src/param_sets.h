@@ -0,0 +1,26 @@
+#pragma once
+
+#include "utils.h"
+
+struct StreamInfo {
+  int width;
+  int height;
+  int profile;
+  int level;
+  // 0: monochrome, 1: 4:2:0, 2: 4:2:2, 3: 4:4:4
+  int chroma_format;
+  int bit_depth;
+  int full_range;
+  // 0 when the stream has no timing information
+  int frame_rate_num;
+  int frame_rate_den;
+};
+
+int param_sets_parse_h264_sps(const uint8_t *nal, int size,
+                              struct StreamInfo *info);
+int param_sets_parse_hevc_sps(const uint8_t *nal, int size,
+                              struct StreamInfo *info);
+int param_sets_parse_hevc_vps(const uint8_t *nal, int size,
+                              struct StreamInfo *info);
+int param_sets_parse(const uint8_t *data, int size, enum AVCodecID codec_id,
+                     struct StreamInfo *info);
@@ -0,0 +1,351 @@
+#include "privacy_mask.h"
+#include "simd.h"
+
+#include <math.h>
+
+static int rasterize(const struct PrivacyMaskShape *shapes, int num_shapes,
+                     double sx, double sy, int width, int height, int box[4],
+                     uint8_t **cover);
+static int init_plane(PrivacyMask *mask, const AVPixFmtDescriptor *desc,
+                      int plane, const int box[4], const uint8_t *cover,
+                      int block_size);
+static void pixelate_plane(const PrivacyMask *mask,
+                           const struct PrivacyMaskPlane *plane, uint8_t *data,
+                           int linesize);
+
+static void blend_row_c(uint8_t *dst, const uint8_t *mask, const uint8_t *fill,
+                        int size) {
+  for (int i = 0; i < size; i++) {
+    dst[i] ^= (dst[i] ^ fill[i]) & mask[i];
+  }
+}
+
+#ifdef NVR_HAVE_X86
+NVR_TARGET_AVX2 static void blend_row_avx2(uint8_t *dst, const uint8_t *mask,
+                                           const uint8_t *fill, int size) {
+  int i = 0;
+
+  for (; i + 32 <= size; i += 32) {
+    __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+    __m256i m = _mm256_loadu_si256((const __m256i *)(mask + i));
+    __m256i f = _mm256_loadu_si256((const __m256i *)(fill + i));
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_blendv_epi8(d, f, m));
+  }
+
+  blend_row_c(dst + i, mask + i, fill + i, size - i);
+}
+#endif
+
+#ifdef NVR_HAVE_NEON
+static void blend_row_neon(uint8_t *dst, const uint8_t *mask,
+                           const uint8_t *fill, int size) {
+  int i = 0;
+
+  for (; i + 16 <= size; i += 16) {
+    uint8x16_t m = vld1q_u8(mask + i);
+    vst1q_u8(dst + i, vbslq_u8(m, vld1q_u8(fill + i), vld1q_u8(dst + i)));
+  }
+
+  blend_row_c(dst + i, mask + i, fill + i, size - i);
+}
+#endif
+
+static PrivacyMaskRowFn blend_row_fn(void) {
+#ifdef NVR_HAVE_X86
+  if (nvr_cpu_has_avx2()) {
+    return blend_row_avx2;
+  }
+#endif
+#ifdef NVR_HAVE_NEON
+  if (nvr_cpu_has_neon()) {
+    return blend_row_neon;
+  }
+#endif
+  return blend_row_c;
+}
+
+PrivacyMask *privacy_mask_alloc(void) {
+  PrivacyMask *mask = (PrivacyMask *)enif_alloc(sizeof(PrivacyMask));
+  memset(mask, 0, sizeof(PrivacyMask));
+  return mask;
+}
+
+int privacy_mask_init(PrivacyMask *mask, const struct PrivacyMaskShape *shapes,
+                      int num_shapes, int in_width, int in_height, int width,
+                      int height, enum AVPixelFormat format,
+                      enum PrivacyMaskMode mode, int block_size) {
+  const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+  if (!desc || desc->flags & (AV_PIX_FMT_FLAG_HWACCEL |
+                              AV_PIX_FMT_FLAG_BITSTREAM |
+                              AV_PIX_FMT_FLAG_PAL)) {
+    return -1;
+  }
+
+  for (int i = 0; i < desc->nb_components; i++) {
+    if (desc->comp[i].depth != 8 || desc->comp[i].shift != 0 ||
+        desc->comp[i].step > 8) {
+      return -1;
+    }
+  }
+
+  if (in_width <= 0 || in_height <= 0 || num_shapes > PRIVACY_MASK_MAX_SHAPES ||
+      block_size < 1 || block_size > PRIVACY_MASK_MAX_BLOCK) {
+    return -1;
+  }
+
+  int box[4];
+  uint8_t *cover = NULL;
+
+  mask->mode = mode;
+  mask->row = blend_row_fn();
+  mask->num_planes = av_pix_fmt_count_planes(format);
+
+  int ret = rasterize(shapes, num_shapes, (double)width / in_width,
+                      (double)height / in_height, width, height, box, &cover);
+
+  for (int i = 0; ret == 0 && i < mask->num_planes; i++) {
+    ret = init_plane(mask, desc, i, box, cover, block_size);
+  }
+
+  if (cover) {
+    enif_free(cover);
+  }
+
+  return ret;
+}
+
+// Coverage of the luma samples in the bounding box of the shapes, a sample is
+// covered when its center is inside one of them. box is [x0, y0, x1, y1).
+static int rasterize(const struct PrivacyMaskShape *shapes, int num_shapes,
+                     double sx, double sy, int width, int height, int box[4],
+                     uint8_t **cover) {
+  double min_x = width, min_y = height, max_x = 0, max_y = 0;
+
+  for (int s = 0; s < num_shapes; s++) {
+    if (shapes[s].num_points < 3 ||
+        shapes[s].num_points > PRIVACY_MASK_MAX_POINTS) {
+      return -1;
+    }
+
+    for (int i = 0; i < shapes[s].num_points; i++) {
+      min_x = FFMIN(min_x, shapes[s].x[i] * sx);
+      max_x = FFMAX(max_x, shapes[s].x[i] * sx);
+      min_y = FFMIN(min_y, shapes[s].y[i] * sy);
+      max_y = FFMAX(max_y, shapes[s].y[i] * sy);
+    }
+  }
+
+  box[0] = av_clip((int)floor(min_x), 0, width);
+  box[1] = av_clip((int)floor(min_y), 0, height);
+  box[2] = av_clip((int)ceil(max_x), 0, width);
+  box[3] = av_clip((int)ceil(max_y), 0, height);
+
+  if (box[0] >= box[2] || box[1] >= box[3]) {
+    box[2] = box[0];
+    return 0;
+  }
+
+  int box_width = box[2] - box[0];
+  *cover = (uint8_t *)enif_alloc(box_width * (box[3] - box[1]));
+  memset(*cover, 0, box_width * (box[3] - box[1]));
+
+  for (int s = 0; s < num_shapes; s++) {
+    const struct PrivacyMaskShape *shape = &shapes[s];
+
+    for (int y = box[1]; y < box[3]; y++) {
+      double center = y + 0.5;
+      double xs[PRIVACY_MASK_MAX_POINTS];
+      int num_xs = 0;
+
+      for (int i = 0, j = shape->num_points - 1; i < shape->num_points;
+           j = i++) {
+        double y0 = shape->y[j] * sy, y1 = shape->y[i] * sy;
+        if ((y0 <= center) == (y1 <= center)) {
+          continue;
+        }
+
+        double x0 = shape->x[j] * sx, x1 = shape->x[i] * sx;
+        double x = x0 + (center - y0) * (x1 - x0) / (y1 - y0);
+
+        // insertion sort, there are only a few crossings per row
+        int k = num_xs++;
+        for (; k > 0 && xs[k - 1] > x; k--) {
+          xs[k] = xs[k - 1];
+        }
+        xs[k] = x;
+      }
+
+      uint8_t *row = *cover + (y - box[1]) * box_width;
+      for (int i = 0; i + 1 < num_xs; i += 2) {
+        int start = av_clip((int)ceil(xs[i] - 0.5), box[0], box[2]);
+        int end = av_clip((int)ceil(xs[i + 1] - 0.5), box[0], box[2]);
+        if (end > start) {
+          memset(row + start - box[0], 1, end - start);
+        }
+      }
+    }
+  }
+
+  return 0;
+}
+
+// A sample of a subsampled plane is masked if any of the luma samples it
+// covers is, each of its bytes is then masked unless it holds alpha.
+static int init_plane(PrivacyMask *mask, const AVPixFmtDescriptor *desc,
+                      int plane, const int box[4], const uint8_t *cover,
+                      int block_size) {
+  struct PrivacyMaskPlane *p = &mask->planes[plane];
+  uint8_t masked[8] = {0}, color[8] = {0};
+  int is_yuv = !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+  int full_range =
+      desc->nb_components < 3 || strncmp(desc->name, "yuvj", 4) == 0;
+  int log2_w = 0, log2_h = 0;
+
+  p->step = 0;
+  for (int i = 0; i < desc->nb_components; i++) {
+    const AVComponentDescriptor *comp = &desc->comp[i];
+    if (comp->plane != plane) {
+      continue;
+    }
+
+    p->step = FFMAX(p->step, comp->step);
+    if ((desc->flags & AV_PIX_FMT_FLAG_ALPHA) && i == desc->nb_components - 1) {
+      continue;
+    }
+
+    masked[comp->offset] = 0xff;
+    if (is_yuv && (i == 1 || i == 2)) {
+      color[comp->offset] = 128;
+      log2_w = desc->log2_chroma_w;
+      log2_h = desc->log2_chroma_h;
+    } else if (is_yuv && !full_range) {
+      color[comp->offset] = 16;
+    }
+  }
+
+  p->x = box[0] >> log2_w;
+  p->y = box[1] >> log2_h;
+  p->width = AV_CEIL_RSHIFT(box[2], log2_w) - p->x;
+  p->height = AV_CEIL_RSHIFT(box[3], log2_h) - p->y;
+  p->block = FFMAX(block_size >> log2_w, 1);
+
+  if (box[0] >= box[2] || !memchr(masked, 0xff, p->step)) {
+    p->width = 0;
+    return 0;
+  }
+
+  int bytes = p->width * p->step;
+  int box_width = box[2] - box[0];
+
+  p->bitmap = (uint8_t *)enif_alloc(bytes * p->height);
+  p->fill = (uint8_t *)enif_alloc(bytes);
+
+  for (int x = 0; x < p->width; x++) {
+    memcpy(p->fill + x * p->step, color, p->step);
+  }
+
+  for (int y = 0; y < p->height; y++) {
+    int luma_y0 = FFMAX((p->y + y) << log2_h, box[1]);
+    int luma_y1 = FFMIN((p->y + y + 1) << log2_h, box[3]);
+    uint8_t *row = p->bitmap + y * bytes;
+
+    for (int x = 0; x < p->width; x++) {
+      int luma_x0 = FFMAX((p->x + x) << log2_w, box[0]);
+      int luma_x1 = FFMIN((p->x + x + 1) << log2_w, box[2]);
+      int covered = 0;
+
+      for (int j = luma_y0; j < luma_y1 && !covered; j++) {
+        const uint8_t *src = cover + (j - box[1]) * box_width - box[0];
+        for (int i = luma_x0; i < luma_x1; i++) {
+          covered |= src[i];
+        }
+      }
+
+      for (int k = 0; k < p->step; k++) {
+        row[x * p->step + k] = covered ? masked[k] : 0;
+      }
+    }
+  }
+
+  return 0;
+}
+
+void privacy_mask_apply(const PrivacyMask *mask, uint8_t *const data[4],
+                        const int linesize[4]) {
+  for (int i = 0; i < mask->num_planes; i++) {
+    const struct PrivacyMaskPlane *p = &mask->planes[i];
+    if (p->width == 0) {
+      continue;
+    }
+
+    uint8_t *dst = data[i] + p->y * linesize[i] + p->x * p->step;
+
+    if (mask->mode == PRIVACY_MASK_PIXELATE && p->block > 1) {
+      pixelate_plane(mask, p, dst, linesize[i]);
+      continue;
+    }
+
+    int bytes = p->width * p->step;
+    for (int y = 0; y < p->height; y++) {
+      mask->row(dst + y * linesize[i], p->bitmap + y * bytes, p->fill, bytes);
+    }
+  }
+}
+
+// The blocks start at the corner of the bounding box, the masked samples of
+// a block are replaced by its mean. All the means of a block are computed
+// before it's written so the plane can be masked in place.
+static void pixelate_plane(const PrivacyMask *mask,
+                           const struct PrivacyMaskPlane *plane, uint8_t *data,
+                           int linesize) {
+  uint8_t fill[PRIVACY_MASK_MAX_BLOCK * 8];
+  int step = plane->step, block = plane->block;
+  int bytes = plane->width * step;
+
+  for (int by = 0; by < plane->height; by += block) {
+    int rows = FFMIN(block, plane->height - by);
+
+    for (int bx = 0; bx < plane->width; bx += block) {
+      int cols = FFMIN(block, plane->width - bx);
+      int count = rows * cols;
+      uint8_t *src = data + by * linesize + bx * step;
+      const uint8_t *bitmap = plane->bitmap + by * bytes + bx * step;
+
+      for (int k = 0; k < step; k++) {
+        int sum = 0;
+        for (int j = 0; j < rows; j++) {
+          for (int i = 0; i < cols; i++) {
+            sum += src[j * linesize + i * step + k];
+          }
+        }
+
+        uint8_t mean = (sum + count / 2) / count;
+        for (int i = 0; i < cols; i++) {
+          fill[i * step + k] = mean;
+        }
+      }
+
+      for (int j = 0; j < rows; j++) {
+        mask->row(src + j * linesize, bitmap + j * bytes, fill, cols * step);
+      }
+    }
+  }
+}
+
+void privacy_mask_free(PrivacyMask **mask) {
+  PrivacyMask *m = *mask;
+  if (m != NULL) {
+    for (int i = 0; i < 4; i++) {
+      if (m->planes[i].bitmap) {
+        enif_free(m->planes[i].bitmap);
+      }
+
+      if (m->planes[i].fill) {
+        enif_free(m->planes[i].fill);
+      }
+    }
+
+    enif_free(m);
+    *mask = NULL;
+  }
+}
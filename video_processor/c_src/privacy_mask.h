@@ -0,0 +1,68 @@
+#pragma once
+
+#include <libavutil/pixdesc.h>
+#include <stdint.h>
+
+#include "utils.h"
+
+#define PRIVACY_MASK_MAX_SHAPES 16
+#define PRIVACY_MASK_MAX_POINTS 32
+#define PRIVACY_MASK_MAX_BLOCK 64
+
+// Blacks out or pixelates polygons of 8 bits frames. The polygons are
+// rasterized once, for the size and format of the frames, into a bitmap per
+// plane covering only their bounding box. Applying the mask then only blends
+// the masked bytes of that box with the fill.
+
+// A polygon, filled with the even-odd rule. The points are in pixels of the
+// frames given to init, they're scaled to the masked frames.
+struct PrivacyMaskShape {
+  int x[PRIVACY_MASK_MAX_POINTS];
+  int y[PRIVACY_MASK_MAX_POINTS];
+  int num_points;
+};
+
+enum PrivacyMaskMode { PRIVACY_MASK_FILL, PRIVACY_MASK_PIXELATE };
+
+// dst[i] = mask[i] ? fill[i] : dst[i], mask bytes are either 0 or 0xff
+typedef void (*PrivacyMaskRowFn)(uint8_t *dst, const uint8_t *mask,
+                                 const uint8_t *fill, int size);
+
+struct PrivacyMaskPlane {
+  // bounding box of the masked samples, width is 0 when there's none
+  int x;
+  int y;
+  int width;
+  int height;
+  // bytes per sample
+  int step;
+  // pixelation block, in samples of the plane
+  int block;
+  // width * step bytes per row of the box
+  uint8_t *bitmap;
+  // one row of the box with the black color
+  uint8_t *fill;
+};
+
+typedef struct PrivacyMask {
+  enum PrivacyMaskMode mode;
+  int num_planes;
+  struct PrivacyMaskPlane planes[4];
+  PrivacyMaskRowFn row;
+} PrivacyMask;
+
+PrivacyMask *privacy_mask_alloc(void);
+
+// in_width and in_height are the dimensions the shapes are relative to,
+// block_size is the pixelation block in pixels of the luma plane. Returns
+// a negative value if the format is not supported.
+int privacy_mask_init(PrivacyMask *mask, const struct PrivacyMaskShape *shapes,
+                      int num_shapes, int in_width, int in_height, int width,
+                      int height, enum AVPixelFormat format,
+                      enum PrivacyMaskMode mode, int block_size);
+
+// The mask is only read, it may be shared by threads masking other frames
+void privacy_mask_apply(const PrivacyMask *mask, uint8_t *const data[4],
+                        const int linesize[4]);
+
+void privacy_mask_free(PrivacyMask **mask);
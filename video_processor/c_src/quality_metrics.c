@@ -0,0 +1,383 @@
+#include "quality_metrics.h"
+#include "simd.h"
+#include <libavutil/intreadwrite.h>
+#include <libavutil/pixdesc.h>
+
+static void compute_histogram(QualityMetrics *metrics, const uint8_t *data,
+                              int stride, int width, int height,
+                              uint32_t *histogram);
+static int reduce_luma(QualityMetrics *metrics, AVFrame *frame,
+                       const AVPixFmtDescriptor *desc);
+
+static void stats_row_c(const uint8_t *row, int n, uint64_t *sum,
+                        uint64_t *sum_sq) {
+  uint64_t s = 0, sq = 0;
+  for (int i = 0; i < n; i++) {
+    s += row[i];
+    sq += row[i] * row[i];
+  }
+
+  *sum += s;
+  *sum_sq += sq;
+}
+
+// 4-neighbour laplacian of row[0..n), the caller makes sure row[-1] and
+// row[n] are readable.
+static void laplacian_row_c(const uint8_t *up, const uint8_t *row,
+                            const uint8_t *down, int n, int64_t *sum,
+                            uint64_t *sum_sq) {
+  int64_t s = 0;
+  uint64_t sq = 0;
+  for (int i = 0; i < n; i++) {
+    int lap = 4 * row[i] - up[i] - down[i] - row[i - 1] - row[i + 1];
+    s += lap;
+    sq += lap * lap;
+  }
+
+  *sum += s;
+  *sum_sq += sq;
+}
+
+#ifdef NVR_HAVE_X86
+NVR_TARGET_AVX2 static void stats_row_avx2(const uint8_t *row, int n,
+                                           uint64_t *sum, uint64_t *sum_sq) {
+  __m256i zero = _mm256_setzero_si256();
+  __m256i acc_sum = zero;
+  __m256i acc_sq = zero;
+  uint64_t sums[4];
+  uint32_t squares[8];
+  int i = 0;
+
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i *)(row + i));
+    __m256i lo = _mm256_unpacklo_epi8(v, zero);
+    __m256i hi = _mm256_unpackhi_epi8(v, zero);
+
+    acc_sum = _mm256_add_epi64(acc_sum, _mm256_sad_epu8(v, zero));
+    acc_sq = _mm256_add_epi32(acc_sq, _mm256_madd_epi16(lo, lo));
+    acc_sq = _mm256_add_epi32(acc_sq, _mm256_madd_epi16(hi, hi));
+  }
+
+  _mm256_storeu_si256((__m256i *)sums, acc_sum);
+  _mm256_storeu_si256((__m256i *)squares, acc_sq);
+
+  for (int j = 0; j < 4; j++)
+    *sum += sums[j];
+
+  for (int j = 0; j < 8; j++)
+    *sum_sq += squares[j];
+
+  stats_row_c(row + i, n - i, sum, sum_sq);
+}
+
+NVR_TARGET_AVX2 static void laplacian_row_avx2(const uint8_t *up,
+                                               const uint8_t *row,
+                                               const uint8_t *down, int n,
+                                               int64_t *sum, uint64_t *sum_sq) {
+  __m256i ones = _mm256_set1_epi16(1);
+  __m256i acc_sum = _mm256_setzero_si256();
+  __m256i acc_sq = _mm256_setzero_si256();
+  int32_t sums[8];
+  uint64_t squares[4];
+  int i = 0;
+
+#define LOAD_EPI16(ptr) \
+  _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(ptr)))
+
+  for (; i + 16 <= n; i += 16) {
+    __m256i lap = _mm256_slli_epi16(LOAD_EPI16(row + i), 2);
+    lap = _mm256_sub_epi16(lap, LOAD_EPI16(up + i));
+    lap = _mm256_sub_epi16(lap, LOAD_EPI16(down + i));
+    lap = _mm256_sub_epi16(lap, LOAD_EPI16(row + i - 1));
+    lap = _mm256_sub_epi16(lap, LOAD_EPI16(row + i + 1));
+
+    // squares may reach 2 * 1020^2 per lane, widen them before accumulating
+    __m256i sq = _mm256_madd_epi16(lap, lap);
+    acc_sum = _mm256_add_epi32(acc_sum, _mm256_madd_epi16(lap, ones));
+    acc_sq = _mm256_add_epi64(
+        acc_sq, _mm256_cvtepu32_epi64(_mm256_castsi256_si128(sq)));
+    acc_sq = _mm256_add_epi64(
+        acc_sq, _mm256_cvtepu32_epi64(_mm256_extracti128_si256(sq, 1)));
+  }
+
+#undef LOAD_EPI16
+
+  _mm256_storeu_si256((__m256i *)sums, acc_sum);
+  _mm256_storeu_si256((__m256i *)squares, acc_sq);
+
+  for (int j = 0; j < 8; j++)
+    *sum += sums[j];
+
+  for (int j = 0; j < 4; j++)
+    *sum_sq += squares[j];
+
+  laplacian_row_c(up + i, row + i, down + i, n - i, sum, sum_sq);
+}
+#endif
+
+#ifdef NVR_HAVE_NEON
+static void stats_row_neon(const uint8_t *row, int n, uint64_t *sum,
+                           uint64_t *sum_sq) {
+  uint32x4_t acc_sum = vdupq_n_u32(0);
+  uint32x4_t acc_sq = vdupq_n_u32(0);
+  int i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    uint8x16_t v = vld1q_u8(row + i);
+    uint16x8_t lo = vmovl_u8(vget_low_u8(v));
+    uint16x8_t hi = vmovl_u8(vget_high_u8(v));
+
+    acc_sum = vpadalq_u16(acc_sum, vpaddlq_u8(v));
+    acc_sq = vmlal_u16(acc_sq, vget_low_u16(lo), vget_low_u16(lo));
+    acc_sq = vmlal_u16(acc_sq, vget_high_u16(lo), vget_high_u16(lo));
+    acc_sq = vmlal_u16(acc_sq, vget_low_u16(hi), vget_low_u16(hi));
+    acc_sq = vmlal_u16(acc_sq, vget_high_u16(hi), vget_high_u16(hi));
+  }
+
+  uint64x2_t s = vpaddlq_u32(acc_sum);
+  uint64x2_t sq = vpaddlq_u32(acc_sq);
+  *sum += vgetq_lane_u64(s, 0) + vgetq_lane_u64(s, 1);
+  *sum_sq += vgetq_lane_u64(sq, 0) + vgetq_lane_u64(sq, 1);
+
+  stats_row_c(row + i, n - i, sum, sum_sq);
+}
+
+static void laplacian_row_neon(const uint8_t *up, const uint8_t *row,
+                               const uint8_t *down, int n, int64_t *sum,
+                               uint64_t *sum_sq) {
+  int32x4_t acc_sum = vdupq_n_s32(0);
+  uint64x2_t acc_sq = vdupq_n_u64(0);
+  int i = 0;
+
+#define LOAD_S16(ptr) vreinterpretq_s16_u16(vmovl_u8(vld1_u8(ptr)))
+
+  for (; i + 8 <= n; i += 8) {
+    int16x8_t lap = vshlq_n_s16(LOAD_S16(row + i), 2);
+    lap = vsubq_s16(lap, LOAD_S16(up + i));
+    lap = vsubq_s16(lap, LOAD_S16(down + i));
+    lap = vsubq_s16(lap, LOAD_S16(row + i - 1));
+    lap = vsubq_s16(lap, LOAD_S16(row + i + 1));
+
+    int32x4_t sq_lo = vmull_s16(vget_low_s16(lap), vget_low_s16(lap));
+    int32x4_t sq_hi = vmull_s16(vget_high_s16(lap), vget_high_s16(lap));
+    acc_sum = vpadalq_s16(acc_sum, lap);
+    acc_sq = vpadalq_u32(acc_sq, vreinterpretq_u32_s32(sq_lo));
+    acc_sq = vpadalq_u32(acc_sq, vreinterpretq_u32_s32(sq_hi));
+  }
+
+#undef LOAD_S16
+
+  int64x2_t s = vpaddlq_s32(acc_sum);
+  *sum += vgetq_lane_s64(s, 0) + vgetq_lane_s64(s, 1);
+  *sum_sq += vgetq_lane_u64(acc_sq, 0) + vgetq_lane_u64(acc_sq, 1);
+
+  laplacian_row_c(up + i, row + i, down + i, n - i, sum, sum_sq);
+}
+#endif
+
+void quality_config_default(struct QualityConfig *config) {
+  config->interval = 1;
+  config->bins = 16;
+  config->uniformity_range = 8;
+}
+
+QualityMetrics *quality_metrics_alloc() {
+  QualityMetrics *metrics =
+      (QualityMetrics *)enif_alloc(sizeof(QualityMetrics));
+
+  quality_config_default(&metrics->config);
+  metrics->frame_count = 0;
+  // one histogram per unrolled lane avoids stalls on repeated values
+  metrics->histograms = enif_alloc(sizeof(uint32_t) * 4 * 256);
+  metrics->luma = NULL;
+  metrics->luma_size = 0;
+
+  metrics->stats_row = stats_row_c;
+  metrics->laplacian_row = laplacian_row_c;
+
+#ifdef NVR_HAVE_X86
+  if (nvr_cpu_has_avx2()) {
+    metrics->stats_row = stats_row_avx2;
+    metrics->laplacian_row = laplacian_row_avx2;
+  }
+#endif
+
+#ifdef NVR_HAVE_NEON
+  if (nvr_cpu_has_neon()) {
+    metrics->stats_row = stats_row_neon;
+    metrics->laplacian_row = laplacian_row_neon;
+  }
+#endif
+
+  return metrics;
+}
+
+int quality_metrics_init(QualityMetrics *metrics, struct QualityConfig *config) {
+  if (config->interval < 1 || config->bins < 1 ||
+      config->bins > QUALITY_MAX_BINS ||
+      (config->bins & (config->bins - 1)) != 0 ||
+      config->uniformity_range < 0 || config->uniformity_range > 255) {
+    return -1;
+  }
+
+  metrics->config = *config;
+  metrics->frame_count = 0;
+  return 0;
+}
+
+// Returns 1 when the metrics were computed for this frame, 0 when the frame
+// is skipped because of the configured interval.
+int quality_metrics_process(QualityMetrics *metrics, AVFrame *frame,
+                            struct QualityResult *result) {
+  const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+  if (!desc || (desc->flags & AV_PIX_FMT_FLAG_RGB)) {
+    return -1;
+  }
+
+  // high bit depth luma is reduced to 8 bits, only little endian 16 bits
+  // samples are supported
+  int high_depth = desc->comp[0].depth > 8;
+  if (high_depth && (desc->comp[0].step != 2 || desc->comp[0].depth > 16 ||
+                     (desc->flags & AV_PIX_FMT_FLAG_BE))) {
+    return -1;
+  }
+
+  if (metrics->frame_count++ % metrics->config.interval != 0) {
+    return 0;
+  }
+
+  const uint8_t *data = frame->data[0];
+  int stride = frame->linesize[0];
+  if (high_depth) {
+    if (reduce_luma(metrics, frame, desc) < 0) {
+      return -1;
+    }
+
+    data = metrics->luma;
+    stride = frame->width;
+  }
+
+  int width = frame->width, height = frame->height;
+  double pixels = (double)width * height;
+  uint64_t sum = 0, sum_sq = 0;
+  uint32_t histogram[256];
+
+  for (int y = 0; y < height; y++) {
+    metrics->stats_row(data + y * stride, width, &sum, &sum_sq);
+  }
+
+  result->mean = sum / pixels;
+  result->variance = sum_sq / pixels - result->mean * result->mean;
+
+  result->sharpness = 0.0;
+  if (width > 2 && height > 2) {
+    int64_t lap_sum = 0;
+    uint64_t lap_sum_sq = 0;
+
+    for (int y = 1; y < height - 1; y++) {
+      const uint8_t *row = data + y * stride + 1;
+      metrics->laplacian_row(row - stride, row, row + stride, width - 2,
+                             &lap_sum, &lap_sum_sq);
+    }
+
+    double count = (double)(width - 2) * (height - 2);
+    double lap_mean = lap_sum / count;
+    result->sharpness = lap_sum_sq / count - lap_mean * lap_mean;
+  }
+
+  compute_histogram(metrics, data, stride, width, height, histogram);
+
+  int peak = 0;
+  for (int i = 1; i < 256; i++) {
+    if (histogram[i] > histogram[peak]) {
+      peak = i;
+    }
+  }
+
+  int range = metrics->config.uniformity_range;
+  uint64_t uniform = 0;
+  for (int i = FFMAX(0, peak - range); i <= FFMIN(255, peak + range); i++) {
+    uniform += histogram[i];
+  }
+
+  result->uniformity = uniform / pixels;
+
+  int bins = metrics->config.bins;
+  int bin_width = 256 / bins;
+  result->num_bins = bins;
+  memset(result->histogram, 0, sizeof(uint32_t) * bins);
+  for (int i = 0; i < 256; i++) {
+    result->histogram[i / bin_width] += histogram[i];
+  }
+
+  return 1;
+}
+
+void quality_metrics_free(QualityMetrics **metrics) {
+  QualityMetrics *m = *metrics;
+  if (m != NULL) {
+    enif_free(m->histograms);
+    if (m->luma != NULL) {
+      enif_free(m->luma);
+    }
+    enif_free(m);
+    *metrics = NULL;
+  }
+}
+
+static void compute_histogram(QualityMetrics *metrics, const uint8_t *data,
+                              int stride, int width, int height,
+                              uint32_t *histogram) {
+  uint32_t(*h)[256] = metrics->histograms;
+  memset(h, 0, sizeof(uint32_t) * 4 * 256);
+
+  for (int y = 0; y < height; y++) {
+    const uint8_t *row = data + y * stride;
+    int x = 0;
+
+    for (; x + 4 <= width; x += 4) {
+      h[0][row[x]]++;
+      h[1][row[x + 1]]++;
+      h[2][row[x + 2]]++;
+      h[3][row[x + 3]]++;
+    }
+
+    for (; x < width; x++) {
+      h[0][row[x]]++;
+    }
+  }
+
+  for (int i = 0; i < 256; i++) {
+    histogram[i] = h[0][i] + h[1][i] + h[2][i] + h[3][i];
+  }
+}
+
+// Copies the luma plane of a high bit depth frame to the 8 bits buffer of the
+// metrics.
+static int reduce_luma(QualityMetrics *metrics, AVFrame *frame,
+                       const AVPixFmtDescriptor *desc) {
+  size_t size = (size_t)frame->width * frame->height;
+  int shift = desc->comp[0].shift + desc->comp[0].depth - 8;
+
+  if (metrics->luma_size < size) {
+    if (metrics->luma != NULL) {
+      enif_free(metrics->luma);
+    }
+
+    metrics->luma = enif_alloc(size);
+    metrics->luma_size = metrics->luma ? size : 0;
+    if (metrics->luma == NULL) {
+      return -1;
+    }
+  }
+
+  for (int y = 0; y < frame->height; y++) {
+    const uint8_t *src = frame->data[0] + y * frame->linesize[0];
+    uint8_t *dst = metrics->luma + (size_t)y * frame->width;
+    for (int x = 0; x < frame->width; x++) {
+      dst[x] = av_clip_uint8(AV_RL16(src + x * 2) >> shift);
+    }
+  }
+
+  return 0;
+}
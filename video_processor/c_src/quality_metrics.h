@@ -0,0 +1,52 @@
+#pragma once
+
+#include "utils.h"
+
+#define QUALITY_MAX_BINS 256
+
+typedef struct QualityMetrics QualityMetrics;
+
+typedef void (*QualityStatsRowFn)(const uint8_t *row, int n, uint64_t *sum,
+                                  uint64_t *sum_sq);
+typedef void (*QualityLaplacianRowFn)(const uint8_t *up, const uint8_t *row,
+                                      const uint8_t *down, int n, int64_t *sum,
+                                      uint64_t *sum_sq);
+
+struct QualityConfig {
+  // metrics are computed on one frame out of interval
+  int interval;
+  // number of bins of the returned luma histogram, a power of two
+  int bins;
+  // luma values within this distance of the histogram peak count as uniform
+  int uniformity_range;
+};
+
+struct QualityResult {
+  double mean;
+  double variance;
+  // variance of the laplacian, low values mean a blurry or defocused image
+  double sharpness;
+  // fraction of pixels close to the dominant luma value, close to 1 when the
+  // camera is covered or blinded
+  double uniformity;
+  int num_bins;
+  uint32_t histogram[QUALITY_MAX_BINS];
+};
+
+struct QualityMetrics {
+  struct QualityConfig config;
+  int64_t frame_count;
+  uint32_t (*histograms)[256];
+  // 8 bits copy of the luma plane of high bit depth frames
+  uint8_t *luma;
+  size_t luma_size;
+  QualityStatsRowFn stats_row;
+  QualityLaplacianRowFn laplacian_row;
+};
+
+void quality_config_default(struct QualityConfig *config);
+QualityMetrics *quality_metrics_alloc();
+int quality_metrics_init(QualityMetrics *metrics, struct QualityConfig *config);
+int quality_metrics_process(QualityMetrics *metrics, AVFrame *frame,
+                            struct QualityResult *result);
+void quality_metrics_free(QualityMetrics **metrics);
@@ -0,0 +1,292 @@
+#include "recording.h"
+#include <sys/mman.h>
+
+#define RECORDING_IO_BUFFER_SIZE 32768
+
+static int read_packet(void *opaque, uint8_t *buf, int buf_size);
+static int64_t seek(void *opaque, int64_t offset, int whence);
+static void keep_last_frame(Decoder *decoder, AVFrame *last);
+static int init_index_decoder(Recording *recording, KeyframeIndex *index);
+
+Recording *recording_alloc() {
+  Recording *recording = (Recording *)enif_alloc(sizeof(Recording));
+
+  recording->data = NULL;
+  recording->size = 0;
+  recording->pos = 0;
+  recording->avio = NULL;
+  recording->format_ctx = NULL;
+  recording->packet = av_packet_alloc();
+  recording->stream_index = -1;
+  recording->decoder = NULL;
+
+  return recording;
+}
+
+int recording_map(Recording *recording, const char *path) {
+  return nvr_map_file(path, &recording->data, &recording->size);
+}
+
+int recording_open(Recording *recording, const char *path) {
+  if (recording_map(recording, path) < 0) {
+    return -1;
+  }
+
+  uint8_t *buffer = av_malloc(RECORDING_IO_BUFFER_SIZE);
+  if (!buffer) {
+    return -1;
+  }
+
+  recording->avio = avio_alloc_context(buffer, RECORDING_IO_BUFFER_SIZE, 0,
+                                       recording, read_packet, NULL, seek);
+  if (!recording->avio) {
+    av_free(buffer);
+    return -1;
+  }
+
+  recording->format_ctx = avformat_alloc_context();
+  if (!recording->format_ctx) {
+    return -1;
+  }
+
+  recording->format_ctx->pb = recording->avio;
+  recording->format_ctx->flags |= AVFMT_FLAG_CUSTOM_IO;
+
+  // the timestamps are kept as stored in the samples table, the same ones
+  // used to index the recordings.
+  AVDictionary *opts = NULL;
+  av_dict_set(&opts, "ignore_editlist", "1", 0);
+
+  int ret = avformat_open_input(&recording->format_ctx, NULL, NULL, &opts);
+  av_dict_free(&opts);
+
+  if (ret < 0 || avformat_find_stream_info(recording->format_ctx, NULL) < 0) {
+    return -1;
+  }
+
+  recording->stream_index = av_find_best_stream(
+      recording->format_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+  if (recording->stream_index < 0) {
+    return -1;
+  }
+
+  AVStream *stream = recording->format_ctx->streams[recording->stream_index];
+
+  recording->decoder = decoder_alloc();
+  return decoder_init_by_parameters(recording->decoder, stream->codecpar);
+}
+
+// Seeks to the keyframe at or before `timestamp`. With the before method only
+// the keyframe is decoded, otherwise the packets are decoded up to the first
+// one with a decoding timestamp after the requested instant and the last frame
+// in presentation order is kept.
+int recording_decode_at(Recording *recording, int64_t timestamp,
+                        enum RecordingSeekMethod method, AVFrame *frame) {
+  AVFormatContext *format_ctx = recording->format_ctx;
+  AVStream *stream = format_ctx->streams[recording->stream_index];
+  AVPacket *packet = recording->packet;
+  Decoder *decoder = recording->decoder;
+  int sent = 0, ret = 0;
+
+  int64_t target = av_rescale_q(timestamp, AV_TIME_BASE_Q, stream->time_base);
+
+  if (av_seek_frame(format_ctx, recording->stream_index, target,
+                    AVSEEK_FLAG_BACKWARD) < 0) {
+    return -1;
+  }
+
+  while (ret >= 0 && (ret = av_read_frame(format_ctx, packet)) >= 0) {
+    if (packet->stream_index != recording->stream_index) {
+      av_packet_unref(packet);
+      continue;
+    }
+
+    int done = method == RECORDING_SEEK_BEFORE || packet->dts > target;
+    ret = decoder_decode(decoder, packet);
+    av_packet_unref(packet);
+
+    if (ret >= 0) {
+      sent = 1;
+      keep_last_frame(decoder, frame);
+    }
+
+    if (done) {
+      break;
+    }
+  }
+
+  // end of file, the frames still buffered in the decoder are the last ones
+  if ((ret >= 0 || ret == AVERROR_EOF) && sent) {
+    ret = decoder_flush(decoder);
+    keep_last_frame(decoder, frame);
+  }
+
+  decoder_reset(decoder);
+
+  if (ret < 0 || frame->buf[0] == NULL) {
+    av_frame_unref(frame);
+    return -1;
+  }
+
+  frame->pts = av_rescale_q(frame->pts, stream->time_base, AV_TIME_BASE_Q);
+  return 0;
+}
+
+// Decodes the keyframe at or before `timestamp` found in the sidecar index, the
+// recording only needs to be mapped.
+int recording_decode_keyframe(Recording *recording, KeyframeIndex *index,
+                              int64_t timestamp, AVFrame *frame) {
+  struct KeyframeIndexEntry entry;
+  AVPacket *packet = recording->packet;
+
+  if (index->count == 0) {
+    return -1;
+  }
+
+  int position = keyframe_index_search(index, timestamp);
+  keyframe_index_entry(index, position < 0 ? 0 : position, &entry);
+
+  if (entry.offset < 0 || entry.offset + entry.size > recording->size) {
+    return -1;
+  }
+
+  if (recording->decoder == NULL && init_index_decoder(recording, index) < 0) {
+    return -1;
+  }
+
+  // the mapping has no padding after the access unit, it's copied
+  if (av_new_packet(packet, entry.size) < 0) {
+    return -1;
+  }
+
+  memcpy(packet->data, recording->data + entry.offset, entry.size);
+  packet->pts = entry.timestamp;
+  packet->dts = entry.timestamp;
+
+  int ret = decoder_decode(recording->decoder, packet);
+  av_packet_unref(packet);
+
+  if (ret >= 0) {
+    keep_last_frame(recording->decoder, frame);
+    ret = decoder_flush(recording->decoder);
+    keep_last_frame(recording->decoder, frame);
+  }
+
+  decoder_reset(recording->decoder);
+
+  if (ret < 0 || frame->buf[0] == NULL) {
+    av_frame_unref(frame);
+    return -1;
+  }
+
+  frame->pts = entry.timestamp;
+  return 0;
+}
+
+void recording_free(Recording **recording) {
+  Recording *r = *recording;
+  if (r != NULL) {
+    decoder_free(&r->decoder);
+
+    if (r->format_ctx != NULL) {
+      avformat_close_input(&r->format_ctx);
+    }
+
+    if (r->avio != NULL) {
+      av_freep(&r->avio->buffer);
+      avio_context_free(&r->avio);
+    }
+
+    if (r->packet != NULL) {
+      av_packet_free(&r->packet);
+    }
+
+    if (r->data != NULL) {
+      munmap(r->data, r->size);
+    }
+
+    enif_free(r);
+    *recording = NULL;
+  }
+}
+
+static int read_packet(void *opaque, uint8_t *buf, int buf_size) {
+  Recording *recording = (Recording *)opaque;
+  int64_t remaining = recording->size - recording->pos;
+
+  if (remaining <= 0) {
+    return AVERROR_EOF;
+  }
+
+  int size = remaining < buf_size ? remaining : buf_size;
+  memcpy(buf, recording->data + recording->pos, size);
+  recording->pos += size;
+
+  return size;
+}
+
+static int64_t seek(void *opaque, int64_t offset, int whence) {
+  Recording *recording = (Recording *)opaque;
+  int64_t pos;
+
+  switch (whence & ~AVSEEK_FORCE) {
+  case AVSEEK_SIZE:
+    return recording->size;
+  case SEEK_SET:
+    pos = offset;
+    break;
+  case SEEK_CUR:
+    pos = recording->pos + offset;
+    break;
+  case SEEK_END:
+    pos = recording->size + offset;
+    break;
+  default:
+    return -1;
+  }
+
+  if (pos < 0 || pos > recording->size) {
+    return -1;
+  }
+
+  recording->pos = pos;
+  return pos;
+}
+
+static void keep_last_frame(Decoder *decoder, AVFrame *last) {
+  for (int i = 0; i < decoder->count_frames; i++) {
+    AVFrame *frame = decoder->frames[i];
+
+    if (last->buf[0] == NULL || frame->pts > last->pts) {
+      av_frame_unref(last);
+      av_frame_move_ref(last, frame);
+    } else {
+      av_frame_unref(frame);
+    }
+  }
+
+  decoder->count_frames = 0;
+}
+
+static int init_index_decoder(Recording *recording, KeyframeIndex *index) {
+  AVCodecParameters *params = avcodec_parameters_alloc();
+  if (!params) {
+    return -1;
+  }
+
+  params->codec_type = AVMEDIA_TYPE_VIDEO;
+  params->codec_id = index->codec_id;
+
+  if (index->extradata_size > 0) {
+    params->extradata =
+        av_mallocz(index->extradata_size + AV_INPUT_BUFFER_PADDING_SIZE);
+    params->extradata_size = index->extradata_size;
+    memcpy(params->extradata, index->extradata, index->extradata_size);
+  }
+
+  recording->decoder = decoder_alloc();
+  int ret = decoder_init_by_parameters(recording->decoder, params);
+  avcodec_parameters_free(&params);
+
+  return ret;
+}
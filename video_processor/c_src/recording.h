@@ -0,0 +1,35 @@
+#pragma once
+
+#include "decoder.h"
+#include "keyframe_index.h"
+#include "utils.h"
+#include <libavformat/avformat.h>
+
+typedef struct Recording Recording;
+
+enum RecordingSeekMethod { RECORDING_SEEK_BEFORE, RECORDING_SEEK_PRECISE };
+
+// A recording opened from a memory mapping of the file, the demuxer reads the
+// mapped pages directly and only the samples needed are touched.
+struct Recording {
+  uint8_t *data;
+  int64_t size;
+  int64_t pos;
+  AVIOContext *avio;
+  AVFormatContext *format_ctx;
+  AVPacket *packet;
+  int stream_index;
+  Decoder *decoder;
+};
+
+Recording *recording_alloc();
+// maps the file without demuxing it, enough to decode from a keyframe index
+int recording_map(Recording *recording, const char *path);
+int recording_open(Recording *recording, const char *path);
+// decodes the frame shown at `timestamp` (in microseconds from the start of
+// the stream) and moves it to `frame`, its pts is set in microseconds.
+int recording_decode_at(Recording *recording, int64_t timestamp,
+                        enum RecordingSeekMethod method, AVFrame *frame);
+int recording_decode_keyframe(Recording *recording, KeyframeIndex *index,
+                              int64_t timestamp, AVFrame *frame);
+void recording_free(Recording **recording);
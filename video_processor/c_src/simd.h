@@ -0,0 +1,33 @@
+#pragma once
+
+#include <libavutil/cpu.h>
+
+// Vectorized kernels are compiled for the widest instruction set the compiler
+// supports and selected at runtime from the CPU flags reported by libavutil.
+
+#if defined(__x86_64__) || defined(__i386__)
+#define NVR_HAVE_X86 1
+#include <immintrin.h>
+#define NVR_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+#if defined(__ARM_NEON) || defined(__aarch64__)
+#define NVR_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+
+static inline int nvr_cpu_has_avx2(void) {
+#ifdef NVR_HAVE_X86
+  return (av_get_cpu_flags() & AV_CPU_FLAG_AVX2) != 0;
+#else
+  return 0;
+#endif
+}
+
+static inline int nvr_cpu_has_neon(void) {
+#ifdef NVR_HAVE_NEON
+  return 1;
+#else
+  return 0;
+#endif
+}
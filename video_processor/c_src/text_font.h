@@ -0,0 +1,883 @@
+#pragma once
+
+#include <stdint.h>
+
+// DejaVu Sans Mono rendered without antialiasing at 26 pixels per em, for the
+// printable ascii characters (32 to 126). Each glyph is a cell of
+// TEXT_FONT_HEIGHT rows, the bits of a row from the most significant one are
+// the TEXT_FONT_WIDTH columns of the cell.
+//
+// DejaVu fonts are based on Bitstream Vera:
+// Copyright (c) 2003 by Bitstream, Inc. All Rights Reserved. Bitstream Vera is
+// a trademark of Bitstream, Inc. DejaVu changes are in public domain.
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of the fonts accompanying this license ("Fonts") and associated
+// documentation files (the "Font Software"), to reproduce and distribute the
+// Font Software, including without limitation the rights to use, copy, merge,
+// publish, distribute, and/or sell copies of the Font Software, and to permit
+// persons to whom the Font Software is furnished to do so, subject to the
+// conditions of the Bitstream Vera license.
+
+#define TEXT_FONT_WIDTH 17
+#define TEXT_FONT_HEIGHT 32
+#define TEXT_FONT_FIRST 32
+#define TEXT_FONT_LAST 126
+
+static const uint32_t text_font_rows[TEXT_FONT_LAST - TEXT_FONT_FIRST + 1]
+                                    [TEXT_FONT_HEIGHT] = {
+    // space
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // !
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x00000000, 0x00000000, 0x00000000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // "
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x06300000, 0x06300000, 0x06300000, 0x06300000, 0x06300000, 0x06300000,
+        0x06300000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // #
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x018c0000, 0x030c0000, 0x031c0000, 0x03180000, 0x03180000,
+        0x7fff0000, 0x7fff0000, 0x06300000, 0x06300000, 0x0c300000, 0x0c600000,
+        0xfffe0000, 0xfffe0000, 0x18600000, 0x18c00000, 0x18c00000, 0x38c00000,
+        0x31c00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // $
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00800000,
+        0x00800000, 0x00800000, 0x03f00000, 0x0ff80000, 0x1e880000, 0x1c800000,
+        0x1c800000, 0x1c800000, 0x1e800000, 0x0f800000, 0x07f00000, 0x01f80000,
+        0x00bc0000, 0x009c0000, 0x009c0000, 0x009c0000, 0x10b80000, 0x1ff80000,
+        0x0fe00000, 0x00800000, 0x00800000, 0x00800000, 0x00800000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // %
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x3c000000, 0x7e000000, 0xe7000000, 0xc3000000, 0xc3000000, 0xe7000000,
+        0x7e0c0000, 0x3c380000, 0x00e00000, 0x03800000, 0x0e000000, 0x38780000,
+        0x60fc0000, 0x01ce0000, 0x01860000, 0x01860000, 0x01ce0000, 0x00fc0000,
+        0x00780000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // &
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x07c00000, 0x0fe00000, 0x1e200000, 0x1c000000, 0x1c000000, 0x1c000000,
+        0x0e000000, 0x0f000000, 0x1f000000, 0x3f830000, 0x33c30000, 0x71e30000,
+        0x70e30000, 0x70f60000, 0x707e0000, 0x783c0000, 0x3c3e0000, 0x1fee0000,
+        0x0fcf0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // '
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000,
+        0x01800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // (
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00600000,
+        0x00c00000, 0x00c00000, 0x01800000, 0x01800000, 0x03800000, 0x03800000,
+        0x07000000, 0x07000000, 0x07000000, 0x07000000, 0x07000000, 0x07000000,
+        0x07000000, 0x07000000, 0x07000000, 0x03800000, 0x03800000, 0x01800000,
+        0x01800000, 0x00c00000, 0x00c00000, 0x00600000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // )
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x06000000,
+        0x03000000, 0x03000000, 0x01800000, 0x01800000, 0x01c00000, 0x01c00000,
+        0x00c00000, 0x00e00000, 0x00e00000, 0x00e00000, 0x00e00000, 0x00e00000,
+        0x00e00000, 0x00e00000, 0x00c00000, 0x01c00000, 0x01c00000, 0x01800000,
+        0x01800000, 0x03000000, 0x03000000, 0x06000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // *
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x01000000, 0x01000000, 0x31180000, 0x39380000, 0x0fe00000, 0x03800000,
+        0x03800000, 0x0fe00000, 0x39380000, 0x31180000, 0x01000000, 0x01000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // +
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x01800000, 0x01800000,
+        0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x7ffe0000, 0x7ffe0000,
+        0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // ,
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x03000000, 0x07000000, 0x06000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // -
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x07f00000,
+        0x07f00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // .
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // /
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x001c0000, 0x00380000, 0x00380000, 0x00700000, 0x00700000, 0x00e00000,
+        0x00e00000, 0x01c00000, 0x01c00000, 0x03800000, 0x03800000, 0x03800000,
+        0x07000000, 0x07000000, 0x0e000000, 0x0e000000, 0x1c000000, 0x1c000000,
+        0x38000000, 0x38000000, 0x70000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // 0
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x03c00000, 0x0ff00000, 0x1e780000, 0x1c380000, 0x1c380000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x3b9c0000, 0x3b9c0000, 0x3b9c0000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x1c380000, 0x1c380000, 0x1e780000, 0x0ff00000,
+        0x03c00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // 1
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x07c00000, 0x1fc00000, 0x19c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x1ffc0000,
+        0x1ffc0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // 2
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x0fc00000, 0x3ff00000, 0x38780000, 0x203c0000, 0x001c0000, 0x001c0000,
+        0x001c0000, 0x003c0000, 0x003c0000, 0x00780000, 0x00f00000, 0x01e00000,
+        0x03c00000, 0x07800000, 0x0f000000, 0x1e000000, 0x38000000, 0x3ffc0000,
+        0x3ffc0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // 3
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x07e00000, 0x1ff00000, 0x10380000, 0x001c0000, 0x001c0000, 0x001c0000,
+        0x001c0000, 0x00780000, 0x07f00000, 0x07e00000, 0x00780000, 0x003c0000,
+        0x001c0000, 0x001c0000, 0x001c0000, 0x003c0000, 0x20780000, 0x3ff00000,
+        0x0fc00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // 4
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00e00000, 0x01e00000, 0x01e00000, 0x03e00000, 0x06e00000, 0x06e00000,
+        0x0ce00000, 0x0ce00000, 0x18e00000, 0x30e00000, 0x30e00000, 0x60e00000,
+        0x7ffc0000, 0x7ffc0000, 0x00e00000, 0x00e00000, 0x00e00000, 0x00e00000,
+        0x00e00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // 5
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x1ff80000, 0x1ff80000, 0x1c000000, 0x1c000000, 0x1c000000, 0x1c000000,
+        0x1fe00000, 0x1ff00000, 0x10780000, 0x00380000, 0x001c0000, 0x001c0000,
+        0x001c0000, 0x001c0000, 0x001c0000, 0x00380000, 0x20780000, 0x3ff00000,
+        0x1fc00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // 6
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x03f00000, 0x07f80000, 0x0f080000, 0x1c000000, 0x1c000000, 0x38000000,
+        0x38000000, 0x39e00000, 0x3bf80000, 0x3c380000, 0x3c1c0000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x181c0000, 0x1c1c0000, 0x1c380000, 0x0ff00000,
+        0x03e00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // 7
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x3ffc0000, 0x3ffc0000, 0x00380000, 0x00380000, 0x00780000, 0x00700000,
+        0x00700000, 0x00f00000, 0x00e00000, 0x00e00000, 0x01c00000, 0x01c00000,
+        0x03c00000, 0x03800000, 0x03800000, 0x07800000, 0x07000000, 0x07000000,
+        0x0e000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // 8
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x07e00000, 0x1ff80000, 0x1c380000, 0x381c0000, 0x381c0000, 0x381c0000,
+        0x381c0000, 0x1c380000, 0x07e00000, 0x0ff00000, 0x1c380000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x381c0000, 0x381c0000, 0x1c380000, 0x1ff80000,
+        0x07e00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // 9
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x07c00000, 0x0ff00000, 0x1c380000, 0x38380000, 0x38180000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x383c0000, 0x1c3c0000, 0x1fdc0000, 0x079c0000,
+        0x001c0000, 0x003c0000, 0x00380000, 0x00380000, 0x10f00000, 0x1fe00000,
+        0x0fc00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // :
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // ;
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x03000000, 0x07000000, 0x06000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // <
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00040000, 0x003c0000,
+        0x00fc0000, 0x03e00000, 0x1f800000, 0x7c000000, 0x70000000, 0x7c000000,
+        0x1f800000, 0x03e00000, 0x00fc0000, 0x003c0000, 0x00040000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // =
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x7ffc0000, 0x7ffc0000, 0x00000000, 0x00000000, 0x00000000,
+        0x7ffc0000, 0x7ffc0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // >
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x40000000, 0x78000000,
+        0x7e000000, 0x0f800000, 0x03f00000, 0x007c0000, 0x001c0000, 0x007c0000,
+        0x03f00000, 0x0f800000, 0x7e000000, 0x78000000, 0x40000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // ?
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x07c00000, 0x0ff00000, 0x18780000, 0x10380000, 0x00380000, 0x00780000,
+        0x00f00000, 0x01e00000, 0x01c00000, 0x03c00000, 0x03800000, 0x03800000,
+        0x03800000, 0x03800000, 0x00000000, 0x00000000, 0x03800000, 0x03800000,
+        0x03800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // @
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x01f80000, 0x07fc0000, 0x0e0e0000, 0x1c060000, 0x38030000,
+        0x30030000, 0x307b0000, 0x61ff0000, 0x61870000, 0x63030000, 0x63030000,
+        0x63030000, 0x63030000, 0x61870000, 0x61ff0000, 0x307b0000, 0x30000000,
+        0x18000000, 0x1c000000, 0x0f040000, 0x07fc0000, 0x01fc0000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // A
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x01c00000, 0x03e00000, 0x03e00000, 0x03e00000, 0x03e00000, 0x07700000,
+        0x07700000, 0x07700000, 0x0e380000, 0x0e380000, 0x0e380000, 0x1c1c0000,
+        0x1ffc0000, 0x1ffc0000, 0x3c1e0000, 0x380e0000, 0x380e0000, 0x780f0000,
+        0x70070000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // B
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x7f800000, 0x7fe00000, 0x70e00000, 0x70700000, 0x70700000, 0x70700000,
+        0x70700000, 0x70e00000, 0x7fc00000, 0x7fc00000, 0x70700000, 0x70300000,
+        0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70700000, 0x7ff00000,
+        0x7fc00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // C
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x03f00000, 0x0ff80000, 0x1e180000, 0x3c080000, 0x38000000, 0x70000000,
+        0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000,
+        0x70000000, 0x70000000, 0x38000000, 0x38080000, 0x1e180000, 0x0ff80000,
+        0x03f00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // D
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x7f000000, 0x7fc00000, 0x70e00000, 0x70700000, 0x70700000, 0x70380000,
+        0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70380000,
+        0x70380000, 0x70380000, 0x70700000, 0x70700000, 0x70e00000, 0x7fc00000,
+        0x7f000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // E
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x7ff80000, 0x7ff80000, 0x70000000, 0x70000000, 0x70000000, 0x70000000,
+        0x70000000, 0x70000000, 0x7ff00000, 0x7ff00000, 0x70000000, 0x70000000,
+        0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x7ff80000,
+        0x7ff80000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // F
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x7ff80000, 0x7ff80000, 0x70000000, 0x70000000, 0x70000000, 0x70000000,
+        0x70000000, 0x70000000, 0x7ff00000, 0x7ff00000, 0x70000000, 0x70000000,
+        0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000,
+        0x70000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // G
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x03f00000, 0x0ff80000, 0x1e180000, 0x38080000, 0x38000000, 0x70000000,
+        0x70000000, 0x70000000, 0x70000000, 0x70fc0000, 0x70fc0000, 0x701c0000,
+        0x701c0000, 0x701c0000, 0x381c0000, 0x381c0000, 0x1c1c0000, 0x0ffc0000,
+        0x03f00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // H
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70380000,
+        0x70380000, 0x70380000, 0x7ff80000, 0x7ff80000, 0x70380000, 0x70380000,
+        0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70380000,
+        0x70380000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // I
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x1ffc0000, 0x1ffc0000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x1ffc0000,
+        0x1ffc0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // J
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x0ff00000, 0x0ff00000, 0x00700000, 0x00700000, 0x00700000, 0x00700000,
+        0x00700000, 0x00700000, 0x00700000, 0x00700000, 0x00700000, 0x00700000,
+        0x00700000, 0x00700000, 0x00700000, 0x40700000, 0x60e00000, 0x7fe00000,
+        0x1f800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // K
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x700e0000, 0x701c0000, 0x70380000, 0x70700000, 0x70e00000, 0x71c00000,
+        0x73800000, 0x77000000, 0x7f000000, 0x7f800000, 0x7bc00000, 0x71c00000,
+        0x71e00000, 0x70f00000, 0x70700000, 0x70780000, 0x703c0000, 0x701c0000,
+        0x701e0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // L
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000,
+        0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000,
+        0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x7ff80000,
+        0x7ff80000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // M
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x783c0000, 0x783c0000, 0x7c7c0000, 0x7c7c0000, 0x7c7c0000, 0x745c0000,
+        0x76dc0000, 0x76dc0000, 0x729c0000, 0x739c0000, 0x739c0000, 0x739c0000,
+        0x701c0000, 0x701c0000, 0x701c0000, 0x701c0000, 0x701c0000, 0x701c0000,
+        0x701c0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // N
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x78380000, 0x78380000, 0x7c380000, 0x7c380000, 0x7c380000, 0x76380000,
+        0x76380000, 0x76380000, 0x73380000, 0x73380000, 0x73380000, 0x71b80000,
+        0x71b80000, 0x71b80000, 0x70f80000, 0x70f80000, 0x70f80000, 0x70780000,
+        0x70780000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // O
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x07c00000, 0x1ff00000, 0x1c700000, 0x38380000, 0x38380000, 0x701c0000,
+        0x701c0000, 0x701c0000, 0x701c0000, 0x701c0000, 0x701c0000, 0x701c0000,
+        0x701c0000, 0x701c0000, 0x38380000, 0x38380000, 0x3c700000, 0x1ff00000,
+        0x07c00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // P
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x7fc00000, 0x7fe00000, 0x70700000, 0x70380000, 0x70380000, 0x70380000,
+        0x70380000, 0x70380000, 0x70700000, 0x7ff00000, 0x7fc00000, 0x70000000,
+        0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000, 0x70000000,
+        0x70000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // Q
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x07c00000, 0x1ff00000, 0x1c700000, 0x38380000, 0x38380000, 0x701c0000,
+        0x701c0000, 0x701c0000, 0x701c0000, 0x701c0000, 0x701c0000, 0x701c0000,
+        0x701c0000, 0x701c0000, 0x38380000, 0x38380000, 0x3c700000, 0x1ff00000,
+        0x07c00000, 0x00e00000, 0x00780000, 0x00300000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // R
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x7fc00000, 0x7fe00000, 0x70700000, 0x70380000, 0x70380000, 0x70380000,
+        0x70380000, 0x70380000, 0x70700000, 0x7fe00000, 0x7fc00000, 0x71e00000,
+        0x70f00000, 0x70700000, 0x70780000, 0x70380000, 0x703c0000, 0x701c0000,
+        0x701e0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // S
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x0fe00000, 0x1ff00000, 0x3c300000, 0x70100000, 0x70000000, 0x70000000,
+        0x78000000, 0x7e000000, 0x3fc00000, 0x1ff00000, 0x01f00000, 0x00780000,
+        0x00380000, 0x00380000, 0x00380000, 0x40380000, 0x70f00000, 0x7fe00000,
+        0x1fc00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // T
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x7fff0000, 0x7fff0000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // U
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70380000,
+        0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x70380000,
+        0x70380000, 0x70380000, 0x70380000, 0x70380000, 0x38700000, 0x1fe00000,
+        0x0fc00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // V
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x700e0000, 0x781e0000, 0x381c0000, 0x381c0000, 0x381c0000, 0x1c380000,
+        0x1c380000, 0x1c380000, 0x1e780000, 0x0e700000, 0x0e700000, 0x0e700000,
+        0x07e00000, 0x07e00000, 0x07e00000, 0x07e00000, 0x03c00000, 0x03c00000,
+        0x03c00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // W
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0xe0070000, 0xe0070000, 0xe0070000, 0x700e0000, 0x700e0000, 0x718e0000,
+        0x73ce0000, 0x73ce0000, 0x73ce0000, 0x73ce0000, 0x3e5c0000, 0x3e7c0000,
+        0x3e7c0000, 0x3e7c0000, 0x3c3c0000, 0x3c3c0000, 0x1c3c0000, 0x1c380000,
+        0x1c180000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // X
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x780f0000, 0x3c1e0000, 0x1c1c0000, 0x1e3c0000, 0x0f780000, 0x07700000,
+        0x07f00000, 0x03e00000, 0x01c00000, 0x01c00000, 0x03e00000, 0x07e00000,
+        0x07700000, 0x0f780000, 0x0e380000, 0x1e3c0000, 0x3c1c0000, 0x380e0000,
+        0x780f0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // Y
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x780f0000, 0x380e0000, 0x3c1e0000, 0x1c1c0000, 0x0e380000, 0x0f780000,
+        0x07700000, 0x07f00000, 0x03e00000, 0x03e00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // Z
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x7ffc0000, 0x7ffc0000, 0x003c0000, 0x00780000, 0x00700000, 0x00f00000,
+        0x00e00000, 0x01e00000, 0x03c00000, 0x03800000, 0x07800000, 0x0f000000,
+        0x0e000000, 0x1e000000, 0x1c000000, 0x3c000000, 0x78000000, 0x7ffc0000,
+        0x7ffc0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // [
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x03f00000,
+        0x03f00000, 0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x03800000, 0x03f00000, 0x03f00000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // backslash
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x70000000, 0x38000000, 0x38000000, 0x1c000000, 0x1c000000, 0x0e000000,
+        0x0e000000, 0x07000000, 0x07000000, 0x03800000, 0x03800000, 0x03800000,
+        0x01c00000, 0x01c00000, 0x00e00000, 0x00e00000, 0x00700000, 0x00700000,
+        0x00380000, 0x00380000, 0x001c0000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // ]
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0fc00000,
+        0x0fc00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x0fc00000, 0x0fc00000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // ^
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x03c00000, 0x03c00000, 0x07e00000, 0x0e700000, 0x1c380000, 0x381c0000,
+        0x700e0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // _
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xffff0000,
+        0xffff0000, 0x00000000,
+    },
+    // `
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x0e000000, 0x07000000,
+        0x03000000, 0x01800000, 0x00c00000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // a
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x07e00000,
+        0x1ff80000, 0x10380000, 0x001c0000, 0x001c0000, 0x07fc0000, 0x1ffc0000,
+        0x3c1c0000, 0x381c0000, 0x381c0000, 0x383c0000, 0x3c7c0000, 0x1fdc0000,
+        0x0f9c0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // b
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x38000000,
+        0x38000000, 0x38000000, 0x38000000, 0x38000000, 0x38000000, 0x39e00000,
+        0x3ff00000, 0x3c380000, 0x3c380000, 0x381c0000, 0x381c0000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x381c0000, 0x3c380000, 0x3c380000, 0x3ff00000,
+        0x39e00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // c
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x03e00000,
+        0x0ff00000, 0x1e180000, 0x1c000000, 0x38000000, 0x38000000, 0x38000000,
+        0x38000000, 0x38000000, 0x38000000, 0x1c000000, 0x1e180000, 0x0ff00000,
+        0x03e00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // d
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x001c0000,
+        0x001c0000, 0x001c0000, 0x001c0000, 0x001c0000, 0x001c0000, 0x079c0000,
+        0x0ffc0000, 0x1c7c0000, 0x3c3c0000, 0x381c0000, 0x381c0000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x381c0000, 0x1c3c0000, 0x1c7c0000, 0x0ffc0000,
+        0x079c0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // e
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x03f00000,
+        0x0ff80000, 0x1e3c0000, 0x1c1c0000, 0x380e0000, 0x380e0000, 0x3ffe0000,
+        0x3ffe0000, 0x38000000, 0x38000000, 0x1c000000, 0x1e0c0000, 0x0ffc0000,
+        0x03f00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // f
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00fc0000,
+        0x01fc0000, 0x03c00000, 0x03800000, 0x03800000, 0x03800000, 0x3ffc0000,
+        0x3ffc0000, 0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // g
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x079c0000,
+        0x0ffc0000, 0x1e3c0000, 0x1c3c0000, 0x381c0000, 0x381c0000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x381c0000, 0x1c3c0000, 0x1e3c0000, 0x0fdc0000,
+        0x079c0000, 0x001c0000, 0x001c0000, 0x08380000, 0x0ff00000, 0x07e00000,
+        0x00000000, 0x00000000,
+    },
+    // h
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x38000000,
+        0x38000000, 0x38000000, 0x38000000, 0x38000000, 0x38000000, 0x39e00000,
+        0x3bf00000, 0x3c780000, 0x38380000, 0x38380000, 0x38380000, 0x38380000,
+        0x38380000, 0x38380000, 0x38380000, 0x38380000, 0x38380000, 0x38380000,
+        0x38380000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // i
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x00000000, 0x00000000, 0x00000000, 0x1fc00000,
+        0x1fc00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x3ffe0000,
+        0x3ffe0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // j
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00e00000,
+        0x00e00000, 0x00e00000, 0x00000000, 0x00000000, 0x00000000, 0x0fe00000,
+        0x0fe00000, 0x00e00000, 0x00e00000, 0x00e00000, 0x00e00000, 0x00e00000,
+        0x00e00000, 0x00e00000, 0x00e00000, 0x00e00000, 0x00e00000, 0x00e00000,
+        0x00e00000, 0x00e00000, 0x00e00000, 0x01e00000, 0x1fc00000, 0x1f000000,
+        0x00000000, 0x00000000,
+    },
+    // k
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x1c000000,
+        0x1c000000, 0x1c000000, 0x1c000000, 0x1c000000, 0x1c000000, 0x1c1e0000,
+        0x1c3c0000, 0x1c780000, 0x1cf00000, 0x1de00000, 0x1fc00000, 0x1fc00000,
+        0x1fe00000, 0x1fe00000, 0x1ef00000, 0x1c780000, 0x1c380000, 0x1c3c0000,
+        0x1c1e0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // l
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x7f800000,
+        0x7f800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03800000,
+        0x03800000, 0x03800000, 0x03800000, 0x03800000, 0x03c00000, 0x01fc0000,
+        0x00fc0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // m
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x77780000,
+        0x7f780000, 0x739c0000, 0x739c0000, 0x739c0000, 0x739c0000, 0x739c0000,
+        0x739c0000, 0x739c0000, 0x739c0000, 0x739c0000, 0x739c0000, 0x739c0000,
+        0x739c0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // n
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x39e00000,
+        0x3bf00000, 0x3c780000, 0x38380000, 0x38380000, 0x38380000, 0x38380000,
+        0x38380000, 0x38380000, 0x38380000, 0x38380000, 0x38380000, 0x38380000,
+        0x38380000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // o
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x07e00000,
+        0x0ff00000, 0x1c380000, 0x1c380000, 0x381c0000, 0x381c0000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x381c0000, 0x1c380000, 0x1c380000, 0x0ff00000,
+        0x07e00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // p
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x39e00000,
+        0x3ff00000, 0x3c380000, 0x3c380000, 0x381c0000, 0x381c0000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x381c0000, 0x3c380000, 0x3c380000, 0x3ff00000,
+        0x39e00000, 0x38000000, 0x38000000, 0x38000000, 0x38000000, 0x38000000,
+        0x00000000, 0x00000000,
+    },
+    // q
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x079c0000,
+        0x0ffc0000, 0x1c3c0000, 0x1c3c0000, 0x381c0000, 0x381c0000, 0x381c0000,
+        0x381c0000, 0x381c0000, 0x381c0000, 0x1c3c0000, 0x1c3c0000, 0x0ffc0000,
+        0x079c0000, 0x001c0000, 0x001c0000, 0x001c0000, 0x001c0000, 0x001c0000,
+        0x00000000, 0x00000000,
+    },
+    // r
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x073c0000,
+        0x077e0000, 0x07c20000, 0x07800000, 0x07000000, 0x07000000, 0x07000000,
+        0x07000000, 0x07000000, 0x07000000, 0x07000000, 0x07000000, 0x07000000,
+        0x07000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // s
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x07e00000,
+        0x0ff00000, 0x1e100000, 0x1c000000, 0x1e000000, 0x1fc00000, 0x0ff00000,
+        0x03f80000, 0x00780000, 0x00380000, 0x00380000, 0x10780000, 0x1ff00000,
+        0x0fe00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // t
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x07000000, 0x07000000, 0x07000000, 0x07000000, 0x7ff80000,
+        0x7ff80000, 0x07000000, 0x07000000, 0x07000000, 0x07000000, 0x07000000,
+        0x07000000, 0x07000000, 0x07000000, 0x07000000, 0x07800000, 0x03f80000,
+        0x01f80000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // u
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x38380000,
+        0x38380000, 0x38380000, 0x38380000, 0x38380000, 0x38380000, 0x38380000,
+        0x38380000, 0x38380000, 0x38380000, 0x38780000, 0x3c780000, 0x1fb80000,
+        0x0f380000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // v
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x701c0000,
+        0x38380000, 0x38380000, 0x38380000, 0x1c700000, 0x1c700000, 0x1ef00000,
+        0x0ee00000, 0x0ee00000, 0x0fe00000, 0x07c00000, 0x07c00000, 0x07c00000,
+        0x03800000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // w
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0xe0070000,
+        0xe0070000, 0x700e0000, 0x700e0000, 0x718e0000, 0x718e0000, 0x3bdc0000,
+        0x3bdc0000, 0x3a5c0000, 0x3e7c0000, 0x1e780000, 0x1c380000, 0x1c380000,
+        0x1c380000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // x
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x3c3c0000,
+        0x1e780000, 0x0e700000, 0x0ff00000, 0x07e00000, 0x03c00000, 0x01800000,
+        0x03c00000, 0x07e00000, 0x07e00000, 0x0ff00000, 0x1e780000, 0x3c3c0000,
+        0x781e0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // y
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x701c0000,
+        0x38380000, 0x38380000, 0x3c780000, 0x1c700000, 0x1c700000, 0x0ee00000,
+        0x0ee00000, 0x0fe00000, 0x07c00000, 0x07c00000, 0x03800000, 0x03800000,
+        0x03800000, 0x07000000, 0x07000000, 0x0f000000, 0x3e000000, 0x3c000000,
+        0x00000000, 0x00000000,
+    },
+    // z
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x1ffc0000,
+        0x1ffc0000, 0x003c0000, 0x00780000, 0x00f00000, 0x00e00000, 0x01e00000,
+        0x03c00000, 0x07800000, 0x07000000, 0x0f000000, 0x1e000000, 0x1ffc0000,
+        0x1ffc0000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // {
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x007c0000,
+        0x00fc0000, 0x01e00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x03800000, 0x1f000000, 0x1f000000,
+        0x03800000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01e00000, 0x00fc0000, 0x007c0000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // |
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x01800000,
+        0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000,
+        0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000,
+        0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000,
+        0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000, 0x01800000,
+        0x01800000, 0x00000000,
+    },
+    // }
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x1f000000,
+        0x1f800000, 0x03c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x01c00000, 0x00e00000, 0x007c0000, 0x007c0000,
+        0x00e00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000, 0x01c00000,
+        0x01c00000, 0x01c00000, 0x03c00000, 0x1f800000, 0x1f000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+    // ~
+    {
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x1e000000, 0x7f8c0000, 0x61fc0000,
+        0x00f00000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+        0x00000000, 0x00000000,
+    },
+};
@@ -0,0 +1,375 @@
+#include "text_overlay.h"
+#include "simd.h"
+
+static void init_plane(TextOverlay *overlay, struct TextOverlayLabel *label,
+                       int plane, int x, int y);
+static void draw_cells(TextOverlay *overlay, struct TextOverlayLabel *label,
+                       int first, int last);
+static void free_label(struct TextOverlayLabel *label);
+
+// a is scaled to 0-256 so that 255 gives the color, the sum fits 16 bits
+static void blend_row_c(uint8_t *dst, const uint8_t *alpha,
+                        const uint8_t *color, int size) {
+  for (int i = 0; i < size; i++) {
+    int a = alpha[i] + (alpha[i] >> 7);
+    dst[i] = (dst[i] * (256 - a) + color[i] * a + 128) >> 8;
+  }
+}
+
+#ifdef NVR_HAVE_X86
+NVR_TARGET_AVX2 static inline __m256i blend_avx2(__m256i d, __m256i a,
+                                                 __m256i c) {
+  a = _mm256_add_epi16(a, _mm256_srli_epi16(a, 7));
+  __m256i sum = _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(256),
+                                                       a));
+  sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(c, a));
+  sum = _mm256_add_epi16(sum, _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(sum, 8);
+}
+
+NVR_TARGET_AVX2 static void blend_row_avx2(uint8_t *dst, const uint8_t *alpha,
+                                           const uint8_t *color, int size) {
+  __m256i zero = _mm256_setzero_si256();
+  int i = 0;
+
+  for (; i + 32 <= size; i += 32) {
+    __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i));
+    __m256i a = _mm256_loadu_si256((const __m256i *)(alpha + i));
+    __m256i c = _mm256_loadu_si256((const __m256i *)(color + i));
+
+    // the unpacks and the pack work within the 128 bits lanes, the order of
+    // the bytes is kept
+    __m256i lo = blend_avx2(_mm256_unpacklo_epi8(d, zero),
+                            _mm256_unpacklo_epi8(a, zero),
+                            _mm256_unpacklo_epi8(c, zero));
+    __m256i hi = blend_avx2(_mm256_unpackhi_epi8(d, zero),
+                            _mm256_unpackhi_epi8(a, zero),
+                            _mm256_unpackhi_epi8(c, zero));
+
+    _mm256_storeu_si256((__m256i *)(dst + i), _mm256_packus_epi16(lo, hi));
+  }
+
+  blend_row_c(dst + i, alpha + i, color + i, size - i);
+}
+#endif
+
+#ifdef NVR_HAVE_NEON
+static inline uint8x8_t blend_neon(uint8x8_t d, uint8x8_t a, uint8x8_t c) {
+  uint16x8_t a16 = vmovl_u8(a);
+  a16 = vaddq_u16(a16, vshrq_n_u16(a16, 7));
+
+  uint16x8_t sum = vmulq_u16(vmovl_u8(d), vsubq_u16(vdupq_n_u16(256), a16));
+  sum = vmlaq_u16(sum, vmovl_u8(c), a16);
+  return vshrn_n_u16(vaddq_u16(sum, vdupq_n_u16(128)), 8);
+}
+
+static void blend_row_neon(uint8_t *dst, const uint8_t *alpha,
+                           const uint8_t *color, int size) {
+  int i = 0;
+
+  for (; i + 16 <= size; i += 16) {
+    uint8x16_t d = vld1q_u8(dst + i);
+    uint8x16_t a = vld1q_u8(alpha + i);
+    uint8x16_t c = vld1q_u8(color + i);
+
+    vst1q_u8(dst + i,
+             vcombine_u8(blend_neon(vget_low_u8(d), vget_low_u8(a),
+                                    vget_low_u8(c)),
+                         blend_neon(vget_high_u8(d), vget_high_u8(a),
+                                    vget_high_u8(c))));
+  }
+
+  blend_row_c(dst + i, alpha + i, color + i, size - i);
+}
+#endif
+
+static TextOverlayBlendFn blend_row_fn(void) {
+#ifdef NVR_HAVE_X86
+  if (nvr_cpu_has_avx2()) {
+    return blend_row_avx2;
+  }
+#endif
+#ifdef NVR_HAVE_NEON
+  if (nvr_cpu_has_neon()) {
+    return blend_row_neon;
+  }
+#endif
+  return blend_row_c;
+}
+
+TextOverlay *text_overlay_alloc(void) {
+  TextOverlay *overlay = (TextOverlay *)enif_alloc(sizeof(TextOverlay));
+  memset(overlay, 0, sizeof(TextOverlay));
+  return overlay;
+}
+
+int text_overlay_init(TextOverlay *overlay, int width, int height,
+                      enum AVPixelFormat format) {
+  const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(format);
+  if (!desc || desc->flags & (AV_PIX_FMT_FLAG_HWACCEL |
+                              AV_PIX_FMT_FLAG_BITSTREAM |
+                              AV_PIX_FMT_FLAG_PAL)) {
+    return -1;
+  }
+
+  for (int i = 0; i < desc->nb_components; i++) {
+    if (desc->comp[i].depth != 8 || desc->comp[i].shift != 0 ||
+        desc->comp[i].step > 8) {
+      return -1;
+    }
+  }
+
+  overlay->width = width;
+  overlay->height = height;
+  overlay->desc = desc;
+  overlay->num_planes = av_pix_fmt_count_planes(format);
+  overlay->num_labels = 0;
+  overlay->blend = blend_row_fn();
+
+  return 0;
+}
+
+int text_overlay_add_label(TextOverlay *overlay, int x, int y, int size,
+                           int background) {
+  if (overlay->num_labels == TEXT_OVERLAY_MAX_LABELS || x < 0 || y < 0 ||
+      x >= overlay->width || y >= overlay->height) {
+    return -1;
+  }
+
+  GlyphAtlas *atlas = glyph_atlas_get(size);
+  if (atlas == NULL) {
+    return -1;
+  }
+
+  struct TextOverlayLabel *label = &overlay->labels[overlay->num_labels];
+  int coverage_size = TEXT_OVERLAY_MAX_CHARS * atlas->cell_width * size;
+
+  memset(label, 0, sizeof(struct TextOverlayLabel));
+  label->atlas = atlas;
+  label->background = background;
+  label->coverage = (uint8_t *)enif_alloc(coverage_size);
+  memset(label->coverage, 0, coverage_size);
+
+  x &= ~((1 << overlay->desc->log2_chroma_w) - 1);
+  y &= ~((1 << overlay->desc->log2_chroma_h) - 1);
+
+  for (int i = 0; i < overlay->num_planes; i++) {
+    init_plane(overlay, label, i, x, y);
+  }
+
+  return overlay->num_labels++;
+}
+
+// The colors are white text on black, in the range of the format
+static void init_plane(TextOverlay *overlay, struct TextOverlayLabel *label,
+                       int plane, int x, int y) {
+  const AVPixFmtDescriptor *desc = overlay->desc;
+  struct TextOverlayPlane *p = &label->planes[plane];
+  uint8_t color[8] = {0}, background[8] = {0};
+  int is_yuv = !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+  int full_range =
+      desc->nb_components < 3 || strncmp(desc->name, "yuvj", 4) == 0;
+
+  for (int i = 0; i < desc->nb_components; i++) {
+    const AVComponentDescriptor *comp = &desc->comp[i];
+    if (comp->plane != plane) {
+      continue;
+    }
+
+    p->step = FFMAX(p->step, comp->step);
+    if ((desc->flags & AV_PIX_FMT_FLAG_ALPHA) && i == desc->nb_components - 1) {
+      continue;
+    }
+
+    p->drawn[comp->offset] = 0xff;
+    if (is_yuv && (i == 1 || i == 2)) {
+      color[comp->offset] = background[comp->offset] = 128;
+      p->log2_chroma_w = desc->log2_chroma_w;
+      p->log2_chroma_h = desc->log2_chroma_h;
+    } else if (is_yuv && !full_range) {
+      color[comp->offset] = 235;
+      background[comp->offset] = 16;
+    } else {
+      color[comp->offset] = 255;
+    }
+  }
+
+  if (!memchr(p->drawn, 0xff, sizeof(p->drawn))) {
+    p->step = 0;
+    return;
+  }
+
+  int width = AV_CEIL_RSHIFT(TEXT_OVERLAY_MAX_CHARS * label->atlas->cell_width,
+                             p->log2_chroma_w);
+
+  p->x = x >> p->log2_chroma_w;
+  p->y = y >> p->log2_chroma_h;
+  p->height = AV_CEIL_RSHIFT(label->atlas->size, p->log2_chroma_h);
+  p->stride = width * p->step;
+  p->alpha = (uint8_t *)enif_alloc(p->stride * p->height);
+  p->color = (uint8_t *)enif_alloc(p->stride);
+  p->background_color = (uint8_t *)enif_alloc(p->stride);
+  p->background_alpha = (uint8_t *)enif_alloc(p->stride);
+  memset(p->alpha, 0, p->stride * p->height);
+
+  for (int i = 0; i < p->stride; i++) {
+    int k = i % p->step;
+    p->color[i] = color[k];
+    p->background_color[i] = background[k];
+    p->background_alpha[i] = p->drawn[k] & 0x80;
+  }
+}
+
+int text_overlay_set_text(TextOverlay *overlay, int index, const char *text,
+                          int length) {
+  if (index < 0 || index >= overlay->num_labels) {
+    return -1;
+  }
+
+  struct TextOverlayLabel *label = &overlay->labels[index];
+  int first = -1, last = -1;
+
+  length = FFMIN(length, TEXT_OVERLAY_MAX_CHARS);
+
+  for (int i = 0; i < FFMAX(length, label->length); i++) {
+    char c = i < length ? text[i] : 0;
+    if (i >= label->length || c != label->text[i]) {
+      label->text[i] = c;
+      first = first < 0 ? i : first;
+      last = i;
+    }
+  }
+
+  label->length = length;
+  label->text[length] = 0;
+
+  if (first >= 0) {
+    draw_cells(overlay, label, first, last);
+  }
+
+  return 0;
+}
+
+// Redraws the coverage of the changed cells between first and last, then the
+// samples of the planes that contain them. A chroma sample takes the mean
+// alpha of the pixels it covers.
+static void draw_cells(TextOverlay *overlay, struct TextOverlayLabel *label,
+                       int first, int last) {
+  const GlyphAtlas *atlas = label->atlas;
+  int cell_width = atlas->cell_width, size = atlas->size;
+  int coverage_stride = TEXT_OVERLAY_MAX_CHARS * cell_width;
+
+  for (int i = first; i <= last; i++) {
+    uint8_t *dst = label->coverage + i * cell_width;
+    const uint8_t *glyph =
+        i < label->length ? glyph_atlas_glyph(atlas, label->text[i]) : NULL;
+
+    for (int y = 0; y < size; y++) {
+      if (glyph) {
+        memcpy(dst + y * coverage_stride, glyph + y * cell_width, cell_width);
+      } else {
+        memset(dst + y * coverage_stride, 0, cell_width);
+      }
+    }
+  }
+
+  for (int i = 0; i < overlay->num_planes; i++) {
+    struct TextOverlayPlane *p = &label->planes[i];
+    if (p->step == 0) {
+      continue;
+    }
+
+    int log2_w = p->log2_chroma_w, log2_h = p->log2_chroma_h;
+    int x0 = (first * cell_width) >> log2_w;
+    int x1 = AV_CEIL_RSHIFT((last + 1) * cell_width, log2_w);
+
+    for (int y = 0; y < p->height; y++) {
+      int luma_y0 = y << log2_h;
+      int luma_y1 = FFMIN((y + 1) << log2_h, size);
+
+      for (int x = x0; x < x1; x++) {
+        int luma_x0 = x << log2_w;
+        int luma_x1 = FFMIN((x + 1) << log2_w, coverage_stride);
+        int sum = 0, count = (luma_y1 - luma_y0) * (luma_x1 - luma_x0);
+
+        for (int j = luma_y0; j < luma_y1; j++) {
+          for (int k = luma_x0; k < luma_x1; k++) {
+            sum += label->coverage[j * coverage_stride + k];
+          }
+        }
+
+        uint8_t alpha = (sum + count / 2) / count;
+        uint8_t *dst = p->alpha + y * p->stride + x * p->step;
+        for (int k = 0; k < p->step; k++) {
+          dst[k] = alpha & p->drawn[k];
+        }
+      }
+    }
+  }
+}
+
+void text_overlay_apply(const TextOverlay *overlay, uint8_t *const data[4],
+                        const int linesize[4]) {
+  for (int l = 0; l < overlay->num_labels; l++) {
+    const struct TextOverlayLabel *label = &overlay->labels[l];
+    if (label->length == 0) {
+      continue;
+    }
+
+    for (int i = 0; i < overlay->num_planes; i++) {
+      const struct TextOverlayPlane *p = &label->planes[i];
+      if (p->step == 0) {
+        continue;
+      }
+
+      int plane_width = AV_CEIL_RSHIFT(overlay->width, p->log2_chroma_w);
+      int plane_height = AV_CEIL_RSHIFT(overlay->height, p->log2_chroma_h);
+      int width = AV_CEIL_RSHIFT(label->length * label->atlas->cell_width,
+                                 p->log2_chroma_w);
+      int bytes = FFMIN(width, plane_width - p->x) * p->step;
+      int rows = FFMIN(p->height, plane_height - p->y);
+
+      for (int y = 0; y < rows; y++) {
+        uint8_t *dst = data[i] + (p->y + y) * linesize[i] + p->x * p->step;
+
+        if (label->background) {
+          overlay->blend(dst, p->background_alpha, p->background_color, bytes);
+        }
+
+        overlay->blend(dst, p->alpha + y * p->stride, p->color, bytes);
+      }
+    }
+  }
+}
+
+static void free_label(struct TextOverlayLabel *label) {
+  glyph_atlas_release(&label->atlas);
+
+  if (label->coverage) {
+    enif_free(label->coverage);
+  }
+
+  for (int i = 0; i < 4; i++) {
+    struct TextOverlayPlane *p = &label->planes[i];
+    uint8_t *buffers[] = {p->alpha, p->color, p->background_color,
+                          p->background_alpha};
+
+    for (int j = 0; j < 4; j++) {
+      if (buffers[j]) {
+        enif_free(buffers[j]);
+      }
+    }
+  }
+}
+
+void text_overlay_free(TextOverlay **overlay) {
+  TextOverlay *o = *overlay;
+  if (o != NULL) {
+    for (int i = 0; i < o->num_labels; i++) {
+      free_label(&o->labels[i]);
+    }
+
+    enif_free(o);
+    *overlay = NULL;
+  }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <libavutil/pixdesc.h>
+#include <stdint.h>
+
+#include "glyph_atlas.h"
+#include "utils.h"
+
+#define TEXT_OVERLAY_MAX_LABELS 4
+#define TEXT_OVERLAY_MAX_CHARS 64
+
+// Burns single line labels into 8 bits frames. The text of a label is drawn
+// from the glyph atlas of its size into an alpha strip per plane, only the
+// characters that changed since the previous text are redrawn. Each frame
+// then only blends the strips of the labels into the planes.
+
+// dst[i] = dst[i] + (color[i] - dst[i]) * alpha[i] / 255
+typedef void (*TextOverlayBlendFn)(uint8_t *dst, const uint8_t *alpha,
+                                   const uint8_t *color, int size);
+
+struct TextOverlayPlane {
+  // top left of the label, in samples of the plane
+  int x;
+  int y;
+  int height;
+  // bytes per sample
+  int step;
+  int log2_chroma_w;
+  int log2_chroma_h;
+  // bytes of the components drawn, alpha is left untouched
+  uint8_t drawn[8];
+  // TEXT_OVERLAY_MAX_CHARS cells, stride bytes per row
+  uint8_t *alpha;
+  int stride;
+  // one row of the text color, of the background color and of the
+  // background alpha
+  uint8_t *color;
+  uint8_t *background_color;
+  uint8_t *background_alpha;
+};
+
+struct TextOverlayLabel {
+  GlyphAtlas *atlas;
+  char text[TEXT_OVERLAY_MAX_CHARS + 1];
+  int length;
+  // draw a half transparent black box under the text
+  int background;
+  // alpha of the text at the resolution of the frame
+  uint8_t *coverage;
+  struct TextOverlayPlane planes[4];
+};
+
+typedef struct TextOverlay {
+  int width;
+  int height;
+  const AVPixFmtDescriptor *desc;
+  int num_planes;
+  struct TextOverlayLabel labels[TEXT_OVERLAY_MAX_LABELS];
+  int num_labels;
+  TextOverlayBlendFn blend;
+} TextOverlay;
+
+TextOverlay *text_overlay_alloc(void);
+
+// Returns a negative value if the format is not supported
+int text_overlay_init(TextOverlay *overlay, int width, int height,
+                      enum AVPixelFormat format);
+
+// Adds an empty label at x, y (moved to the chroma sample containing it) with
+// glyphs of size pixels high. Returns the index of the label or a negative
+// value.
+int text_overlay_add_label(TextOverlay *overlay, int x, int y, int size,
+                           int background);
+
+// Longer texts are truncated to TEXT_OVERLAY_MAX_CHARS
+int text_overlay_set_text(TextOverlay *overlay, int label, const char *text,
+                          int length);
+
+// The overlay is only read, it may be shared by threads drawing other frames
+void text_overlay_apply(const TextOverlay *overlay, uint8_t *const data[4],
+                        const int linesize[4]);
+
+void text_overlay_free(TextOverlay **overlay);
@@ -0,0 +1,333 @@
+#include "timelapse.h"
+#include "nal.h"
+
+static int open_output(Timelapse *timelapse);
+static int encode_frames(Timelapse *timelapse);
+static int write_packets(Timelapse *timelapse);
+static int write_header(Timelapse *timelapse, AVPacket *packet);
+
+void timelapse_config_default(struct TimelapseConfig *config) {
+  config->width = 1280;
+  config->height = 720;
+  config->frame_rate = 30;
+  config->gop_size = 30;
+  config->interval = 0;
+  config->format = TIMELAPSE_FORMAT_H264;
+  config->path = NULL;
+}
+
+Timelapse *timelapse_alloc() {
+  Timelapse *timelapse = (Timelapse *)enif_alloc(sizeof(Timelapse));
+
+  timelapse_config_default(&timelapse->config);
+  timelapse->decoder = NULL;
+  timelapse->encoder = NULL;
+  timelapse->sws_ctx = NULL;
+  timelapse->frame = NULL;
+  timelapse->format_ctx = NULL;
+  timelapse->header_written = 0;
+  timelapse->last_sample_pts = AV_NOPTS_VALUE;
+  timelapse->num_frames = 0;
+  timelapse->output = NULL;
+  timelapse->output_size = 0;
+
+  return timelapse;
+}
+
+int timelapse_init(Timelapse *timelapse, enum AVCodecID codec_id,
+                   struct TimelapseConfig *config) {
+  timelapse->config = *config;
+  config->path = NULL;
+
+  if (config->width < 2 || config->height < 2 || config->width % 2 != 0 ||
+      config->height % 2 != 0 || config->width > 8192 ||
+      config->height > 8192 || config->frame_rate < 1 ||
+      config->interval < 0) {
+    return -1;
+  }
+
+  const AVCodec *codec = avcodec_find_decoder(codec_id);
+  if (!codec) {
+    return -1;
+  }
+
+  timelapse->decoder = decoder_alloc();
+  if (decoder_init(timelapse->decoder, codec) < 0) {
+    return -1;
+  }
+
+  timelapse->decoder->c->skip_frame = AVDISCARD_NONKEY;
+
+  timelapse->frame = av_frame_alloc();
+  timelapse->frame->format = AV_PIX_FMT_YUV420P;
+  timelapse->frame->width = config->width;
+  timelapse->frame->height = config->height;
+
+  if (av_frame_get_buffer(timelapse->frame, 0) < 0) {
+    return -1;
+  }
+
+  // the output has its own clock, one frame per sampled keyframe
+  struct EncoderConfig encoder_config = {
+      .media_type = AVMEDIA_TYPE_VIDEO,
+      .codec = avcodec_find_encoder(AV_CODEC_ID_H264),
+      .width = config->width,
+      .height = config->height,
+      .format = AV_PIX_FMT_YUV420P,
+      .time_base = (AVRational){1, config->frame_rate},
+      .gop_size = config->gop_size,
+      .max_b_frames = -1,
+      .profile = FF_PROFILE_UNKNOWN,
+      .preset = NULL,
+      .tune = NULL};
+
+  if (!encoder_config.codec) {
+    return -1;
+  }
+
+  timelapse->encoder = encoder_alloc();
+  if (encoder_init(timelapse->encoder, &encoder_config) < 0) {
+    return -1;
+  }
+
+  return open_output(timelapse);
+}
+
+// Returns 1 if the packet was sampled, 0 if it was skipped. Only keyframes at
+// least `interval` apart are sampled.
+int timelapse_add_packet(Timelapse *timelapse, AVPacket *packet) {
+  int64_t interval = timelapse->config.interval;
+
+  if (!decoder_is_keyframe(timelapse->decoder, packet->data, packet->size)) {
+    return 0;
+  }
+
+  if (interval > 0 && timelapse->last_sample_pts != AV_NOPTS_VALUE &&
+      packet->pts - timelapse->last_sample_pts < interval) {
+    return 0;
+  }
+
+  timelapse->last_sample_pts = packet->pts;
+
+  if (decoder_decode(timelapse->decoder, packet) < 0) {
+    return -1;
+  }
+
+  return encode_frames(timelapse) < 0 ? -1 : 1;
+}
+
+// Encodes the frames still buffered in the decoder, `num_frames` is then the
+// final number of frames of the timelapse.
+int timelapse_flush(Timelapse *timelapse) {
+  if (decoder_flush(timelapse->decoder) < 0) {
+    return -1;
+  }
+
+  return encode_frames(timelapse);
+}
+
+// Drains the encoder and finalizes the container, the in memory output is then
+// available in `output`. The timelapse must be flushed first.
+int timelapse_close(Timelapse *timelapse) {
+  if (encoder_encode(timelapse->encoder, NULL) < 0 ||
+      write_packets(timelapse) < 0) {
+    return -1;
+  }
+
+  if (!timelapse->header_written) {
+    return -1;
+  }
+
+  AVFormatContext *format_ctx = timelapse->format_ctx;
+  if (av_write_trailer(format_ctx) < 0) {
+    return -1;
+  }
+
+  if (timelapse->config.path) {
+    return avio_closep(&format_ctx->pb);
+  }
+
+  timelapse->output_size =
+      avio_close_dyn_buf(format_ctx->pb, &timelapse->output);
+  format_ctx->pb = NULL;
+
+  return 0;
+}
+
+void timelapse_free(Timelapse **timelapse) {
+  Timelapse *t = *timelapse;
+  if (t != NULL) {
+    decoder_free(&t->decoder);
+    encoder_free(t->encoder);
+
+    if (t->sws_ctx != NULL) {
+      sws_freeContext(t->sws_ctx);
+    }
+
+    if (t->frame != NULL) {
+      av_frame_free(&t->frame);
+    }
+
+    if (t->format_ctx != NULL) {
+      if (t->format_ctx->pb != NULL && t->config.path) {
+        avio_closep(&t->format_ctx->pb);
+      } else if (t->format_ctx->pb != NULL) {
+        uint8_t *buffer;
+        avio_close_dyn_buf(t->format_ctx->pb, &buffer);
+        av_free(buffer);
+      }
+
+      avformat_free_context(t->format_ctx);
+    }
+
+    if (t->output != NULL) {
+      av_free(t->output);
+    }
+
+    if (t->config.path != NULL) {
+      enif_free(t->config.path);
+    }
+
+    enif_free(t);
+    *timelapse = NULL;
+  }
+}
+
+static int open_output(Timelapse *timelapse) {
+  struct TimelapseConfig *config = &timelapse->config;
+  const char *format_name =
+      config->format == TIMELAPSE_FORMAT_MP4 ? "mp4" : "h264";
+
+  if (avformat_alloc_output_context2(&timelapse->format_ctx, NULL,
+                                     format_name, config->path) < 0) {
+    return -1;
+  }
+
+  AVStream *stream = avformat_new_stream(timelapse->format_ctx, NULL);
+  if (!stream) {
+    return -1;
+  }
+
+  stream->time_base = timelapse->encoder->c->time_base;
+  if (avcodec_parameters_from_context(stream->codecpar,
+                                      timelapse->encoder->c) < 0) {
+    return -1;
+  }
+
+  if (config->path) {
+    return avio_open(&timelapse->format_ctx->pb, config->path,
+                     AVIO_FLAG_WRITE);
+  }
+
+  return avio_open_dyn_buf(&timelapse->format_ctx->pb);
+}
+
+static int encode_frames(Timelapse *timelapse) {
+  Decoder *decoder = timelapse->decoder;
+  AVFrame *output = timelapse->frame;
+  int ret = 0;
+
+  for (int i = 0; i < decoder->count_frames && ret >= 0; i++) {
+    AVFrame *frame = decoder->frames[i];
+
+    timelapse->sws_ctx = sws_getCachedContext(
+        timelapse->sws_ctx, frame->width, frame->height, frame->format,
+        output->width, output->height, output->format, SWS_BILINEAR, NULL,
+        NULL, NULL);
+
+    // the encoder may still hold a reference to the previous frame
+    if (!timelapse->sws_ctx || av_frame_make_writable(output) < 0) {
+      ret = -1;
+      break;
+    }
+
+    sws_scale(timelapse->sws_ctx, (const uint8_t *const *)frame->data,
+              frame->linesize, 0, frame->height, output->data,
+              output->linesize);
+
+    output->pts = timelapse->num_frames++;
+    if (encoder_encode(timelapse->encoder, output) < 0) {
+      ret = -1;
+      break;
+    }
+
+    ret = write_packets(timelapse);
+  }
+
+  for (int i = 0; i < decoder->count_frames; i++) {
+    av_frame_unref(decoder->frames[i]);
+  }
+
+  decoder->count_frames = 0;
+  return ret;
+}
+
+static int write_packets(Timelapse *timelapse) {
+  Encoder *encoder = timelapse->encoder;
+  AVStream *stream = timelapse->format_ctx->streams[0];
+  int ret = 0;
+
+  for (int i = 0; i < encoder->num_packets; i++) {
+    AVPacket *packet = encoder->packets[i];
+
+    if (ret >= 0 && !timelapse->header_written) {
+      ret = write_header(timelapse, packet);
+    }
+
+    if (ret >= 0) {
+      packet->stream_index = 0;
+      av_packet_rescale_ts(packet, encoder->c->time_base, stream->time_base);
+      ret = av_interleaved_write_frame(timelapse->format_ctx, packet);
+    }
+
+    av_packet_unref(packet);
+  }
+
+  encoder->num_packets = 0;
+  return ret;
+}
+
+// The encoder emits the parameter sets in band, they are copied to the stream
+// extradata before writing the header since the mp4 muxer needs them for the
+// avcC record.
+static int write_header(Timelapse *timelapse, AVPacket *packet) {
+  AVFormatContext *format_ctx = timelapse->format_ctx;
+  AVCodecParameters *codecpar = format_ctx->streams[0]->codecpar;
+  AVDictionary *opts = NULL;
+
+  if (codecpar->extradata_size == 0) {
+    struct NalUnit *units;
+    int count = nal_parse_annexb(packet->data, packet->size, AV_CODEC_ID_H264,
+                                 &units);
+    int num_params = 0;
+
+    for (int i = 0; i < count; i++) {
+      if (units[i].type == 7 || units[i].type == 8) {
+        units[num_params++] = units[i];
+      }
+    }
+
+    int size = nal_annexb_size(units, num_params);
+    if (size > 0) {
+      codecpar->extradata = av_mallocz(size + AV_INPUT_BUFFER_PADDING_SIZE);
+      codecpar->extradata_size = size;
+      nal_write_annexb(packet->data, units, num_params, codecpar->extradata);
+    }
+
+    enif_free(units);
+  }
+
+  if (timelapse->config.format == TIMELAPSE_FORMAT_MP4) {
+    // a fragmented file can be written to a non seekable buffer
+    av_dict_set(&opts, "movflags",
+                timelapse->config.path ? "+faststart"
+                                       : "+frag_keyframe+empty_moov",
+                0);
+  }
+
+  int ret = avformat_write_header(format_ctx, &opts);
+  av_dict_free(&opts);
+
+  timelapse->header_written = ret >= 0;
+  return ret;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "decoder.h"
+#include "encoder.h"
+#include "utils.h"
+#include <libavformat/avformat.h>
+#include <libswscale/swscale.h>
+
+typedef struct Timelapse Timelapse;
+
+enum TimelapseFormat { TIMELAPSE_FORMAT_H264, TIMELAPSE_FORMAT_MP4 };
+
+struct TimelapseConfig {
+  // size of the output, must be even
+  int width;
+  int height;
+  int frame_rate;
+  int gop_size;
+  // minimum pts difference between two sampled keyframes, 0 keeps all of them
+  int64_t interval;
+  enum TimelapseFormat format;
+  // the output is kept in memory when NULL, owned by the timelapse once
+  // initialized
+  char *path;
+};
+
+struct Timelapse {
+  struct TimelapseConfig config;
+  Decoder *decoder;
+  Encoder *encoder;
+  struct SwsContext *sws_ctx;
+  AVFrame *frame;
+  AVFormatContext *format_ctx;
+  int header_written;
+  int64_t last_sample_pts;
+  int64_t num_frames;
+  // the in memory output, available once finished
+  uint8_t *output;
+  int output_size;
+};
+
+void timelapse_config_default(struct TimelapseConfig *config);
+Timelapse *timelapse_alloc();
+int timelapse_init(Timelapse *timelapse, enum AVCodecID codec_id,
+                   struct TimelapseConfig *config);
+int timelapse_add_packet(Timelapse *timelapse, AVPacket *packet);
+int timelapse_flush(Timelapse *timelapse);
+int timelapse_close(Timelapse *timelapse);
+void timelapse_free(Timelapse **timelapse);
@@ -1,4 +1,9 @@
 #include "utils.h"
+#include <fcntl.h>
+#include <libavutil/pixdesc.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 ERL_NIF_TERM nif_ok(ErlNifEnv *env, ERL_NIF_TERM data_term) {
   ERL_NIF_TERM ok_term = enif_make_atom(env, "ok");
@@ -66,3 +71,64 @@ ERL_NIF_TERM nif_frame_to_term(ErlNifEnv *env, AVFrame *frame) {
   return enif_make_tuple(env, 5, data_term, format_term, width_term,
                          height_term, pts_term);
 }
+
+ERL_NIF_TERM nif_planes_to_term(ErlNifEnv *env, AVFrame *frame,
+                                int num_planes) {
+  const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(frame->format);
+  int is_yuv = !(desc->flags & AV_PIX_FMT_FLAG_RGB);
+  ERL_NIF_TERM planes = enif_make_list(env, 0);
+
+  num_planes = FFMIN(num_planes, av_pix_fmt_count_planes(frame->format));
+
+  for (int i = num_planes - 1; i >= 0; i--) {
+    int chroma = is_yuv && (i == 1 || i == 2);
+    int height = chroma ? AV_CEIL_RSHIFT(frame->height, desc->log2_chroma_h)
+                        : frame->height;
+    int stride = frame->linesize[i];
+    // the padding of the last row may not be allocated
+    int size = (height - 1) * stride +
+               av_image_get_linesize(frame->format, frame->width, i);
+
+    ERL_NIF_TERM data_term;
+    memcpy(enif_make_new_binary(env, size, &data_term), frame->data[i], size);
+
+    planes = enif_make_list_cell(
+        env, enif_make_tuple2(env, data_term, enif_make_int(env, stride)),
+        planes);
+  }
+
+  ERL_NIF_TERM terms[] = {enif_make_atom(env, "planes"),
+                          planes,
+                          enif_make_atom(env, desc->name),
+                          enif_make_int(env, frame->width),
+                          enif_make_int(env, frame->height),
+                          enif_make_int64(env, frame->pts)};
+
+  return enif_make_tuple_from_array(env, terms, 6);
+}
+
+int nvr_map_file(const char *path, uint8_t **data, int64_t *size) {
+  struct stat st;
+  int fd = open(path, O_RDONLY);
+
+  if (fd < 0) {
+    return -1;
+  }
+
+  if (fstat(fd, &st) < 0 || st.st_size == 0) {
+    close(fd);
+    return -1;
+  }
+
+  void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (addr == MAP_FAILED) {
+    return -1;
+  }
+
+  *data = (uint8_t *)addr;
+  *size = st.st_size;
+
+  return 0;
+}
@@ -27,4 +27,15 @@ int nif_get_atom(ErlNifEnv *env, ERL_NIF_TERM term, char **value);
 int nif_get_string(ErlNifEnv *env, ERL_NIF_TERM term, char **value);
 
 ERL_NIF_TERM nif_frame_to_term(ErlNifEnv *env, AVFrame *frame);
+// {:planes, [{data, stride}], format, width, height, pts} with the first
+// num_planes planes of the frame, each one copied with its padding.
+ERL_NIF_TERM nif_planes_to_term(ErlNifEnv *env, AVFrame *frame,
+                                int num_planes);
+
+// maps the whole file read only, the mapping stays valid once the file is
+// closed and is released with munmap.
+int nvr_map_file(const char *path, uint8_t **data, int64_t *size);
+
+// last, it may redefine the allocation functions declared above
+#include "alloc_stats.h"
 #endif // UTILS_H
\ No newline at end of file
@@ -2,6 +2,8 @@
 #include "utils.h"
 
 int add_padding(AVFrame *scaled_frame, AVFrame *dst_frame);
+static int box_scale_input(VideoConverter *converter, AVFrame *frame,
+                           const uint8_t *src_data[4], int src_linesize[4]);
 
 VideoConverter *video_converter_alloc() {
   VideoConverter *converter =
@@ -9,6 +11,19 @@ VideoConverter *video_converter_alloc() {
   converter->sws_ctx = NULL;
   converter->frame = av_frame_alloc();
   converter->scaled_frame = av_frame_alloc();
+  converter->crop_x = 0;
+  converter->crop_y = 0;
+  converter->crop_width = 0;
+  converter->crop_height = 0;
+  converter->in_desc = NULL;
+  converter->fast_path = 1;
+  converter->yuv_rgb_row = NULL;
+  converter->box_shift = 0;
+  converter->box_row = NULL;
+  converter->box_frame = av_frame_alloc();
+  converter->in_place = 0;
+  converter->privacy_mask = NULL;
+  converter->text_overlay = NULL;
   return converter;
 }
 
@@ -68,6 +83,9 @@ int video_converter_init(VideoConverter *converter, int in_width, int in_height,
       if (ret < 0) {
         return ret;
       }
+
+      // only the scaled area is written on conversion, the borders stay black
+      memset(dst_frame->data[0], 0, dst_frame->linesize[0] * dst_frame->height);
     }
   }
 
@@ -76,9 +94,43 @@ int video_converter_init(VideoConverter *converter, int in_width, int in_height,
     return ret;
   }
 
+  int src_width = in_width;
+  int src_height = in_height;
+
+  if (converter->fast_path) {
+    converter->box_shift =
+        box_scale_shift(in_format, in_width, in_height, scaled_frame->width,
+                        scaled_frame->height);
+  }
+
+  if (converter->box_shift) {
+    converter->box_row = box_scale_row_fn();
+    converter->in_desc = av_pix_fmt_desc_get(in_format);
+    src_width = in_width >> converter->box_shift;
+    src_height = in_height >> converter->box_shift;
+
+    converter->box_frame->width = src_width;
+    converter->box_frame->height = src_height;
+    converter->box_frame->format = in_format;
+
+    if (src_width == scaled_frame->width &&
+        src_height == scaled_frame->height && in_format == out_format) {
+      return 0;
+    }
+  }
+
+  if (converter->fast_path && src_width == scaled_frame->width &&
+      src_height == scaled_frame->height) {
+    converter->yuv_rgb_row = yuv_rgb_row_fn(in_format, out_format);
+    if (converter->yuv_rgb_row) {
+      return 0;
+    }
+  }
+
   converter->sws_ctx = sws_getContext(
-      in_width, in_height, in_format, scaled_frame->width, scaled_frame->height,
-      scaled_frame->format, SWS_BILINEAR, NULL, NULL, NULL);
+      src_width, src_height, in_format, scaled_frame->width,
+      scaled_frame->height, scaled_frame->format, SWS_BILINEAR, NULL, NULL,
+      NULL);
 
   if (!converter->sws_ctx) {
     NVR_LOG_DEBUG("Couldn't get sws context");
@@ -88,28 +140,155 @@ int video_converter_init(VideoConverter *converter, int in_width, int in_height,
   return 0;
 }
 
+// Scales only a rectangle of the input frames. The rectangle is grown to the
+// chroma subsampling of the input format so that it starts on a chroma sample,
+// the crop is then only an offset of the plane pointers, the input is not
+// copied.
+int video_converter_init_roi(VideoConverter *converter, int in_width,
+                             int in_height, enum AVPixelFormat in_format,
+                             struct VideoConverterRoi *roi,
+                             enum AVPixelFormat out_format) {
+  const AVPixFmtDescriptor *desc = av_pix_fmt_desc_get(in_format);
+  if (!desc || desc->flags & (AV_PIX_FMT_FLAG_HWACCEL |
+                              AV_PIX_FMT_FLAG_BITSTREAM |
+                              AV_PIX_FMT_FLAG_PAL)) {
+    return -1;
+  }
+
+  if (roi->x < 0 || roi->y < 0 || roi->width <= 0 || roi->height <= 0 ||
+      roi->x + roi->width > in_width || roi->y + roi->height > in_height) {
+    return -1;
+  }
+
+  int h_mask = (1 << desc->log2_chroma_w) - 1;
+  int v_mask = (1 << desc->log2_chroma_h) - 1;
+  int x = roi->x & ~h_mask;
+  int y = roi->y & ~v_mask;
+  int width = FFMIN((roi->x + roi->width - x + h_mask) & ~h_mask, in_width - x);
+  int height =
+      FFMIN((roi->y + roi->height - y + v_mask) & ~v_mask, in_height - y);
+
+  converter->crop_x = x;
+  converter->crop_y = y;
+  converter->crop_width = width;
+  converter->crop_height = height;
+  converter->in_desc = desc;
+  av_image_fill_max_pixsteps(converter->pixel_steps, NULL, desc);
+
+  return video_converter_init(converter, width, height, in_format,
+                              roi->out_width, roi->out_height, out_format, 0);
+}
+
 int video_converter_convert(VideoConverter *converter, AVFrame *frame) {
   int ret;
+  const uint8_t *src_data[4] = {frame->data[0], frame->data[1], frame->data[2],
+                                frame->data[3]};
+  int src_linesize[4] = {frame->linesize[0], frame->linesize[1],
+                         frame->linesize[2], frame->linesize[3]};
+  int src_height = frame->height;
+  AVFrame *scaled_frame = converter->scaled_frame;
+
   converter->frame->pts = frame->pts;
-  converter->scaled_frame->pts = frame->pts;
+  scaled_frame->pts = frame->pts;
 
-  ret = sws_scale(converter->sws_ctx, (const uint8_t *const *)frame->data,
-                    frame->linesize, 0, frame->height,
-                    converter->scaled_frame->data,
-                    converter->scaled_frame->linesize);
+  if (converter->crop_width > 0) {
+    const AVPixFmtDescriptor *desc = converter->in_desc;
+    int is_yuv = !(desc->flags & AV_PIX_FMT_FLAG_RGB);
 
-  if (ret < 0) {
-    return ret;
+    for (int i = 0; i < 4 && src_data[i]; i++) {
+      int chroma = is_yuv && (i == 1 || i == 2);
+      int x = chroma ? converter->crop_x >> desc->log2_chroma_w
+                     : converter->crop_x;
+      int y = chroma ? converter->crop_y >> desc->log2_chroma_h
+                     : converter->crop_y;
+
+      src_data[i] += y * frame->linesize[i] + x * converter->pixel_steps[i];
+    }
+
+    src_height = converter->crop_height;
+  }
+
+  if (converter->box_shift) {
+    ret = box_scale_input(converter, frame, src_data, src_linesize);
+    if (ret < 0) {
+      return ret;
+    }
+
+    src_height = converter->box_frame->height;
+  }
+
+  if (converter->yuv_rgb_row) {
+    // the matrix and the range may change with the stream parameters
+    yuv_rgb_coeffs(&converter->coeffs, frame, scaled_frame->format);
+    yuv_rgb_convert(converter->yuv_rgb_row, &converter->coeffs, src_data,
+                    src_linesize, scaled_frame->width, scaled_frame->height,
+                    scaled_frame->data[0], scaled_frame->linesize[0]);
+  } else if (converter->sws_ctx) {
+    ret = sws_scale(converter->sws_ctx, src_data, src_linesize, 0, src_height,
+                    scaled_frame->data, scaled_frame->linesize);
+
+    if (ret < 0) {
+      return ret;
+    }
+  }
+
+  if (converter->privacy_mask) {
+    privacy_mask_apply(converter->privacy_mask, scaled_frame->data,
+                       scaled_frame->linesize);
+  }
+
+  if (converter->text_overlay) {
+    text_overlay_apply(converter->text_overlay, scaled_frame->data,
+                       scaled_frame->linesize);
   }
 
   if (converter->pad) {
-    return add_padding(converter->scaled_frame, converter->frame);
+    return add_padding(scaled_frame, converter->frame);
   } else {
     av_frame_unref(converter->frame);
-    return av_frame_ref(converter->frame, converter->scaled_frame);
+    return av_frame_ref(converter->frame, scaled_frame);
   }
 }
 
+// Reduces the input with the box filter. The result goes straight to the
+// scaled frame when nothing else is left to do, otherwise it's written over
+// the input when allowed or to the box frame. The source planes are then
+// replaced by the reduced ones.
+static int box_scale_input(VideoConverter *converter, AVFrame *frame,
+                           const uint8_t *src_data[4], int src_linesize[4]) {
+  AVFrame *dst = NULL;
+  uint8_t *dst_data[4];
+  int dst_linesize[4];
+
+  if (!converter->yuv_rgb_row && !converter->sws_ctx) {
+    dst = converter->scaled_frame;
+  } else if (!converter->in_place || !av_frame_is_writable(frame)) {
+    dst = converter->box_frame;
+    if (!dst->buf[0]) {
+      int ret = av_frame_get_buffer(dst, 0);
+      if (ret < 0) {
+        return ret;
+      }
+    }
+  }
+
+  for (int i = 0; i < 4; i++) {
+    dst_data[i] = dst ? dst->data[i] : (uint8_t *)src_data[i];
+    dst_linesize[i] = dst ? dst->linesize[i] : src_linesize[i];
+  }
+
+  box_scale(converter->box_row, converter->in_desc, src_data, src_linesize,
+            dst_data, dst_linesize, converter->box_frame->width,
+            converter->box_frame->height, converter->box_shift);
+
+  for (int i = 0; i < 4; i++) {
+    src_data[i] = dst_data[i];
+    src_linesize[i] = dst_linesize[i];
+  }
+
+  return 0;
+}
+
 void video_converter_free(struct VideoConverter **converter) {
   struct VideoConverter *vc = *converter;
   if (vc != NULL) {
@@ -125,6 +304,10 @@ void video_converter_free(struct VideoConverter **converter) {
       av_frame_free(&(*converter)->scaled_frame);
     }
 
+    if (vc->box_frame != NULL) {
+      av_frame_free(&(*converter)->box_frame);
+    }
+
     enif_free(vc);
     *converter = NULL;
   }
@@ -1,8 +1,14 @@
 
 #include <libavutil/frame.h>
 #include <libavutil/imgutils.h>
+#include <libavutil/pixdesc.h>
 #include <libswscale/swscale.h>
 
+#include "box_scale.h"
+#include "privacy_mask.h"
+#include "text_overlay.h"
+#include "yuv_rgb.h"
+
 typedef struct VideoConverter VideoConverter;
 
 struct VideoConverter {
@@ -10,6 +16,42 @@ struct VideoConverter {
   AVFrame *frame;
   AVFrame *scaled_frame;
   int pad;
+  // source rectangle, the whole frame is converted when crop_width is 0
+  int crop_x;
+  int crop_y;
+  int crop_width;
+  int crop_height;
+  // bytes per pixel of each plane of the input format
+  int pixel_steps[4];
+  const AVPixFmtDescriptor *in_desc;
+  // same size yuv to rgb conversions and power of two downscales skip
+  // swscale, unless fast_path is cleared before init
+  int fast_path;
+  YuvRgbRowFn yuv_rgb_row;
+  struct YuvRgbCoeffs coeffs;
+  // the input is first reduced by 1 << box_shift, swscale or the yuv to rgb
+  // kernels only do what's left
+  int box_shift;
+  BoxScaleRowFn box_row;
+  // reduced input, its buffer is only allocated when the reduction can't be
+  // done in the output frame or in place
+  AVFrame *box_frame;
+  // set before init when the input frames may be overwritten, they're then
+  // reduced in place if nobody else references them
+  int in_place;
+  // applied to the scaled frame before padding, the text over the mask. They
+  // are not owned by the converter
+  const PrivacyMask *privacy_mask;
+  const TextOverlay *text_overlay;
+};
+
+struct VideoConverterRoi {
+  int x;
+  int y;
+  int width;
+  int height;
+  int out_width;
+  int out_height;
 };
 
 VideoConverter *video_converter_alloc();
@@ -18,6 +60,11 @@ int video_converter_init(VideoConverter *converter, int in_width, int in_height,
                          enum AVPixelFormat in_format, int out_width,
                          int out_height, enum AVPixelFormat out_format, int pad);
 
+int video_converter_init_roi(VideoConverter *converter, int in_width,
+                             int in_height, enum AVPixelFormat in_format,
+                             struct VideoConverterRoi *roi,
+                             enum AVPixelFormat out_format);
+
 int video_converter_convert(VideoConverter *converter, AVFrame *src_frame);
 
 void video_converter_free(VideoConverter **converter);
@@ -1,15 +1,98 @@
 #include "video_processor.h"
+#include <libavutil/cpu.h>
 #include <libavutil/imgutils.h>
 
 ErlNifResourceType *encoder_resource_type;
 ErlNifResourceType *decoder_resource_type;
 ErlNifResourceType *converter_resource_type;
+ErlNifResourceType *timelapse_resource_type;
+ErlNifResourceType *keyframe_index_resource_type;
+
+#define CODEC_POOL_DEFAULT_SIZE 16
+#define CODEC_POOL_DEFAULT_SIZE_PER_KEY 2
+
+static CodecPool *encoder_pool = NULL;
+static CodecPool *decoder_pool = NULL;
 
 static int get_profile(enum AVCodecID, const char *);
+static int get_color_range(ErlNifEnv *env, ERL_NIF_TERM term,
+                           enum AVColorRange *range);
+static int get_privacy_mask_shapes(ErlNifEnv *env, ERL_NIF_TERM list,
+                                   struct PrivacyMaskShape *shapes,
+                                   int *num_shapes, char **error);
 static ERL_NIF_TERM packets_to_term(ErlNifEnv *env, Encoder *encoder);
-static ERL_NIF_TERM frames_to_term(ErlNifEnv *env, Decoder *encoder);
+static ERL_NIF_TERM frames_to_term(ErlNifEnv *env,
+                                   struct NvrDecoder *nvr_decoder);
+static char *decoded_frame_to_term(ErlNifEnv *env,
+                                   struct NvrDecoder *nvr_decoder,
+                                   AVFrame *frame, ERL_NIF_TERM *term);
 static ERL_NIF_TERM nif_packet_to_term(ErlNifEnv *env, AVPacket *packet);
 static int convert_frames(struct NvrDecoder *);
+static int get_pooled_buffer(struct NvrDecoder *nvr_decoder, AVFrame *frame);
+static int parse_encoder_config(ErlNifEnv *env, ERL_NIF_TERM codec_term,
+                                ERL_NIF_TERM params_term,
+                                struct EncoderConfig *encoder_config,
+                                char **error);
+static void free_encoder_config(struct EncoderConfig *encoder_config);
+static int parse_decoder_config(ErlNifEnv *env, const ERL_NIF_TERM argv[],
+                                struct NvrDecoderConfig *decoder_config,
+                                char **error);
+static int init_nvr_encoder(struct NvrEncoder *nvr_encoder,
+                            struct EncoderConfig *encoder_config);
+static int init_nvr_decoder(struct NvrDecoder *nvr_decoder,
+                            struct NvrDecoderConfig *decoder_config);
+static int encoder_pool_key(struct EncoderConfig *encoder_config,
+                            struct CodecPoolKey *key);
+static void decoder_pool_key(struct NvrDecoderConfig *decoder_config,
+                             int width, int height, struct CodecPoolKey *key);
+static void free_pooled_encoder(void *item);
+static void free_pooled_decoder(void *item);
+static struct NvrDecoder *take_pooled_decoder(
+    struct NvrDecoderConfig *decoder_config, struct CodecPoolKey *key);
+static void put_pooled_decoder(struct NvrDecoder *item);
+static struct NvrDecoder *lease_index_decoder(KeyframeIndex *index);
+static char *decode_packet(ErlNifEnv *env, const ERL_NIF_TERM argv[],
+                           struct NvrDecoder **nvr_decoder);
+static void reset_output_rate(struct OutputRate *rate, int every,
+                              int64_t interval);
+static void select_output_frames(struct NvrDecoder *nvr_decoder);
+static int keep_closest_frame(Decoder *decoder, AVFrame *closest,
+                              int64_t target_pts);
+static char *encode_frame(ErlNifEnv *env, const ERL_NIF_TERM argv[],
+                          struct NvrEncoder **nvr_encoder);
+static int get_batch(ErlNifEnv *env, ERL_NIF_TERM list, unsigned int *length,
+                     char **error);
+static void *convert_job_run(void *arg);
+static int parse_motion_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                               struct MotionConfig *config, char **error);
+static int parse_mv_activity_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                                    struct MvActivityConfig *config,
+                                    char **error);
+static int parse_quality_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                                struct QualityConfig *config, char **error);
+static int parse_mosaic_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                               struct MosaicConfig *config, char **error);
+static int parse_timelapse_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                                  struct TimelapseConfig *config, char **error);
+static int parse_snapshot_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                                 struct NvrSnapshotConfig *config,
+                                 char **error);
+static int parse_frame_ring_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                                   struct NvrFrameRingConfig *config,
+                                   char **error);
+static int parse_jpeg_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                             struct NvrJpegConfig *config, char **error);
+static int parse_jpeg_config_key(ErlNifEnv *env, const char *config_name,
+                                 ERL_NIF_TERM value,
+                                 struct NvrJpegConfig *config, int *err);
+static char *encode_jpeg(ErlNifEnv *env, AVFrame *frame,
+                         struct NvrJpegConfig *config, ERL_NIF_TERM *term);
+static int get_codec_id(ErlNifEnv *env, ERL_NIF_TERM term,
+                        enum AVCodecID *codec_id, char **error);
+static ERL_NIF_TERM convert_bitstream(ErlNifEnv *env, const ERL_NIF_TERM argv[],
+                                      int to_annexb);
+static ERL_NIF_TERM analysis_to_term(ErlNifEnv *env,
+                                     struct NvrDecoder *nvr_decoder);
 
 ERL_NIF_TERM new_encoder(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
   if (argc != 2) {
@@ -17,226 +100,248 @@ ERL_NIF_TERM new_encoder(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
   }
 
   ERL_NIF_TERM ret;
-  struct EncoderConfig encoder_config = {0};
-  encoder_config.max_b_frames = -1;
-  encoder_config.profile = FF_PROFILE_UNKNOWN;
-
-  char *codec_name = NULL, *format = NULL, *profile = NULL;
-  struct NvrEncoder *nvr_encoder = NULL;
-
-  ErlNifMapIterator iter;
-  ERL_NIF_TERM key, value;
-  char *config_name = NULL;
-  int err;
+  struct EncoderConfig encoder_config;
+  char *error = NULL;
 
-  if (!nif_get_atom(env, argv[0], &codec_name)) {
-    return nif_raise(env, "failed_to_get_atom");
+  if (!parse_encoder_config(env, argv[0], argv[1], &encoder_config, &error)) {
+    return nif_raise(env, error);
   }
 
-  if (!enif_is_map(env, argv[1])) {
-    return nif_raise(env, "failed_to_get_map");
+  struct NvrEncoder *nvr_encoder =
+      enif_alloc_resource(encoder_resource_type, sizeof(struct NvrEncoder));
+
+  if (init_nvr_encoder(nvr_encoder, &encoder_config) < 0) {
+    ret = nif_raise(env, "failed_to_init_encoder");
+  } else {
+    ret = enif_make_resource(env, nvr_encoder);
   }
 
-  enif_map_iterator_create(env, argv[1], &iter, ERL_NIF_MAP_ITERATOR_FIRST);
+  enif_release_resource(nvr_encoder);
+  free_encoder_config(&encoder_config);
 
-  while (enif_map_iterator_get_pair(env, &iter, &key, &value)) {
-    if (!nif_get_atom(env, key, &config_name)) {
-      ret = nif_raise(env, "failed_to_get_map_key");
-      goto clean;
-    }
+  return ret;
+}
 
-    if (strcmp(config_name, "width") == 0) {
-      err = enif_get_int(env, value, &encoder_config.width);
-    } else if (strcmp(config_name, "height") == 0) {
-      err = enif_get_int(env, value, &encoder_config.height);
-    } else if (strcmp(config_name, "format") == 0) {
-      err = nif_get_atom(env, value, &format);
-    } else if (strcmp(config_name, "time_base_num") == 0) {
-      err = enif_get_int(env, value, &encoder_config.time_base.num);
-    } else if (strcmp(config_name, "time_base_den") == 0) {
-      err = enif_get_int(env, value, &encoder_config.time_base.den);
-    } else if (strcmp(config_name, "gop_size") == 0) {
-      err = enif_get_int(env, value, &encoder_config.gop_size);
-    } else if (strcmp(config_name, "max_b_frames") == 0) {
-      err = enif_get_int(env, value, &encoder_config.max_b_frames);
-    } else if (strcmp(config_name, "profile") == 0) {
-      err = nif_get_string(env, value, &profile);
-    } else if (strcmp(config_name, "preset") == 0) {
-      err = nif_get_atom(env, value, &encoder_config.preset);
-    } else if (strcmp(config_name, "tune") == 0) {
-      err = nif_get_atom(env, value, &encoder_config.tune);
-    } else {
-      ret = nif_raise(env, "unknown_config_key");
-      goto clean;
-    }
+ERL_NIF_TERM new_decoder(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  if (argc != 6) {
+    return nif_raise(env, "invalid_arg_count");
+  }
 
-    if (!err) {
-      ret = nif_raise(env, "couldnt_read_value");
-      goto clean;
-    }
+  ERL_NIF_TERM ret;
+  struct NvrDecoderConfig decoder_config;
+  ErlNifBinary extradata;
+  char *error = NULL;
 
-    enif_free(config_name);
-    config_name = NULL;
+  if (!parse_decoder_config(env, argv, &decoder_config, &error)) {
+    return nif_raise(env, error);
+  }
 
-    enif_map_iterator_next(env, &iter);
+  if (!enif_inspect_binary(env, argv[5], &extradata)) {
+    return nif_raise(env, "couldnt_inspect_binary");
   }
 
-  if (strcmp(codec_name, "h264") == 0) {
-    encoder_config.codec = avcodec_find_encoder(AV_CODEC_ID_H264);
-  } else if (strcmp(codec_name, "mjpeg") == 0) {
-    encoder_config.codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+  decoder_config.extradata = extradata.data;
+  decoder_config.extradata_size = extradata.size;
+
+  struct NvrDecoder *nvr_decoder =
+      enif_alloc_resource(decoder_resource_type, sizeof(struct NvrDecoder));
+
+  if (init_nvr_decoder(nvr_decoder, &decoder_config) < 0) {
+    ret = nif_raise(env, "failed_to_init_decoder");
   } else {
-    ret = nif_raise(env, "unknown_codec");
-    goto clean;
+    ret = enif_make_resource(env, nvr_decoder);
   }
 
-  if (!encoder_config.codec) {
-    ret = nif_raise(env, "unknown_codec");
-    goto clean;
-  }
+  enif_release_resource(nvr_decoder);
 
-  if (format == NULL) {
-    ret = nif_raise(env, "missing_format");
-    goto clean;
+  return ret;
+}
+
+ERL_NIF_TERM lease_encoder(ErlNifEnv *env, int argc,
+                           const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
   }
 
-  encoder_config.format = av_get_pix_fmt(format);
-  if (encoder_config.format == AV_PIX_FMT_NONE) {
-    ret = nif_raise(env, "unknown_format");
-    goto clean;
+  ERL_NIF_TERM ret;
+  struct EncoderConfig encoder_config;
+  struct CodecPoolKey key;
+  char *error = NULL;
+
+  if (!parse_encoder_config(env, argv[0], argv[1], &encoder_config, &error)) {
+    return nif_raise(env, error);
   }
 
-  if (profile) {
-    encoder_config.profile = get_profile(encoder_config.codec->id, profile);
-    if (encoder_config.profile == FF_PROFILE_UNKNOWN) {
-      ret = nif_raise(env, "invalid_profile");
-      goto clean;
-    }
+  // encoders without a key are freed on release instead of being pooled
+  int poolable = encoder_pool_key(&encoder_config, &key) == 0;
+  if (!poolable) {
+    key.codec_id = AV_CODEC_ID_NONE;
   }
 
-  nvr_encoder =
+  struct NvrEncoder *nvr_encoder =
       enif_alloc_resource(encoder_resource_type, sizeof(struct NvrEncoder));
-
-  nvr_encoder->encoder = encoder_alloc();
-  nvr_encoder->frame = av_frame_alloc();
-
-  if (encoder_init(nvr_encoder->encoder, &encoder_config) < 0) {
+  struct NvrEncoder *pooled =
+      poolable ? codec_pool_get(encoder_pool, &key) : NULL;
+
+  if (pooled != NULL) {
+    *nvr_encoder = *pooled;
+    enif_free(pooled);
+    ret = enif_make_resource(env, nvr_encoder);
+  } else if (init_nvr_encoder(nvr_encoder, &encoder_config) < 0) {
     ret = nif_raise(env, "failed_to_init_encoder");
-    goto clean;
+  } else {
+    ret = enif_make_resource(env, nvr_encoder);
   }
 
-  ret = enif_make_resource(env, nvr_encoder);
-
-clean:
-  // clean encoder
-  if (nvr_encoder)
-    enif_release_resource(nvr_encoder);
-  if (codec_name)
-    enif_free(codec_name);
-  if (format)
-    enif_free(format);
-  if (config_name)
-    enif_free(config_name);
-  if (profile)
-    enif_free(profile);
-  if (encoder_config.preset)
-    enif_free(encoder_config.preset);
-  if (encoder_config.tune)
-    enif_free(encoder_config.tune);
+  nvr_encoder->leased = 1;
+  nvr_encoder->pool_key = key;
 
-  enif_map_iterator_destroy(env, &iter);
+  enif_release_resource(nvr_encoder);
+  free_encoder_config(&encoder_config);
 
   return ret;
 }
 
-ERL_NIF_TERM new_decoder(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-  if (argc != 5) {
+ERL_NIF_TERM lease_decoder(ErlNifEnv *env, int argc,
+                           const ERL_NIF_TERM argv[]) {
+  if (argc != 8) {
     return nif_raise(env, "invalid_arg_count");
   }
 
   ERL_NIF_TERM ret;
-  char *codec_name = NULL, *out_format = NULL;
-  const AVCodec *codec = NULL;
-  struct NvrDecoder *nvr_decoder = NULL;
-  int out_width, out_height, pad;
+  struct NvrDecoderConfig decoder_config;
+  struct CodecPoolKey key;
+  ErlNifBinary extradata;
+  int width, height;
+  char *error = NULL;
+
+  if (!parse_decoder_config(env, argv, &decoder_config, &error)) {
+    return nif_raise(env, error);
+  }
 
-  if (!nif_get_atom(env, argv[0], &codec_name)) {
-    return nif_raise(env, "failed_to_get_atom");
+  if (!enif_get_int(env, argv[5], &width) ||
+      !enif_get_int(env, argv[6], &height)) {
+    return nif_raise(env, "failed_to_get_int");
   }
 
-  if (strcmp(codec_name, "h264") == 0) {
-    codec = avcodec_find_decoder(AV_CODEC_ID_H264);
-  } else if (strcmp(codec_name, "hevc") == 0) {
-    codec = avcodec_find_decoder(AV_CODEC_ID_HEVC);
+  if (!enif_inspect_binary(env, argv[7], &extradata)) {
+    return nif_raise(env, "couldnt_inspect_binary");
   }
 
-  if (!codec) {
-    ret = nif_raise(env, "unknown_codec");
-    goto clean;
+  decoder_config.extradata = extradata.data;
+  decoder_config.extradata_size = extradata.size;
+  decoder_pool_key(&decoder_config, width, height, &key);
+
+  struct NvrDecoder *nvr_decoder =
+      enif_alloc_resource(decoder_resource_type, sizeof(struct NvrDecoder));
+  struct NvrDecoder *pooled = take_pooled_decoder(&decoder_config, &key);
+
+  if (pooled != NULL) {
+    *nvr_decoder = *pooled;
+    enif_free(pooled);
+    ret = enif_make_resource(env, nvr_decoder);
+  } else if (init_nvr_decoder(nvr_decoder, &decoder_config) < 0) {
+    ret = nif_raise(env, "failed_to_init_decoder");
+  } else {
+    ret = enif_make_resource(env, nvr_decoder);
   }
 
-  if (!enif_get_int(env, argv[1], &out_width)) {
-    ret = nif_raise(env, "failed_to_get_int");
-    goto clean;
+  nvr_decoder->leased = 1;
+  nvr_decoder->pool_key = key;
+
+  enif_release_resource(nvr_decoder);
+
+  return ret;
+}
+
+ERL_NIF_TERM release_encoder(ErlNifEnv *env, int argc,
+                             const ERL_NIF_TERM argv[]) {
+  if (argc != 1) {
+    return nif_raise(env, "invalid_arg_count");
   }
 
-  if (!enif_get_int(env, argv[2], &out_height)) {
-    ret = nif_raise(env, "failed_to_get_int");
-    goto clean;
+  struct NvrEncoder *nvr_encoder;
+  if (!enif_get_resource(env, argv[0], encoder_resource_type,
+                         (void **)&nvr_encoder)) {
+    return nif_raise(env, "invalid_resource");
   }
 
-  if (!nif_get_atom(env, argv[3], &out_format)) {
-    ret = nif_raise(env, "failed_to_get_atom");
-    goto clean;
+  if (!nvr_encoder->leased) {
+    return nif_raise(env, "encoder_not_leased");
   }
 
-  if (!enif_get_int(env, argv[4], &pad)) {
-    ret = nif_raise(env, "failed_to_get_int");
-    goto clean;
+  if (nvr_encoder->encoder == NULL) {
+    return nif_raise(env, "encoder_released");
   }
 
-  enum AVPixelFormat out_pix_fmt = av_get_pix_fmt(out_format);
+  // move the codec context out of the resource, the term may still be
+  // referenced but can no longer be used.
+  struct NvrEncoder *item = enif_alloc(sizeof(struct NvrEncoder));
+  *item = *nvr_encoder;
+  nvr_encoder->encoder = NULL;
+  nvr_encoder->frame = NULL;
+  nvr_encoder->privacy_mask = NULL;
+  nvr_encoder->masked_frame = NULL;
+
+  // pooled encoders are not masked
+  privacy_mask_free(&item->privacy_mask);
+  av_frame_free(&item->masked_frame);
+
+  if (item->pool_key.codec_id == AV_CODEC_ID_NONE ||
+      encoder_reset(item->encoder) < 0) {
+    free_pooled_encoder(item);
+  } else {
+    codec_pool_put(encoder_pool, &item->pool_key, item);
+  }
 
-  nvr_decoder =
-      enif_alloc_resource(decoder_resource_type, sizeof(struct NvrDecoder));
+  return enif_make_atom(env, "ok");
+}
 
-  nvr_decoder->decoder = decoder_alloc();
-  nvr_decoder->packet = av_packet_alloc();
-  nvr_decoder->video_converter = NULL;
-  nvr_decoder->out_width = out_width;
-  nvr_decoder->out_height = out_height;
-  nvr_decoder->out_format = out_pix_fmt;
-  nvr_decoder->pad = pad;
+ERL_NIF_TERM release_decoder(ErlNifEnv *env, int argc,
+                             const ERL_NIF_TERM argv[]) {
+  if (argc != 1) {
+    return nif_raise(env, "invalid_arg_count");
+  }
 
-  if (decoder_init(nvr_decoder->decoder, codec) < 0) {
-    ret = nif_raise(env, "failed_to_init_decoder");
-    goto clean;
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return nif_raise(env, "couldnt_get_decoder_resource");
   }
 
-  ret = enif_make_resource(env, nvr_decoder);
+  if (!nvr_decoder->leased) {
+    return nif_raise(env, "decoder_not_leased");
+  }
 
-clean:
-  if (nvr_decoder)
-    enif_release_resource(nvr_decoder);
+  if (nvr_decoder->decoder == NULL) {
+    return nif_raise(env, "decoder_released");
+  }
 
-  if (codec_name)
-    enif_free(codec_name);
+  struct NvrDecoder *item = enif_alloc(sizeof(struct NvrDecoder));
+  *item = *nvr_decoder;
+  nvr_decoder->decoder = NULL;
+  nvr_decoder->packet = NULL;
+  nvr_decoder->video_converter = NULL;
+  nvr_decoder->motion_detector = NULL;
+  nvr_decoder->mv_activity = NULL;
+  nvr_decoder->quality_metrics = NULL;
+  nvr_decoder->frame_ring = NULL;
+  nvr_decoder->frame_pool = NULL;
 
-  if (out_format)
-    enif_free(out_format);
+  put_pooled_decoder(item);
 
-  return ret;
+  return enif_make_atom(env, "ok");
 }
 
 ERL_NIF_TERM new_converter(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-  if (argc != 7) {
+  if (argc != 8) {
     return nif_raise(env, "invalid_arg_count");
   }
 
   ERL_NIF_TERM ret;
   char *in_format = NULL, *out_format = NULL;
   struct NvrConverter *nvr_converter = NULL;
-  int in_width, in_height, out_width, out_height, pad;
+  int in_width, in_height, out_width, out_height, pad, fast_path;
 
   if (!enif_get_int(env, argv[0], &in_width)) {
     ret = nif_raise(env, "failed_to_get_int");
@@ -273,6 +378,11 @@ ERL_NIF_TERM new_converter(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[])
     goto clean;
   }
 
+  if (!enif_get_int(env, argv[7], &fast_path)) {
+    ret = nif_raise(env, "failed_to_get_int");
+    goto clean;
+  }
+
   enum AVPixelFormat in_pix_fmt = av_get_pix_fmt(in_format);
   enum AVPixelFormat out_pix_fmt = av_get_pix_fmt(out_format);
 
@@ -285,6 +395,15 @@ ERL_NIF_TERM new_converter(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[])
   nvr_converter->frame->width = in_width;
   nvr_converter->frame->height = in_height;
   nvr_converter->frame->format = in_pix_fmt;
+  nvr_converter->num_workers = 0;
+  nvr_converter->out_width = out_width;
+  nvr_converter->out_height = out_height;
+  nvr_converter->out_format = out_pix_fmt;
+  nvr_converter->pad = pad;
+  nvr_converter->num_rois = 0;
+  nvr_converter->privacy_mask = NULL;
+  nvr_converter->text_overlay = NULL;
+  nvr_converter->video_converter->fast_path = fast_path;
 
   if (video_converter_init(nvr_converter->video_converter, in_width, in_height,
                            in_pix_fmt, out_width, out_height, out_pix_fmt,
@@ -308,274 +427,3414 @@ clean:
   return ret;
 }
 
-ERL_NIF_TERM encode(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-  int ret;
-
-  if (argc != 3) {
+ERL_NIF_TERM new_roi_converter(ErlNifEnv *env, int argc,
+                               const ERL_NIF_TERM argv[]) {
+  if (argc != 5) {
     return nif_raise(env, "invalid_arg_count");
   }
 
-  struct NvrEncoder *nvr_encoder;
-  if (!enif_get_resource(env, argv[0], encoder_resource_type,
-                         (void **)&nvr_encoder)) {
-    return nif_raise(env, "invalid_resource");
-  }
+  ERL_NIF_TERM ret, head, tail;
+  char *in_format = NULL, *out_format = NULL;
+  struct NvrConverter *nvr_converter = NULL;
+  unsigned int num_rois;
+  int in_width, in_height;
 
-  ErlNifBinary input;
-  if (!enif_inspect_binary(env, argv[1], &input)) {
-    return nif_raise(env, "failed_to_inspect_binary");
+  if (!enif_get_int(env, argv[0], &in_width) ||
+      !enif_get_int(env, argv[1], &in_height)) {
+    ret = nif_raise(env, "failed_to_get_int");
+    goto clean;
   }
 
-  unsigned long pts;
-  if (!enif_get_ulong(env, argv[2], &pts)) {
-    return nif_raise(env, "failed_to_get_int");
+  if (!nif_get_atom(env, argv[2], &in_format) ||
+      !nif_get_atom(env, argv[3], &out_format)) {
+    ret = nif_raise(env, "failed_to_get_atom");
+    goto clean;
   }
 
-  AVFrame *frame = nvr_encoder->frame;
-  frame->width = nvr_encoder->encoder->c->width;
-  frame->height = nvr_encoder->encoder->c->height;
-  frame->format = nvr_encoder->encoder->c->pix_fmt;
-  frame->pts = pts;
-
-  ret = av_image_fill_arrays(frame->data, frame->linesize, input.data,
-                             frame->format, frame->width, frame->height, 1);
-  if (ret < 0) {
-    return nif_raise(env, "failed_to_fill_arrays");
+  if (!enif_get_list_length(env, argv[4], &num_rois) || num_rois == 0 ||
+      num_rois > NVR_MAX_ROIS) {
+    ret = nif_raise(env, "invalid_rois");
+    goto clean;
   }
 
-  if (encoder_encode(nvr_encoder->encoder, frame) < 0) {
-    return nif_raise(env, "failed_to_encode");
-  }
+  enum AVPixelFormat in_pix_fmt = av_get_pix_fmt(in_format);
+  enum AVPixelFormat out_pix_fmt = av_get_pix_fmt(out_format);
 
-  return packets_to_term(env, nvr_encoder->encoder);
-}
+  nvr_converter =
+      enif_alloc_resource(converter_resource_type, sizeof(struct NvrConverter));
 
-ERL_NIF_TERM decode(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-  ERL_NIF_TERM frame_term;
+  nvr_converter->video_converter = NULL;
+  nvr_converter->frame = av_frame_alloc();
+  nvr_converter->frame->width = in_width;
+  nvr_converter->frame->height = in_height;
+  nvr_converter->frame->format = in_pix_fmt;
+  nvr_converter->num_workers = 0;
+  nvr_converter->num_rois = 0;
+  nvr_converter->privacy_mask = NULL;
+  nvr_converter->text_overlay = NULL;
+
+  tail = argv[4];
+  while (enif_get_list_cell(env, tail, &head, &tail)) {
+    const ERL_NIF_TERM *items;
+    int arity;
+    struct VideoConverterRoi roi;
+
+    if (!enif_get_tuple(env, head, &arity, &items) || arity != 6 ||
+        !enif_get_int(env, items[0], &roi.x) ||
+        !enif_get_int(env, items[1], &roi.y) ||
+        !enif_get_int(env, items[2], &roi.width) ||
+        !enif_get_int(env, items[3], &roi.height) ||
+        !enif_get_int(env, items[4], &roi.out_width) ||
+        !enif_get_int(env, items[5], &roi.out_height)) {
+      ret = nif_raise(env, "invalid_rois");
+      goto clean;
+    }
 
-  if (argc != 4) {
-    return nif_raise(env, "invalid_arg_count");
-  }
+    VideoConverter *converter = video_converter_alloc();
+    nvr_converter->rois[nvr_converter->num_rois++] = converter;
 
-  struct NvrDecoder *nvr_decoder;
-  if (!enif_get_resource(env, argv[0], decoder_resource_type,
-                         (void **)&nvr_decoder)) {
-    return nif_raise(env, "couldnt_get_decoder_resource");
+    if (video_converter_init_roi(converter, in_width, in_height, in_pix_fmt,
+                                 &roi, out_pix_fmt) < 0) {
+      ret = nif_raise(env, "failed_to_init_converter");
+      goto clean;
+    }
   }
 
-  ErlNifBinary data;
-  if (!enif_inspect_binary(env, argv[1], &data)) {
-    return nif_raise(env, "couldnt_inspect_binary");
-  }
+  ret = enif_make_resource(env, nvr_converter);
 
-  unsigned long pts;
-  if (!enif_get_ulong(env, argv[2], &pts)) {
-    return nif_raise(env, "couldnt_get_int");
-  }
+clean:
+  if (nvr_converter)
+    enif_release_resource(nvr_converter);
 
-  unsigned long dts;
-  if (!enif_get_ulong(env, argv[3], &dts)) {
-    return nif_raise(env, "couldnt_get_int");
-  }
+  if (in_format)
+    enif_free(in_format);
 
-  nvr_decoder->packet->data = data.data;
-  nvr_decoder->packet->size = data.size;
-  nvr_decoder->packet->pts = pts;
-  nvr_decoder->packet->dts = dts;
+  if (out_format)
+    enif_free(out_format);
 
-  int ret = decoder_decode(nvr_decoder->decoder, nvr_decoder->packet);
-  if (ret < 0) {
-    return nif_raise(env, "failed_to_decode");
+  return ret;
+}
+
+ERL_NIF_TERM encode(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  if (argc != 3) {
+    return nif_raise(env, "invalid_arg_count");
   }
 
-  if (convert_frames(nvr_decoder) < 0) {
-    return nif_raise(env, "failed_to_convert");
+  struct NvrEncoder *nvr_encoder;
+  char *error = encode_frame(env, argv, &nvr_encoder);
+  if (error) {
+    return nif_raise(env, error);
   }
 
-  return frames_to_term(env, nvr_decoder->decoder);
+  return packets_to_term(env, nvr_encoder->encoder);
 }
 
-ERL_NIF_TERM convert(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
-  int ret;
-
+ERL_NIF_TERM encode_many(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
   if (argc != 2) {
     return nif_raise(env, "invalid_arg_count");
   }
 
-  struct NvrConverter *nvr_converter;
-  if (!enif_get_resource(env, argv[0], converter_resource_type,
-                         (void **)&nvr_converter)) {
-    return nif_raise(env, "invalid_resource");
+  unsigned int length;
+  char *error = NULL;
+  if (!get_batch(env, argv[1], &length, &error)) {
+    return nif_raise(env, error);
   }
 
-  ErlNifBinary input;
-  if (!enif_inspect_binary(env, argv[1], &input)) {
+  ERL_NIF_TERM head, tail = argv[1];
+  ERL_NIF_TERM packets = enif_make_list(env, 0);
+
+  while (enif_get_list_cell(env, tail, &head, &tail)) {
+    const ERL_NIF_TERM *items;
+    int arity;
+    if (!enif_get_tuple(env, head, &arity, &items) || arity != 2) {
+      return nif_raise(env, "invalid_frame");
+    }
+
+    struct NvrEncoder *nvr_encoder;
+    ERL_NIF_TERM frame_argv[3] = {argv[0], items[0], items[1]};
+    error = encode_frame(env, frame_argv, &nvr_encoder);
+    if (error) {
+      return nif_raise(env, error);
+    }
+
+    Encoder *encoder = nvr_encoder->encoder;
+    for (int i = 0; i < encoder->num_packets; i++) {
+      packets = enif_make_list_cell(
+          env, nif_packet_to_term(env, encoder->packets[i]), packets);
+      av_packet_unref(encoder->packets[i]);
+    }
+  }
+
+  enif_make_reverse_list(env, packets, &packets);
+  return packets;
+}
+
+ERL_NIF_TERM decode(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  if (argc != 4) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  char *error = decode_packet(env, argv, &nvr_decoder);
+  if (error) {
+    return nif_raise(env, error);
+  }
+
+  select_output_frames(nvr_decoder);
+  if (convert_frames(nvr_decoder) < 0) {
+    return nif_raise(env, "failed_to_convert");
+  }
+
+  return frames_to_term(env, nvr_decoder);
+}
+
+ERL_NIF_TERM decode_many(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  unsigned int length;
+  char *error = NULL;
+  if (!get_batch(env, argv[1], &length, &error)) {
+    return nif_raise(env, error);
+  }
+
+  ERL_NIF_TERM head, tail = argv[1];
+  ERL_NIF_TERM frames = enif_make_list(env, 0);
+
+  while (enif_get_list_cell(env, tail, &head, &tail)) {
+    const ERL_NIF_TERM *items;
+    int arity;
+    if (!enif_get_tuple(env, head, &arity, &items) || arity != 3) {
+      return nif_raise(env, "invalid_packet");
+    }
+
+    struct NvrDecoder *nvr_decoder;
+    ERL_NIF_TERM packet_argv[4] = {argv[0], items[0], items[1], items[2]};
+    error = decode_packet(env, packet_argv, &nvr_decoder);
+    if (error) {
+      return nif_raise(env, error);
+    }
+
+    select_output_frames(nvr_decoder);
+    if (convert_frames(nvr_decoder) < 0) {
+      return nif_raise(env, "failed_to_convert");
+    }
+
+    Decoder *decoder = nvr_decoder->decoder;
+    for (int i = 0; i < decoder->count_frames && !error; i++) {
+      ERL_NIF_TERM frame;
+      error = decoded_frame_to_term(env, nvr_decoder, decoder->frames[i],
+                                    &frame);
+      if (!error) {
+        frames = enif_make_list_cell(env, frame, frames);
+      }
+    }
+
+    for (int i = 0; i < decoder->count_frames; i++) {
+      av_frame_unref(decoder->frames[i]);
+    }
+
+    if (error) {
+      return nif_raise(env, error);
+    }
+  }
+
+  enif_make_reverse_list(env, frames, &frames);
+  return frames;
+}
+
+ERL_NIF_TERM decode_until(ErlNifEnv *env, int argc,
+                          const ERL_NIF_TERM argv[]) {
+  if (argc != 3) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return nif_raise(env, "couldnt_get_decoder_resource");
+  }
+
+  if (nvr_decoder->decoder == NULL) {
+    return nif_raise(env, "decoder_released");
+  }
+
+  if (!enif_is_list(env, argv[1])) {
+    return nif_raise(env, "couldnt_get_list");
+  }
+
+  ErlNifSInt64 target_pts;
+  if (!enif_get_int64(env, argv[2], &target_pts)) {
+    return nif_raise(env, "couldnt_get_int");
+  }
+
+  Decoder *decoder = nvr_decoder->decoder;
+  AVPacket *packet = nvr_decoder->packet;
+  AVFrame *closest = av_frame_alloc();
+  ERL_NIF_TERM head, tail = argv[1];
+  char *error = NULL;
+  int found = 0, sent = 0;
+
+  while (!found && enif_get_list_cell(env, tail, &head, &tail)) {
+    const ERL_NIF_TERM *items;
+    int arity;
+    ErlNifBinary data;
+    ErlNifSInt64 pts, dts;
+
+    if (!enif_get_tuple(env, head, &arity, &items) || arity != 3 ||
+        !enif_inspect_binary(env, items[0], &data) ||
+        !enif_get_int64(env, items[1], &pts) ||
+        !enif_get_int64(env, items[2], &dts)) {
+      error = "invalid_packet";
+      break;
+    }
+
+    // a frame shown at or before the target and the pictures it references are
+    // all decoded before it, the rest of the list is not needed. The first
+    // packet is always decoded to have a frame to fall back to.
+    if (dts > target_pts && sent) {
+      break;
+    }
+
+    if (pts > target_pts &&
+        decoder_is_discardable(decoder, data.data, data.size)) {
+      continue;
+    }
+
+    packet->data = data.data;
+    packet->size = data.size;
+    packet->pts = pts;
+    packet->dts = dts;
+
+    if (decoder_decode(decoder, packet) < 0) {
+      error = "failed_to_decode";
+      break;
+    }
+
+    sent = 1;
+    found = keep_closest_frame(decoder, closest, target_pts);
+  }
+
+  if (!error && !found) {
+    if (decoder_flush(decoder) < 0) {
+      error = "failed_to_flush";
+    } else {
+      keep_closest_frame(decoder, closest, target_pts);
+    }
+  }
+
+  // drop the frames still buffered in the context so the decoder can be used
+  // for another group of pictures.
+  decoder_reset(decoder);
+
+  if (error) {
+    av_frame_free(&closest);
+    return nif_raise(env, error);
+  }
+
+  if (closest->buf[0] != NULL) {
+    av_frame_move_ref(decoder->frames[0], closest);
+    decoder->count_frames = 1;
+  }
+
+  av_frame_free(&closest);
+
+  if (convert_frames(nvr_decoder) < 0) {
+    decoder_reset(decoder);
+    return nif_raise(env, "failed_to_convert");
+  }
+
+  return frames_to_term(env, nvr_decoder);
+}
+
+ERL_NIF_TERM analyze(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  if (argc != 4) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  char *error = decode_packet(env, argv, &nvr_decoder);
+  if (error) {
+    return nif_raise(env, error);
+  }
+
+  return analysis_to_term(env, nvr_decoder);
+}
+
+ERL_NIF_TERM convert(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  int ret;
+
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrConverter *nvr_converter;
+  if (!enif_get_resource(env, argv[0], converter_resource_type,
+                         (void **)&nvr_converter)) {
+    return nif_raise(env, "invalid_resource");
+  }
+
+  ErlNifBinary input;
+  if (!enif_inspect_binary(env, argv[1], &input)) {
+    return nif_raise(env, "failed_to_inspect_binary");
+  }
+
+  if (!nvr_converter->video_converter) {
+    return nif_raise(env, "invalid_converter");
+  }
+
+  AVFrame *frame = nvr_converter->frame;
+
+  ret = av_image_fill_arrays(frame->data, frame->linesize, input.data,
+                             frame->format, frame->width, frame->height, 1);
+  if (ret < 0) {
+    return nif_raise(env, "failed_to_fill_arrays");
+  }
+
+  ret = video_converter_convert(nvr_converter->video_converter, frame);
+  if (ret < 0) {
+    return nif_raise(env, "failed_to_convert");
+  }
+
+  return nif_frame_to_term(env, nvr_converter->video_converter->frame);
+}
+
+// All the regions are scaled from the same input binary, only their plane
+// pointers differ.
+ERL_NIF_TERM convert_rois(ErlNifEnv *env, int argc,
+                          const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrConverter *nvr_converter;
+  if (!enif_get_resource(env, argv[0], converter_resource_type,
+                         (void **)&nvr_converter) ||
+      nvr_converter->num_rois == 0) {
+    return nif_raise(env, "invalid_resource");
+  }
+
+  ErlNifBinary input;
+  if (!enif_inspect_binary(env, argv[1], &input)) {
     return nif_raise(env, "failed_to_inspect_binary");
   }
 
-  AVFrame *frame = nvr_converter->frame;
+  AVFrame *frame = nvr_converter->frame;
+  int in_size = av_image_get_buffer_size(frame->format, frame->width,
+                                         frame->height, 1);
+  if (in_size < 0 || (int)input.size < in_size) {
+    return nif_raise(env, "invalid_frame_size");
+  }
+
+  if (av_image_fill_arrays(frame->data, frame->linesize, input.data,
+                           frame->format, frame->width, frame->height,
+                           1) < 0) {
+    return nif_raise(env, "failed_to_fill_arrays");
+  }
+
+  ERL_NIF_TERM outputs[NVR_MAX_ROIS];
+  for (int i = 0; i < nvr_converter->num_rois; i++) {
+    VideoConverter *converter = nvr_converter->rois[i];
+
+    if (video_converter_convert(converter, frame) < 0) {
+      return nif_raise(env, "failed_to_convert");
+    }
+
+    outputs[i] = nif_frame_to_term(env, converter->frame);
+  }
+
+  return enif_make_list_from_array(env, outputs, nvr_converter->num_rois);
+}
+
+struct ConvertJob {
+  VideoConverter *converter;
+  AVFrame *frame;
+  ErlNifBinary *inputs;
+  ErlNifBinary *outputs;
+  int count;
+  int ret;
+};
+
+ERL_NIF_TERM convert_many(ErlNifEnv *env, int argc,
+                          const ERL_NIF_TERM argv[]) {
+  if (argc != 3) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrConverter *nvr_converter;
+  if (!enif_get_resource(env, argv[0], converter_resource_type,
+                         (void **)&nvr_converter)) {
+    return nif_raise(env, "invalid_resource");
+  }
+
+  if (!nvr_converter->video_converter) {
+    return nif_raise(env, "invalid_converter");
+  }
+
+  unsigned int length;
+  char *error = NULL;
+  if (!get_batch(env, argv[1], &length, &error)) {
+    return nif_raise(env, error);
+  }
+
+  int threads;
+  if (!enif_get_int(env, argv[2], &threads) || threads < 1) {
+    return nif_raise(env, "failed_to_get_int");
+  }
+
+  if (length == 0) {
+    return argv[1];
+  }
+
+  AVFrame *in_frame = nvr_converter->frame;
+  int in_size = av_image_get_buffer_size(in_frame->format, in_frame->width,
+                                         in_frame->height, 1);
+
+  ErlNifBinary inputs[NVR_MAX_BATCH_SIZE];
+  ErlNifBinary outputs[NVR_MAX_BATCH_SIZE];
+  ERL_NIF_TERM head, tail = argv[1];
+  for (unsigned int i = 0; enif_get_list_cell(env, tail, &head, &tail); i++) {
+    if (!enif_inspect_binary(env, head, &inputs[i])) {
+      return nif_raise(env, "failed_to_inspect_binary");
+    }
+
+    if ((int)inputs[i].size < in_size) {
+      return nif_raise(env, "invalid_frame_size");
+    }
+
+    outputs[i].data = NULL;
+  }
+
+  if (threads > NVR_MAX_CONVERT_THREADS) {
+    threads = NVR_MAX_CONVERT_THREADS;
+  }
+
+  if (threads > (int)length) {
+    threads = length;
+  }
+
+  // sws contexts are not thread safe, each thread gets its own converter
+  while (nvr_converter->num_workers < threads - 1) {
+    VideoConverter *worker = video_converter_alloc();
+    worker->fast_path = nvr_converter->video_converter->fast_path;
+    worker->privacy_mask = nvr_converter->privacy_mask;
+    worker->text_overlay = nvr_converter->text_overlay;
+    if (video_converter_init(worker, in_frame->width, in_frame->height,
+                             in_frame->format, nvr_converter->out_width,
+                             nvr_converter->out_height,
+                             nvr_converter->out_format, nvr_converter->pad) < 0) {
+      video_converter_free(&worker);
+      return nif_raise(env, "failed_to_init_converter");
+    }
+
+    nvr_converter->workers[nvr_converter->num_workers++] = worker;
+  }
+
+  struct ConvertJob jobs[NVR_MAX_CONVERT_THREADS];
+  ErlNifTid tids[NVR_MAX_CONVERT_THREADS];
+  int started = 1, offset = 0;
+
+  for (int i = 0; i < threads; i++) {
+    int count = (length - offset) / (threads - i);
+    jobs[i].converter =
+        i == 0 ? nvr_converter->video_converter : nvr_converter->workers[i - 1];
+    jobs[i].frame = av_frame_alloc();
+    jobs[i].frame->width = in_frame->width;
+    jobs[i].frame->height = in_frame->height;
+    jobs[i].frame->format = in_frame->format;
+    jobs[i].inputs = inputs + offset;
+    jobs[i].outputs = outputs + offset;
+    jobs[i].count = count;
+    jobs[i].ret = 0;
+    offset += count;
+  }
+
+  for (; started < threads; started++) {
+    if (enif_thread_create("nvr_convert", &tids[started], convert_job_run,
+                           &jobs[started], NULL) != 0) {
+      break;
+    }
+  }
+
+  // the calling thread takes the first share, and the share of the threads
+  // that couldn't be started.
+  convert_job_run(&jobs[0]);
+  for (int i = started; i < threads; i++) {
+    convert_job_run(&jobs[i]);
+  }
+
+  int ret = 0;
+  for (int i = 0; i < threads; i++) {
+    if (i > 0 && i < started) {
+      enif_thread_join(tids[i], NULL);
+    }
+
+    av_frame_free(&jobs[i].frame);
+    if (jobs[i].ret < 0) {
+      ret = jobs[i].ret;
+    }
+  }
+
+  if (ret < 0) {
+    for (unsigned int i = 0; i < length; i++) {
+      if (outputs[i].data != NULL) {
+        enif_release_binary(&outputs[i]);
+      }
+    }
+
+    return nif_raise(env, "failed_to_convert");
+  }
+
+  ERL_NIF_TERM results[NVR_MAX_BATCH_SIZE];
+  for (unsigned int i = 0; i < length; i++) {
+    results[i] = enif_make_binary(env, &outputs[i]);
+  }
+
+  return enif_make_list_from_array(env, results, length);
+}
+
+ERL_NIF_TERM flush_encoder(ErlNifEnv *env, int argc,
+                           const ERL_NIF_TERM argv[]) {
+  if (argc != 1) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrEncoder *nvr_encoder;
+  if (!enif_get_resource(env, argv[0], encoder_resource_type,
+                         (void **)&nvr_encoder)) {
+    return nif_raise(env, "invalid_resource");
+  }
+
+  if (nvr_encoder->encoder == NULL) {
+    return nif_raise(env, "encoder_released");
+  }
+
+  int ret = encoder_encode(nvr_encoder->encoder, NULL);
+  if (ret < 0) {
+    return nif_raise(env, "failed_to_encode");
+  }
+
+  return packets_to_term(env, nvr_encoder->encoder);
+}
+
+ERL_NIF_TERM flush_decoder(ErlNifEnv *env, int argc,
+                           const ERL_NIF_TERM argv[]) {
+  if (argc != 1) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return nif_raise(env, "couldnt_get_decoder_resource");
+  }
+
+  if (nvr_decoder->decoder == NULL) {
+    return nif_raise(env, "decoder_released");
+  }
+
+  if (decoder_flush(nvr_decoder->decoder) < 0) {
+    return nif_raise(env, "failed_to_flush");
+  }
+
+  select_output_frames(nvr_decoder);
+  if (convert_frames(nvr_decoder) < 0) {
+    return nif_raise(env, "failed_to_convert");
+  }
+
+  return frames_to_term(env, nvr_decoder);
+}
+
+ERL_NIF_TERM hibernate_decoder(ErlNifEnv *env, int argc,
+                               const ERL_NIF_TERM argv[]) {
+  if (argc != 1) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return nif_raise(env, "couldnt_get_decoder_resource");
+  }
+
+  if (nvr_decoder->decoder == NULL) {
+    return nif_raise(env, "decoder_released");
+  }
+
+  // The output configuration is kept, the converter is re-created from the
+  // first frame decoded after wake up.
+  decoder_hibernate(nvr_decoder->decoder);
+  video_converter_free(&nvr_decoder->video_converter);
+  av_buffer_pool_uninit(&nvr_decoder->frame_pool);
+
+  return enif_make_atom(env, "ok");
+}
+
+ERL_NIF_TERM enable_motion_detection(ErlNifEnv *env, int argc,
+                                     const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return nif_raise(env, "couldnt_get_decoder_resource");
+  }
+
+  if (nvr_decoder->decoder == NULL) {
+    return nif_raise(env, "decoder_released");
+  }
+
+  struct MotionConfig config;
+  char *error = NULL;
+  if (!parse_motion_config(env, argv[1], &config, &error)) {
+    return nif_raise(env, error);
+  }
+
+  if (nvr_decoder->motion_detector == NULL) {
+    nvr_decoder->motion_detector = motion_detector_alloc();
+  }
+
+  if (motion_detector_init(nvr_decoder->motion_detector, &config) < 0) {
+    motion_detector_free(&nvr_decoder->motion_detector);
+    return nif_raise(env, "invalid_motion_config");
+  }
+
+  return enif_make_atom(env, "ok");
+}
+
+ERL_NIF_TERM enable_motion_vectors(ErlNifEnv *env, int argc,
+                                   const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return nif_raise(env, "couldnt_get_decoder_resource");
+  }
+
+  if (nvr_decoder->decoder == NULL) {
+    return nif_raise(env, "decoder_released");
+  }
+
+  // the hevc decoder doesn't export motion vectors
+  if (nvr_decoder->decoder->codec->id != AV_CODEC_ID_H264) {
+    return nif_raise(env, "motion_vectors_not_supported");
+  }
+
+  struct MvActivityConfig config;
+  char *error = NULL;
+  if (!parse_mv_activity_config(env, argv[1], &config, &error)) {
+    return nif_raise(env, error);
+  }
+
+  if (nvr_decoder->mv_activity == NULL) {
+    nvr_decoder->mv_activity = mv_activity_alloc();
+  }
+
+  if (mv_activity_init(nvr_decoder->mv_activity, &config) < 0) {
+    mv_activity_free(&nvr_decoder->mv_activity);
+    return nif_raise(env, "invalid_motion_vectors_config");
+  }
+
+  decoder_export_motion_vectors(nvr_decoder->decoder, 1, config.skip_pixels);
+
+  return enif_make_atom(env, "ok");
+}
+
+ERL_NIF_TERM enable_quality_metrics(ErlNifEnv *env, int argc,
+                                    const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return nif_raise(env, "couldnt_get_decoder_resource");
+  }
+
+  if (nvr_decoder->decoder == NULL) {
+    return nif_raise(env, "decoder_released");
+  }
+
+  struct QualityConfig config;
+  char *error = NULL;
+  if (!parse_quality_config(env, argv[1], &config, &error)) {
+    return nif_raise(env, error);
+  }
+
+  if (nvr_decoder->quality_metrics == NULL) {
+    nvr_decoder->quality_metrics = quality_metrics_alloc();
+  }
+
+  if (quality_metrics_init(nvr_decoder->quality_metrics, &config) < 0) {
+    quality_metrics_free(&nvr_decoder->quality_metrics);
+    return nif_raise(env, "invalid_quality_config");
+  }
+
+  return enif_make_atom(env, "ok");
+}
+
+ERL_NIF_TERM set_output_rate(ErlNifEnv *env, int argc,
+                             const ERL_NIF_TERM argv[]) {
+  if (argc != 3) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return nif_raise(env, "couldnt_get_decoder_resource");
+  }
+
+  if (nvr_decoder->decoder == NULL) {
+    return nif_raise(env, "decoder_released");
+  }
+
+  int every;
+  ErlNifSInt64 interval;
+  if (!enif_get_int(env, argv[1], &every) ||
+      !enif_get_int64(env, argv[2], &interval)) {
+    return nif_raise(env, "couldnt_get_int");
+  }
+
+  if (every < 1 || interval < 0) {
+    return nif_raise(env, "invalid_output_rate");
+  }
+
+  reset_output_rate(&nvr_decoder->output_rate, every, interval);
+
+  return enif_make_atom(env, "ok");
+}
+
+ERL_NIF_TERM set_plane_output(ErlNifEnv *env, int argc,
+                              const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return nif_raise(env, "couldnt_get_decoder_resource");
+  }
+
+  if (nvr_decoder->decoder == NULL) {
+    return nif_raise(env, "decoder_released");
+  }
+
+  if (enif_is_identical(argv[1], enif_make_atom(env, "packed"))) {
+    nvr_decoder->plane_output = NVR_PLANES_PACKED;
+  } else if (enif_is_identical(argv[1], enif_make_atom(env, "planes"))) {
+    nvr_decoder->plane_output = NVR_PLANES_ALL;
+  } else if (enif_is_identical(argv[1], enif_make_atom(env, "luma"))) {
+    nvr_decoder->plane_output = NVR_PLANES_LUMA;
+  } else {
+    return nif_raise(env, "invalid_plane_output");
+  }
+
+  return enif_make_atom(env, "ok");
+}
+
+// Applies to converters created with new_converter and to encoders, an empty
+// list of shapes removes the mask.
+ERL_NIF_TERM set_privacy_mask(ErlNifEnv *env, int argc,
+                              const ERL_NIF_TERM argv[]) {
+  if (argc != 4) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrConverter *nvr_converter = NULL;
+  struct NvrEncoder *nvr_encoder = NULL;
+  int in_width, in_height, width, height;
+  enum AVPixelFormat format;
+
+  if (enif_get_resource(env, argv[0], converter_resource_type,
+                        (void **)&nvr_converter)) {
+    if (nvr_converter->video_converter == NULL) {
+      return nif_raise(env, "invalid_converter");
+    }
+
+    AVFrame *scaled_frame = nvr_converter->video_converter->scaled_frame;
+    in_width = nvr_converter->frame->width;
+    in_height = nvr_converter->frame->height;
+    width = scaled_frame->width;
+    height = scaled_frame->height;
+    format = scaled_frame->format;
+  } else if (enif_get_resource(env, argv[0], encoder_resource_type,
+                               (void **)&nvr_encoder)) {
+    if (nvr_encoder->encoder == NULL) {
+      return nif_raise(env, "encoder_released");
+    }
+
+    in_width = width = nvr_encoder->encoder->c->width;
+    in_height = height = nvr_encoder->encoder->c->height;
+    format = nvr_encoder->encoder->c->pix_fmt;
+  } else {
+    return nif_raise(env, "invalid_resource");
+  }
+
+  struct PrivacyMaskShape shapes[PRIVACY_MASK_MAX_SHAPES];
+  char *error = NULL;
+  int num_shapes, block_size;
+  enum PrivacyMaskMode mode;
+
+  if (!get_privacy_mask_shapes(env, argv[1], shapes, &num_shapes, &error)) {
+    return nif_raise(env, error);
+  }
+
+  if (enif_is_identical(argv[2], enif_make_atom(env, "fill"))) {
+    mode = PRIVACY_MASK_FILL;
+  } else if (enif_is_identical(argv[2], enif_make_atom(env, "pixelate"))) {
+    mode = PRIVACY_MASK_PIXELATE;
+  } else {
+    return nif_raise(env, "invalid_privacy_mask_mode");
+  }
+
+  if (!enif_get_int(env, argv[3], &block_size)) {
+    return nif_raise(env, "failed_to_get_int");
+  }
+
+  PrivacyMask *mask = NULL;
+  if (num_shapes > 0) {
+    mask = privacy_mask_alloc();
+    if (privacy_mask_init(mask, shapes, num_shapes, in_width, in_height, width,
+                          height, format, mode, block_size) < 0) {
+      privacy_mask_free(&mask);
+      return nif_raise(env, "invalid_privacy_mask");
+    }
+  }
+
+  if (nvr_converter) {
+    nvr_converter->video_converter->privacy_mask = mask;
+    for (int i = 0; i < nvr_converter->num_workers; i++) {
+      nvr_converter->workers[i]->privacy_mask = mask;
+    }
+
+    privacy_mask_free(&nvr_converter->privacy_mask);
+    nvr_converter->privacy_mask = mask;
+  } else {
+    privacy_mask_free(&nvr_encoder->privacy_mask);
+    nvr_encoder->privacy_mask = mask;
+
+    if (mask && nvr_encoder->masked_frame == NULL) {
+      AVFrame *masked = av_frame_alloc();
+      masked->width = width;
+      masked->height = height;
+      masked->format = format;
+      nvr_encoder->masked_frame = masked;
+
+      if (av_frame_get_buffer(masked, 0) < 0) {
+        privacy_mask_free(&nvr_encoder->privacy_mask);
+        av_frame_free(&nvr_encoder->masked_frame);
+        return nif_raise(env, "failed_to_alloc_frame");
+      }
+    }
+  }
+
+  return enif_make_atom(env, "ok");
+}
+
+ERL_NIF_TERM add_text_label(ErlNifEnv *env, int argc,
+                            const ERL_NIF_TERM argv[]) {
+  if (argc != 5) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrConverter *nvr_converter;
+  if (!enif_get_resource(env, argv[0], converter_resource_type,
+                         (void **)&nvr_converter)) {
+    return nif_raise(env, "invalid_resource");
+  }
+
+  if (nvr_converter->video_converter == NULL) {
+    return nif_raise(env, "invalid_converter");
+  }
+
+  int x, y, size, background;
+  if (!enif_get_int(env, argv[1], &x) || !enif_get_int(env, argv[2], &y) ||
+      !enif_get_int(env, argv[3], &size) ||
+      !enif_get_int(env, argv[4], &background)) {
+    return nif_raise(env, "failed_to_get_int");
+  }
+
+  // labels are drawn on the scaled frames
+  if (nvr_converter->text_overlay == NULL) {
+    AVFrame *scaled_frame = nvr_converter->video_converter->scaled_frame;
+    TextOverlay *overlay = text_overlay_alloc();
+
+    if (text_overlay_init(overlay, scaled_frame->width, scaled_frame->height,
+                          scaled_frame->format) < 0) {
+      text_overlay_free(&overlay);
+      return nif_raise(env, "unsupported_format");
+    }
+
+    nvr_converter->text_overlay = overlay;
+    nvr_converter->video_converter->text_overlay = overlay;
+    for (int i = 0; i < nvr_converter->num_workers; i++) {
+      nvr_converter->workers[i]->text_overlay = overlay;
+    }
+  }
+
+  int label = text_overlay_add_label(nvr_converter->text_overlay, x, y, size,
+                                     background);
+  if (label < 0) {
+    return nif_raise(env, "invalid_text_label");
+  }
+
+  return enif_make_int(env, label);
+}
+
+ERL_NIF_TERM set_label_text(ErlNifEnv *env, int argc,
+                            const ERL_NIF_TERM argv[]) {
+  if (argc != 3) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrConverter *nvr_converter;
+  if (!enif_get_resource(env, argv[0], converter_resource_type,
+                         (void **)&nvr_converter)) {
+    return nif_raise(env, "invalid_resource");
+  }
+
+  int label;
+  if (!enif_get_int(env, argv[1], &label)) {
+    return nif_raise(env, "failed_to_get_int");
+  }
+
+  ErlNifBinary text;
+  if (!enif_inspect_binary(env, argv[2], &text)) {
+    return nif_raise(env, "failed_to_inspect_binary");
+  }
+
+  if (nvr_converter->text_overlay == NULL ||
+      text_overlay_set_text(nvr_converter->text_overlay, label,
+                            (const char *)text.data, text.size) < 0) {
+    return nif_raise(env, "invalid_text_label");
+  }
+
+  return enif_make_atom(env, "ok");
+}
+
+ERL_NIF_TERM enable_frame_ring(ErlNifEnv *env, int argc,
+                               const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return nif_raise(env, "couldnt_get_decoder_resource");
+  }
+
+  if (nvr_decoder->decoder == NULL) {
+    return nif_raise(env, "decoder_released");
+  }
+
+  struct NvrFrameRingConfig config;
+  char *error = NULL;
+  if (!parse_frame_ring_config(env, argv[1], &config, &error)) {
+    return nif_raise(env, error);
+  }
+
+  frame_ring_free(&nvr_decoder->frame_ring);
+  nvr_decoder->frame_ring = frame_ring_alloc();
+
+  int ret = frame_ring_init(nvr_decoder->frame_ring, config.name, config.slots,
+                            config.slot_size, config.mode);
+  enif_free(config.name);
+
+  if (ret < 0) {
+    frame_ring_free(&nvr_decoder->frame_ring);
+  }
+
+  switch (ret) {
+  case FRAME_RING_INVALID:
+    return nif_raise(env, "invalid_frame_ring_config");
+  case FRAME_RING_EXISTS:
+    return nif_raise(env, "frame_ring_exists");
+  case FRAME_RING_FAILED:
+    return nif_raise(env, "failed_to_create_frame_ring");
+  }
+
+  return enif_make_atom(env, "ok");
+}
+
+ERL_NIF_TERM mosaic(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  if (argc != 3) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  ERL_NIF_TERM ret, head, tail = argv[1];
+  ErlNifBinary data;
+  char *error = NULL;
+  enum AVCodecID codec_id;
+  struct MosaicConfig config;
+
+  if (!get_codec_id(env, argv[0], &codec_id, &error)) {
+    return nif_raise(env, error);
+  }
+
+  if (!enif_is_list(env, argv[1])) {
+    return nif_raise(env, "failed_to_get_list");
+  }
+
+  if (!parse_mosaic_config(env, argv[2], &config, &error)) {
+    return nif_raise(env, error);
+  }
+
+  Mosaic *mosaic = mosaic_alloc();
+  AVPacket *packet = av_packet_alloc();
+
+  if (mosaic_init(mosaic, codec_id, &config) < 0) {
+    ret = nif_raise(env, "failed_to_init_mosaic");
+    goto clean;
+  }
+
+  for (int64_t pts = 0; enif_get_list_cell(env, tail, &head, &tail); pts++) {
+    if (!enif_inspect_binary(env, head, &data)) {
+      ret = nif_raise(env, "couldnt_inspect_binary");
+      goto clean;
+    }
+
+    packet->data = data.data;
+    packet->size = data.size;
+    packet->pts = pts;
+    packet->dts = pts;
+
+    if (mosaic_add_packet(mosaic, packet) < 0) {
+      ret = nif_raise(env, "failed_to_decode");
+      goto clean;
+    }
+  }
+
+  if (mosaic_encode(mosaic) < 0) {
+    ret = nif_raise(env, "failed_to_encode");
+    goto clean;
+  }
+
+  AVPacket *jpeg = mosaic->encoder->packets[0];
+  unsigned char *ptr = enif_make_new_binary(env, jpeg->size, &ret);
+  memcpy(ptr, jpeg->data, jpeg->size);
+
+clean:
+  packet->data = NULL;
+  packet->size = 0;
+  av_packet_free(&packet);
+  mosaic_free(&mosaic);
+
+  return ret;
+}
+
+ERL_NIF_TERM avcc_to_annexb(ErlNifEnv *env, int argc,
+                            const ERL_NIF_TERM argv[]) {
+  if (argc != 3) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  return convert_bitstream(env, argv, 1);
+}
+
+ERL_NIF_TERM annexb_to_avcc(ErlNifEnv *env, int argc,
+                            const ERL_NIF_TERM argv[]) {
+  if (argc != 3) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  return convert_bitstream(env, argv, 0);
+}
+
+ERL_NIF_TERM parse_parameter_sets(ErlNifEnv *env, int argc,
+                                  const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  ErlNifBinary data;
+  enum AVCodecID codec_id;
+  struct StreamInfo info;
+  char *error = NULL;
+
+  if (!enif_inspect_binary(env, argv[0], &data)) {
+    return nif_raise(env, "couldnt_inspect_binary");
+  }
+
+  if (!get_codec_id(env, argv[1], &codec_id, &error)) {
+    return nif_raise(env, error);
+  }
+
+  if (param_sets_parse(data.data, data.size, codec_id, &info) < 0) {
+    return nif_raise(env, "invalid_parameter_sets");
+  }
+
+  char *chroma_formats[] = {"monochrome", "yuv420", "yuv422", "yuv444"};
+  ERL_NIF_TERM frame_rate = enif_make_atom(env, "nil");
+  if (info.frame_rate_num > 0) {
+    frame_rate = enif_make_tuple2(env, enif_make_int(env, info.frame_rate_num),
+                                  enif_make_int(env, info.frame_rate_den));
+  }
+
+  ERL_NIF_TERM keys[] = {
+      enif_make_atom(env, "width"),         enif_make_atom(env, "height"),
+      enif_make_atom(env, "profile"),       enif_make_atom(env, "level"),
+      enif_make_atom(env, "chroma_format"), enif_make_atom(env, "bit_depth"),
+      enif_make_atom(env, "full_range"),    enif_make_atom(env, "frame_rate")};
+  ERL_NIF_TERM values[] = {
+      enif_make_int(env, info.width),
+      enif_make_int(env, info.height),
+      enif_make_int(env, info.profile),
+      enif_make_int(env, info.level),
+      enif_make_atom(env, chroma_formats[info.chroma_format]),
+      enif_make_int(env, info.bit_depth),
+      enif_make_atom(env, info.full_range ? "true" : "false"),
+      frame_rate};
+
+  ERL_NIF_TERM ret;
+  enif_make_map_from_arrays(env, keys, values, 8, &ret);
+
+  return ret;
+}
+
+ERL_NIF_TERM new_timelapse(ErlNifEnv *env, int argc,
+                           const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  ERL_NIF_TERM ret;
+  char *error = NULL;
+  enum AVCodecID codec_id;
+  struct TimelapseConfig config;
+
+  if (!get_codec_id(env, argv[0], &codec_id, &error)) {
+    return nif_raise(env, error);
+  }
+
+  if (!parse_timelapse_config(env, argv[1], &config, &error)) {
+    if (config.path) {
+      enif_free(config.path);
+    }
+
+    return nif_raise(env, error);
+  }
+
+  struct NvrTimelapse *nvr_timelapse = enif_alloc_resource(
+      timelapse_resource_type, sizeof(struct NvrTimelapse));
+  nvr_timelapse->timelapse = timelapse_alloc();
+
+  if (timelapse_init(nvr_timelapse->timelapse, codec_id, &config) < 0) {
+    ret = nif_raise(env, "failed_to_init_timelapse");
+  } else {
+    ret = enif_make_resource(env, nvr_timelapse);
+  }
+
+  enif_release_resource(nvr_timelapse);
+
+  return ret;
+}
+
+ERL_NIF_TERM timelapse_add(ErlNifEnv *env, int argc,
+                           const ERL_NIF_TERM argv[]) {
+  if (argc != 3) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrTimelapse *nvr_timelapse;
+  if (!enif_get_resource(env, argv[0], timelapse_resource_type,
+                         (void **)&nvr_timelapse)) {
+    return nif_raise(env, "invalid_resource");
+  }
+
+  if (nvr_timelapse->timelapse == NULL) {
+    return nif_raise(env, "timelapse_finished");
+  }
+
+  ErlNifBinary data;
+  if (!enif_inspect_binary(env, argv[1], &data)) {
+    return nif_raise(env, "couldnt_inspect_binary");
+  }
+
+  ErlNifSInt64 pts;
+  if (!enif_get_int64(env, argv[2], &pts)) {
+    return nif_raise(env, "couldnt_get_int");
+  }
+
+  AVPacket *packet = av_packet_alloc();
+  packet->data = data.data;
+  packet->size = data.size;
+  packet->pts = pts;
+  packet->dts = pts;
+
+  int ret = timelapse_add_packet(nvr_timelapse->timelapse, packet);
+
+  packet->data = NULL;
+  packet->size = 0;
+  av_packet_free(&packet);
+
+  if (ret < 0) {
+    return nif_raise(env, "failed_to_add_packet");
+  }
+
+  return enif_make_atom(env, ret ? "true" : "false");
+}
+
+ERL_NIF_TERM timelapse_finish(ErlNifEnv *env, int argc,
+                              const ERL_NIF_TERM argv[]) {
+  if (argc != 1) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrTimelapse *nvr_timelapse;
+  if (!enif_get_resource(env, argv[0], timelapse_resource_type,
+                         (void **)&nvr_timelapse)) {
+    return nif_raise(env, "invalid_resource");
+  }
+
+  Timelapse *timelapse = nvr_timelapse->timelapse;
+  if (timelapse == NULL) {
+    return nif_raise(env, "timelapse_finished");
+  }
+
+  // the decoder may still hold sampled keyframes, the frames are only
+  // counted once it's flushed
+  ERL_NIF_TERM ret;
+  if (timelapse_flush(timelapse) < 0) {
+    ret = nif_raise(env, "failed_to_finish_timelapse");
+  } else if (timelapse->num_frames == 0) {
+    ret = nif_raise(env, "empty_timelapse");
+  } else if (timelapse_close(timelapse) < 0) {
+    ret = nif_raise(env, "failed_to_finish_timelapse");
+  } else if (timelapse->config.path) {
+    ret = enif_make_atom(env, "ok");
+  } else {
+    unsigned char *ptr =
+        enif_make_new_binary(env, timelapse->output_size, &ret);
+    memcpy(ptr, timelapse->output, timelapse->output_size);
+  }
+
+  // the codec contexts and the output are released right away, not when the
+  // resource is garbage collected
+  timelapse_free(&nvr_timelapse->timelapse);
+
+  return ret;
+}
+
+ERL_NIF_TERM recording_snapshot(ErlNifEnv *env, int argc,
+                                const ERL_NIF_TERM argv[]) {
+  if (argc != 3) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  char *path = NULL;
+  if (!nif_get_string(env, argv[0], &path)) {
+    return nif_raise(env, "couldnt_get_string");
+  }
+
+  ErlNifSInt64 timestamp;
+  struct NvrSnapshotConfig config;
+  char *error = NULL;
+
+  if (!enif_get_int64(env, argv[1], &timestamp)) {
+    enif_free(path);
+    return nif_raise(env, "couldnt_get_int");
+  }
+
+  // like the other recording functions, everything but the type of the
+  // arguments is reported as an error tuple
+  if (!parse_snapshot_config(env, argv[2], &config, &error)) {
+    enif_free(path);
+    return nif_error(env, error);
+  }
+
+  ERL_NIF_TERM ret, data;
+  Recording *recording = recording_alloc();
+  AVFrame *frame = av_frame_alloc();
+  struct NvrDecoder *leased = NULL;
+
+  // the keyframe can be decoded without demuxing when the index is available,
+  // the decoder is then leased with the avcC/hvcC record of the index.
+  int use_index = config.index && config.method == RECORDING_SEEK_BEFORE;
+  if (use_index && (leased = lease_index_decoder(config.index)) != NULL) {
+    recording->decoder = leased->decoder;
+  }
+
+  if ((use_index ? recording_map(recording, path)
+                 : recording_open(recording, path)) < 0) {
+    ret = nif_error(env, "invalid_recording");
+  } else if ((use_index ? recording_decode_keyframe(recording, config.index,
+                                                    timestamp, frame)
+                        : recording_decode_at(recording, timestamp,
+                                              config.method, frame)) < 0) {
+    ret = nif_error(env, "failed_to_decode");
+  } else if (!config.jpeg) {
+    ret = nif_ok(env, nif_frame_to_term(env, frame));
+  } else if ((error = encode_jpeg(env, frame, &config.jpeg_config, &data)) !=
+             NULL) {
+    ret = nif_error(env, error);
+  } else {
+    ret = nif_ok(env, enif_make_tuple2(env, enif_make_int64(env, frame->pts),
+                                       data));
+  }
+
+  if (leased != NULL) {
+    recording->decoder = NULL;
+    put_pooled_decoder(leased);
+  }
+
+  av_frame_free(&frame);
+  recording_free(&recording);
+  enif_free(path);
+
+  return ret;
+}
+
+ERL_NIF_TERM build_keyframe_index(ErlNifEnv *env, int argc,
+                                  const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  char *path = NULL, *index_path = NULL;
+  if (!nif_get_string(env, argv[0], &path)) {
+    return nif_raise(env, "couldnt_get_string");
+  }
+
+  if (!nif_get_string(env, argv[1], &index_path)) {
+    enif_free(path);
+    return nif_raise(env, "couldnt_get_string");
+  }
+
+  ERL_NIF_TERM ret;
+  Recording *recording = recording_alloc();
+
+  if (recording_open(recording, path) < 0) {
+    ret = nif_error(env, "invalid_recording");
+  } else if (keyframe_index_write(recording->format_ctx,
+                                  recording->stream_index, index_path) < 0) {
+    ret = nif_error(env, "failed_to_write_index");
+  } else {
+    ret = enif_make_atom(env, "ok");
+  }
+
+  recording_free(&recording);
+  enif_free(path);
+  enif_free(index_path);
+
+  return ret;
+}
+
+ERL_NIF_TERM open_keyframe_index(ErlNifEnv *env, int argc,
+                                 const ERL_NIF_TERM argv[]) {
+  if (argc != 1) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  char *path = NULL;
+  if (!nif_get_string(env, argv[0], &path)) {
+    return nif_raise(env, "couldnt_get_string");
+  }
+
+  ERL_NIF_TERM ret;
+  struct NvrKeyframeIndex *nvr_index = enif_alloc_resource(
+      keyframe_index_resource_type, sizeof(struct NvrKeyframeIndex));
+  nvr_index->index = keyframe_index_alloc();
+
+  if (keyframe_index_open(nvr_index->index, path) < 0) {
+    ret = nif_error(env, "invalid_index");
+  } else {
+    ret = nif_ok(env, enif_make_resource(env, nvr_index));
+  }
+
+  enif_release_resource(nvr_index);
+  enif_free(path);
+
+  return ret;
+}
+
+ERL_NIF_TERM keyframe_index_lookup(ErlNifEnv *env, int argc,
+                                   const ERL_NIF_TERM argv[]) {
+  if (argc != 2) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  struct NvrKeyframeIndex *nvr_index;
+  if (!enif_get_resource(env, argv[0], keyframe_index_resource_type,
+                         (void **)&nvr_index)) {
+    return nif_raise(env, "invalid_resource");
+  }
+
+  ErlNifSInt64 timestamp;
+  if (!enif_get_int64(env, argv[1], &timestamp)) {
+    return nif_raise(env, "couldnt_get_int");
+  }
+
+  int position = keyframe_index_search(nvr_index->index, timestamp);
+  if (position < 0) {
+    return enif_make_atom(env, "nil");
+  }
+
+  struct KeyframeIndexEntry entry;
+  keyframe_index_entry(nvr_index->index, position, &entry);
+
+  return enif_make_tuple4(env, enif_make_int64(env, entry.timestamp),
+                          enif_make_int64(env, entry.offset),
+                          enif_make_uint(env, entry.size),
+                          enif_make_uint(env, entry.gop_length));
+}
+
+ERL_NIF_TERM alloc_stats(ErlNifEnv *env, int argc, const ERL_NIF_TERM argv[]) {
+  if (argc != 0) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  if (!nvr_alloc_stats_enabled()) {
+    return nif_error(env, "not_enabled");
+  }
+
+  return nif_ok(env, nvr_alloc_stats_to_term(env));
+}
+
+ERL_NIF_TERM reset_alloc_stats(ErlNifEnv *env, int argc,
+                               const ERL_NIF_TERM argv[]) {
+  if (argc != 0) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  nvr_alloc_stats_reset();
+  return enif_make_atom(env, "ok");
+}
+
+static int get_profile(enum AVCodecID codec, const char *profile_name) {
+  const AVCodecDescriptor *desc = avcodec_descriptor_get(codec);
+  const AVProfile *profile = desc->profiles;
+
+  if (profile == NULL) {
+    return FF_PROFILE_UNKNOWN;
+  }
+
+  while (profile->profile != FF_PROFILE_UNKNOWN) {
+    if (strcmp(profile->name, profile_name) == 0) {
+      break;
+    }
+
+    profile++;
+  }
+
+  return profile->profile;
+}
+
+// A list of polygons, each one a list of {x, y} points
+static int get_privacy_mask_shapes(ErlNifEnv *env, ERL_NIF_TERM list,
+                                   struct PrivacyMaskShape *shapes,
+                                   int *num_shapes, char **error) {
+  ERL_NIF_TERM head, tail = list;
+  unsigned int length;
+
+  *error = "invalid_privacy_mask";
+  if (!enif_get_list_length(env, list, &length) ||
+      length > PRIVACY_MASK_MAX_SHAPES) {
+    return 0;
+  }
+
+  *num_shapes = 0;
+  while (enif_get_list_cell(env, tail, &head, &tail)) {
+    struct PrivacyMaskShape *shape = &shapes[(*num_shapes)++];
+    ERL_NIF_TERM point, points = head;
+
+    if (!enif_get_list_length(env, points, &length) || length < 3 ||
+        length > PRIVACY_MASK_MAX_POINTS) {
+      return 0;
+    }
+
+    shape->num_points = 0;
+    while (enif_get_list_cell(env, points, &point, &points)) {
+      const ERL_NIF_TERM *items;
+      int arity, i = shape->num_points++;
+
+      if (!enif_get_tuple(env, point, &arity, &items) || arity != 2 ||
+          !enif_get_int(env, items[0], &shape->x[i]) ||
+          !enif_get_int(env, items[1], &shape->y[i])) {
+        return 0;
+      }
+    }
+  }
+
+  return 1;
+}
+
+static int get_color_range(ErlNifEnv *env, ERL_NIF_TERM term,
+                           enum AVColorRange *range) {
+  if (enif_is_identical(term, enif_make_atom(env, "full"))) {
+    *range = AVCOL_RANGE_JPEG;
+  } else if (enif_is_identical(term, enif_make_atom(env, "limited"))) {
+    *range = AVCOL_RANGE_MPEG;
+  } else {
+    return 0;
+  }
+
+  return 1;
+}
+
+static char *decode_packet(ErlNifEnv *env, const ERL_NIF_TERM argv[],
+                           struct NvrDecoder **decoder) {
+  struct NvrDecoder *nvr_decoder;
+  if (!enif_get_resource(env, argv[0], decoder_resource_type,
+                         (void **)&nvr_decoder)) {
+    return "couldnt_get_decoder_resource";
+  }
+
+  if (nvr_decoder->decoder == NULL) {
+    return "decoder_released";
+  }
+
+  ErlNifBinary data;
+  if (!enif_inspect_binary(env, argv[1], &data)) {
+    return "couldnt_inspect_binary";
+  }
+
+  ErlNifSInt64 pts;
+  if (!enif_get_int64(env, argv[2], &pts)) {
+    return "couldnt_get_int";
+  }
+
+  ErlNifSInt64 dts;
+  if (!enif_get_int64(env, argv[3], &dts)) {
+    return "couldnt_get_int";
+  }
+
+  nvr_decoder->packet->data = data.data;
+  nvr_decoder->packet->size = data.size;
+  nvr_decoder->packet->pts = pts;
+  nvr_decoder->packet->dts = dts;
+
+  if (decoder_decode(nvr_decoder->decoder, nvr_decoder->packet) < 0) {
+    return "failed_to_decode";
+  }
+
+  *decoder = nvr_decoder;
+  return NULL;
+}
+
+static void reset_output_rate(struct OutputRate *rate, int every,
+                              int64_t interval) {
+  rate->every = every;
+  rate->interval = interval;
+  rate->count = 0;
+  rate->next_pts = AV_NOPTS_VALUE;
+}
+
+// Drops the decoded frames that are not due before they are converted, the
+// kept frames are moved to the front of the frames array.
+static void select_output_frames(struct NvrDecoder *nvr_decoder) {
+  struct OutputRate *rate = &nvr_decoder->output_rate;
+  Decoder *decoder = nvr_decoder->decoder;
+  int count = 0;
+
+  if (rate->every == 1 && rate->interval == 0) {
+    return;
+  }
+
+  for (int i = 0; i < decoder->count_frames; i++) {
+    AVFrame *frame = decoder->frames[i];
+    int due = rate->count++ % rate->every == 0;
+
+    if (due && rate->interval > 0) {
+      // a jump back in time (e.g. a new stream) restarts the schedule
+      if (rate->next_pts == AV_NOPTS_VALUE ||
+          frame->pts < rate->next_pts - rate->interval) {
+        rate->next_pts = frame->pts;
+      }
+
+      due = frame->pts >= rate->next_pts;
+      if (due) {
+        // stay on the schedule unless more than one interval was missed
+        rate->next_pts += rate->interval;
+        if (rate->next_pts <= frame->pts) {
+          rate->next_pts = frame->pts + rate->interval;
+        }
+      }
+    }
+
+    if (!due) {
+      av_frame_unref(frame);
+    } else if (i != count) {
+      // swap the frames so each one of them is still allocated once
+      decoder->frames[i] = decoder->frames[count];
+      decoder->frames[count++] = frame;
+    } else {
+      count++;
+    }
+  }
+
+  decoder->count_frames = count;
+}
+
+// Keeps the last frame shown at or before the target, or the first one after
+// it when there's none. Returns 1 once the frame at the target is found.
+static int keep_closest_frame(Decoder *decoder, AVFrame *closest,
+                              int64_t target_pts) {
+  int found = 0;
+
+  for (int i = 0; i < decoder->count_frames; i++) {
+    AVFrame *frame = decoder->frames[i];
+    int64_t pts = frame->pts;
+    int better;
+
+    if (closest->buf[0] == NULL) {
+      better = 1;
+    } else if (pts <= target_pts) {
+      better = closest->pts > target_pts || pts > closest->pts;
+    } else {
+      better = closest->pts > target_pts && pts < closest->pts;
+    }
+
+    if (better) {
+      av_frame_unref(closest);
+      av_frame_move_ref(closest, frame);
+      found = pts == target_pts;
+    } else {
+      av_frame_unref(frame);
+    }
+  }
+
+  decoder->count_frames = 0;
+  return found;
+}
+
+static char *encode_frame(ErlNifEnv *env, const ERL_NIF_TERM argv[],
+                          struct NvrEncoder **encoder) {
+  struct NvrEncoder *nvr_encoder;
+  if (!enif_get_resource(env, argv[0], encoder_resource_type,
+                         (void **)&nvr_encoder)) {
+    return "invalid_resource";
+  }
+
+  if (nvr_encoder->encoder == NULL) {
+    return "encoder_released";
+  }
+
+  ErlNifBinary input;
+  if (!enif_inspect_binary(env, argv[1], &input)) {
+    return "failed_to_inspect_binary";
+  }
+
+  unsigned long pts;
+  if (!enif_get_ulong(env, argv[2], &pts)) {
+    return "failed_to_get_int";
+  }
+
+  AVFrame *frame = nvr_encoder->frame;
+  frame->width = nvr_encoder->encoder->c->width;
+  frame->height = nvr_encoder->encoder->c->height;
+  frame->format = nvr_encoder->encoder->c->pix_fmt;
+  frame->pts = pts;
+
+  if (av_image_fill_arrays(frame->data, frame->linesize, input.data,
+                           frame->format, frame->width, frame->height, 1) < 0) {
+    return "failed_to_fill_arrays";
+  }
+
+  if (nvr_encoder->privacy_mask) {
+    // the encoder may still reference the previous masked frame
+    AVFrame *masked = nvr_encoder->masked_frame;
+    if (av_frame_make_writable(masked) < 0) {
+      return "failed_to_mask_frame";
+    }
+
+    av_image_copy(masked->data, masked->linesize,
+                  (const uint8_t *const *)frame->data, frame->linesize,
+                  frame->format, frame->width, frame->height);
+    privacy_mask_apply(nvr_encoder->privacy_mask, masked->data,
+                       masked->linesize);
+
+    masked->pts = pts;
+    frame = masked;
+  }
+
+  if (encoder_encode(nvr_encoder->encoder, frame) < 0) {
+    return "failed_to_encode";
+  }
+
+  *encoder = nvr_encoder;
+  return NULL;
+}
+
+static int get_batch(ErlNifEnv *env, ERL_NIF_TERM list, unsigned int *length,
+                     char **error) {
+  if (!enif_get_list_length(env, list, length)) {
+    *error = "couldnt_get_list";
+    return 0;
+  }
+
+  if (*length > NVR_MAX_BATCH_SIZE) {
+    *error = "batch_too_large";
+    return 0;
+  }
+
+  return 1;
+}
+
+static void *convert_job_run(void *arg) {
+  struct ConvertJob *job = (struct ConvertJob *)arg;
+  AVFrame *frame = job->frame;
+
+  for (int i = 0; i < job->count; i++) {
+    job->ret = av_image_fill_arrays(frame->data, frame->linesize,
+                                    job->inputs[i].data, frame->format,
+                                    frame->width, frame->height, 1);
+    if (job->ret < 0) {
+      return NULL;
+    }
+
+    job->ret = video_converter_convert(job->converter, frame);
+    if (job->ret < 0) {
+      return NULL;
+    }
+
+    AVFrame *out = job->converter->frame;
+    int size = av_image_get_buffer_size(out->format, out->width, out->height, 1);
+    if (!enif_alloc_binary(size, &job->outputs[i])) {
+      job->outputs[i].data = NULL;
+      job->ret = AVERROR(ENOMEM);
+      return NULL;
+    }
+
+    av_image_copy_to_buffer(job->outputs[i].data, size,
+                            (const uint8_t *const *)out->data,
+                            (const int *)out->linesize, out->format, out->width,
+                            out->height, 1);
+  }
+
+  return NULL;
+}
+
+static int get_codec_id(ErlNifEnv *env, ERL_NIF_TERM term,
+                        enum AVCodecID *codec_id, char **error) {
+  char *codec_name = NULL;
+
+  if (!nif_get_atom(env, term, &codec_name)) {
+    *error = "failed_to_get_atom";
+    return 0;
+  }
+
+  *codec_id = AV_CODEC_ID_NONE;
+  if (strcmp(codec_name, "h264") == 0) {
+    *codec_id = AV_CODEC_ID_H264;
+  } else if (strcmp(codec_name, "hevc") == 0) {
+    *codec_id = AV_CODEC_ID_HEVC;
+  }
+
+  enif_free(codec_name);
+
+  if (*codec_id == AV_CODEC_ID_NONE) {
+    *error = "unknown_codec";
+    return 0;
+  }
+
+  return 1;
+}
+
+// Converts between annex b and length prefixed nal units, the output is
+// allocated once and returned with the index of the nal units it contains.
+static ERL_NIF_TERM convert_bitstream(ErlNifEnv *env, const ERL_NIF_TERM argv[],
+                                      int to_annexb) {
+  ErlNifBinary data;
+  enum AVCodecID codec_id;
+  int length_size, count;
+  char *error = NULL;
+  struct NalUnit *units = NULL;
+
+  if (!enif_inspect_binary(env, argv[0], &data)) {
+    return nif_raise(env, "couldnt_inspect_binary");
+  }
+
+  if (!get_codec_id(env, argv[1], &codec_id, &error)) {
+    return nif_raise(env, error);
+  }
+
+  if (!enif_get_int(env, argv[2], &length_size)) {
+    return nif_raise(env, "failed_to_get_int");
+  }
+
+  if (length_size != 1 && length_size != 2 && length_size != 4) {
+    return nif_raise(env, "invalid_length_size");
+  }
+
+  if (to_annexb) {
+    count = nal_parse_avcc(data.data, data.size, length_size, codec_id, &units);
+  } else {
+    count = nal_parse_annexb(data.data, data.size, codec_id, &units);
+  }
+
+  if (count < 0) {
+    return nif_raise(env, "invalid_bitstream");
+  }
+
+  if (!to_annexb && length_size < 4) {
+    for (int i = 0; i < count; i++) {
+      if (units[i].size >= (1 << (8 * length_size))) {
+        enif_free(units);
+        return nif_raise(env, "nal_unit_too_large");
+      }
+    }
+  }
+
+  ERL_NIF_TERM out_term;
+  unsigned char *out;
+  if (to_annexb) {
+    out = enif_make_new_binary(env, nal_annexb_size(units, count), &out_term);
+    nal_write_annexb(data.data, units, count, out);
+  } else {
+    out = enif_make_new_binary(env, nal_avcc_size(units, count, length_size),
+                               &out_term);
+    nal_write_avcc(data.data, units, count, length_size, out);
+  }
+
+  ERL_NIF_TERM index = enif_make_list(env, 0);
+  for (int i = count - 1; i >= 0; i--) {
+    ERL_NIF_TERM unit = enif_make_tuple3(env, enif_make_int(env, units[i].type),
+                                         enif_make_int(env, units[i].offset),
+                                         enif_make_int(env, units[i].size));
+    index = enif_make_list_cell(env, unit, index);
+  }
+
+  enif_free(units);
+
+  return enif_make_tuple2(env, out_term, index);
+}
+
+static int parse_motion_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                               struct MotionConfig *config, char **error) {
+  ErlNifMapIterator iter;
+  ERL_NIF_TERM key, value;
+  char *config_name = NULL;
+  int err, ret = 0;
+
+  motion_config_default(config);
+
+  if (!enif_is_map(env, params_term)) {
+    *error = "failed_to_get_map";
+    return 0;
+  }
+
+  enif_map_iterator_create(env, params_term, &iter,
+                           ERL_NIF_MAP_ITERATOR_FIRST);
+
+  while (enif_map_iterator_get_pair(env, &iter, &key, &value)) {
+    if (!nif_get_atom(env, key, &config_name)) {
+      *error = "failed_to_get_map_key";
+      goto clean;
+    }
+
+    if (strcmp(config_name, "downscale") == 0) {
+      err = enif_get_int(env, value, &config->downscale);
+    } else if (strcmp(config_name, "block_size") == 0) {
+      err = enif_get_int(env, value, &config->block_size);
+    } else if (strcmp(config_name, "threshold") == 0) {
+      err = enif_get_int(env, value, &config->threshold);
+    } else if (strcmp(config_name, "learning_shift") == 0) {
+      err = enif_get_int(env, value, &config->learning_shift);
+    } else if (strcmp(config_name, "max_regions") == 0) {
+      err = enif_get_int(env, value, &config->max_regions);
+    } else {
+      *error = "unknown_config_key";
+      goto clean;
+    }
+
+    if (!err) {
+      *error = "couldnt_read_value";
+      goto clean;
+    }
+
+    enif_free(config_name);
+    config_name = NULL;
+
+    enif_map_iterator_next(env, &iter);
+  }
+
+  ret = 1;
+
+clean:
+  if (config_name)
+    enif_free(config_name);
+
+  enif_map_iterator_destroy(env, &iter);
+
+  return ret;
+}
+
+static int parse_encoder_config(ErlNifEnv *env, ERL_NIF_TERM codec_term,
+                                ERL_NIF_TERM params_term,
+                                struct EncoderConfig *encoder_config,
+                                char **error) {
+  char *codec_name = NULL, *format = NULL, *profile = NULL;
+  char *config_name = NULL;
+  ErlNifMapIterator iter;
+  ERL_NIF_TERM key, value;
+  int err, ret = 0;
+
+  memset(encoder_config, 0, sizeof(struct EncoderConfig));
+  encoder_config->max_b_frames = -1;
+  encoder_config->profile = FF_PROFILE_UNKNOWN;
+
+  if (!nif_get_atom(env, codec_term, &codec_name)) {
+    *error = "failed_to_get_atom";
+    return 0;
+  }
+
+  if (!enif_is_map(env, params_term)) {
+    *error = "failed_to_get_map";
+    enif_free(codec_name);
+    return 0;
+  }
+
+  enif_map_iterator_create(env, params_term, &iter,
+                           ERL_NIF_MAP_ITERATOR_FIRST);
+
+  while (enif_map_iterator_get_pair(env, &iter, &key, &value)) {
+    if (!nif_get_atom(env, key, &config_name)) {
+      *error = "failed_to_get_map_key";
+      goto clean;
+    }
+
+    if (strcmp(config_name, "width") == 0) {
+      err = enif_get_int(env, value, &encoder_config->width);
+    } else if (strcmp(config_name, "height") == 0) {
+      err = enif_get_int(env, value, &encoder_config->height);
+    } else if (strcmp(config_name, "format") == 0) {
+      err = nif_get_atom(env, value, &format);
+    } else if (strcmp(config_name, "time_base_num") == 0) {
+      err = enif_get_int(env, value, &encoder_config->time_base.num);
+    } else if (strcmp(config_name, "time_base_den") == 0) {
+      err = enif_get_int(env, value, &encoder_config->time_base.den);
+    } else if (strcmp(config_name, "gop_size") == 0) {
+      err = enif_get_int(env, value, &encoder_config->gop_size);
+    } else if (strcmp(config_name, "max_b_frames") == 0) {
+      err = enif_get_int(env, value, &encoder_config->max_b_frames);
+    } else if (strcmp(config_name, "profile") == 0) {
+      err = nif_get_string(env, value, &profile);
+    } else if (strcmp(config_name, "preset") == 0) {
+      err = nif_get_atom(env, value, &encoder_config->preset);
+    } else if (strcmp(config_name, "tune") == 0) {
+      err = nif_get_atom(env, value, &encoder_config->tune);
+    } else if (strcmp(config_name, "quality") == 0) {
+      err = enif_get_int(env, value, &encoder_config->quality);
+    } else if (strcmp(config_name, "threads") == 0) {
+      err = enif_get_int(env, value, &encoder_config->threads);
+    } else if (strcmp(config_name, "color_range") == 0) {
+      err = get_color_range(env, value, &encoder_config->color_range);
+    } else {
+      *error = "unknown_config_key";
+      goto clean;
+    }
+
+    if (!err) {
+      *error = "couldnt_read_value";
+      goto clean;
+    }
+
+    enif_free(config_name);
+    config_name = NULL;
+
+    enif_map_iterator_next(env, &iter);
+  }
+
+  if (strcmp(codec_name, "h264") == 0) {
+    encoder_config->codec = avcodec_find_encoder(AV_CODEC_ID_H264);
+  } else if (strcmp(codec_name, "mjpeg") == 0) {
+    encoder_config->codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG);
+  }
+
+  if (!encoder_config->codec) {
+    *error = "unknown_codec";
+    goto clean;
+  }
+
+  if (format == NULL) {
+    *error = "missing_format";
+    goto clean;
+  }
+
+  encoder_config->format = av_get_pix_fmt(format);
+  if (encoder_config->format == AV_PIX_FMT_NONE) {
+    *error = "unknown_format";
+    goto clean;
+  }
+
+  if (encoder_config->quality < 0 ||
+      encoder_config->quality > NVR_JPEG_WORST_QUALITY) {
+    *error = "invalid_quality";
+    goto clean;
+  }
+
+  if (encoder_config->threads < 0) {
+    *error = "invalid_threads";
+    goto clean;
+  }
+
+  if (profile) {
+    encoder_config->profile =
+        get_profile(encoder_config->codec->id, profile);
+    if (encoder_config->profile == FF_PROFILE_UNKNOWN) {
+      *error = "invalid_profile";
+      goto clean;
+    }
+  }
+
+  ret = 1;
+
+clean:
+  if (codec_name)
+    enif_free(codec_name);
+  if (format)
+    enif_free(format);
+  if (config_name)
+    enif_free(config_name);
+  if (profile)
+    enif_free(profile);
+  if (!ret)
+    free_encoder_config(encoder_config);
+
+  enif_map_iterator_destroy(env, &iter);
+
+  return ret;
+}
+
+static void free_encoder_config(struct EncoderConfig *encoder_config) {
+  if (encoder_config->preset) {
+    enif_free(encoder_config->preset);
+    encoder_config->preset = NULL;
+  }
+
+  if (encoder_config->tune) {
+    enif_free(encoder_config->tune);
+    encoder_config->tune = NULL;
+  }
+}
+
+static int parse_decoder_config(ErlNifEnv *env, const ERL_NIF_TERM argv[],
+                                struct NvrDecoderConfig *decoder_config,
+                                char **error) {
+  char *codec_name = NULL, *out_format = NULL;
+  int ret = 0;
+
+  decoder_config->codec = NULL;
+  decoder_config->extradata = NULL;
+  decoder_config->extradata_size = 0;
+
+  if (!nif_get_atom(env, argv[0], &codec_name)) {
+    *error = "failed_to_get_atom";
+    return 0;
+  }
+
+  if (strcmp(codec_name, "h264") == 0) {
+    decoder_config->codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+  } else if (strcmp(codec_name, "hevc") == 0) {
+    decoder_config->codec = avcodec_find_decoder(AV_CODEC_ID_HEVC);
+  }
+
+  if (!decoder_config->codec) {
+    *error = "unknown_codec";
+    goto clean;
+  }
+
+  if (!enif_get_int(env, argv[1], &decoder_config->out_width)) {
+    *error = "failed_to_get_int";
+    goto clean;
+  }
+
+  if (!enif_get_int(env, argv[2], &decoder_config->out_height)) {
+    *error = "failed_to_get_int";
+    goto clean;
+  }
+
+  if (!nif_get_atom(env, argv[3], &out_format)) {
+    *error = "failed_to_get_atom";
+    goto clean;
+  }
+
+  if (!enif_get_int(env, argv[4], &decoder_config->pad)) {
+    *error = "failed_to_get_int";
+    goto clean;
+  }
+
+  decoder_config->out_format = av_get_pix_fmt(out_format);
+  ret = 1;
+
+clean:
+  if (codec_name)
+    enif_free(codec_name);
+
+  if (out_format)
+    enif_free(out_format);
+
+  return ret;
+}
+
+static int init_nvr_encoder(struct NvrEncoder *nvr_encoder,
+                            struct EncoderConfig *encoder_config) {
+  nvr_encoder->encoder = encoder_alloc();
+  nvr_encoder->frame = av_frame_alloc();
+  nvr_encoder->privacy_mask = NULL;
+  nvr_encoder->masked_frame = NULL;
+  nvr_encoder->leased = 0;
+  memset(&nvr_encoder->pool_key, 0, sizeof(struct CodecPoolKey));
+
+  return encoder_init(nvr_encoder->encoder, encoder_config);
+}
+
+static int init_nvr_decoder(struct NvrDecoder *nvr_decoder,
+                            struct NvrDecoderConfig *decoder_config) {
+  nvr_decoder->decoder = decoder_alloc();
+  nvr_decoder->packet = av_packet_alloc();
+  nvr_decoder->video_converter = NULL;
+  nvr_decoder->motion_detector = NULL;
+  nvr_decoder->mv_activity = NULL;
+  nvr_decoder->quality_metrics = NULL;
+  nvr_decoder->frame_ring = NULL;
+  nvr_decoder->frame_pool = NULL;
+  nvr_decoder->frame_pool_size = 0;
+  nvr_decoder->out_width = decoder_config->out_width;
+  nvr_decoder->out_height = decoder_config->out_height;
+  nvr_decoder->out_format = decoder_config->out_format;
+  nvr_decoder->pad = decoder_config->pad;
+  nvr_decoder->leased = 0;
+  reset_output_rate(&nvr_decoder->output_rate, 1, 0);
+  nvr_decoder->plane_output = NVR_PLANES_PACKED;
+  memset(&nvr_decoder->pool_key, 0, sizeof(struct CodecPoolKey));
+
+  if (decoder_config->extradata_size == 0) {
+    return decoder_init(nvr_decoder->decoder, decoder_config->codec);
+  }
+
+  // the parameters are kept by the decoder, the extradata survives
+  // hibernation.
+  AVCodecParameters *params = avcodec_parameters_alloc();
+  params->codec_type = AVMEDIA_TYPE_VIDEO;
+  params->codec_id = decoder_config->codec->id;
+  params->extradata = av_mallocz(decoder_config->extradata_size +
+                                 AV_INPUT_BUFFER_PADDING_SIZE);
+  params->extradata_size = decoder_config->extradata_size;
+  memcpy(params->extradata, decoder_config->extradata,
+         decoder_config->extradata_size);
+
+  int ret = decoder_init_by_parameters(nvr_decoder->decoder, params);
+  avcodec_parameters_free(&params);
+
+  return ret;
+}
+
+// Returns -1 if the options don't fit in the key, such encoders can't be
+// pooled.
+static int encoder_pool_key(struct EncoderConfig *encoder_config,
+                            struct CodecPoolKey *key) {
+  memset(key, 0, sizeof(struct CodecPoolKey));
+  key->codec_id = encoder_config->codec->id;
+  key->width = encoder_config->width;
+  key->height = encoder_config->height;
+  key->format = encoder_config->format;
+  key->extra[0] = encoder_config->time_base.num;
+  key->extra[1] = encoder_config->time_base.den;
+  key->extra[2] = encoder_config->gop_size;
+  key->extra[3] = encoder_config->max_b_frames;
+  key->extra[4] = encoder_config->profile;
+  key->extra[5] = encoder_config->quality;
+  key->extra[6] = encoder_config->threads;
+  key->extra[7] = encoder_config->color_range;
+  int size = snprintf(key->options, sizeof(key->options), "%s:%s",
+                      encoder_config->preset ? encoder_config->preset : "",
+                      encoder_config->tune ? encoder_config->tune : "");
+  return size < 0 || size >= (int)sizeof(key->options) ? -1 : 0;
+}
+
+static void decoder_pool_key(struct NvrDecoderConfig *decoder_config,
+                             int width, int height, struct CodecPoolKey *key) {
+  memset(key, 0, sizeof(struct CodecPoolKey));
+  key->codec_id = decoder_config->codec->id;
+  key->width = width;
+  key->height = height;
+  key->format = decoder_config->out_format;
+  key->extra[0] = decoder_config->out_width;
+  key->extra[1] = decoder_config->out_height;
+  key->extra[2] = decoder_config->pad;
+
+  // fnv-1a of the extradata, the pooled decoders are compared byte by byte
+  // when taken out of the pool
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < decoder_config->extradata_size; i++) {
+    hash = (hash ^ decoder_config->extradata[i]) * 16777619u;
+  }
+
+  key->extra[3] = decoder_config->extradata_size;
+  key->extra[4] = (int)hash;
+}
+
+// Takes a decoder out of the pool, NULL if none has the same config.
+static struct NvrDecoder *take_pooled_decoder(
+    struct NvrDecoderConfig *decoder_config, struct CodecPoolKey *key) {
+  struct NvrDecoder *item = codec_pool_get(decoder_pool, key);
+  if (item == NULL) {
+    return NULL;
+  }
+
+  AVCodecParameters *params = item->decoder->params;
+  int size = params ? params->extradata_size : 0;
+  if (size != decoder_config->extradata_size ||
+      (size > 0 &&
+       memcmp(params->extradata, decoder_config->extradata, size) != 0)) {
+    free_pooled_decoder(item);
+    return NULL;
+  }
+
+  return item;
+}
+
+// Resets a decoder detached from its resource and gives it back to the pool.
+static void put_pooled_decoder(struct NvrDecoder *item) {
+  // analyzers keep per stream state, they're not part of the pooled context
+  decoder_reset(item->decoder);
+  decoder_export_motion_vectors(item->decoder, 0, 0);
+  reset_output_rate(&item->output_rate, 1, 0);
+  item->plane_output = NVR_PLANES_PACKED;
+  motion_detector_free(&item->motion_detector);
+  mv_activity_free(&item->mv_activity);
+  quality_metrics_free(&item->quality_metrics);
+  frame_ring_free(&item->frame_ring);
+
+  // the converter is bound to the input geometry and pixel format, which the
+  // pool key doesn't cover. The frame pool is recreated when the buffer size
+  // changes.
+  video_converter_free(&item->video_converter);
+
+  codec_pool_put(decoder_pool, &item->pool_key, item);
+}
+
+// Leases a decoder for the keyframes of an index, the index doesn't store the
+// geometry so such decoders are pooled by codec and extradata only.
+static struct NvrDecoder *lease_index_decoder(KeyframeIndex *index) {
+  struct NvrDecoderConfig decoder_config = {
+      .codec = avcodec_find_decoder(index->codec_id),
+      .extradata = index->extradata,
+      .extradata_size = index->extradata_size,
+      .out_width = -1,
+      .out_height = -1,
+      .pad = 0,
+      .out_format = AV_PIX_FMT_NONE};
+  struct CodecPoolKey key;
+
+  if (!decoder_config.codec) {
+    return NULL;
+  }
+
+  decoder_pool_key(&decoder_config, 0, 0, &key);
+
+  struct NvrDecoder *item = take_pooled_decoder(&decoder_config, &key);
+  if (item == NULL) {
+    item = enif_alloc(sizeof(struct NvrDecoder));
+    if (init_nvr_decoder(item, &decoder_config) < 0) {
+      free_pooled_decoder(item);
+      return NULL;
+    }
+  }
+
+  item->leased = 1;
+  item->pool_key = key;
+  return item;
+}
+
+// Pre-opens the contexts of the warm up list. Warming up is only an
+// optimization, invalid entries or contexts that fail to open are skipped so
+// that the library still loads.
+static void warm_up_pools(ErlNifEnv *env, ERL_NIF_TERM list) {
+  ERL_NIF_TERM head, tail = list;
+  const ERL_NIF_TERM *elements;
+  char *error = NULL;
+  int arity;
+
+  while (enif_get_list_cell(env, tail, &head, &tail)) {
+    if (!enif_get_tuple(env, head, &arity, &elements)) {
+      NVR_LOG_DEBUG("Invalid codec pool warm up entry");
+      continue;
+    }
+
+    if (arity == 8 &&
+        enif_is_identical(elements[0], enif_make_atom(env, "decoder"))) {
+      struct NvrDecoderConfig decoder_config;
+      struct CodecPoolKey key;
+      int width, height;
+
+      if (!parse_decoder_config(env, elements + 1, &decoder_config, &error) ||
+          !enif_get_int(env, elements[6], &width) ||
+          !enif_get_int(env, elements[7], &height)) {
+        NVR_LOG_DEBUG("Invalid decoder warm up entry");
+        continue;
+      }
+
+      struct NvrDecoder *item = enif_alloc(sizeof(struct NvrDecoder));
+      if (init_nvr_decoder(item, &decoder_config) < 0) {
+        free_pooled_decoder(item);
+        continue;
+      }
+
+      decoder_pool_key(&decoder_config, width, height, &key);
+      item->leased = 1;
+      item->pool_key = key;
+      codec_pool_put(decoder_pool, &key, item);
+    } else if (arity == 3 && enif_is_identical(elements[0],
+                                               enif_make_atom(env, "encoder"))) {
+      struct EncoderConfig encoder_config;
+      struct CodecPoolKey key;
+
+      if (!parse_encoder_config(env, elements[1], elements[2], &encoder_config,
+                                &error)) {
+        NVR_LOG_DEBUG("Invalid encoder warm up entry: %s", error);
+        continue;
+      }
+
+      if (encoder_pool_key(&encoder_config, &key) < 0) {
+        NVR_LOG_DEBUG("Encoder warm up entry options are too long");
+        free_encoder_config(&encoder_config);
+        continue;
+      }
+
+      struct NvrEncoder *item = enif_alloc(sizeof(struct NvrEncoder));
+      int ret = init_nvr_encoder(item, &encoder_config);
+      free_encoder_config(&encoder_config);
+
+      if (ret < 0) {
+        free_pooled_encoder(item);
+        continue;
+      }
+
+      item->leased = 1;
+      item->pool_key = key;
+      codec_pool_put(encoder_pool, &key, item);
+    } else {
+      NVR_LOG_DEBUG("Invalid codec pool warm up entry");
+    }
+  }
+}
+
+static int convert_frames(struct NvrDecoder *nvr_decoder) {
+  int ret = 0;
+  if (nvr_decoder->decoder->count_frames == 0) {
+    return ret;
+  }
+
+  if (nvr_decoder->out_width != -1 || nvr_decoder->out_height != -1 ||
+      nvr_decoder->out_format != AV_PIX_FMT_NONE) {
+    if (nvr_decoder->video_converter == NULL) {
+      AVCodecContext *c = nvr_decoder->decoder->c;
+      nvr_decoder->video_converter = video_converter_alloc();
+      // the decoded frames are dropped once converted
+      nvr_decoder->video_converter->in_place = 1;
+      enum AVPixelFormat out_format = nvr_decoder->out_format == AV_PIX_FMT_NONE
+                                          ? c->pix_fmt
+                                          : nvr_decoder->out_format;
+      ret = video_converter_init(nvr_decoder->video_converter, c->width,
+                                 c->height, c->pix_fmt, nvr_decoder->out_width,
+                                 nvr_decoder->out_height, out_format, nvr_decoder->pad);
+      if (ret < 0)
+        return ret;
+    }
+
+    struct Decoder *decoder = nvr_decoder->decoder;
+    for (int i = 0; i < decoder->count_frames; i++) {
+      ret = video_converter_convert(nvr_decoder->video_converter,
+                                    decoder->frames[i]);
+      if (ret < 0) {
+        return ret;
+      }
+
+      AVFrame *converted = nvr_decoder->video_converter->frame;
+
+      av_frame_unref(decoder->frames[i]);
+      decoder->frames[i]->width = converted->width;
+      decoder->frames[i]->height = converted->height;
+      decoder->frames[i]->format = converted->format;
+
+      ret = get_pooled_buffer(nvr_decoder, decoder->frames[i]);
+      if (ret < 0) {
+        return ret;
+      }
+
+      ret = av_frame_copy(decoder->frames[i], converted);
+      if (ret < 0) {
+        return ret;
+      }
+
+      ret = av_frame_copy_props(decoder->frames[i], converted);
+      if (ret < 0) {
+        return ret;
+      }
+    }
+  }
+
+  return ret;
+}
+
+// The converted frames only live until they're copied to the BEAM, their
+// buffers are taken from a pool instead of being allocated for each frame.
+static int get_pooled_buffer(struct NvrDecoder *nvr_decoder, AVFrame *frame) {
+  int size = av_image_get_buffer_size(frame->format, frame->width,
+                                      frame->height, NVR_FRAME_ALIGN);
+  if (size < 0) {
+    return size;
+  }
+
+  if (nvr_decoder->frame_pool && nvr_decoder->frame_pool_size != size) {
+    av_buffer_pool_uninit(&nvr_decoder->frame_pool);
+  }
+
+  if (nvr_decoder->frame_pool == NULL) {
+    nvr_decoder->frame_pool = av_buffer_pool_init(size, NULL);
+    nvr_decoder->frame_pool_size = size;
+    if (nvr_decoder->frame_pool == NULL) {
+      return -1;
+    }
+  }
+
+  frame->buf[0] = av_buffer_pool_get(nvr_decoder->frame_pool);
+  if (frame->buf[0] == NULL) {
+    return -1;
+  }
+
+  return av_image_fill_arrays(frame->data, frame->linesize,
+                              frame->buf[0]->data, frame->format,
+                              frame->width, frame->height, NVR_FRAME_ALIGN);
+}
+
+static ERL_NIF_TERM packets_to_term(ErlNifEnv *env, Encoder *encoder) {
+  ERL_NIF_TERM ret = enif_make_list(env, 0);
+
+  for (int i = encoder->num_packets - 1; i >= 0; i--) {
+    ret = enif_make_list_cell(env, nif_packet_to_term(env, encoder->packets[i]),
+                              ret);
+  }
+
+  for (int i = 0; i < encoder->num_packets; i++)
+    av_packet_unref(encoder->packets[i]);
+
+  return ret;
+}
+
+static ERL_NIF_TERM frames_to_term(ErlNifEnv *env,
+                                   struct NvrDecoder *nvr_decoder) {
+  Decoder *decoder = nvr_decoder->decoder;
+  char *error = NULL;
+  ERL_NIF_TERM frame, ret = enif_make_list(env, 0);
+
+  // built from the end, no array is needed
+  for (int i = decoder->count_frames - 1; i >= 0 && !error; i--) {
+    error = decoded_frame_to_term(env, nvr_decoder, decoder->frames[i], &frame);
+    if (!error) {
+      ret = enif_make_list_cell(env, frame, ret);
+    }
+  }
+
+  for (int i = 0; i < decoder->count_frames; i++)
+    av_frame_unref(decoder->frames[i]);
+
+  return error ? nif_raise(env, error) : ret;
+}
+
+// With a frame ring, only the metadata of the slot the frame was published to
+// is returned. Frames that don't fit in a slot are copied to the BEAM.
+static char *decoded_frame_to_term(ErlNifEnv *env,
+                                   struct NvrDecoder *nvr_decoder,
+                                   AVFrame *frame, ERL_NIF_TERM *term) {
+  struct FrameRingEntry entry;
+  int ret = 0;
+
+  if (nvr_decoder->frame_ring != NULL) {
+    ret = frame_ring_publish(nvr_decoder->frame_ring, frame, &entry);
+  }
+
+  if (ret < 0) {
+    return "failed_to_publish_frame";
+  }
+
+  if (ret == 0) {
+    switch (nvr_decoder->plane_output) {
+    case NVR_PLANES_ALL:
+      *term = nif_planes_to_term(env, frame, AV_NUM_DATA_POINTERS);
+      break;
+    case NVR_PLANES_LUMA:
+      *term = nif_planes_to_term(env, frame, 1);
+      break;
+    default:
+      *term = nif_frame_to_term(env, frame);
+    }
+
+    return NULL;
+  }
+
+  ERL_NIF_TERM slot_terms[] = {
+      enif_make_atom(env, "slot"),
+      enif_make_int(env, entry.slot),
+      enif_make_uint64(env, entry.sequence),
+      enif_make_uint64(env, entry.frame_number),
+      enif_make_atom(env, av_get_pix_fmt_name(frame->format)),
+      enif_make_int(env, frame->width),
+      enif_make_int(env, frame->height),
+      enif_make_int64(env, frame->pts)};
+
+  *term = enif_make_tuple_from_array(env, slot_terms, 8);
+  return NULL;
+}
+
+static int parse_mv_activity_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                                    struct MvActivityConfig *config,
+                                    char **error) {
+  ErlNifMapIterator iter;
+  ERL_NIF_TERM key, value;
+  char *config_name = NULL;
+  char *atom_value = NULL;
+  int err, ret = 0;
+
+  mv_activity_config_default(config);
+
+  if (!enif_is_map(env, params_term)) {
+    *error = "failed_to_get_map";
+    return 0;
+  }
+
+  enif_map_iterator_create(env, params_term, &iter,
+                           ERL_NIF_MAP_ITERATOR_FIRST);
+
+  while (enif_map_iterator_get_pair(env, &iter, &key, &value)) {
+    if (!nif_get_atom(env, key, &config_name)) {
+      *error = "failed_to_get_map_key";
+      goto clean;
+    }
+
+    if (strcmp(config_name, "grid_width") == 0) {
+      err = enif_get_int(env, value, &config->grid_width);
+    } else if (strcmp(config_name, "grid_height") == 0) {
+      err = enif_get_int(env, value, &config->grid_height);
+    } else if (strcmp(config_name, "min_magnitude") == 0) {
+      err = enif_get_int(env, value, &config->min_magnitude);
+    } else if (strcmp(config_name, "skip_pixels") == 0) {
+      err = nif_get_atom(env, value, &atom_value);
+      if (err) {
+        config->skip_pixels = strcmp(atom_value, "true") == 0;
+        enif_free(atom_value);
+        atom_value = NULL;
+      }
+    } else {
+      *error = "unknown_config_key";
+      goto clean;
+    }
+
+    if (!err) {
+      *error = "couldnt_read_value";
+      goto clean;
+    }
+
+    enif_free(config_name);
+    config_name = NULL;
+
+    enif_map_iterator_next(env, &iter);
+  }
+
+  ret = 1;
+
+clean:
+  if (config_name)
+    enif_free(config_name);
+
+  enif_map_iterator_destroy(env, &iter);
+
+  return ret;
+}
+
+static int parse_quality_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                                struct QualityConfig *config, char **error) {
+  ErlNifMapIterator iter;
+  ERL_NIF_TERM key, value;
+  char *config_name = NULL;
+  int err, ret = 0;
+
+  quality_config_default(config);
+
+  if (!enif_is_map(env, params_term)) {
+    *error = "failed_to_get_map";
+    return 0;
+  }
+
+  enif_map_iterator_create(env, params_term, &iter,
+                           ERL_NIF_MAP_ITERATOR_FIRST);
+
+  while (enif_map_iterator_get_pair(env, &iter, &key, &value)) {
+    if (!nif_get_atom(env, key, &config_name)) {
+      *error = "failed_to_get_map_key";
+      goto clean;
+    }
+
+    if (strcmp(config_name, "interval") == 0) {
+      err = enif_get_int(env, value, &config->interval);
+    } else if (strcmp(config_name, "bins") == 0) {
+      err = enif_get_int(env, value, &config->bins);
+    } else if (strcmp(config_name, "uniformity_range") == 0) {
+      err = enif_get_int(env, value, &config->uniformity_range);
+    } else {
+      *error = "unknown_config_key";
+      goto clean;
+    }
+
+    if (!err) {
+      *error = "couldnt_read_value";
+      goto clean;
+    }
+
+    enif_free(config_name);
+    config_name = NULL;
+
+    enif_map_iterator_next(env, &iter);
+  }
+
+  ret = 1;
+
+clean:
+  if (config_name)
+    enif_free(config_name);
+
+  enif_map_iterator_destroy(env, &iter);
+
+  return ret;
+}
+
+static int parse_mosaic_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                               struct MosaicConfig *config, char **error) {
+  ErlNifMapIterator iter;
+  ERL_NIF_TERM key, value;
+  char *config_name = NULL;
+  int err, ret = 0;
+
+  mosaic_config_default(config);
+
+  if (!enif_is_map(env, params_term)) {
+    *error = "failed_to_get_map";
+    return 0;
+  }
+
+  enif_map_iterator_create(env, params_term, &iter,
+                           ERL_NIF_MAP_ITERATOR_FIRST);
+
+  while (enif_map_iterator_get_pair(env, &iter, &key, &value)) {
+    if (!nif_get_atom(env, key, &config_name)) {
+      *error = "failed_to_get_map_key";
+      goto clean;
+    }
+
+    if (strcmp(config_name, "columns") == 0) {
+      err = enif_get_int(env, value, &config->columns);
+    } else if (strcmp(config_name, "rows") == 0) {
+      err = enif_get_int(env, value, &config->rows);
+    } else if (strcmp(config_name, "tile_width") == 0) {
+      err = enif_get_int(env, value, &config->tile_width);
+    } else if (strcmp(config_name, "tile_height") == 0) {
+      err = enif_get_int(env, value, &config->tile_height);
+    } else {
+      *error = "unknown_config_key";
+      goto clean;
+    }
+
+    if (!err) {
+      *error = "couldnt_read_value";
+      goto clean;
+    }
+
+    enif_free(config_name);
+    config_name = NULL;
+
+    enif_map_iterator_next(env, &iter);
+  }
+
+  if (!mosaic_config_valid(config)) {
+    *error = "invalid_mosaic_config";
+    goto clean;
+  }
+
+  ret = 1;
+
+clean:
+  if (config_name)
+    enif_free(config_name);
+
+  enif_map_iterator_destroy(env, &iter);
+
+  return ret;
+}
+
+static int parse_timelapse_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                                  struct TimelapseConfig *config,
+                                  char **error) {
+  ErlNifMapIterator iter;
+  ERL_NIF_TERM key, value;
+  char *config_name = NULL;
+  char *atom_value = NULL;
+  int err, ret = 0;
+
+  timelapse_config_default(config);
+
+  if (!enif_is_map(env, params_term)) {
+    *error = "failed_to_get_map";
+    return 0;
+  }
+
+  enif_map_iterator_create(env, params_term, &iter,
+                           ERL_NIF_MAP_ITERATOR_FIRST);
+
+  while (enif_map_iterator_get_pair(env, &iter, &key, &value)) {
+    if (!nif_get_atom(env, key, &config_name)) {
+      *error = "failed_to_get_map_key";
+      goto clean;
+    }
+
+    if (strcmp(config_name, "width") == 0) {
+      err = enif_get_int(env, value, &config->width);
+    } else if (strcmp(config_name, "height") == 0) {
+      err = enif_get_int(env, value, &config->height);
+    } else if (strcmp(config_name, "frame_rate") == 0) {
+      err = enif_get_int(env, value, &config->frame_rate);
+    } else if (strcmp(config_name, "gop_size") == 0) {
+      err = enif_get_int(env, value, &config->gop_size);
+    } else if (strcmp(config_name, "interval") == 0) {
+      ErlNifSInt64 interval;
+      err = enif_get_int64(env, value, &interval);
+      config->interval = interval;
+    } else if (strcmp(config_name, "format") == 0) {
+      err = nif_get_atom(env, value, &atom_value);
+      if (err && strcmp(atom_value, "mp4") == 0) {
+        config->format = TIMELAPSE_FORMAT_MP4;
+      } else if (err && strcmp(atom_value, "h264") == 0) {
+        config->format = TIMELAPSE_FORMAT_H264;
+      } else {
+        err = 0;
+      }
+    } else if (strcmp(config_name, "path") == 0) {
+      err = config->path == NULL && nif_get_string(env, value, &config->path);
+    } else {
+      *error = "unknown_config_key";
+      goto clean;
+    }
+
+    if (!err) {
+      *error = "couldnt_read_value";
+      goto clean;
+    }
+
+    enif_free(config_name);
+    config_name = NULL;
+
+    if (atom_value) {
+      enif_free(atom_value);
+      atom_value = NULL;
+    }
+
+    enif_map_iterator_next(env, &iter);
+  }
+
+  ret = 1;
+
+clean:
+  if (config_name)
+    enif_free(config_name);
+
+  if (atom_value)
+    enif_free(atom_value);
+
+  enif_map_iterator_destroy(env, &iter);
+
+  return ret;
+}
+
+static int parse_snapshot_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                                 struct NvrSnapshotConfig *config,
+                                 char **error) {
+  ErlNifMapIterator iter;
+  ERL_NIF_TERM key, value;
+  char *config_name = NULL;
+  char *atom_value = NULL;
+  int err, ret = 0;
+
+  config->method = RECORDING_SEEK_BEFORE;
+  config->jpeg = 1;
+  config->index = NULL;
+  memset(&config->jpeg_config, 0, sizeof(struct NvrJpegConfig));
+
+  if (!enif_is_map(env, params_term)) {
+    *error = "failed_to_get_map";
+    return 0;
+  }
+
+  enif_map_iterator_create(env, params_term, &iter,
+                           ERL_NIF_MAP_ITERATOR_FIRST);
+
+  while (enif_map_iterator_get_pair(env, &iter, &key, &value)) {
+    if (!nif_get_atom(env, key, &config_name)) {
+      *error = "failed_to_get_map_key";
+      goto clean;
+    }
+
+    if (strcmp(config_name, "method") == 0) {
+      err = nif_get_atom(env, value, &atom_value);
+      if (err && strcmp(atom_value, "before") == 0) {
+        config->method = RECORDING_SEEK_BEFORE;
+      } else if (err && strcmp(atom_value, "precise") == 0) {
+        config->method = RECORDING_SEEK_PRECISE;
+      } else {
+        err = 0;
+      }
+    } else if (strcmp(config_name, "format") == 0) {
+      err = nif_get_atom(env, value, &atom_value);
+      if (err && strcmp(atom_value, "jpeg") == 0) {
+        config->jpeg = 1;
+      } else if (err && strcmp(atom_value, "frame") == 0) {
+        config->jpeg = 0;
+      } else {
+        err = 0;
+      }
+    } else if (strcmp(config_name, "index") == 0) {
+      struct NvrKeyframeIndex *nvr_index;
+      err = enif_get_resource(env, value, keyframe_index_resource_type,
+                              (void **)&nvr_index);
+      if (err) {
+        config->index = nvr_index->index;
+      }
+    } else if (!parse_jpeg_config_key(env, config_name, value,
+                                      &config->jpeg_config, &err)) {
+      *error = "unknown_config_key";
+      goto clean;
+    }
+
+    if (!err) {
+      *error = "couldnt_read_value";
+      goto clean;
+    }
+
+    enif_free(config_name);
+    config_name = NULL;
+
+    if (atom_value) {
+      enif_free(atom_value);
+      atom_value = NULL;
+    }
+
+    enif_map_iterator_next(env, &iter);
+  }
+
+  ret = 1;
+
+clean:
+  if (config_name)
+    enif_free(config_name);
+
+  if (atom_value)
+    enif_free(atom_value);
+
+  enif_map_iterator_destroy(env, &iter);
+
+  return ret;
+}
+
+static int parse_frame_ring_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                                   struct NvrFrameRingConfig *config,
+                                   char **error) {
+  ErlNifMapIterator iter;
+  ERL_NIF_TERM key, value;
+  char *config_name = NULL;
+  int err, ret = 0;
+
+  config->name = NULL;
+  config->slots = 4;
+  config->slot_size = 0;
+  config->mode = 0640;
+
+  if (!enif_is_map(env, params_term)) {
+    *error = "failed_to_get_map";
+    return 0;
+  }
+
+  enif_map_iterator_create(env, params_term, &iter,
+                           ERL_NIF_MAP_ITERATOR_FIRST);
 
-  ret = av_image_fill_arrays(frame->data, frame->linesize, input.data,
-                             frame->format, frame->width, frame->height, 1);
-  if (ret < 0) {
-    return nif_raise(env, "failed_to_fill_arrays");
+  while (enif_map_iterator_get_pair(env, &iter, &key, &value)) {
+    if (!nif_get_atom(env, key, &config_name)) {
+      *error = "failed_to_get_map_key";
+      goto clean;
+    }
+
+    if (strcmp(config_name, "name") == 0) {
+      err = config->name == NULL && nif_get_string(env, value, &config->name);
+    } else if (strcmp(config_name, "slots") == 0) {
+      err = enif_get_int(env, value, &config->slots);
+    } else if (strcmp(config_name, "slot_size") == 0) {
+      ErlNifSInt64 slot_size;
+      err = enif_get_int64(env, value, &slot_size);
+      config->slot_size = slot_size;
+    } else if (strcmp(config_name, "mode") == 0) {
+      err = enif_get_int(env, value, &config->mode);
+    } else {
+      *error = "unknown_config_key";
+      goto clean;
+    }
+
+    if (!err) {
+      *error = "couldnt_read_value";
+      goto clean;
+    }
+
+    enif_free(config_name);
+    config_name = NULL;
+
+    enif_map_iterator_next(env, &iter);
   }
 
-  ret = video_converter_convert(nvr_converter->video_converter, frame);
-  if (ret < 0) {
-    return nif_raise(env, "failed_to_convert");
+  if (config->name == NULL) {
+    *error = "missing_frame_ring_name";
+    goto clean;
   }
 
-  return nif_frame_to_term(env, nvr_converter->video_converter->frame);
+  ret = 1;
+
+clean:
+  if (config_name)
+    enif_free(config_name);
+
+  if (!ret && config->name) {
+    enif_free(config->name);
+    config->name = NULL;
+  }
+
+  enif_map_iterator_destroy(env, &iter);
+
+  return ret;
 }
 
+// Returns 1 if the key is one of the jpeg options, err is then set to whether
+// its value was read.
+static int parse_jpeg_config_key(ErlNifEnv *env, const char *config_name,
+                                 ERL_NIF_TERM value,
+                                 struct NvrJpegConfig *config, int *err) {
+  if (strcmp(config_name, "quality") == 0) {
+    *err = enif_get_int(env, value, &config->quality) &&
+           config->quality >= 0 && config->quality <= NVR_JPEG_WORST_QUALITY;
+  } else if (strcmp(config_name, "max_size") == 0) {
+    *err = enif_get_int(env, value, &config->max_size) &&
+           config->max_size >= 0;
+  } else if (strcmp(config_name, "threads") == 0) {
+    *err = enif_get_int(env, value, &config->threads) && config->threads >= 0;
+  } else if (strcmp(config_name, "color_range") == 0) {
+    *err = get_color_range(env, value, &config->color_range);
+  } else {
+    return 0;
+  }
+
+  return 1;
+}
 
-ERL_NIF_TERM flush_encoder(ErlNifEnv *env, int argc,
-                           const ERL_NIF_TERM argv[]) {
-  if (argc != 1) {
-    return nif_raise(env, "invalid_arg_count");
+static int parse_jpeg_config(ErlNifEnv *env, ERL_NIF_TERM params_term,
+                             struct NvrJpegConfig *config, char **error) {
+  ErlNifMapIterator iter;
+  ERL_NIF_TERM key, value;
+  char *config_name = NULL;
+  int err, ret = 0;
+
+  memset(config, 0, sizeof(struct NvrJpegConfig));
+
+  if (!enif_is_map(env, params_term)) {
+    *error = "failed_to_get_map";
+    return 0;
   }
 
-  struct NvrEncoder *nvr_encoder;
-  if (!enif_get_resource(env, argv[0], encoder_resource_type,
-                         (void **)&nvr_encoder)) {
-    return nif_raise(env, "invalid_resource");
+  enif_map_iterator_create(env, params_term, &iter,
+                           ERL_NIF_MAP_ITERATOR_FIRST);
+
+  while (enif_map_iterator_get_pair(env, &iter, &key, &value)) {
+    if (!nif_get_atom(env, key, &config_name)) {
+      *error = "failed_to_get_map_key";
+      goto clean;
+    }
+
+    if (!parse_jpeg_config_key(env, config_name, value, config, &err)) {
+      *error = "unknown_config_key";
+      goto clean;
+    }
+
+    if (!err) {
+      *error = "couldnt_read_value";
+      goto clean;
+    }
+
+    enif_free(config_name);
+    config_name = NULL;
+
+    enif_map_iterator_next(env, &iter);
   }
 
-  int ret = encoder_encode(nvr_encoder->encoder, NULL);
-  if (ret < 0) {
-    return nif_raise(env, "failed_to_encode");
+  ret = 1;
+
+clean:
+  if (config_name)
+    enif_free(config_name);
+
+  enif_map_iterator_destroy(env, &iter);
+
+  return ret;
+}
+
+// Encodes a single image, the packet is owned by the encoder
+static AVPacket *encode_jpeg_image(Encoder *encoder, AVFrame *frame,
+                                   int quality) {
+  frame->quality = quality * FF_QP2LAMBDA;
+
+  if (encoder_encode(encoder, frame) < 0 ||
+      (encoder->num_packets == 0 && encoder_encode(encoder, NULL) < 0) ||
+      encoder->num_packets == 0) {
+    return NULL;
   }
 
-  return packets_to_term(env, nvr_encoder->encoder);
+  return encoder->packets[0];
 }
 
-ERL_NIF_TERM flush_decoder(ErlNifEnv *env, int argc,
-                           const ERL_NIF_TERM argv[]) {
-  if (argc != 1) {
-    return nif_raise(env, "invalid_arg_count");
+// Encodes the frame the same way as `VideoProcessor.encode_to_jpeg/2`, with an
+// mjpeg encoder taken from the pool.
+// yuv420p frames are encoded as they are, their range is signalled in the
+// image instead of being converted. Other formats are converted to yuvj420p.
+// With a maximum size, the quantizer is searched for the best quality that
+// fits, each step encodes the frame again.
+static char *encode_jpeg(ErlNifEnv *env, AVFrame *frame,
+                         struct NvrJpegConfig *config, ERL_NIF_TERM *term) {
+  int direct = frame->format == AV_PIX_FMT_YUVJ420P;
+  enum AVColorRange color_range = AVCOL_RANGE_JPEG;
+
+  // limited range images are only understood by libav based decoders, yuv420p
+  // frames are converted to full range unless the caller gives their range
+  if (frame->format == AV_PIX_FMT_YUV420P) {
+    if (config->color_range != AVCOL_RANGE_UNSPECIFIED) {
+      direct = 1;
+      color_range = config->color_range;
+    } else {
+      direct = frame->color_range == AVCOL_RANGE_JPEG;
+    }
   }
 
-  struct NvrDecoder *nvr_decoder;
-  if (!enif_get_resource(env, argv[0], decoder_resource_type,
-                         (void **)&nvr_decoder)) {
-    return nif_raise(env, "couldnt_get_decoder_resource");
+  int threads = config->threads;
+  if (threads == 0) {
+    threads = frame->width * frame->height > NVR_JPEG_SLICE_PIXELS
+                  ? FFMIN(av_cpu_count(), NVR_JPEG_MAX_THREADS)
+                  : 1;
   }
 
-  if (decoder_flush(nvr_decoder->decoder) < 0) {
-    return nif_raise(env, "failed_to_flush");
+  int quality = config->quality;
+  if (quality == 0 && config->max_size > 0) {
+    quality = NVR_JPEG_BEST_QUALITY;
   }
 
-  if (convert_frames(nvr_decoder) < 0) {
-    return nif_raise(env, "failed_to_convert");
+  struct CodecPoolKey key;
+  struct EncoderConfig encoder_config = {
+      .media_type = AVMEDIA_TYPE_VIDEO,
+      .codec = avcodec_find_encoder(AV_CODEC_ID_MJPEG),
+      .width = frame->width,
+      .height = frame->height,
+      .format = direct ? frame->format : AV_PIX_FMT_YUVJ420P,
+      .time_base = (AVRational){1, 30},
+      .gop_size = 0,
+      .max_b_frames = -1,
+      .profile = FF_PROFILE_UNKNOWN,
+      .preset = NULL,
+      .tune = NULL,
+      .quality = quality,
+      .threads = threads,
+      .color_range = color_range};
+
+  if (!encoder_config.codec) {
+    return "unknown_codec";
   }
 
-  return frames_to_term(env, nvr_decoder->decoder);
-}
+  encoder_pool_key(&encoder_config, &key);
 
-static int get_profile(enum AVCodecID codec, const char *profile_name) {
-  const AVCodecDescriptor *desc = avcodec_descriptor_get(codec);
-  const AVProfile *profile = desc->profiles;
+  struct NvrEncoder *nvr_encoder = codec_pool_get(encoder_pool, &key);
+  if (nvr_encoder == NULL) {
+    nvr_encoder = enif_alloc(sizeof(struct NvrEncoder));
+    if (init_nvr_encoder(nvr_encoder, &encoder_config) < 0) {
+      free_pooled_encoder(nvr_encoder);
+      return "failed_to_init_encoder";
+    }
+  }
 
-  if (profile == NULL) {
-    return FF_PROFILE_UNKNOWN;
+  nvr_encoder->leased = 1;
+  nvr_encoder->pool_key = key;
+
+  Encoder *encoder = nvr_encoder->encoder;
+  VideoConverter *converter = NULL;
+  AVFrame *input = frame;
+  AVPacket *best = av_packet_alloc();
+  char *error = NULL;
+
+  if (!direct) {
+    converter = video_converter_alloc();
+    if (video_converter_init(converter, frame->width, frame->height,
+                             frame->format, -1, -1, AV_PIX_FMT_YUVJ420P,
+                             0) < 0 ||
+        video_converter_convert(converter, frame) < 0) {
+      error = "failed_to_convert";
+    }
+
+    input = converter->frame;
   }
 
-  while (profile->profile != FF_PROFILE_UNKNOWN) {
-    if (strcmp(profile->name, profile_name) == 0) {
+  int low = quality, high = NVR_JPEG_WORST_QUALITY;
+  while (!error) {
+    AVPacket *jpeg = encode_jpeg_image(encoder, input, quality);
+    if (jpeg == NULL) {
+      error = "failed_to_encode";
       break;
     }
 
-    profile++;
-  }
+    int fits = config->max_size == 0 || jpeg->size <= config->max_size;
+    if (fits || quality == NVR_JPEG_WORST_QUALITY) {
+      av_packet_unref(best);
+      av_packet_move_ref(best, jpeg);
+    }
 
-  return profile->profile;
-}
+    for (int i = 0; i < encoder->num_packets; i++) {
+      av_packet_unref(encoder->packets[i]);
+    }
+    encoder->num_packets = 0;
 
-static int convert_frames(struct NvrDecoder *nvr_decoder) {
-  int ret = 0;
-  if (nvr_decoder->out_width != -1 || nvr_decoder->out_height != -1 ||
-      nvr_decoder->out_format != AV_PIX_FMT_NONE) {
-    if (nvr_decoder->video_converter == NULL) {
-      AVCodecContext *c = nvr_decoder->decoder->c;
-      nvr_decoder->video_converter = video_converter_alloc();
-      enum AVPixelFormat out_format = nvr_decoder->out_format == AV_PIX_FMT_NONE
-                                          ? c->pix_fmt
-                                          : nvr_decoder->out_format;
-      ret = video_converter_init(nvr_decoder->video_converter, c->width,
-                                 c->height, c->pix_fmt, nvr_decoder->out_width,
-                                 nvr_decoder->out_height, out_format, nvr_decoder->pad);
-      if (ret < 0)
-        return ret;
+    if (fits) {
+      high = quality - 1;
+    } else {
+      low = quality + 1;
     }
 
-    struct Decoder *decoder = nvr_decoder->decoder;
-    for (int i = 0; i < decoder->count_frames; i++) {
-      ret = video_converter_convert(nvr_decoder->video_converter,
-                                    decoder->frames[i]);
-      if (ret < 0) {
-        return ret;
-      }
+    if (config->max_size == 0 || low > high) {
+      break;
+    }
 
-      AVFrame *converted = nvr_decoder->video_converter->frame;
+    quality = (low + high) / 2;
+  }
 
-      av_frame_unref(decoder->frames[i]);
-      decoder->frames[i]->width = converted->width;
-      decoder->frames[i]->height = converted->height;
-      decoder->frames[i]->format = converted->format;
+  if (!error) {
+    unsigned char *ptr = enif_make_new_binary(env, best->size, term);
+    memcpy(ptr, best->data, best->size);
+  }
 
-      ret = av_frame_get_buffer(decoder->frames[i], 0);
-      if (ret < 0) {
-        return ret;
-      }
+  for (int i = 0; i < encoder->num_packets; i++) {
+    av_packet_unref(encoder->packets[i]);
+  }
 
-      ret = av_frame_copy(decoder->frames[i], converted);
-      if (ret < 0) {
-        return ret;
-      }
+  encoder->num_packets = 0;
+  av_packet_free(&best);
+  video_converter_free(&converter);
 
-      ret = av_frame_copy_props(decoder->frames[i], converted);
-      if (ret < 0) {
-        return ret;
-      }
-    }
+  if (encoder_reset(encoder) < 0) {
+    free_pooled_encoder(nvr_encoder);
+  } else {
+    codec_pool_put(encoder_pool, &key, nvr_encoder);
   }
 
-  return ret;
+  return error;
 }
 
-static ERL_NIF_TERM packets_to_term(ErlNifEnv *env, Encoder *encoder) {
+ERL_NIF_TERM encode_to_jpeg(ErlNifEnv *env, int argc,
+                            const ERL_NIF_TERM argv[]) {
+  if (argc != 5) {
+    return nif_raise(env, "invalid_arg_count");
+  }
+
+  ErlNifBinary data;
+  char *format = NULL, *error = NULL;
+  int width, height;
+  struct NvrJpegConfig config;
+
+  if (!enif_inspect_binary(env, argv[0], &data)) {
+    return nif_raise(env, "failed_to_inspect_binary");
+  }
+
+  if (!enif_get_int(env, argv[2], &width) ||
+      !enif_get_int(env, argv[3], &height)) {
+    return nif_raise(env, "failed_to_get_int");
+  }
+
+  if (!parse_jpeg_config(env, argv[4], &config, &error)) {
+    return nif_raise(env, error);
+  }
+
+  if (!nif_get_atom(env, argv[1], &format)) {
+    return nif_raise(env, "failed_to_get_atom");
+  }
+
+  AVFrame *frame = av_frame_alloc();
   ERL_NIF_TERM ret;
-  ERL_NIF_TERM *packets =
-      enif_alloc(sizeof(ERL_NIF_TERM) * encoder->num_packets);
-  for (int i = 0; i < encoder->num_packets; i++) {
-    packets[i] = nif_packet_to_term(env, encoder->packets[i]);
+
+  frame->format = av_get_pix_fmt(format);
+  frame->width = width;
+  frame->height = height;
+  enif_free(format);
+
+  if (frame->format == AV_PIX_FMT_NONE || width <= 0 || height <= 0 ||
+      av_image_get_buffer_size(frame->format, width, height, 1) !=
+          (int)data.size) {
+    error = "invalid_frame";
+  } else if (av_image_fill_arrays(frame->data, frame->linesize, data.data,
+                                  frame->format, width, height, 1) < 0) {
+    error = "failed_to_fill_arrays";
+  } else {
+    error = encode_jpeg(env, frame, &config, &ret);
   }
 
-  ret = enif_make_list_from_array(env, packets, encoder->num_packets);
+  av_frame_free(&frame);
 
-  for (int i = 0; i < encoder->num_packets; i++)
-    av_packet_unref(encoder->packets[i]);
-  enif_free(packets);
+  return error ? nif_raise(env, error) : ret;
+}
+
+static ERL_NIF_TERM motion_to_term(ErlNifEnv *env,
+                                   struct MotionResult *result) {
+  ERL_NIF_TERM *regions =
+      enif_alloc(sizeof(ERL_NIF_TERM) * (result->num_regions + 1));
+  for (int i = 0; i < result->num_regions; i++) {
+    struct MotionRegion *region = &result->regions[i];
+    regions[i] = enif_make_tuple4(env, enif_make_int(env, region->x),
+                                  enif_make_int(env, region->y),
+                                  enif_make_int(env, region->width),
+                                  enif_make_int(env, region->height));
+  }
+
+  ERL_NIF_TERM keys[] = {enif_make_atom(env, "score"),
+                         enif_make_atom(env, "regions")};
+  ERL_NIF_TERM values[] = {
+      enif_make_double(env, result->score),
+      enif_make_list_from_array(env, regions, result->num_regions)};
+
+  ERL_NIF_TERM ret;
+  enif_make_map_from_arrays(env, keys, values, 2, &ret);
+  enif_free(regions);
 
   return ret;
 }
 
-static ERL_NIF_TERM frames_to_term(ErlNifEnv *env, Decoder *decoder) {
+static ERL_NIF_TERM mv_activity_to_term(ErlNifEnv *env,
+                                        MvActivity *activity) {
+  int grid_width = activity->config.grid_width;
+  int grid_height = activity->config.grid_height;
+  ERL_NIF_TERM *cells = enif_alloc(sizeof(ERL_NIF_TERM) * grid_width);
+  ERL_NIF_TERM rows = enif_make_list(env, 0);
+
+  for (int y = grid_height - 1; y >= 0; y--) {
+    for (int x = 0; x < grid_width; x++) {
+      cells[x] = enif_make_double(env, activity->cells[y * grid_width + x]);
+    }
+
+    rows = enif_make_list_cell(
+        env, enif_make_list_from_array(env, cells, grid_width), rows);
+  }
+
+  enif_free(cells);
+
+  ERL_NIF_TERM keys[] = {enif_make_atom(env, "score"),
+                         enif_make_atom(env, "count"),
+                         enif_make_atom(env, "grid")};
+  ERL_NIF_TERM values[] = {enif_make_double(env, activity->score),
+                           enif_make_int(env, activity->count), rows};
+
   ERL_NIF_TERM ret;
-  ERL_NIF_TERM *frames =
-      enif_alloc(sizeof(ERL_NIF_TERM) * decoder->count_frames);
-  for (int i = 0; i < decoder->count_frames; i++) {
-    frames[i] = nif_frame_to_term(env, decoder->frames[i]);
+  enif_make_map_from_arrays(env, keys, values, 3, &ret);
+
+  return ret;
+}
+
+static ERL_NIF_TERM quality_to_term(ErlNifEnv *env,
+                                    struct QualityResult *result) {
+  ERL_NIF_TERM histogram[QUALITY_MAX_BINS];
+  for (int i = 0; i < result->num_bins; i++) {
+    histogram[i] = enif_make_uint(env, result->histogram[i]);
   }
 
-  ret = enif_make_list_from_array(env, frames, decoder->count_frames);
+  ERL_NIF_TERM keys[] = {
+      enif_make_atom(env, "mean"), enif_make_atom(env, "variance"),
+      enif_make_atom(env, "sharpness"), enif_make_atom(env, "uniformity"),
+      enif_make_atom(env, "histogram")};
+  ERL_NIF_TERM values[] = {
+      enif_make_double(env, result->mean),
+      enif_make_double(env, result->variance),
+      enif_make_double(env, result->sharpness),
+      enif_make_double(env, result->uniformity),
+      enif_make_list_from_array(env, histogram, result->num_bins)};
+
+  ERL_NIF_TERM ret;
+  enif_make_map_from_arrays(env, keys, values, 5, &ret);
+
+  return ret;
+}
+
+// Builds one map per decoded frame with the result of each enabled analyzer,
+// the frames themselves never leave the native side.
+static ERL_NIF_TERM analysis_to_term(ErlNifEnv *env,
+                                     struct NvrDecoder *nvr_decoder) {
+  Decoder *decoder = nvr_decoder->decoder;
+  ERL_NIF_TERM ret = enif_make_list(env, 0);
+  struct MotionResult motion;
+  struct QualityResult quality;
+
+  for (int i = decoder->count_frames - 1; i >= 0; i--) {
+    AVFrame *frame = decoder->frames[i];
+    ERL_NIF_TERM result = enif_make_new_map(env);
+
+    enif_make_map_put(env, result, enif_make_atom(env, "pts"),
+                      enif_make_int64(env, frame->pts), &result);
+
+    if (nvr_decoder->motion_detector != NULL) {
+      if (motion_detector_process(nvr_decoder->motion_detector, frame,
+                                  &motion) < 0) {
+        ret = nif_raise(env, "failed_to_analyze");
+        break;
+      }
+
+      enif_make_map_put(env, result, enif_make_atom(env, "motion"),
+                        motion_to_term(env, &motion), &result);
+    }
+
+    if (nvr_decoder->mv_activity != NULL) {
+      if (mv_activity_process(nvr_decoder->mv_activity, frame) < 0) {
+        ret = nif_raise(env, "failed_to_analyze");
+        break;
+      }
+
+      enif_make_map_put(env, result, enif_make_atom(env, "motion_vectors"),
+                        mv_activity_to_term(env, nvr_decoder->mv_activity),
+                        &result);
+    }
+
+    if (nvr_decoder->quality_metrics != NULL) {
+      int computed = quality_metrics_process(nvr_decoder->quality_metrics,
+                                             frame, &quality);
+      if (computed < 0) {
+        ret = nif_raise(env, "failed_to_analyze");
+        break;
+      }
+
+      if (computed) {
+        enif_make_map_put(env, result, enif_make_atom(env, "quality"),
+                          quality_to_term(env, &quality), &result);
+      }
+    }
+
+    ret = enif_make_list_cell(env, result, ret);
+  }
 
   for (int i = 0; i < decoder->count_frames; i++)
     av_frame_unref(decoder->frames[i]);
 
-  enif_free(frames);
-
   return ret;
 }
 
@@ -602,6 +3861,9 @@ void free_encoder(ErlNifEnv *env, void *obj) {
   if (nvr_encoder->frame != NULL) {
     av_frame_free(&nvr_encoder->frame);
   }
+
+  privacy_mask_free(&nvr_encoder->privacy_mask);
+  av_frame_free(&nvr_encoder->masked_frame);
 }
 
 void free_decoder(ErlNifEnv *env, void *obj) {
@@ -610,6 +3872,11 @@ void free_decoder(ErlNifEnv *env, void *obj) {
 
   decoder_free(&nvr_decoder->decoder);
   video_converter_free(&nvr_decoder->video_converter);
+  motion_detector_free(&nvr_decoder->motion_detector);
+  mv_activity_free(&nvr_decoder->mv_activity);
+  quality_metrics_free(&nvr_decoder->quality_metrics);
+  frame_ring_free(&nvr_decoder->frame_ring);
+  av_buffer_pool_uninit(&nvr_decoder->frame_pool);
 
   if (nvr_decoder->packet != NULL) {
     av_packet_free(&nvr_decoder->packet);
@@ -622,20 +3889,88 @@ void free_converter(ErlNifEnv *env, void *obj) {
 
   video_converter_free(&nvr_converter->video_converter);
 
+  for (int i = 0; i < nvr_converter->num_workers; i++) {
+    video_converter_free(&nvr_converter->workers[i]);
+  }
+
+  for (int i = 0; i < nvr_converter->num_rois; i++) {
+    video_converter_free(&nvr_converter->rois[i]);
+  }
+
   if (nvr_converter->frame != NULL) {
     av_frame_free(&nvr_converter->frame);
   }
+
+  privacy_mask_free(&nvr_converter->privacy_mask);
+  text_overlay_free(&nvr_converter->text_overlay);
+}
+
+void free_timelapse(ErlNifEnv *env, void *obj) {
+  NVR_LOG_DEBUG("Freeing Timelapse object");
+  struct NvrTimelapse *nvr_timelapse = (struct NvrTimelapse *)obj;
+  timelapse_free(&nvr_timelapse->timelapse);
+}
+
+void free_keyframe_index(ErlNifEnv *env, void *obj) {
+  NVR_LOG_DEBUG("Freeing KeyframeIndex object");
+  struct NvrKeyframeIndex *nvr_index = (struct NvrKeyframeIndex *)obj;
+  keyframe_index_free(&nvr_index->index);
+}
+
+static void free_pooled_encoder(void *item) {
+  free_encoder(NULL, item);
+  enif_free(item);
+}
+
+static void free_pooled_decoder(void *item) {
+  free_decoder(NULL, item);
+  enif_free(item);
 }
 
 static ErlNifFunc funcs[] = {
   {"new_encoder", 2, new_encoder},
-  {"new_decoder", 5, new_decoder},
-  {"new_converter", 7, new_converter},
+  {"new_decoder", 6, new_decoder},
+  {"new_converter", 8, new_converter},
+  {"new_roi_converter", 5, new_roi_converter},
   {"encode", 3, encode, ERL_DIRTY_JOB_CPU_BOUND},
   {"decode", 4, decode, ERL_DIRTY_JOB_CPU_BOUND},
+  {"encode_many", 2, encode_many, ERL_DIRTY_JOB_CPU_BOUND},
+  {"decode_many", 2, decode_many, ERL_DIRTY_JOB_CPU_BOUND},
+  {"convert_many", 3, convert_many, ERL_DIRTY_JOB_CPU_BOUND},
+  {"decode_until", 3, decode_until, ERL_DIRTY_JOB_CPU_BOUND},
   {"convert", 2, convert, ERL_DIRTY_JOB_CPU_BOUND},
+  {"convert_rois", 2, convert_rois, ERL_DIRTY_JOB_CPU_BOUND},
   {"flush_encoder", 1, flush_encoder, ERL_DIRTY_JOB_CPU_BOUND},
-  {"flush_decoder", 1, flush_decoder, ERL_DIRTY_JOB_CPU_BOUND}
+  {"flush_decoder", 1, flush_decoder, ERL_DIRTY_JOB_CPU_BOUND},
+  {"hibernate_decoder", 1, hibernate_decoder, ERL_DIRTY_JOB_CPU_BOUND},
+  {"lease_encoder", 2, lease_encoder, ERL_DIRTY_JOB_CPU_BOUND},
+  {"lease_decoder", 8, lease_decoder, ERL_DIRTY_JOB_CPU_BOUND},
+  {"release_encoder", 1, release_encoder, ERL_DIRTY_JOB_CPU_BOUND},
+  {"release_decoder", 1, release_decoder, ERL_DIRTY_JOB_CPU_BOUND},
+  {"enable_motion_detection", 2, enable_motion_detection},
+  {"enable_motion_vectors", 2, enable_motion_vectors},
+  {"enable_quality_metrics", 2, enable_quality_metrics},
+  {"set_output_rate", 3, set_output_rate},
+  {"set_plane_output", 2, set_plane_output},
+  {"set_privacy_mask", 4, set_privacy_mask, ERL_DIRTY_JOB_CPU_BOUND},
+  {"add_text_label", 5, add_text_label, ERL_DIRTY_JOB_CPU_BOUND},
+  {"set_label_text", 3, set_label_text},
+  {"enable_frame_ring", 2, enable_frame_ring},
+  {"alloc_stats", 0, alloc_stats},
+  {"reset_alloc_stats", 0, reset_alloc_stats},
+  {"analyze", 4, analyze, ERL_DIRTY_JOB_CPU_BOUND},
+  {"mosaic", 3, mosaic, ERL_DIRTY_JOB_CPU_BOUND},
+  {"avcc_to_annexb", 3, avcc_to_annexb, ERL_DIRTY_JOB_CPU_BOUND},
+  {"annexb_to_avcc", 3, annexb_to_avcc, ERL_DIRTY_JOB_CPU_BOUND},
+  {"parse_parameter_sets", 2, parse_parameter_sets},
+  {"new_timelapse", 2, new_timelapse, ERL_DIRTY_JOB_CPU_BOUND},
+  {"timelapse_add", 3, timelapse_add, ERL_DIRTY_JOB_CPU_BOUND},
+  {"timelapse_finish", 1, timelapse_finish, ERL_DIRTY_JOB_CPU_BOUND},
+  {"recording_snapshot", 3, recording_snapshot, ERL_DIRTY_JOB_CPU_BOUND},
+  {"encode_to_jpeg", 5, encode_to_jpeg, ERL_DIRTY_JOB_CPU_BOUND},
+  {"build_keyframe_index", 2, build_keyframe_index, ERL_DIRTY_JOB_IO_BOUND},
+  {"open_keyframe_index", 1, open_keyframe_index, ERL_DIRTY_JOB_IO_BOUND},
+  {"keyframe_index_lookup", 2, keyframe_index_lookup}
 };
 
 static int load(ErlNifEnv *env, void **priv, ERL_NIF_TERM load_info) {
@@ -648,7 +3983,56 @@ static int load(ErlNifEnv *env, void **priv, ERL_NIF_TERM load_info) {
   converter_resource_type = enif_open_resource_type(
     env, NULL, "NvrConverter", free_converter, ERL_NIF_RT_CREATE, NULL);
 
+  timelapse_resource_type = enif_open_resource_type(
+    env, NULL, "NvrTimelapse", free_timelapse, ERL_NIF_RT_CREATE, NULL);
+
+  keyframe_index_resource_type = enif_open_resource_type(
+    env, NULL, "NvrKeyframeIndex", free_keyframe_index, ERL_NIF_RT_CREATE,
+    NULL);
+
+  // load_info is an optional map configuring the codec pools:
+  //   max_size: maximum number of idle contexts per pool
+  //   max_size_per_key: maximum number of idle contexts with the same key
+  //   warm_up: list of {:decoder, codec, out_width, out_height, out_format,
+  //            pad, width, height} and {:encoder, codec, params} to pre-open
+  // nothing is allocated before the options are read, unload is not called
+  // when load fails
+  int max_size = CODEC_POOL_DEFAULT_SIZE;
+  int max_size_per_key = CODEC_POOL_DEFAULT_SIZE_PER_KEY;
+  ERL_NIF_TERM value, warm_up = enif_make_list(env, 0);
+
+  if (enif_is_map(env, load_info)) {
+    if (enif_get_map_value(env, load_info, enif_make_atom(env, "max_size"),
+                           &value) &&
+        !enif_get_int(env, value, &max_size)) {
+      return -1;
+    }
+
+    if (enif_get_map_value(env, load_info,
+                           enif_make_atom(env, "max_size_per_key"), &value) &&
+        !enif_get_int(env, value, &max_size_per_key)) {
+      return -1;
+    }
+
+    enif_get_map_value(env, load_info, enif_make_atom(env, "warm_up"),
+                       &warm_up);
+  }
+
+  encoder_pool =
+      codec_pool_alloc(max_size, max_size_per_key, free_pooled_encoder);
+  decoder_pool =
+      codec_pool_alloc(max_size, max_size_per_key, free_pooled_decoder);
+
+  glyph_atlas_cache_init();
+  warm_up_pools(env, warm_up);
+
   return 0;
 }
 
-ERL_NIF_INIT(Elixir.ExNVR.AV.VideoProcessor.NIF, funcs, &load, NULL, NULL, NULL);
\ No newline at end of file
+static void unload(ErlNifEnv *env, void *priv) {
+  codec_pool_free(&encoder_pool);
+  codec_pool_free(&decoder_pool);
+  glyph_atlas_cache_free();
+}
+
+ERL_NIF_INIT(Elixir.ExNVR.AV.VideoProcessor.NIF, funcs, &load, NULL, NULL, &unload);
\ No newline at end of file
@@ -1,27 +1,151 @@
 #pragma once
 
+#include "codec_pool.h"
 #include "encoder.h"
 #include "decoder.h"
+#include "frame_ring.h"
+#include "mosaic.h"
+#include "motion_detector.h"
+#include "mv_activity.h"
+#include "nal.h"
+#include "param_sets.h"
+#include "quality_metrics.h"
+#include "recording.h"
+#include "timelapse.h"
 #include "video_converter.h"
 #include "utils.h"
 
+// maximum number of items processed by one call of the *_many functions, keeps
+// the time spent on a dirty scheduler bounded
+#define NVR_MAX_BATCH_SIZE 64
+#define NVR_MAX_CONVERT_THREADS 16
+#define NVR_MAX_ROIS 16
+// alignment of the converted frame buffers, as av_frame_get_buffer with AVX512
+#define NVR_FRAME_ALIGN 64
+// jpeg quantizer scales, images above the pixel count use slice threads
+#define NVR_JPEG_BEST_QUALITY 2
+#define NVR_JPEG_WORST_QUALITY 31
+#define NVR_JPEG_SLICE_PIXELS (1920 * 1080)
+#define NVR_JPEG_MAX_THREADS 8
+
 struct NvrEncoder {
   Encoder *encoder;
   AVFrame *frame;
+  // the input frames are copied to masked_frame and masked before encoding
+  PrivacyMask *privacy_mask;
+  AVFrame *masked_frame;
+  // leased encoders are returned to the pool on release
+  int leased;
+  struct CodecPoolKey pool_key;
+};
+
+// Limits the frames returned by a decoder, the others are still decoded since
+// they may be referenced but are never converted nor copied to the BEAM.
+struct OutputRate {
+  // output one frame out of `every`, 1 outputs all of them
+  int every;
+  // minimum pts difference between two output frames, 0 disables it
+  int64_t interval;
+  int64_t count;
+  int64_t next_pts;
+};
+
+enum NvrPlaneOutput {
+  // all the planes packed in a single binary
+  NVR_PLANES_PACKED,
+  // one binary per plane, with its stride
+  NVR_PLANES_ALL,
+  // only the first plane, the luma of yuv formats
+  NVR_PLANES_LUMA
 };
 
 struct NvrDecoder {
   Decoder *decoder;
   AVPacket *packet;
   VideoConverter *video_converter;
+  MotionDetector *motion_detector;
+  MvActivity *mv_activity;
+  QualityMetrics *quality_metrics;
+  // the converted frames are published to the ring instead of being copied
+  // to the BEAM
+  FrameRing *frame_ring;
+  // buffers of the converted frames, recycled once the frames are copied out
+  AVBufferPool *frame_pool;
+  int frame_pool_size;
   // output params
   int out_width;
   int out_height;
   int pad;
   enum AVPixelFormat out_format;
+  struct OutputRate output_rate;
+  enum NvrPlaneOutput plane_output;
+  // leased decoders are returned to the pool on release
+  int leased;
+  struct CodecPoolKey pool_key;
+};
+
+struct NvrDecoderConfig {
+  const AVCodec *codec;
+  // avcC/hvcC record or annex b parameter sets, not owned
+  const uint8_t *extradata;
+  int extradata_size;
+  int out_width;
+  int out_height;
+  int pad;
+  enum AVPixelFormat out_format;
+};
+
+struct NvrFrameRingConfig {
+  char *name;
+  int slots;
+  int64_t slot_size;
+  int mode;
+};
+
+struct NvrTimelapse {
+  // NULL once finished
+  Timelapse *timelapse;
+};
+
+struct NvrJpegConfig {
+  // fixed quantizer scale (1-31, lower is better), 0 for the encoder default
+  int quality;
+  // the quantizer is raised until the image fits, 0 for no limit
+  int max_size;
+  // slice threads, 0 picks them from the image size
+  int threads;
+  // range of yuv420p frames, unspecified to use the range of the frame
+  enum AVColorRange color_range;
+};
+
+struct NvrSnapshotConfig {
+  enum RecordingSeekMethod method;
+  // encode the frame to jpeg, the raw frame is returned otherwise
+  int jpeg;
+  struct NvrJpegConfig jpeg_config;
+  // sidecar index of the recording, not owned
+  KeyframeIndex *index;
+};
+
+struct NvrKeyframeIndex {
+  KeyframeIndex *index;
 };
 
 struct NvrConverter {
   VideoConverter *video_converter;
   AVFrame *frame;
+  // one converter per extra thread of convert_many, created on first use
+  VideoConverter *workers[NVR_MAX_CONVERT_THREADS - 1];
+  int num_workers;
+  // output params, to init the workers
+  int out_width;
+  int out_height;
+  int pad;
+  enum AVPixelFormat out_format;
+  // one converter per region of interest, video_converter is then NULL
+  VideoConverter *rois[NVR_MAX_ROIS];
+  int num_rois;
+  // shared by the converter and its workers
+  PrivacyMask *privacy_mask;
+  TextOverlay *text_overlay;
 };
@@ -0,0 +1,308 @@
+#include "yuv_rgb.h"
+#include "simd.h"
+#include <math.h>
+
+// Per pixel, with Y, U and V scaled to 16 bits lanes:
+//
+//   y' = mulhrs((Y - y_offset) << 7, y_gain)
+//   R  = y' + mulhrs((V - 128) << 8, rv)
+//   G  = y' + mulhrs((U - 128) << 8, gu) + mulhrs((V - 128) << 8, gv)
+//   B  = y' + mulhrs((U - 128) << 8, bu)
+//
+// the components are then 64 times their value, they're rounded, shifted and
+// clamped to 8 bits. mulhrs is the rounded high product of the SSSE3/AVX2
+// instruction, NEON vqrdmulh gives the same result.
+
+static inline int16_t sat16(int value) {
+  return value > INT16_MAX ? INT16_MAX : value < INT16_MIN ? INT16_MIN : value;
+}
+
+static inline int16_t mulhrs(int16_t a, int16_t b) {
+  return ((int32_t)a * b + (1 << 14)) >> 15;
+}
+
+static inline uint8_t to_u8(int16_t value) {
+  int out = sat16(value + 32) >> 6;
+  return out < 0 ? 0 : out > 255 ? 255 : out;
+}
+
+static void yuv_rgb_row_c(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                          int chroma_step, uint8_t *dst, int width,
+                          const struct YuvRgbCoeffs *k) {
+  int r_off = k->bgr ? 2 : 0;
+  int b_off = 2 - r_off;
+
+  for (int i = 0; i < width; i++) {
+    int c = (i >> 1) * chroma_step;
+    int16_t us = (u[c] - 128) * 256;
+    int16_t vs = (v[c] - 128) * 256;
+    int16_t ys = mulhrs((y[i] - k->y_offset) * 128, k->y_gain);
+
+    dst[r_off] = to_u8(sat16(ys + mulhrs(vs, k->rv)));
+    dst[1] = to_u8(
+        sat16(ys + sat16(mulhrs(us, k->gu) + mulhrs(vs, k->gv))));
+    dst[b_off] = to_u8(sat16(ys + mulhrs(us, k->bu)));
+    dst += 3;
+  }
+}
+
+static void yuv420p_row_c(const uint8_t *y, const uint8_t *u,
+                          const uint8_t *v, uint8_t *dst, int width,
+                          const struct YuvRgbCoeffs *k) {
+  yuv_rgb_row_c(y, u, v, 1, dst, width, k);
+}
+
+static void nv12_row_c(const uint8_t *y, const uint8_t *u, const uint8_t *v,
+                       uint8_t *dst, int width,
+                       const struct YuvRgbCoeffs *k) {
+  yuv_rgb_row_c(y, u, v, 2, dst, width, k);
+}
+
+#ifdef NVR_HAVE_X86
+// pshufb masks interleaving 16 r, g and b bytes into 48 rgb bytes
+#define Z -1
+static const int8_t rgb_shuffle[3][3][16] = {
+    {{0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z, Z, 5},
+     {Z, 0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z, Z},
+     {Z, Z, 0, Z, Z, 1, Z, Z, 2, Z, Z, 3, Z, Z, 4, Z}},
+    {{Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z, 10, Z},
+     {5, Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z, 10},
+     {Z, 5, Z, Z, 6, Z, Z, 7, Z, Z, 8, Z, Z, 9, Z, Z}},
+    {{Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15, Z, Z},
+     {Z, Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15, Z},
+     {10, Z, Z, 11, Z, Z, 12, Z, Z, 13, Z, Z, 14, Z, Z, 15}}};
+#undef Z
+
+// duplicates each chroma contribution for the two pixels sharing it
+NVR_TARGET_AVX2 static inline __m256i dup_chroma_avx2(__m128i c) {
+  return _mm256_inserti128_si256(
+      _mm256_castsi128_si256(_mm_unpacklo_epi16(c, c)),
+      _mm_unpackhi_epi16(c, c), 1);
+}
+
+NVR_TARGET_AVX2 static inline __m128i to_u8_avx2(__m256i ys, __m128i c) {
+  __m256i value = _mm256_adds_epi16(ys, dup_chroma_avx2(c));
+  value = _mm256_srai_epi16(
+      _mm256_adds_epi16(value, _mm256_set1_epi16(32)), 6);
+
+  return _mm_packus_epi16(_mm256_castsi256_si128(value),
+                          _mm256_extracti128_si256(value, 1));
+}
+
+// converts 16 pixels, us and vs are the 8 centered chroma samples
+NVR_TARGET_AVX2 static inline void convert_16_avx2(
+    const uint8_t *y, __m128i us, __m128i vs, uint8_t *dst,
+    const struct YuvRgbCoeffs *k) {
+  __m256i ys = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)y));
+  ys = _mm256_slli_epi16(
+      _mm256_sub_epi16(ys, _mm256_set1_epi16(k->y_offset)), 7);
+  ys = _mm256_mulhrs_epi16(ys, _mm256_set1_epi16(k->y_gain));
+
+  __m128i rc = _mm_mulhrs_epi16(vs, _mm_set1_epi16(k->rv));
+  __m128i gc = _mm_adds_epi16(_mm_mulhrs_epi16(us, _mm_set1_epi16(k->gu)),
+                              _mm_mulhrs_epi16(vs, _mm_set1_epi16(k->gv)));
+  __m128i bc = _mm_mulhrs_epi16(us, _mm_set1_epi16(k->bu));
+
+  __m128i r = to_u8_avx2(ys, rc);
+  __m128i g = to_u8_avx2(ys, gc);
+  __m128i b = to_u8_avx2(ys, bc);
+
+  if (k->bgr) {
+    __m128i tmp = r;
+    r = b;
+    b = tmp;
+  }
+
+  for (int i = 0; i < 3; i++) {
+    __m128i out = _mm_or_si128(
+        _mm_or_si128(
+            _mm_shuffle_epi8(
+                r, _mm_loadu_si128((const __m128i *)rgb_shuffle[i][0])),
+            _mm_shuffle_epi8(
+                g, _mm_loadu_si128((const __m128i *)rgb_shuffle[i][1]))),
+        _mm_shuffle_epi8(
+            b, _mm_loadu_si128((const __m128i *)rgb_shuffle[i][2])));
+    _mm_storeu_si128((__m128i *)(dst + 16 * i), out);
+  }
+}
+
+NVR_TARGET_AVX2 static void yuv420p_row_avx2(const uint8_t *y,
+                                             const uint8_t *u,
+                                             const uint8_t *v, uint8_t *dst,
+                                             int width,
+                                             const struct YuvRgbCoeffs *k) {
+  __m128i center = _mm_set1_epi16(128);
+  int i = 0;
+
+  for (; i + 16 <= width; i += 16) {
+    __m128i us = _mm_cvtepu8_epi16(
+        _mm_loadl_epi64((const __m128i *)(u + (i >> 1))));
+    __m128i vs = _mm_cvtepu8_epi16(
+        _mm_loadl_epi64((const __m128i *)(v + (i >> 1))));
+
+    convert_16_avx2(y + i, _mm_slli_epi16(_mm_sub_epi16(us, center), 8),
+                    _mm_slli_epi16(_mm_sub_epi16(vs, center), 8),
+                    dst + 3 * i, k);
+  }
+
+  yuv420p_row_c(y + i, u + (i >> 1), v + (i >> 1), dst + 3 * i, width - i, k);
+}
+
+NVR_TARGET_AVX2 static void nv12_row_avx2(const uint8_t *y, const uint8_t *u,
+                                          const uint8_t *v, uint8_t *dst,
+                                          int width,
+                                          const struct YuvRgbCoeffs *k) {
+  __m128i center = _mm_set1_epi16(128);
+  int i = 0;
+
+  for (; i + 16 <= width; i += 16) {
+    __m128i uv = _mm_loadu_si128((const __m128i *)(u + i));
+    __m128i us = _mm_and_si128(uv, _mm_set1_epi16(0xff));
+    __m128i vs = _mm_srli_epi16(uv, 8);
+
+    convert_16_avx2(y + i, _mm_slli_epi16(_mm_sub_epi16(us, center), 8),
+                    _mm_slli_epi16(_mm_sub_epi16(vs, center), 8),
+                    dst + 3 * i, k);
+  }
+
+  nv12_row_c(y + i, u + i, v + i, dst + 3 * i, width - i, k);
+}
+#endif
+
+#ifdef NVR_HAVE_NEON
+static inline uint8x16_t to_u8_neon(int16x8_t ys_lo, int16x8_t ys_hi,
+                                    int16x8_t c) {
+  int16x8x2_t dup = vzipq_s16(c, c);
+  return vcombine_u8(vqrshrun_n_s16(vqaddq_s16(ys_lo, dup.val[0]), 6),
+                     vqrshrun_n_s16(vqaddq_s16(ys_hi, dup.val[1]), 6));
+}
+
+static inline void convert_16_neon(const uint8_t *y, uint8x8_t u, uint8x8_t v,
+                                   uint8_t *dst,
+                                   const struct YuvRgbCoeffs *k) {
+  int16x8_t center = vdupq_n_s16(128);
+  int16x8_t y_offset = vdupq_n_s16(k->y_offset);
+  int16x8_t y_gain = vdupq_n_s16(k->y_gain);
+  uint8x16_t y8 = vld1q_u8(y);
+
+  int16x8_t ys_lo = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(y8)));
+  int16x8_t ys_hi = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(y8)));
+  ys_lo = vqrdmulhq_s16(vshlq_n_s16(vsubq_s16(ys_lo, y_offset), 7), y_gain);
+  ys_hi = vqrdmulhq_s16(vshlq_n_s16(vsubq_s16(ys_hi, y_offset), 7), y_gain);
+
+  int16x8_t us = vshlq_n_s16(
+      vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), center), 8);
+  int16x8_t vs = vshlq_n_s16(
+      vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), center), 8);
+
+  int16x8_t rc = vqrdmulhq_s16(vs, vdupq_n_s16(k->rv));
+  int16x8_t gc = vqaddq_s16(vqrdmulhq_s16(us, vdupq_n_s16(k->gu)),
+                            vqrdmulhq_s16(vs, vdupq_n_s16(k->gv)));
+  int16x8_t bc = vqrdmulhq_s16(us, vdupq_n_s16(k->bu));
+
+  uint8x16x3_t rgb;
+  rgb.val[k->bgr ? 2 : 0] = to_u8_neon(ys_lo, ys_hi, rc);
+  rgb.val[1] = to_u8_neon(ys_lo, ys_hi, gc);
+  rgb.val[k->bgr ? 0 : 2] = to_u8_neon(ys_lo, ys_hi, bc);
+  vst3q_u8(dst, rgb);
+}
+
+static void yuv420p_row_neon(const uint8_t *y, const uint8_t *u,
+                             const uint8_t *v, uint8_t *dst, int width,
+                             const struct YuvRgbCoeffs *k) {
+  int i = 0;
+
+  for (; i + 16 <= width; i += 16) {
+    convert_16_neon(y + i, vld1_u8(u + (i >> 1)), vld1_u8(v + (i >> 1)),
+                    dst + 3 * i, k);
+  }
+
+  yuv420p_row_c(y + i, u + (i >> 1), v + (i >> 1), dst + 3 * i, width - i, k);
+}
+
+static void nv12_row_neon(const uint8_t *y, const uint8_t *u,
+                          const uint8_t *v, uint8_t *dst, int width,
+                          const struct YuvRgbCoeffs *k) {
+  int i = 0;
+
+  for (; i + 16 <= width; i += 16) {
+    uint8x8x2_t uv = vld2_u8(u + i);
+    convert_16_neon(y + i, uv.val[0], uv.val[1], dst + 3 * i, k);
+  }
+
+  nv12_row_c(y + i, u + i, v + i, dst + 3 * i, width - i, k);
+}
+#endif
+
+YuvRgbRowFn yuv_rgb_row_fn(enum AVPixelFormat in_format,
+                           enum AVPixelFormat out_format) {
+  if (out_format != AV_PIX_FMT_RGB24 && out_format != AV_PIX_FMT_BGR24) {
+    return NULL;
+  }
+
+  switch (in_format) {
+  case AV_PIX_FMT_YUV420P:
+  case AV_PIX_FMT_YUVJ420P:
+#ifdef NVR_HAVE_X86
+    if (nvr_cpu_has_avx2()) {
+      return yuv420p_row_avx2;
+    }
+#endif
+#ifdef NVR_HAVE_NEON
+    if (nvr_cpu_has_neon()) {
+      return yuv420p_row_neon;
+    }
+#endif
+    return yuv420p_row_c;
+
+  case AV_PIX_FMT_NV12:
+#ifdef NVR_HAVE_X86
+    if (nvr_cpu_has_avx2()) {
+      return nv12_row_avx2;
+    }
+#endif
+#ifdef NVR_HAVE_NEON
+    if (nvr_cpu_has_neon()) {
+      return nv12_row_neon;
+    }
+#endif
+    return nv12_row_c;
+
+  default:
+    return NULL;
+  }
+}
+
+void yuv_rgb_coeffs(struct YuvRgbCoeffs *coeffs, const AVFrame *frame,
+                    enum AVPixelFormat out_format) {
+  int bt709 = frame->colorspace == AVCOL_SPC_BT709;
+  int full_range = frame->color_range == AVCOL_RANGE_JPEG ||
+                   frame->format == AV_PIX_FMT_YUVJ420P;
+
+  double kr = bt709 ? 0.2126 : 0.299;
+  double kb = bt709 ? 0.0722 : 0.114;
+  double kg = 1.0 - kr - kb;
+  double y_gain = full_range ? 1.0 : 255.0 / 219.0;
+  double c_gain = full_range ? 1.0 : 255.0 / 224.0;
+
+  coeffs->y_offset = full_range ? 0 : 16;
+  coeffs->y_gain = lrint(y_gain * (1 << 14));
+  coeffs->rv = lrint(2 * (1 - kr) * c_gain * (1 << 13));
+  coeffs->gu = lrint(-2 * (1 - kb) * kb / kg * c_gain * (1 << 13));
+  coeffs->gv = lrint(-2 * (1 - kr) * kr / kg * c_gain * (1 << 13));
+  coeffs->bu = lrint(2 * (1 - kb) * c_gain * (1 << 13));
+  coeffs->bgr = out_format == AV_PIX_FMT_BGR24;
+}
+
+void yuv_rgb_convert(YuvRgbRowFn row, const struct YuvRgbCoeffs *coeffs,
+                     const uint8_t *const src[4], const int src_linesize[4],
+                     int width, int height, uint8_t *dst, int dst_linesize) {
+  for (int i = 0; i < height; i++) {
+    const uint8_t *u = src[1] + (i >> 1) * src_linesize[1];
+    // nv12 has a single chroma plane, v is the second byte of each pair
+    const uint8_t *v = src[2] ? src[2] + (i >> 1) * src_linesize[2] : u + 1;
+
+    row(src[0] + i * src_linesize[0], u, v, dst + i * dst_linesize, width,
+        coeffs);
+  }
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <libavutil/frame.h>
+#include <stdint.h>
+
+// Same size yuv420p/yuvj420p/nv12 to rgb24/bgr24 conversion, without the
+// generic swscale pipeline. The kernels use 16 bits fixed point arithmetic and
+// give the same result on every instruction set.
+
+// Q14 luma gain and Q13 chroma coefficients
+struct YuvRgbCoeffs {
+  int16_t y_offset;
+  int16_t y_gain;
+  int16_t rv;
+  int16_t gu;
+  int16_t gv;
+  int16_t bu;
+  int bgr;
+};
+
+// Converts a row of `width` pixels. For nv12, `u` is the interleaved chroma
+// row and `v` points to its second byte.
+typedef void (*YuvRgbRowFn)(const uint8_t *y, const uint8_t *u,
+                            const uint8_t *v, uint8_t *dst, int width,
+                            const struct YuvRgbCoeffs *coeffs);
+
+// NULL if the conversion is not supported
+YuvRgbRowFn yuv_rgb_row_fn(enum AVPixelFormat in_format,
+                           enum AVPixelFormat out_format);
+// BT.709 is used for the frames tagged as such, BT.601 otherwise
+void yuv_rgb_coeffs(struct YuvRgbCoeffs *coeffs, const AVFrame *frame,
+                    enum AVPixelFormat out_format);
+void yuv_rgb_convert(YuvRgbRowFn row, const struct YuvRgbCoeffs *coeffs,
+                     const uint8_t *const src[4], const int src_linesize[4],
+                     int width, int height, uint8_t *dst, int dst_linesize);
@@ -0,0 +1,56 @@
+defmodule ExNVR.AV.AllocStats do
+  @moduledoc """
+  Allocations and copies made by the native code, per call site.
+
+  The counters are only collected when the NIF is compiled with
+  `NVR_ALLOC_STATS=1`, they cover the `enif_alloc`, `enif_realloc`, `av_malloc`,
+  `av_mallocz` and `av_frame_get_buffer` calls (`:heap`) and the binaries created
+  for the BEAM (`:binary`). The allocations made inside FFmpeg are not counted.
+
+  The counters are global, reset them before the measured code and don't run other
+  native code concurrently.
+  """
+
+  alias ExNVR.AV.VideoProcessor.NIF
+
+  @type site() :: %{
+          file: String.t(),
+          line: pos_integer(),
+          function: atom(),
+          kind: :heap | :binary,
+          count: non_neg_integer(),
+          bytes: non_neg_integer()
+        }
+
+  @spec enabled?() :: boolean()
+  def enabled?, do: match?({:ok, _sites}, NIF.alloc_stats())
+
+  @spec reset() :: :ok
+  def reset, do: NIF.reset_alloc_stats()
+
+  @doc """
+  Get the call sites used since the last reset.
+  """
+  @spec sites() :: [site()]
+  def sites do
+    {:ok, sites} = NIF.alloc_stats()
+
+    Enum.map(sites, fn {file, line, function, kind, count, bytes} ->
+      %{file: file, line: line, function: function, kind: kind, count: count, bytes: bytes}
+    end)
+  end
+
+  @doc """
+  Get the number of calls and bytes of each kind since the last reset.
+  """
+  @spec totals() :: %{heap: map(), binary: map()}
+  def totals do
+    empty = %{count: 0, bytes: 0}
+
+    Enum.reduce(sites(), %{heap: empty, binary: empty}, fn site, totals ->
+      Map.update!(totals, site.kind, fn total ->
+        %{count: total.count + site.count, bytes: total.bytes + site.bytes}
+      end)
+    end)
+  end
+end
@@ -0,0 +1,68 @@
+defmodule ExNVR.AV.Bitstream do
+  @moduledoc false
+
+  alias ExNVR.AV.VideoProcessor.NIF
+
+  @type codec() :: :h264 | :h265 | :hevc
+
+  @typedoc """
+  A NAL unit in the returned bitstream.
+
+  The offset is the position of the NAL unit header, the start code or the
+  length prefix is not included in the offset nor in the size.
+  """
+  @type nal_unit() ::
+          {type :: non_neg_integer(), offset :: non_neg_integer(), size :: pos_integer()}
+
+  @doc """
+  Convert length prefixed NAL units (avcC/hvcC samples) to Annex B.
+
+  Returns the converted access unit and the index of its NAL units.
+
+  ## Options
+    * `length_size` - the size in bytes of the length prefix, one of `1`, `2` or `4`.
+    Defaults to `4`.
+  """
+  @spec to_annexb(binary(), codec(), keyword()) :: {binary(), [nal_unit()]}
+  def to_annexb(access_unit, codec, opts \\ []) do
+    NIF.avcc_to_annexb(access_unit, nif_codec(codec), Keyword.get(opts, :length_size, 4))
+  end
+
+  @doc """
+  Convert an Annex B access unit to length prefixed NAL units.
+
+  Returns the converted access unit and the index of its NAL units.
+
+  ## Options
+    * `length_size` - the size in bytes of the length prefix, one of `1`, `2` or `4`.
+    Defaults to `4`.
+  """
+  @spec to_avcc(binary(), codec(), keyword()) :: {binary(), [nal_unit()]}
+  def to_avcc(access_unit, codec, opts \\ []) do
+    NIF.annexb_to_avcc(access_unit, nif_codec(codec), Keyword.get(opts, :length_size, 4))
+  end
+
+  @doc """
+  Read the stream parameters from the parameter sets of an Annex B buffer.
+
+  The SPS (and the VPS for HEVC) are parsed directly, no decoder is involved.
+  The buffer is usually a keyframe or the parameter sets alone. `frame_rate`
+  is `nil` when the stream has no timing information.
+  """
+  @spec stream_info(binary(), codec()) :: %{
+          width: pos_integer(),
+          height: pos_integer(),
+          profile: non_neg_integer(),
+          level: non_neg_integer(),
+          chroma_format: :monochrome | :yuv420 | :yuv422 | :yuv444,
+          bit_depth: pos_integer(),
+          full_range: boolean(),
+          frame_rate: {pos_integer(), pos_integer()} | nil
+        }
+  def stream_info(access_unit, codec) do
+    NIF.parse_parameter_sets(access_unit, nif_codec(codec))
+  end
+
+  defp nif_codec(:h265), do: :hevc
+  defp nif_codec(codec) when codec in [:h264, :hevc], do: codec
+end
@@ -1,41 +1,376 @@
 defmodule ExNVR.AV.Decoder do
   @moduledoc false
 
-  alias ExNVR.AV.Frame
+  alias ExNVR.AV.{Frame, FrameRing, Packet}
   alias ExNVR.AV.VideoProcessor.NIF
 
   @type codec() :: :h264 | :hevc
 
   @type t() :: reference()
 
+  @type frame() :: Frame.t() | FrameRing.Slot.t()
+
+  @type motion_region() :: {non_neg_integer(), non_neg_integer(), pos_integer(), pos_integer()}
+
+  @type analysis() :: %{
+          :pts => integer(),
+          optional(:motion) => %{score: float(), regions: [motion_region()]},
+          optional(:motion_vectors) => %{
+            score: float(),
+            count: non_neg_integer(),
+            grid: [[float()]]
+          },
+          optional(:quality) => %{
+            mean: float(),
+            variance: float(),
+            sharpness: float(),
+            uniformity: float(),
+            histogram: [non_neg_integer()]
+          }
+        }
+
   @default_codec_options [out_format: nil, out_width: -1, out_height: -1, pad: false]
 
+  @doc """
+  Create a new decoder.
+
+  When `extradata` is an avcC/hvcC record (from an MP4 sample description or
+  an RTSP SDP), the decoder expects length prefixed access units instead of
+  Annex B ones.
+  """
   @spec new(codec(), keyword()) :: t()
   def new(codec, opts \\ []) when codec in [:h264, :h265, :hevc] do
     codec = if codec == :h265, do: :hevc, else: codec
     opts = Keyword.merge(@default_codec_options, opts)
     pad = if opts[:pad], do: 1, else: 0
-    NIF.new_decoder(codec, opts[:out_width], opts[:out_height], opts[:out_format], pad)
+
+    NIF.new_decoder(
+      codec,
+      opts[:out_width],
+      opts[:out_height],
+      opts[:out_format],
+      pad,
+      opts[:extradata] || <<>>
+    )
+  end
+
+  @doc """
+  Lease a decoder from the native pool.
+
+  Decoders are pooled by codec, input geometry, output options and `extradata`
+  (see `new/2`). A new decoder is created if none is available. The decoder must be
+  given back with `release/1`.
+  """
+  @spec lease(codec(), pos_integer(), pos_integer(), keyword()) :: t()
+  def lease(codec, width, height, opts \\ []) when codec in [:h264, :h265, :hevc] do
+    codec = if codec == :h265, do: :hevc, else: codec
+    opts = Keyword.merge(@default_codec_options, opts)
+    pad = if opts[:pad], do: 1, else: 0
+
+    NIF.lease_decoder(
+      codec,
+      opts[:out_width],
+      opts[:out_height],
+      opts[:out_format],
+      pad,
+      width,
+      height,
+      opts[:extradata] || <<>>
+    )
   end
 
-  @spec decode(t(), binary(), pts: integer(), dts: integer()) :: [Frame.t()]
+  @doc """
+  Return a leased decoder to the pool.
+
+  The decoder is flushed and reset, any pending frame is lost. The reference
+  must not be used after this call.
+  """
+  @spec release(t()) :: :ok
+  def release(decoder), do: NIF.release_decoder(decoder)
+
+  @spec decode(t(), binary(), pts: integer(), dts: integer()) :: [frame()]
   def decode(decoder, data, opts \\ []) do
     pts = opts[:pts] || 0
     dts = opts[:dts] || 0
 
     decoder
     |> NIF.decode(data, pts, dts)
-    |> Enum.map(fn {data, format, width, height, pts} ->
-      Frame.new(data, format: format, width: width, height: height, pts: pts)
+    |> Enum.map(&to_frame/1)
+  end
+
+  @doc """
+  Decode a list of packets.
+
+  The packets are decoded in batches, each batch in a single call to the native
+  code. This is faster than calling `decode/3` for each packet when processing a
+  lot of packets back to back.
+  """
+  @spec decode_many(t(), [Packet.t()]) :: [frame()]
+  def decode_many(decoder, packets) do
+    packets
+    |> Stream.map(&{&1.data, &1.pts || 0, &1.dts || 0})
+    |> Stream.chunk_every(NIF.max_batch_size())
+    |> Enum.flat_map(fn batch ->
+      decoder
+      |> NIF.decode_many(batch)
+      |> Enum.map(&to_frame/1)
     end)
   end
 
-  @spec flush(t()) :: [Frame.t()]
+  @doc """
+  Decode a stream of packets using several decoders in parallel.
+
+  The packets are split into groups of pictures at each keyframe
+  (`keyframe?: true`). Each group is decoded by its own decoder. The groups must
+  be closed (start with an IDR frame), the leading pictures of an open group are
+  dropped. Frames are returned lazily, in pts order.
+
+  Up to `max_concurrency` decoded groups are kept in memory, plus the group being
+  reordered. Scale the output down when decoding high resolution footage.
+
+  ## Options
+    * `max_concurrency` - number of groups decoded at the same time. Defaults to the
+    number of online schedulers.
+
+  The other options are the same as `new/2`.
+  """
+  @spec decode_parallel(codec(), Enumerable.t(Packet.t()), keyword()) :: Enumerable.t(Frame.t())
+  def decode_parallel(codec, packets, opts \\ []) do
+    {max_concurrency, opts} = Keyword.pop(opts, :max_concurrency, System.schedulers_online())
+
+    packets
+    |> Stream.chunk_while([], &chunk_gop/2, &last_gop/1)
+    |> Task.async_stream(
+      fn gop ->
+        decoder = new(codec, opts)
+        decode_many(decoder, gop) ++ flush(decoder)
+      end,
+      max_concurrency: max_concurrency,
+      timeout: :infinity
+    )
+    |> Stream.transform(
+      fn -> [] end,
+      fn {:ok, frames}, pending -> reorder(pending, frames) end,
+      &{&1, []},
+      fn _pending -> :ok end
+    )
+  end
+
+  @doc """
+  Decode the packets and return the frame closest to `target_pts`.
+
+  This is the last frame shown at or before the target, or the first one after it
+  if there's none. Decoding stops as soon as the target frame is available and
+  non-reference pictures after it are skipped (h264 only). Only the returned frame
+  is converted.
+
+  The packets are given in decoding order and must start with a keyframe. The
+  decoder is reset afterwards, any pending frame is dropped.
+  """
+  @spec decode_until(t(), [Packet.t()], integer()) :: frame() | nil
+  def decode_until(decoder, packets, target_pts) do
+    packets = Enum.map(packets, &{&1.data, &1.pts, &1.dts || 0})
+
+    case NIF.decode_until(decoder, packets, target_pts) do
+      [frame] -> to_frame(frame)
+      [] -> nil
+    end
+  end
+
+  @spec flush(t()) :: [frame()]
   def flush(decoder) do
     decoder
     |> NIF.flush_decoder()
-    |> Enum.map(fn {data, format, width, height, pts} ->
-      Frame.new(data, format: format, width: width, height: height, pts: pts)
-    end)
+    |> Enum.map(&to_frame/1)
+  end
+
+  @doc """
+  Release the codec context and the cached frames of the decoder.
+
+  The configuration is kept and the decoder is re-opened on the next keyframe,
+  any packet received before that is dropped.
+  """
+  @spec hibernate(t()) :: :ok
+  def hibernate(decoder), do: NIF.hibernate_decoder(decoder)
+
+  @doc """
+  Enable motion detection on the decoded frames.
+
+  The luma plane is downscaled and compared block by block to a running
+  background model, results are returned by `analyze/3`. Calling this function
+  again resets the background. High bit depth frames are reduced to 8 bits, so
+  `threshold` is always on the 8 bits scale.
+
+  ## Options
+    * `downscale` - the factor by which the luma plane is reduced. Defaults to `4`.
+    * `block_size` - size of the blocks in downscaled pixels, a multiple of 8. Defaults to `16`.
+    * `threshold` - mean absolute difference above which a block is active. Defaults to `10`.
+    * `learning_shift` - the background is updated by `1 / 2^learning_shift` of the
+    difference on each frame. Defaults to `4`.
+    * `max_regions` - maximum number of motion regions, the largest are kept. Defaults to `16`.
+  """
+  @spec enable_motion_detection(t(), keyword()) :: :ok
+  def enable_motion_detection(decoder, opts \\ []) do
+    NIF.enable_motion_detection(decoder, Map.new(opts))
+  end
+
+  @doc """
+  Export the motion vectors of the decoded frames and aggregate them into an
+  activity grid.
+
+  This is much cheaper than `enable_motion_detection/2` since the vectors are a by-product
+  of decoding, the results are returned by `analyze/3`. Only `h264` streams are supported.
+
+  ## Options
+    * `grid_width` - number of columns of the activity grid. Defaults to `16`.
+    * `grid_height` - number of rows of the activity grid. Defaults to `9`.
+    * `min_magnitude` - vectors shorter than this, in pixels, are ignored. Defaults to `1`.
+    * `skip_pixels` - skip the inverse transform and the loop filter. Defaults to `true`.
+    The decoded pixels are unusable, don't use `decode/3` or `enable_motion_detection/2`
+    on the same decoder.
+
+  Each cell of the grid is the mean displacement in pixels of the area it covers, the
+  score is the fraction of the frame covered by moving blocks.
+  """
+  @spec enable_motion_vectors(t(), keyword()) :: :ok
+  def enable_motion_vectors(decoder, opts \\ []) do
+    NIF.enable_motion_vectors(decoder, Map.new(opts))
+  end
+
+  @doc """
+  Compute image quality metrics on the luma plane of the decoded frames.
+
+  The metrics are used to detect tampering: a covered or blinded camera has a
+  high `uniformity` and a low `variance`, a defocused one has a low `sharpness`
+  (variance of the laplacian). The results are returned by `analyze/3`. High bit
+  depth frames are reduced to 8 bits first.
+
+  ## Options
+    * `interval` - compute the metrics on one frame out of `interval`. Defaults to `1`.
+    * `bins` - number of bins of the luma histogram, a power of 2. Defaults to `16`.
+    * `uniformity_range` - luma values within this distance of the histogram peak
+    count as uniform. Defaults to `8`.
+  """
+  @spec enable_quality_metrics(t(), keyword()) :: :ok
+  def enable_quality_metrics(decoder, opts \\ []) do
+    NIF.enable_quality_metrics(decoder, Map.new(opts))
+  end
+
+  @doc """
+  Limit the rate of the frames returned by the decoder.
+
+  All the frames are still decoded since the next ones may reference them, but the
+  frames that are not due are dropped before being converted or copied. Calling this
+  function again restarts the schedule, calling it without options returns all the frames.
+
+  ## Options
+    * `every` - return one frame out of `every`. Defaults to `1`.
+    * `fps` - maximum number of frames per second, based on the pts of the frames.
+    * `time_base` - the time base of the pts. Defaults to `{1, 90_000}`.
+  """
+  @spec set_output_rate(t(), keyword()) :: :ok
+  def set_output_rate(decoder, opts \\ []) do
+    interval =
+      case opts[:fps] do
+        nil ->
+          0
+
+        fps ->
+          {num, den} = Keyword.get(opts, :time_base, {1, 90_000})
+          round(den / (fps * num))
+      end
+
+    NIF.set_output_rate(decoder, Keyword.get(opts, :every, 1), interval)
+  end
+
+  @doc """
+  Select how the planes of the decoded frames are copied to the BEAM.
+
+    * `:packed` - all the planes in the `data` of the frame, the default.
+    * `:planes` - one binary per plane with its stride in `planes`, the padding at the
+    end of the rows is kept so each plane is a single copy.
+    * `:luma` - only the first plane in `planes`, the luma of yuv formats.
+
+  With `:planes` and `:luma`, the `data` of the frames is `nil`.
+  """
+  @spec set_plane_output(t(), :packed | :planes | :luma) :: :ok
+  def set_plane_output(decoder, mode) do
+    NIF.set_plane_output(decoder, mode)
+  end
+
+  @doc """
+  Publish the decoded frames to a shared memory ring, see `ExNVR.AV.FrameRing`.
+
+  The decoding functions then return a `ExNVR.AV.FrameRing.Slot` for each frame
+  instead of copying it to the BEAM. Frames larger than a slot are still returned
+  as `ExNVR.AV.Frame`. The ring is removed once the decoder is garbage collected
+  or released.
+
+  The shared memory object is created by this call, it raises `frame_ring_exists`
+  if the name is already taken.
+
+  ## Options
+    * `name` - name of the shared memory object, a single component starting with `/`.
+    * `slots` - number of slots. Defaults to `4`.
+    * `slot_size` - size of a slot in bytes. Defaults to the size of the first
+    published frame, the object is then empty until the first frame.
+    * `mode` - permissions of the shared memory object. Defaults to `0o640`.
+  """
+  @spec enable_frame_ring(t(), keyword()) :: :ok
+  def enable_frame_ring(decoder, opts) do
+    NIF.enable_frame_ring(decoder, Map.new(opts))
+  end
+
+  @doc """
+  Decode a packet and run the enabled analyzers on the decoded frames.
+
+  Only the analysis results are returned, the decoded frames are not converted
+  nor copied to the BEAM.
+  """
+  @spec analyze(t(), binary(), pts: integer(), dts: integer()) :: [analysis()]
+  def analyze(decoder, data, opts \\ []) do
+    NIF.analyze(decoder, data, opts[:pts] || 0, opts[:dts] || 0)
+  end
+
+  defp to_frame({data, format, width, height, pts}) do
+    Frame.new(data, format: format, width: width, height: height, pts: pts)
+  end
+
+  defp to_frame({:planes, planes, format, width, height, pts}) do
+    %Frame{type: :video, planes: planes, format: format, width: width, height: height, pts: pts}
+  end
+
+  defp to_frame({:slot, slot, sequence, frame_number, format, width, height, pts}) do
+    %FrameRing.Slot{
+      slot: slot,
+      sequence: sequence,
+      frame_number: frame_number,
+      format: format,
+      width: width,
+      height: height,
+      pts: pts
+    }
+  end
+
+  defp chunk_gop(%{keyframe?: true} = packet, [_ | _] = gop) do
+    {:cont, Enum.reverse(gop), [packet]}
+  end
+
+  defp chunk_gop(packet, gop), do: {:cont, [packet | gop]}
+
+  defp last_gop([]), do: {:cont, []}
+  defp last_gop(gop), do: {:cont, Enum.reverse(gop), []}
+
+  # A frame of a group may be shown before the last frames of the previous one
+  # when the keyframes are not IDR. The frames are held until the next group is
+  # decoded and only those shown before it are emitted.
+  defp reorder(pending, []), do: {[], pending}
+
+  defp reorder(pending, frames) do
+    min_pts = frames |> Enum.map(& &1.pts) |> Enum.min()
+
+    (pending ++ frames)
+    |> Enum.sort_by(& &1.pts)
+    |> Enum.split_while(&(&1.pts < min_pts))
   end
 end
@@ -14,21 +14,36 @@ defmodule ExNVR.AV.Encoder do
           | {:gop_size, non_neg_integer()}
           | {:max_b_frames, non_neg_integer()}
           | {:profile, String.t()}
+          | {:quality, 1..31}
+          | {:threads, non_neg_integer()}
+          | {:color_range, :full | :limited}
         ]
 
   @spec new(codec(), encoder_options()) :: t()
   def new(codec, opts) when codec in [:h264, :mjpeg] do
-    {time_base_num, time_base_den} = opts[:time_base]
+    NIF.new_encoder(codec, nif_options(opts))
+  end
 
-    nif_options =
-      opts
-      |> Map.new()
-      |> Map.delete(:time_base)
-      |> Map.merge(%{time_base_num: time_base_num, time_base_den: time_base_den})
+  @doc """
+  Lease an encoder from the native pool.
 
-    NIF.new_encoder(codec, nif_options)
+  Encoders are pooled by their whole configuration. A new encoder
+  is created if none is available. The encoder must be given back with `release/1`.
+  """
+  @spec lease(codec(), encoder_options()) :: t()
+  def lease(codec, opts) when codec in [:h264, :mjpeg] do
+    NIF.lease_encoder(codec, nif_options(opts))
   end
 
+  @doc """
+  Return a leased encoder to the pool.
+
+  Encoders that cannot be reset (e.g. drained encoders with delay) are destroyed
+  instead. The reference must not be used after this call.
+  """
+  @spec release(t()) :: :ok
+  def release(encoder), do: NIF.release_encoder(encoder)
+
   @spec encode(t(), ExNVR.AV.Frame.t()) :: [ExNVR.AV.Packet.t()]
   def encode(encoder, frame) do
     encoder
@@ -36,6 +51,25 @@ defmodule ExNVR.AV.Encoder do
     |> to_packets()
   end
 
+  @doc """
+  Encode a list of frames.
+
+  The frames are encoded in batches, each batch in a single call to the native code.
+  """
+  @spec encode_many(t(), [ExNVR.AV.Frame.t()]) :: [ExNVR.AV.Packet.t()]
+  def encode_many(encoder, frames) do
+    frames
+    |> Stream.map(&{&1.data, &1.pts})
+    |> Stream.chunk_every(NIF.max_batch_size())
+    |> Enum.flat_map(&to_packets(NIF.encode_many(encoder, &1)))
+  end
+
+  @doc """
+  Mask regions of the encoded frames, see `ExNVR.AV.VideoProcessor.set_privacy_mask/3`.
+  """
+  @spec set_privacy_mask(t(), [map()], keyword()) :: :ok
+  defdelegate set_privacy_mask(encoder, shapes, opts \\ []), to: ExNVR.AV.VideoProcessor
+
   @doc """
   Flush the encoder.
   """
@@ -46,6 +80,15 @@ defmodule ExNVR.AV.Encoder do
     |> to_packets()
   end
 
+  defp nif_options(opts) do
+    {time_base_num, time_base_den} = opts[:time_base]
+
+    opts
+    |> Map.new()
+    |> Map.delete(:time_base)
+    |> Map.merge(%{time_base_num: time_base_num, time_base_den: time_base_den})
+  end
+
   defp to_packets(result) do
     Enum.map(result, fn {data, dts, pts, keyframe?} ->
       %ExNVR.AV.Packet{data: data, dts: dts, pts: pts, keyframe?: keyframe?}
@@ -6,9 +6,15 @@ defmodule ExNVR.AV.Frame do
   @type width :: non_neg_integer() | nil
   @type height :: non_neg_integer() | nil
 
+  @typedoc """
+  A plane of the frame with the distance in bytes between the start of two rows.
+  """
+  @type plane() :: {binary(), stride :: pos_integer()}
+
   @type t() :: %__MODULE__{
           type: :video,
-          data: binary(),
+          data: binary() | nil,
+          planes: [plane()] | nil,
           format: format(),
           width: width(),
           height: height(),
@@ -18,6 +24,7 @@ defmodule ExNVR.AV.Frame do
   defstruct [
     :type,
     :data,
+    :planes,
     :format,
     :width,
     :height,
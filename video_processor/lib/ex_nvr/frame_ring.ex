@@ -0,0 +1,50 @@
+defmodule ExNVR.AV.FrameRing do
+  @moduledoc """
+  Ring of decoded frames in a named POSIX shared memory object.
+
+  A decoder with a frame ring (see `ExNVR.AV.Decoder.enable_frame_ring/2`) copies
+  each converted frame to the next slot of the ring instead of the BEAM, and returns
+  only the metadata of the slot. Local processes map the object and read the frames
+  in place. On Linux, the object is the file `/dev/shm/<name>`. It's empty until the
+  first frame when the decoder doesn't set a slot size, readers must check its size
+  before mapping it.
+
+  All the fields are in host byte order. The object starts with a 64 bytes header:
+
+    * `magic` (8) - `NVRRING1`, written last when the ring is created.
+    * `version` (4), `num_slots` (4)
+    * `slot_size` (8) - maximum size of a frame.
+    * `slot_stride` (8) - distance between two slots.
+    * `write_count` (8) - number of frames published, the last one is in slot
+    `rem(write_count - 1, num_slots)`.
+    * `closed` (4) - set when the decoder is gone, the ring is never written again
+    and a new ring may be created with the same name.
+
+  Followed by `num_slots` slots of `slot_stride` bytes, each one a 64 bytes header,
+  `sequence` (8), `pts` (8), `frame_number` (8), `width` (4), `height` (4), `size` (4),
+  `format` (4) and the nul terminated `format_name` (16), then the planes of the frame
+  packed without padding.
+
+  The sequence of a slot is odd while the frame is written. A reader loads the
+  sequence, reads the frame and loads the sequence again, the frame was overwritten
+  if they differ.
+  """
+
+  defmodule Slot do
+    @moduledoc """
+    A frame published to a frame ring.
+    """
+
+    @type t() :: %__MODULE__{
+            slot: non_neg_integer(),
+            sequence: non_neg_integer(),
+            frame_number: non_neg_integer(),
+            format: atom(),
+            width: pos_integer(),
+            height: pos_integer(),
+            pts: integer()
+          }
+
+    defstruct [:slot, :sequence, :frame_number, :format, :width, :height, :pts]
+  end
+end
@@ -0,0 +1,48 @@
+defmodule ExNVR.AV.KeyframeIndex do
+  @moduledoc """
+  Sidecar index of the keyframes of an MP4 recording.
+
+  The index is a compact binary file with one fixed width entry per keyframe
+  (timestamp, byte offset, size and GOP length) sorted by timestamp. It's
+  memory mapped when opened and searched in `O(log n)` without parsing the
+  sample tables of the recording.
+
+  The timestamps are the pts of the keyframes in microseconds from the start of
+  the recording. The index is built by reading the recording once, it can be
+  done lazily the first time it's needed.
+  """
+
+  alias ExNVR.AV.VideoProcessor.NIF
+
+  @type t() :: reference()
+
+  @type entry() :: %{
+          timestamp: integer(),
+          offset: non_neg_integer(),
+          size: non_neg_integer(),
+          gop_length: non_neg_integer()
+        }
+
+  @doc """
+  Build the index of an MP4 recording and write it to `index_path`.
+  """
+  @spec build(Path.t(), Path.t()) :: :ok | {:error, atom()}
+  def build(path, index_path), do: NIF.build_keyframe_index(path, index_path)
+
+  @spec open(Path.t()) :: {:ok, t()} | {:error, atom()}
+  def open(index_path), do: NIF.open_keyframe_index(index_path)
+
+  @doc """
+  Get the last keyframe at or before `timestamp` (in microseconds).
+  """
+  @spec lookup(t(), integer()) :: entry() | nil
+  def lookup(index, timestamp) do
+    case NIF.keyframe_index_lookup(index, timestamp) do
+      {timestamp, offset, size, gop_length} ->
+        %{timestamp: timestamp, offset: offset, size: size, gop_length: gop_length}
+
+      nil ->
+        nil
+    end
+  end
+end
@@ -0,0 +1,51 @@
+defmodule ExNVR.AV.Timelapse do
+  @moduledoc """
+  Build an H264 timelapse from the keyframes of a recording.
+
+  The keyframes are sampled, decoded, scaled and encoded natively, the frames
+  are never copied to the BEAM. Each sampled keyframe is one frame of the output
+  which has a constant frame rate.
+  """
+
+  alias ExNVR.AV.Decoder
+  alias ExNVR.AV.VideoProcessor.NIF
+
+  @type t() :: reference()
+
+  @doc """
+  Create a new timelapse.
+
+  ## Options
+    * `width` - width of the output, must be even. Defaults to `1280`.
+    * `height` - height of the output, must be even. Defaults to `720`.
+    * `frame_rate` - frame rate of the output. Defaults to `30`.
+    * `gop_size` - number of frames between two keyframes of the output. Defaults to `30`.
+    * `interval` - minimum pts difference between two sampled keyframes, in the time base
+    of the input. Defaults to `0`, all the keyframes are sampled.
+    * `format` - the output format, `:h264` (elementary stream) or `:mp4`. Defaults to `:h264`.
+    * `path` - the file to write the output to. The output is kept in memory and returned
+    by `finish/1` if not provided.
+  """
+  @spec new(Decoder.codec(), keyword()) :: t()
+  def new(codec, opts \\ []) when codec in [:h264, :h265, :hevc] do
+    codec = if codec == :h265, do: :hevc, else: codec
+    NIF.new_timelapse(codec, Map.new(opts))
+  end
+
+  @doc """
+  Add an access unit to the timelapse.
+
+  Only keyframes are considered, returns `true` if the access unit was sampled.
+  """
+  @spec add(t(), binary(), integer()) :: boolean()
+  def add(timelapse, data, pts), do: NIF.timelapse_add(timelapse, data, pts)
+
+  @doc """
+  Finalize the timelapse.
+
+  Returns the output when it's written in memory, `:ok` otherwise. The timelapse
+  cannot be used after this call.
+  """
+  @spec finish(t()) :: binary() | :ok
+  def finish(timelapse), do: NIF.timelapse_finish(timelapse)
+end
@@ -1,29 +1,104 @@
 defmodule ExNVR.AV.VideoProcessor do
   @moduledoc false
 
-  alias ExNVR.AV.Encoder
+  alias ExNVR.AV.{Decoder, Frame}
   alias ExNVR.AV.VideoProcessor.NIF
 
-  @spec encode_to_jpeg(ExNVR.AV.Frame.t()) :: binary()
-  def encode_to_jpeg(frame) do
-    encoder =
-      Encoder.new(:mjpeg,
-        width: frame.width,
-        height: frame.height,
-        time_base: {1, 30},
-        format: :yuvj420p
-      )
+  @doc """
+  Encode a frame to JPEG.
 
-    encoder
-    |> Encoder.encode(frame)
-    |> Kernel.++(Encoder.flush(encoder))
-    |> hd()
-    |> Map.get(:data)
+  Frames are converted to full range `yuvj420p` first, unless they are `yuv420p` frames
+  tagged as full range or their range is given with `color_range`.
+
+  ## Options
+    * `quality` - quantizer scale from `1` (best) to `31`. Defaults to the encoder default.
+    * `max_size` - maximum size of the image in bytes. The best quality that fits is
+    searched, each step encodes the frame again. The image encoded with the worst quality
+    is returned if none fits.
+    * `threads` - number of slice threads. Defaults to one per core (up to 8) for frames
+    bigger than 1080p, and `1` otherwise.
+    * `color_range` - `:full` or `:limited`, range of `yuv420p` frames. When given, the
+    frame is encoded as it is. Limited range images are only signalled in a comment that
+    most viewers ignore.
+  """
+  @spec encode_to_jpeg(Frame.t(), keyword()) :: binary()
+  def encode_to_jpeg(frame, opts \\ []) do
+    NIF.encode_to_jpeg(frame.data, frame.format, frame.width, frame.height, Map.new(opts))
+  end
+
+  @doc """
+  Get a snapshot from an MP4 recording at `timestamp` (in microseconds from the start).
+
+  The file is memory mapped and demuxed natively, only the group of pictures
+  containing the requested instant is read and decoded, none of it is copied to
+  the BEAM. The returned pts is in microseconds.
+
+  ## Options
+    * `method` - `:before` returns the keyframe at or before the timestamp, `:precise`
+    decodes up to the requested instant. Defaults to `:before`.
+    * `format` - `:jpeg` or `:frame` to get the decoded frame. Defaults to `:jpeg`.
+    * `index` - the `ExNVR.AV.KeyframeIndex` of the recording. With the `:before` method,
+    the keyframe is read directly from the file without parsing the mp4 sample tables.
+    * `quality`, `max_size`, `threads`, `color_range` - JPEG options, see `encode_to_jpeg/2`.
+
+  Returns `{:ok, pts, jpeg}` with the `:jpeg` format and `{:ok, frame}` with the `:frame`
+  format. Invalid options and failures to read, decode or encode the recording are
+  returned as `{:error, reason}`.
+  """
+  @spec recording_snapshot(Path.t(), non_neg_integer(), keyword()) ::
+          {:ok, pts :: integer(), jpeg :: binary()} | {:ok, Frame.t()} | {:error, atom()}
+  def recording_snapshot(path, timestamp, opts \\ []) do
+    case NIF.recording_snapshot(path, timestamp, Map.new(opts)) do
+      {:ok, {data, format, width, height, pts}} ->
+        {:ok, Frame.new(data, format: format, width: width, height: height, pts: pts)}
+
+      {:ok, {pts, jpeg}} ->
+        {:ok, pts, jpeg}
+
+      error ->
+        error
+    end
+  end
+
+  @doc """
+  Build a JPEG mosaic from a list of keyframes.
+
+  Only keyframes are decoded, each one is scaled into its tile of the mosaic
+  in order. Keyframes that don't fit in the grid are ignored, missing ones
+  leave a black tile.
+
+  ## Options
+    * `columns` - number of tiles per row. Defaults to `4`.
+    * `rows` - number of rows. Defaults to the number needed to fit all the keyframes.
+    * `tile_width` - width of each tile, must be even. Defaults to `160`.
+    * `tile_height` - height of each tile, must be even. Defaults to `90`.
+  """
+  @spec mosaic(Decoder.codec(), [binary()], keyword()) :: binary()
+  def mosaic(codec, keyframes, opts \\ []) when codec in [:h264, :h265, :hevc] do
+    codec = if codec == :h265, do: :hevc, else: codec
+    columns = Keyword.get(opts, :columns, 4)
+    rows = Keyword.get(opts, :rows, max(ceil(length(keyframes) / columns), 1))
+
+    params =
+      opts
+      |> Keyword.merge(columns: columns, rows: rows)
+      |> Map.new()
+
+    NIF.mosaic(codec, keyframes, params)
   end
 
+  @doc """
+  Create a converter of raw frames.
+
+  Same size conversions of `yuv420p`, `yuvj420p` and `nv12` to `rgb24` or `bgr24`
+  use vectorized kernels instead of swscale. Planar yuv inputs are first reduced by
+  2, 4 or 8 with a box filter when the output is at least that much smaller, swscale
+  only scales what's left. Set `fast_path?` to `false` to always use swscale.
+  """
   @spec new_converter(keyword()) :: reference()
   def new_converter(opts) do
     pad = if Keyword.get(opts, :pad?, false), do: 1, else: 0
+    fast_path = if Keyword.get(opts, :fast_path?, true), do: 1, else: 0
 
     NIF.new_converter(
       opts[:in_width],
@@ -32,13 +107,141 @@ defmodule ExNVR.AV.VideoProcessor do
       opts[:out_width],
       opts[:out_height],
       opts[:out_format],
-      pad
+      pad,
+      fast_path
     )
   end
 
+  @doc """
+  Create a converter that scales regions of interest of the input frames.
+
+  Each region is cropped and scaled to its own output size, the crop is done by
+  offsetting the input planes so the input frame is never copied. A region is
+  grown to start and end on a chroma sample of subsampled input formats.
+
+  ## Options
+    * `in_width`, `in_height`, `in_format` - the input frames.
+    * `out_format` - the format of all the outputs.
+    * `rois` - a list of maps with the `x`, `y`, `width` and `height` of each region
+    and optionally their `out_width` and `out_height`. An output dimension set to `-1`
+    keeps the aspect ratio, both default to the size of the region.
+  """
+  @spec new_roi_converter(keyword()) :: reference()
+  def new_roi_converter(opts) do
+    rois =
+      Enum.map(opts[:rois], fn roi ->
+        out_width = Map.get(roi, :out_width, -1)
+        out_height = Map.get(roi, :out_height, -1)
+        {roi.x, roi.y, roi.width, roi.height, out_width, out_height}
+      end)
+
+    NIF.new_roi_converter(
+      opts[:in_width],
+      opts[:in_height],
+      opts[:in_format],
+      opts[:out_format],
+      rois
+    )
+  end
+
+  @doc """
+  Convert a raw frame with a converter created by `new_roi_converter/1`.
+
+  Returns one converted frame per region, in the order of the regions.
+  """
+  @spec convert_rois(reference(), binary()) :: [binary()]
+  def convert_rois(converter, data) do
+    converter
+    |> NIF.convert_rois(data)
+    |> Enum.map(&elem(&1, 0))
+  end
+
   @spec convert(reference(), binary()) :: binary()
   def convert(converter, data) do
     {data, _w, _h, _fmt, _pts} = NIF.convert(converter, data)
     data
   end
+
+  @doc """
+  Convert a list of raw frames.
+
+  The frames are converted in batches, the frames of each batch are spread
+  over several threads.
+
+  ## Options
+    * `threads` - maximum number of threads per batch. Defaults to the number of
+    online schedulers.
+  """
+  @spec convert_many(reference(), [binary()], keyword()) :: [binary()]
+  def convert_many(converter, frames, opts \\ []) do
+    threads = Keyword.get(opts, :threads, System.schedulers_online())
+
+    frames
+    |> Stream.chunk_every(NIF.max_batch_size())
+    |> Enum.flat_map(&NIF.convert_many(converter, &1, threads))
+  end
+
+  @doc """
+  Black out or pixelate regions of the frames of a converter or an encoder.
+
+  The shapes are given in pixels of the input frames, as rectangles
+  (`%{x: x, y: y, width: width, height: height}`) or polygons (`%{points: [{x, y}, ...]}`).
+  They're rasterized once for the output of the converter and masked after scaling, the
+  input of an encoder is copied and masked before encoding. An empty list removes the mask.
+
+  Converters created with `new_roi_converter/1` can't be masked.
+
+  ## Options
+    * `mode` - `:fill` to black out the regions or `:pixelate`. Defaults to `:fill`.
+    * `block_size` - size of the pixelation blocks, from `1` to `64`. Defaults to `16`.
+  """
+  @spec set_privacy_mask(reference(), [map()], keyword()) :: :ok
+  def set_privacy_mask(ref, shapes, opts \\ []) do
+    mode = Keyword.get(opts, :mode, :fill)
+    block_size = Keyword.get(opts, :block_size, 16)
+
+    NIF.set_privacy_mask(ref, Enum.map(shapes, &to_polygon/1), mode, block_size)
+  end
+
+  @doc """
+  Add a text label to the frames of a converter, returns the index of the label.
+
+  The label is drawn on the output frames, after scaling and masking, and is empty until
+  its text is set with `set_label_text/3`. A converter has at most 4 labels.
+
+  Converters created with `new_roi_converter/1` can't have labels.
+
+  ## Options
+    * `x` - left of the label in pixels of the output frames. Defaults to `0`.
+    * `y` - top of the label in pixels of the output frames. Defaults to `0`.
+    * `size` - height of the text in pixels, from `8` to `128`. Defaults to `24`.
+    * `background?` - draw the text over a half transparent black box. Defaults to `true`.
+  """
+  @spec add_text_label(reference(), keyword()) :: non_neg_integer()
+  def add_text_label(converter, opts \\ []) do
+    x = Keyword.get(opts, :x, 0)
+    y = Keyword.get(opts, :y, 0)
+    size = Keyword.get(opts, :size, 24)
+    background = if Keyword.get(opts, :background?, true), do: 1, else: 0
+
+    NIF.add_text_label(converter, x, y, size, background)
+  end
+
+  @doc """
+  Set the text of a label, it's drawn on all the frames converted afterwards.
+
+  Only the characters that differ from the previous text are redrawn, updating a
+  timestamp every frame is cheap. The text is a single line of at most 64 characters,
+  the characters outside of printable ascii are drawn as `?`. An empty text hides the label.
+  """
+  @spec set_label_text(reference(), non_neg_integer(), String.t()) :: :ok
+  def set_label_text(converter, label, text) do
+    NIF.set_label_text(converter, label, text)
+  end
+
+  defp to_polygon(%{points: points}), do: points
+
+  defp to_polygon(%{x: x, y: y, width: width, height: height}) do
+    [{x, y}, {x + width, y}, {x + width, y + height}, {x, y + height}]
+  end
 end
@@ -1,17 +1,70 @@
 defmodule ExNVR.AV.VideoProcessor.NIF do
   @moduledoc false
 
+  require Logger
+
   @compile {:autoload, false}
   @on_load :__on_load__
 
+  # The codec pools are configured through the application environment, e.g.
+  #
+  #   config :video_processor, :codec_pool,
+  #     max_size: 16,
+  #     max_size_per_key: 2,
+  #     warm_up: [
+  #       {:decoder, :h264, -1, -1, :yuvj420p, 0, 1920, 1080},
+  #       {:encoder, :mjpeg, %{width: 1920, height: 1080, format: :yuvj420p, ...}}
+  #     ]
+  #
+  # Invalid options are logged and dropped, a bad configuration must not prevent
+  # the library from loading.
   def __on_load__ do
     path = :filename.join(:code.priv_dir(:video_processor), ~c"libvideoprocessor")
-    :ok = :erlang.load_nif(path, 0)
+
+    load_info =
+      :video_processor
+      |> Application.get_env(:codec_pool, %{})
+      |> Enum.flat_map(&validate_pool_option/1)
+      |> Map.new()
+
+    :ok = :erlang.load_nif(path, load_info)
+  end
+
+  defp validate_pool_option({key, value})
+       when key in [:max_size, :max_size_per_key] and is_integer(value) and value >= 0,
+       do: [{key, value}]
+
+  defp validate_pool_option({:warm_up, entries}) when is_list(entries) do
+    [{:warm_up, Enum.filter(entries, &valid_warm_up_entry?/1)}]
+  end
+
+  defp validate_pool_option(option) do
+    Logger.warning("Ignoring invalid codec pool option: #{inspect(option)}")
+    []
   end
 
+  defp valid_warm_up_entry?({:decoder, codec, out_width, out_height, out_format, pad, w, h})
+       when is_atom(codec) and is_integer(out_width) and is_integer(out_height) and
+              is_atom(out_format) and is_integer(pad) and is_integer(w) and is_integer(h),
+       do: true
+
+  defp valid_warm_up_entry?({:encoder, codec, params}) when is_atom(codec) and is_map(params),
+    do: true
+
+  defp valid_warm_up_entry?(entry) do
+    Logger.warning("Ignoring invalid codec pool warm up entry: #{inspect(entry)}")
+    false
+  end
+
+  # maximum number of items accepted by the *_many functions, see NVR_MAX_BATCH_SIZE
+  @max_batch_size 64
+
+  @spec max_batch_size() :: pos_integer()
+  def max_batch_size, do: @max_batch_size
+
   def new_encoder(_codec, _params), do: :erlang.nif_error(:undef)
 
-  def new_decoder(_codec, _out_width, _out_height, _out_format, _pad?),
+  def new_decoder(_codec, _out_width, _out_height, _out_format, _pad?, _extradata),
     do: :erlang.nif_error(:undef)
 
   def new_converter(
@@ -21,13 +74,67 @@ defmodule ExNVR.AV.VideoProcessor.NIF do
         _out_width,
         _out_height,
         _out_format,
-        _pad?
+        _pad?,
+        _fast_path?
       ),
       do: :erlang.nif_error(:undef)
 
+  def new_roi_converter(_in_width, _in_height, _in_format, _out_format, _rois),
+    do: :erlang.nif_error(:undef)
+
   def encode(_encoder, _data, _pts), do: :erlang.nif_error(:undef)
   def decode(_decoder, _data, _dts, _pts), do: :erlang.nif_error(:undef)
+  def encode_many(_encoder, _frames), do: :erlang.nif_error(:undef)
+  def decode_many(_decoder, _packets), do: :erlang.nif_error(:undef)
+  def convert_many(_converter, _frames, _threads), do: :erlang.nif_error(:undef)
+  def decode_until(_decoder, _packets, _target_pts), do: :erlang.nif_error(:undef)
   def convert(_converter, _data), do: :erlang.nif_error(:undef)
+  def convert_rois(_converter, _data), do: :erlang.nif_error(:undef)
   def flush_encoder(_encoder), do: :erlang.nif_error(:undef)
   def flush_decoder(_decoder), do: :erlang.nif_error(:undef)
+  def hibernate_decoder(_decoder), do: :erlang.nif_error(:undef)
+  def enable_motion_detection(_decoder, _params), do: :erlang.nif_error(:undef)
+  def enable_motion_vectors(_decoder, _params), do: :erlang.nif_error(:undef)
+  def enable_quality_metrics(_decoder, _params), do: :erlang.nif_error(:undef)
+  def set_output_rate(_decoder, _every, _interval), do: :erlang.nif_error(:undef)
+  def set_plane_output(_decoder, _mode), do: :erlang.nif_error(:undef)
+
+  def set_privacy_mask(_converter_or_encoder, _shapes, _mode, _block_size),
+    do: :erlang.nif_error(:undef)
+
+  def add_text_label(_converter, _x, _y, _size, _background), do: :erlang.nif_error(:undef)
+  def set_label_text(_converter, _label, _text), do: :erlang.nif_error(:undef)
+  def enable_frame_ring(_decoder, _params), do: :erlang.nif_error(:undef)
+  def alloc_stats, do: :erlang.nif_error(:undef)
+  def reset_alloc_stats, do: :erlang.nif_error(:undef)
+  def analyze(_decoder, _data, _pts, _dts), do: :erlang.nif_error(:undef)
+  def mosaic(_codec, _keyframes, _params), do: :erlang.nif_error(:undef)
+  def avcc_to_annexb(_data, _codec, _length_size), do: :erlang.nif_error(:undef)
+  def annexb_to_avcc(_data, _codec, _length_size), do: :erlang.nif_error(:undef)
+  def parse_parameter_sets(_data, _codec), do: :erlang.nif_error(:undef)
+  def new_timelapse(_codec, _params), do: :erlang.nif_error(:undef)
+  def timelapse_add(_timelapse, _data, _pts), do: :erlang.nif_error(:undef)
+  def timelapse_finish(_timelapse), do: :erlang.nif_error(:undef)
+  def recording_snapshot(_path, _timestamp, _params), do: :erlang.nif_error(:undef)
+  def encode_to_jpeg(_data, _format, _width, _height, _params), do: :erlang.nif_error(:undef)
+  def build_keyframe_index(_path, _index_path), do: :erlang.nif_error(:undef)
+  def open_keyframe_index(_index_path), do: :erlang.nif_error(:undef)
+  def keyframe_index_lookup(_index, _timestamp), do: :erlang.nif_error(:undef)
+
+  def lease_encoder(_codec, _params), do: :erlang.nif_error(:undef)
+
+  def lease_decoder(
+        _codec,
+        _out_width,
+        _out_height,
+        _out_format,
+        _pad?,
+        _width,
+        _height,
+        _extradata
+      ),
+      do: :erlang.nif_error(:undef)
+
+  def release_encoder(_encoder), do: :erlang.nif_error(:undef)
+  def release_decoder(_decoder), do: :erlang.nif_error(:undef)
 end
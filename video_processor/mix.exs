@@ -9,6 +9,7 @@ defmodule ExNVR.AV.VideoProcessor.MixProject do
       version: @version,
       elixir: "~> 1.18",
       compilers: [:elixir_make] ++ Mix.compilers(),
+      elixirc_paths: elixirc_paths(Mix.env()),
       start_permanent: Mix.env() == :prod,
       deps: deps(),
       make_clean: ["clean"]
@@ -22,6 +23,9 @@ defmodule ExNVR.AV.VideoProcessor.MixProject do
     ]
   end
 
+  defp elixirc_paths(:test), do: ["lib", "test/support"]
+  defp elixirc_paths(_), do: ["lib"]
+
   # Run "mix help deps" to learn about dependencies.
   defp deps do
     [
@@ -0,0 +1,61 @@
+defmodule ExNVR.AV.AllocStatsTest do
+  # the counters are global, the test must not run with other native code
+  use ExUnit.Case, async: false
+
+  alias ExNVR.AV.{AllocStats, Decoder, Frame, VideoProcessor}
+
+  import ExNVR.AV.TestHelpers
+
+  @moduletag :alloc_stats
+
+  @width 64
+  @height 64
+  @warm_up 10
+
+  setup do
+    frames =
+      for idx <- 0..39, do: %Frame{data: solid_yuv420p(@width, @height, 16 + idx * 4), pts: idx}
+
+    packets =
+      encoded_h264(frames, width: @width, height: @height, gop_size: 10, max_b_frames: 0)
+
+    %{packets: packets, frames: frames}
+  end
+
+  test "decoding and converting doesn't allocate after warm up", %{packets: packets} do
+    decoder = Decoder.new(:h264, out_format: :rgb24)
+    {warm_up, packets} = Enum.split(packets, @warm_up)
+
+    Enum.each(warm_up, &Decoder.decode(decoder, &1.data, pts: &1.pts))
+
+    AllocStats.reset()
+    frames = Enum.flat_map(packets, &Decoder.decode(decoder, &1.data, pts: &1.pts))
+    totals = AllocStats.totals()
+
+    assert length(frames) > 0
+    assert totals.heap.count == 0, inspect(AllocStats.sites(), pretty: true)
+    assert totals.binary.count == length(frames)
+    assert totals.binary.bytes == length(frames) * @width * @height * 3
+  end
+
+  test "converting raw frames doesn't allocate", %{frames: frames} do
+    converter =
+      VideoProcessor.new_converter(
+        in_width: @width,
+        in_height: @height,
+        in_format: :yuv420p,
+        out_width: div(@width, 2),
+        out_height: div(@height, 2),
+        out_format: :rgb24
+      )
+
+    VideoProcessor.convert(converter, hd(frames).data)
+
+    AllocStats.reset()
+    Enum.each(frames, &VideoProcessor.convert(converter, &1.data))
+    totals = AllocStats.totals()
+
+    assert totals.heap.count == 0, inspect(AllocStats.sites(), pretty: true)
+    assert totals.binary.bytes == length(frames) * div(@width, 2) * div(@height, 2) * 3
+  end
+end
@@ -0,0 +1,95 @@
+defmodule ExNVR.AV.BitstreamTest do
+  use ExUnit.Case, async: true
+
+  alias ExNVR.AV.Bitstream
+
+  @h264_frame File.read!("test/fixtures/decoder/sample.h264")
+  @h265_frame File.read!("test/fixtures/decoder/sample.h265")
+
+  test "convert annexb to avcc and back" do
+    assert {avcc, units} = Bitstream.to_avcc(@h264_frame, :h264)
+    types = Enum.map(units, &elem(&1, 0))
+    assert 7 in types and 8 in types and 5 in types
+
+    for {_type, offset, size} <- units do
+      assert <<^size::32>> = binary_part(avcc, offset - 4, 4)
+    end
+
+    assert {annexb, ^units} = Bitstream.to_annexb(avcc, :h264)
+    assert {^avcc, ^units} = Bitstream.to_avcc(annexb, :h264)
+  end
+
+  test "nal unit index" do
+    sps = <<0x67, 0x42, 0x00, 0x1F>>
+    pps = <<0x68, 0xCE, 0x3C, 0x80>>
+    idr = <<0x65, 0x88, 0x84, 0x00, 0x00, 0x03, 0x00, 0x10>>
+
+    annexb = <<1::32, sps::binary, 1::24, pps::binary, 1::32, idr::binary, 0, 0>>
+
+    assert {avcc, [{7, 2, 4}, {8, 8, 4}, {5, 14, 8}]} =
+             Bitstream.to_avcc(annexb, :h264, length_size: 2)
+
+    assert avcc == <<4::16, sps::binary, 4::16, pps::binary, 8::16, idr::binary>>
+
+    assert {annexb, [{7, 4, 4}, {8, 12, 4}, {5, 20, 8}]} =
+             Bitstream.to_annexb(avcc, :h264, length_size: 2)
+
+    assert annexb == <<1::32, sps::binary, 1::32, pps::binary, 1::32, idr::binary>>
+  end
+
+  test "hevc nal unit types" do
+    vps = <<0x40, 0x01, 0x0C>>
+    idr = <<0x26, 0x01, 0xAF>>
+
+    assert {_avcc, [{32, 4, 3}, {19, 11, 3}]} =
+             Bitstream.to_avcc(<<1::32, vps::binary, 1::32, idr::binary>>, :hevc)
+  end
+
+  test "truncated avcc raises" do
+    assert_raise ErlangError, ~r/invalid_bitstream/, fn ->
+      Bitstream.to_annexb(<<10::32, 0x65, 0x88>>, :h264)
+    end
+  end
+
+  describe "stream_info/2" do
+    test "h264 sps" do
+      assert %{
+               width: 1280,
+               height: 720,
+               profile: 100,
+               level: 50,
+               chroma_format: :yuv420,
+               bit_depth: 8,
+               full_range: false,
+               frame_rate: {30, 1}
+             } = Bitstream.stream_info(@h264_frame, :h264)
+    end
+
+    test "hevc sps" do
+      assert %{
+               width: 1920,
+               height: 1080,
+               profile: 1,
+               level: 120,
+               chroma_format: :yuv420,
+               bit_depth: 8,
+               frame_rate: {30, 1}
+             } = Bitstream.stream_info(@h265_frame, :hevc)
+    end
+
+    test "raises without parameter sets" do
+      assert_raise ErlangError, ~r/invalid_parameter_sets/, fn ->
+        Bitstream.stream_info(<<1::32, 0x65, 0x88, 0x84>>, :h264)
+      end
+    end
+
+    test "raises on an out of range chroma format" do
+      # high profile sps with chroma_format_idc = 2^31, escaped after each 00 00
+      sps = <<0x67, 100, 0, 31, 0x80, 0, 0, 3, 0, 0x80, 0, 0, 3, 1, 0xFF, 0xFF, 0x80>>
+
+      assert_raise ErlangError, ~r/invalid_parameter_sets/, fn ->
+        Bitstream.stream_info(<<1::32, sps::binary>>, :h264)
+      end
+    end
+  end
+end
@@ -1,9 +1,11 @@
 defmodule ExNVR.AV.DecoderTest do
   use ExUnit.Case, async: true
 
-  alias ExNVR.AV.{Decoder, Encoder, Frame}
+  alias ExNVR.AV.{Bitstream, Decoder, Encoder, Frame, FrameRing}
   alias ExNVR.AV.VideoProcessor.NIF
 
+  import ExNVR.AV.TestHelpers, only: [encoded_h264: 1, encoded_h264: 2]
+
   @h264_frame File.read!("test/fixtures/decoder/sample.h264")
   @h265_frame File.read!("test/fixtures/decoder/sample.h265")
 
@@ -20,7 +22,7 @@ defmodule ExNVR.AV.DecoderTest do
   test "repeated failed constructions with an unknown codec raise a controlled error" do
     for _i <- 1..1000 do
       assert_raise ErlangError, ~r/unknown_codec/, fn ->
-        NIF.new_decoder(:vp9, -1, -1, nil, 0)
+        NIF.new_decoder(:vp9, -1, -1, nil, 0, <<>>)
       end
     end
   end
@@ -102,15 +104,566 @@ defmodule ExNVR.AV.DecoderTest do
     end
   end
 
+  describe "avcC input" do
+    setup do
+      {avcc, units} = Bitstream.to_avcc(@h264_frame, :h264)
+      [sps] = for {7, offset, size} <- units, do: binary_part(avcc, offset, size)
+      [pps] = for {8, offset, size} <- units, do: binary_part(avcc, offset, size)
+
+      <<_type, profile, compatibility, level, _rest::binary>> = sps
+
+      extradata =
+        <<1, profile, compatibility, level, 0xFF, 0xE1, byte_size(sps)::16, sps::binary, 1,
+          byte_size(pps)::16, pps::binary>>
+
+      %{avcc: avcc, extradata: extradata}
+    end
+
+    test "decodes length prefixed access units", %{avcc: avcc, extradata: extradata} do
+      decoder = Decoder.new(:h264, extradata: extradata, out_format: :rgb24)
+
+      assert [%Frame{width: 1280, height: 720, format: :rgb24}] =
+               decode_and_flush(decoder, avcc)
+    end
+
+    test "hibernated decoder wakes up on a length prefixed keyframe", ctx do
+      decoder = Decoder.new(:h264, extradata: ctx.extradata)
+
+      assert [%Frame{width: 1280, height: 720}] = decode_and_flush(decoder, ctx.avcc)
+      assert :ok = Decoder.hibernate(decoder)
+      assert [%Frame{width: 1280, height: 720}] = decode_and_flush(decoder, ctx.avcc)
+    end
+
+    test "hibernated decoder drops units with a corrupt length", ctx do
+      decoder = Decoder.new(:h264, extradata: ctx.extradata)
+      assert :ok = Decoder.hibernate(decoder)
+
+      # the length runs past the end of the packet, the idr slice must not be found
+      <<_length::32, rest::binary>> = ctx.avcc
+      assert [] = Decoder.decode(decoder, <<0x7FFFFFFF::32, rest::binary>>)
+      assert [] = Decoder.decode(decoder, <<0xFFFFFFF0::32, rest::binary>>)
+    end
+
+    test "leased decoders are pooled by extradata", ctx do
+      decoder = Decoder.lease(:h264, 1280, 720, extradata: ctx.extradata)
+      assert [%Frame{width: 1280, height: 720}] = decode_and_flush(decoder, ctx.avcc)
+      assert :ok = Decoder.release(decoder)
+
+      decoder = Decoder.lease(:h264, 1280, 720)
+      assert [%Frame{width: 1280, height: 720}] = decode_and_flush(decoder, @h264_frame)
+      assert :ok = Decoder.release(decoder)
+
+      decoder = Decoder.lease(:h264, 1280, 720, extradata: ctx.extradata)
+      assert [%Frame{width: 1280, height: 720}] = decode_and_flush(decoder, ctx.avcc)
+      assert :ok = Decoder.release(decoder)
+    end
+  end
+
+  describe "lease/4" do
+    test "leased decoders are reset and reused" do
+      decoder = Decoder.lease(:h264, 1280, 720, out_format: :rgb24)
+
+      assert [%Frame{width: 1280, height: 720, format: :rgb24}] =
+               decode_and_flush(decoder, @h264_frame)
+
+      assert :ok = Decoder.release(decoder)
+
+      decoder = Decoder.lease(:h264, 1280, 720, out_format: :rgb24)
+
+      assert [%Frame{width: 1280, height: 720, format: :rgb24}] =
+               decode_and_flush(decoder, @h264_frame)
+
+      assert :ok = Decoder.release(decoder)
+    end
+
+    test "released decoders cannot be used" do
+      decoder = Decoder.lease(:hevc, 1920, 1080)
+      :ok = Decoder.release(decoder)
+
+      assert_raise ErlangError, ~r/decoder_released/, fn ->
+        Decoder.decode(decoder, @h265_frame)
+      end
+
+      assert_raise ErlangError, ~r/decoder_released/, fn -> Decoder.release(decoder) end
+
+      assert_raise ErlangError, ~r/decoder_not_leased/, fn ->
+        Decoder.release(Decoder.new(:h264))
+      end
+    end
+  end
+
+  describe "hibernate/1" do
+    test "decoder wakes up on the next keyframe" do
+      decoder = Decoder.new(:h264, out_format: :rgb24)
+
+      assert [%Frame{width: 1280, height: 720}] = decode_and_flush(decoder, @h264_frame)
+      assert :ok = Decoder.hibernate(decoder)
+      assert :ok = Decoder.hibernate(decoder)
+      assert [] = Decoder.flush(decoder)
+
+      assert [%Frame{width: 1280, height: 720, format: :rgb24}] =
+               decode_and_flush(decoder, @h264_frame)
+    end
+
+    test "packets before the next keyframe are dropped" do
+      packets =
+        0..7
+        |> Enum.map(&%Frame{data: solid_yuv420p(64, 64, 128), pts: &1})
+        |> encoded_h264(gop_size: 4, max_b_frames: 0)
+
+      [keyframe | packets] = packets
+
+      decoder = Decoder.new(:h264)
+      Decoder.decode(decoder, keyframe.data, pts: keyframe.pts)
+      assert :ok = Decoder.hibernate(decoder)
+
+      frames =
+        Enum.flat_map(packets, &Decoder.decode(decoder, &1.data, pts: &1.pts)) ++
+          Decoder.flush(decoder)
+
+      assert Enum.map(frames, & &1.pts) == [4, 5, 6, 7]
+    end
+  end
+
+  describe "decode_many/2" do
+    test "returns the same frames as decode/3" do
+      packets =
+        0..99
+        |> Enum.map(&%Frame{data: solid_yuv420p(64, 64, &1 + 16), pts: &1})
+        |> encoded_h264()
+
+      decoder = Decoder.new(:h264, out_format: :gray)
+      frames = Decoder.decode_many(decoder, packets) ++ Decoder.flush(decoder)
+
+      decoder = Decoder.new(:h264, out_format: :gray)
+
+      assert frames ==
+               Enum.flat_map(packets, &Decoder.decode(decoder, &1.data, pts: &1.pts)) ++
+                 Decoder.flush(decoder)
+
+      assert Enum.map(frames, & &1.pts) == Enum.to_list(0..99)
+    end
+
+    test "raises on batches larger than the maximum size" do
+      assert_raise ErlangError, ~r/batch_too_large/, fn ->
+        NIF.decode_many(Decoder.new(:h264), List.duplicate({@h264_frame, 0, 0}, 65))
+      end
+    end
+  end
+
+  describe "set_output_rate/2" do
+    setup do
+      packets =
+        0..49
+        |> Enum.map(&%Frame{data: solid_yuv420p(64, 64, &1 + 16), pts: &1 * 3_600})
+        |> encoded_h264()
+
+      %{packets: packets}
+    end
+
+    test "returns one frame out of every", %{packets: packets} do
+      decoder = Decoder.new(:h264, out_format: :rgb24)
+      :ok = Decoder.set_output_rate(decoder, every: 5)
+
+      frames = Decoder.decode_many(decoder, packets) ++ Decoder.flush(decoder)
+      assert Enum.map(frames, & &1.pts) == Enum.map(0..9, &(&1 * 18_000))
+    end
+
+    test "limits the frames per second", %{packets: packets} do
+      decoder = Decoder.new(:h264)
+      :ok = Decoder.set_output_rate(decoder, fps: 5)
+
+      frames =
+        Enum.flat_map(packets, &Decoder.decode(decoder, &1.data, pts: &1.pts)) ++
+          Decoder.flush(decoder)
+
+      assert Enum.map(frames, & &1.pts) == Enum.map(0..9, &(&1 * 18_000))
+    end
+
+    test "returns all the frames once reset", %{packets: packets} do
+      decoder = Decoder.new(:h264)
+      :ok = Decoder.set_output_rate(decoder, every: 5, fps: 1)
+      :ok = Decoder.set_output_rate(decoder)
+
+      assert length(Decoder.decode_many(decoder, packets) ++ Decoder.flush(decoder)) == 50
+    end
+
+    test "raises on invalid rate" do
+      assert_raise ErlangError, ~r/invalid_output_rate/, fn ->
+        Decoder.set_output_rate(Decoder.new(:h264), every: 0)
+      end
+    end
+  end
+
+  describe "set_plane_output/2" do
+    setup do
+      packets =
+        0..4
+        |> Enum.map(&%Frame{data: solid_yuv420p(64, 48, &1 * 40 + 16), pts: &1})
+        |> encoded_h264(height: 48)
+
+      %{packets: packets}
+    end
+
+    test "returns each plane with its stride", %{packets: packets} do
+      decoder = Decoder.new(:h264)
+      expected = Decoder.decode_many(decoder, packets) ++ Decoder.flush(decoder)
+
+      decoder = Decoder.new(:h264)
+      :ok = Decoder.set_plane_output(decoder, :planes)
+      frames = Decoder.decode_many(decoder, packets) ++ Decoder.flush(decoder)
+
+      assert length(frames) == 5
+
+      for {frame, packed} <- Enum.zip(frames, expected) do
+        assert %Frame{data: nil, format: :yuv420p, width: 64, height: 48} = frame
+        assert [{y, y_stride}, {u, u_stride}, {v, v_stride}] = frame.planes
+        assert y_stride >= 64 and u_stride >= 32 and v_stride >= 32
+
+        assert unpad(y, y_stride, 64) <> unpad(u, u_stride, 32) <> unpad(v, v_stride, 32) ==
+                 packed.data
+      end
+    end
+
+    test "returns only the luma plane", %{packets: packets} do
+      decoder = Decoder.new(:h264, out_width: 32, out_height: 24)
+      :ok = Decoder.set_plane_output(decoder, :luma)
+
+      frames = Decoder.decode_many(decoder, packets) ++ Decoder.flush(decoder)
+
+      assert [%Frame{planes: [{luma, stride}], width: 32, height: 24} | _rest] = frames
+      assert byte_size(luma) == 23 * stride + 32
+
+      :ok = Decoder.set_plane_output(decoder, :packed)
+      assert [%Frame{planes: nil, data: data} | _rest] = Decoder.decode_many(decoder, packets)
+      assert byte_size(data) == div(32 * 24 * 3, 2)
+    end
+
+    test "raises on invalid mode" do
+      assert_raise ErlangError, ~r/invalid_plane_output/, fn ->
+        Decoder.set_plane_output(Decoder.new(:h264), :rgb)
+      end
+    end
+  end
+
+  describe "enable_frame_ring/2" do
+    setup do
+      packets =
+        0..5
+        |> Enum.map(&%Frame{data: solid_yuv420p(64, 64, &1 * 30 + 16), pts: &1 * 3_600})
+        |> encoded_h264()
+
+      %{packets: packets, name: "/ex_nvr_test_#{System.unique_integer([:positive])}"}
+    end
+
+    test "publishes the frames to shared memory", %{packets: packets, name: name} do
+      reference = Decoder.new(:h264, out_format: :rgb24)
+      expected = Decoder.decode_many(reference, packets) ++ Decoder.flush(reference)
+
+      decoder = Decoder.new(:h264, out_format: :rgb24)
+      :ok = Decoder.enable_frame_ring(decoder, name: name, slots: 4)
+      slots = Decoder.decode_many(decoder, packets) ++ Decoder.flush(decoder)
+
+      assert Enum.map(slots, & &1.pts) == Enum.map(expected, & &1.pts)
+      assert Enum.map(slots, & &1.slot) == [0, 1, 2, 3, 0, 1]
+      assert Enum.all?(slots, &match?(%FrameRing.Slot{format: :rgb24, width: 64}, &1))
+
+      ring = File.read!("/dev/shm" <> name)
+
+      assert <<"NVRRING1", 1::32-native, 4::32-native, 12_288::64-native, stride::64-native,
+               6::64-native, 0::32-native, _rest::binary>> = ring
+
+      for slot <- Enum.take(slots, -4) do
+        assert <<sequence::64-native, pts::64-signed-native, frame_number::64-native,
+                 64::32-native, 64::32-native, 12_288::32-native, _format::32-native,
+                 "rgb24", 0, _name::binary-size(10), _reserved::binary-size(8),
+                 data::binary-size(12_288), _padding::binary>> =
+                 binary_part(ring, 64 + slot.slot * stride, stride)
+
+        assert sequence == slot.sequence and rem(sequence, 2) == 0
+        assert frame_number == slot.frame_number
+        assert %Frame{pts: ^pts, data: ^data} = Enum.at(expected, frame_number)
+      end
+
+      # the ring lives as long as the decoder
+      assert Decoder.flush(decoder) == []
+    end
+
+    test "returns the frames larger than a slot", %{packets: packets, name: name} do
+      decoder = Decoder.new(:h264)
+      :ok = Decoder.enable_frame_ring(decoder, name: name, slot_size: 1_024)
+
+      frames = Decoder.decode_many(decoder, packets) ++ Decoder.flush(decoder)
+      assert length(frames) == 6
+      assert Enum.all?(frames, &match?(%Frame{width: 64, height: 64}, &1))
+    end
+
+    test "creates the ring with the given mode", %{name: name} do
+      decoder = Decoder.new(:h264)
+      :ok = Decoder.enable_frame_ring(decoder, name: name)
+      assert %File.Stat{mode: mode} = File.stat!("/dev/shm" <> name)
+      assert Bitwise.band(mode, 0o777) == 0o640
+
+      other_name = name <> "_private"
+      other = Decoder.new(:h264)
+      :ok = Decoder.enable_frame_ring(other, name: other_name, mode: 0o600)
+      assert %File.Stat{mode: mode} = File.stat!("/dev/shm" <> other_name)
+      assert Bitwise.band(mode, 0o777) == 0o600
+    end
+
+    test "raises when the name is taken", %{name: name} do
+      decoder = Decoder.new(:h264)
+      :ok = Decoder.enable_frame_ring(decoder, name: name)
+
+      assert_raise ErlangError, ~r/frame_ring_exists/, fn ->
+        Decoder.enable_frame_ring(Decoder.new(:h264), name: name)
+      end
+
+      # the existing ring is left untouched
+      assert File.exists?("/dev/shm" <> name)
+    end
+
+    test "raises on invalid name" do
+      assert_raise ErlangError, ~r/invalid_frame_ring_config/, fn ->
+        Decoder.enable_frame_ring(Decoder.new(:h264), name: "ex_nvr_test")
+      end
+
+      assert_raise ErlangError, ~r/missing_frame_ring_name/, fn ->
+        Decoder.enable_frame_ring(Decoder.new(:h264), slots: 2)
+      end
+    end
+  end
+
+  describe "decode_parallel/3" do
+    test "returns the frames of all the groups in pts order" do
+      packets =
+        0..59
+        |> Enum.map(&%Frame{data: solid_yuv420p(64, 64, &1 * 4), pts: &1})
+        |> encoded_h264(gop_size: 10, max_b_frames: 2)
+
+      assert Enum.count(packets, & &1.keyframe?) > 1
+
+      decoder = Decoder.new(:h264, out_format: :gray)
+      expected = Decoder.decode_many(decoder, packets) ++ Decoder.flush(decoder)
+
+      frames =
+        :h264
+        |> Decoder.decode_parallel(packets, out_format: :gray, max_concurrency: 3)
+        |> Enum.to_list()
+
+      assert Enum.map(frames, & &1.pts) == Enum.to_list(0..59)
+      assert frames == expected
+    end
+  end
+
+  describe "decode_until/3" do
+    setup do
+      packets =
+        0..5
+        |> Enum.map(&%Frame{data: solid_yuv420p(64, 64, 40 + &1 * 30), pts: &1 * 10})
+        |> encoded_h264(gop_size: 32, max_b_frames: 2)
+
+      %{packets: packets}
+    end
+
+    test "returns only the frame at the target", %{packets: packets} do
+      decoder = Decoder.new(:h264, out_format: :gray)
+
+      assert %Frame{pts: 30, format: :gray, data: data} =
+               Decoder.decode_until(decoder, packets, 30)
+
+      assert_in_delta dominant_byte(data), 130, 2
+    end
+
+    test "returns the closest frame before the target", %{packets: packets} do
+      decoder = Decoder.new(:h264)
+
+      assert %Frame{pts: 20} = Decoder.decode_until(decoder, packets, 25)
+      assert %Frame{pts: 50} = Decoder.decode_until(decoder, packets, 1_000)
+      assert %Frame{pts: 0} = Decoder.decode_until(decoder, packets, -10)
+    end
+
+    test "decoder is reset after each call", %{packets: packets} do
+      decoder = Decoder.new(:h264)
+
+      assert %Frame{pts: 40} = Decoder.decode_until(decoder, packets, 40)
+      assert %Frame{pts: 10} = Decoder.decode_until(decoder, packets, 10)
+      assert [] = Decoder.flush(decoder)
+      assert is_nil(Decoder.decode_until(decoder, [], 10))
+    end
+  end
+
+  describe "analyze/3" do
+    test "returns only timestamps when no analyzer is enabled" do
+      packets = encoded_h264([%Frame{data: solid_yuv420p(64, 64, 128), pts: 7}], max_b_frames: 0)
+
+      decoder = Decoder.new(:h264)
+
+      assert [%{pts: 7} = analysis] =
+               Enum.flat_map(packets, &Decoder.analyze(decoder, &1.data, pts: &1.pts))
+
+      refute Map.has_key?(analysis, :motion)
+    end
+
+    test "detects motion regions" do
+      background = solid_yuv420p(128, 128, 64)
+
+      packets =
+        [background, background, with_square(background, 128, 64, 32)]
+        |> Enum.with_index(&%Frame{data: &1, pts: &2})
+        |> encoded_h264(width: 128, height: 128, max_b_frames: 0)
+
+      decoder = Decoder.new(:h264)
+      assert :ok = Decoder.enable_motion_detection(decoder, downscale: 2, block_size: 8)
+
+      assert [first, second, moved] =
+               Enum.flat_map(packets, &Decoder.analyze(decoder, &1.data, pts: &1.pts))
+
+      assert %{pts: 0, motion: %{score: +0.0, regions: []}} = first
+      assert %{pts: 1, motion: %{score: +0.0, regions: []}} = second
+
+      assert %{pts: 2, motion: %{score: score, regions: [{x, y, width, height}]}} = moved
+      assert score > 0 and score < 0.5
+      assert x <= 64 and y <= 64
+      assert x + width >= 96 and y + height >= 96
+    end
+
+    test "detects motion on 10 bit frames" do
+      background = solid_yuv420p(128, 128, 64)
+
+      packets =
+        [background, background, with_square(background, 128, 64, 32)]
+        |> Enum.with_index(&%Frame{data: to_10_bit(&1), pts: &2})
+        |> encoded_h264(width: 128, height: 128, format: :yuv420p10le, max_b_frames: 0)
+
+      decoder = Decoder.new(:h264)
+      assert :ok = Decoder.enable_motion_detection(decoder, downscale: 2, block_size: 8)
+
+      assert [first, _second, moved] =
+               Enum.flat_map(packets, &Decoder.analyze(decoder, &1.data, pts: &1.pts))
+
+      assert %{pts: 0, motion: %{score: +0.0, regions: []}} = first
+      assert %{pts: 2, motion: %{score: score, regions: [_region]}} = moved
+      assert score > 0 and score < 0.5
+    end
+
+    test "aggregates motion vectors" do
+      background = solid_yuv420p(128, 128, 64)
+
+      packets =
+        0..5
+        |> Enum.map(&%Frame{data: with_square(background, 128, 32 + &1 * 4, 32), pts: &1})
+        |> encoded_h264(width: 128, height: 128, max_b_frames: 0)
+
+      decoder = Decoder.new(:h264)
+      assert :ok = Decoder.enable_motion_vectors(decoder, grid_width: 4, grid_height: 2)
+
+      assert [keyframe | frames] =
+               Enum.flat_map(packets, &Decoder.analyze(decoder, &1.data, pts: &1.pts))
+
+      assert %{motion_vectors: %{score: +0.0, count: 0, grid: grid}} = keyframe
+      assert length(grid) == 2 and Enum.all?(grid, &(length(&1) == 4))
+
+      assert length(frames) == 5
+      assert Enum.any?(frames, &(&1.motion_vectors.score > 0))
+    end
+
+    test "motion vectors are not exported by the hevc decoder" do
+      assert_raise ErlangError, ~r/motion_vectors_not_supported/, fn ->
+        Decoder.enable_motion_vectors(Decoder.new(:hevc))
+      end
+    end
+
+    test "computes quality metrics every nth frame" do
+      background = solid_yuv420p(64, 64, 160)
+      square = with_square(background, 64, 16, 32)
+
+      packets =
+        [background, background, square, square]
+        |> Enum.with_index(&%Frame{data: &1, pts: &2})
+        |> encoded_h264(max_b_frames: 0)
+
+      decoder = Decoder.new(:h264)
+      assert :ok = Decoder.enable_quality_metrics(decoder, interval: 2, bins: 4)
+
+      assert [%{quality: uniform}, second, %{quality: textured}, fourth] =
+               Enum.flat_map(packets, &Decoder.analyze(decoder, &1.data, pts: &1.pts))
+
+      refute Map.has_key?(second, :quality)
+      refute Map.has_key?(fourth, :quality)
+
+      assert_in_delta uniform.mean, 160, 2
+      assert uniform.variance < 1
+      assert uniform.sharpness < 1
+      assert uniform.uniformity > 0.99
+      assert [0, 0, 4096, 0] = uniform.histogram
+
+      assert textured.variance > 100
+      assert textured.sharpness > uniform.sharpness
+      assert_in_delta textured.uniformity, 0.75, 0.05
+      assert Enum.sum(textured.histogram) == 4096
+      assert List.last(textured.histogram) > 0
+    end
+
+    test "computes quality metrics on 10 bit frames" do
+      packets =
+        [%Frame{data: to_10_bit(solid_yuv420p(64, 64, 160)), pts: 0}]
+        |> encoded_h264(format: :yuv420p10le, max_b_frames: 0)
+
+      decoder = Decoder.new(:h264)
+      assert :ok = Decoder.enable_quality_metrics(decoder, bins: 4)
+
+      assert [%{quality: quality}] =
+               Enum.flat_map(packets, &Decoder.analyze(decoder, &1.data, pts: &1.pts))
+
+      assert_in_delta quality.mean, 160, 2
+      assert quality.uniformity > 0.99
+      assert [0, 0, 4096, 0] = quality.histogram
+    end
+
+    test "invalid configuration raises" do
+      decoder = Decoder.new(:h264)
+
+      assert_raise ErlangError, ~r/invalid_motion_config/, fn ->
+        Decoder.enable_motion_detection(decoder, block_size: 12)
+      end
+
+      assert_raise ErlangError, ~r/unknown_config_key/, fn ->
+        Decoder.enable_motion_detection(decoder, sensitivity: 1)
+      end
+
+      assert_raise ErlangError, ~r/invalid_quality_config/, fn ->
+        Decoder.enable_quality_metrics(decoder, bins: 10)
+      end
+    end
+  end
+
   defp decode_and_flush(decoder, sample) do
     Decoder.decode(decoder, sample) ++ Decoder.flush(decoder)
   end
 
+  defp unpad(plane, stride, width) do
+    rows = div(byte_size(plane) - width, stride) + 1
+    for row <- 0..(rows - 1), into: <<>>, do: binary_part(plane, row * stride, width)
+  end
+
   defp solid_yuv420p(width, height, luma) do
     chroma = :binary.copy(<<128>>, div(width, 2) * div(height, 2))
     :binary.copy(<<luma>>, width * height) <> chroma <> chroma
   end
 
+  defp with_square(yuv420p, width, offset, size) do
+    square = :binary.copy(<<235>>, size)
+
+    Enum.reduce(offset..(offset + size - 1), yuv420p, fn row, data ->
+      pos = row * width + offset
+      <<before::binary-size(pos), _old::binary-size(size), rest::binary>> = data
+      before <> square <> rest
+    end)
+  end
+
+  defp to_10_bit(data), do: for(<<sample <- data>>, into: <<>>, do: <<sample * 4::little-16>>)
+
   defp dominant_byte(data) do
     data
     |> :binary.bin_to_list()
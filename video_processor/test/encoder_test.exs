@@ -103,6 +103,74 @@ defmodule ExNVR.AV.EncoderTest do
       assert Enum.all?(packets, & &1.keyframe?)
     end
 
+    test "encode a list of frames", %{frame: frame} do
+      opts = [width: 360, height: 240, format: :yuv420p, time_base: {1, 25}, gop_size: 1]
+      frames = Enum.map(0..69, &%{frame | pts: &1})
+
+      encoder = Encoder.new(:h264, opts)
+      packets = Encoder.encode_many(encoder, frames) ++ Encoder.flush(encoder)
+
+      assert length(packets) == 70
+      assert Enum.map(packets, & &1.pts) == Enum.to_list(0..69)
+      assert Enum.all?(packets, & &1.keyframe?)
+    end
+
+    test "leased mjpeg encoder is reused", %{frame: frame} do
+      opts = [width: 360, height: 240, format: :yuvj420p, time_base: {1, 30}]
+
+      for _i <- 1..3 do
+        encoder = Encoder.lease(:mjpeg, opts)
+        assert [%Packet{data: <<0xFF, 0xD8, _rest::binary>>}] = Encoder.encode(encoder, frame)
+        assert :ok = Encoder.release(encoder)
+      end
+    end
+
+    test "mjpeg encoder with fixed quality and limited range input", %{frame: frame} do
+      opts = [width: 360, height: 240, format: :yuv420p, time_base: {1, 30}, threads: 2]
+
+      sizes =
+        for quality <- [2, 31] do
+          encoder = Encoder.new(:mjpeg, [color_range: :limited, quality: quality] ++ opts)
+
+          assert [%Packet{data: <<0xFF, 0xD8, _rest::binary>> = jpeg}] =
+                   Encoder.encode(encoder, frame)
+
+          byte_size(jpeg)
+        end
+
+      assert [best, worst] = sizes
+      assert worst < best
+
+      assert_raise ErlangError, ~r/invalid_quality/, fn ->
+        Encoder.new(:mjpeg, [quality: 32] ++ opts)
+      end
+    end
+
+    test "masked regions are encoded from the mask only", %{frame: frame} do
+      opts = [width: 360, height: 240, format: :yuvj420p, time_base: {1, 30}, quality: 2]
+      other_frame = %{frame | data: :binary.copy(<<200>>, byte_size(frame.data))}
+
+      encoder = Encoder.new(:mjpeg, opts)
+      assert :ok = Encoder.set_privacy_mask(encoder, [%{x: 0, y: 0, width: 360, height: 240}])
+
+      assert [%Packet{data: masked}] = Encoder.encode(encoder, frame)
+      assert [%Packet{data: ^masked}] = Encoder.encode(encoder, other_frame)
+
+      assert :ok = Encoder.set_privacy_mask(encoder, [])
+      assert [%Packet{data: unmasked}] = Encoder.encode(encoder, frame)
+      assert unmasked != masked
+    end
+
+    test "drained h264 encoder can be released", %{frame: frame} do
+      opts = [width: 360, height: 240, format: :yuv420p, time_base: {1, 25}]
+
+      encoder = Encoder.lease(:h264, opts)
+      assert [%Packet{keyframe?: true}] = Encoder.encode(encoder, frame) ++ Encoder.flush(encoder)
+      assert :ok = Encoder.release(encoder)
+
+      assert_raise ErlangError, ~r/encoder_released/, fn -> Encoder.encode(encoder, frame) end
+    end
+
     test "no bframes inserted", %{frame: frame} do
       encoder =
         Encoder.new(:h264,
@@ -0,0 +1,53 @@
+defmodule ExNVR.AV.KeyframeIndexTest do
+  use ExUnit.Case, async: true
+
+  alias ExNVR.AV.{KeyframeIndex, VideoProcessor}
+
+  import ExNVR.AV.TestHelpers
+
+  @moduletag :tmp_dir
+
+  setup %{tmp_dir: tmp_dir} do
+    path = Path.join(tmp_dir, "recording.mp4")
+    :ok = write_recording(path)
+
+    %{path: path, index_path: Path.join(tmp_dir, "recording.kfi")}
+  end
+
+  test "build and search the index", %{path: path, index_path: index_path} do
+    assert :ok = KeyframeIndex.build(path, index_path)
+    assert {:ok, index} = KeyframeIndex.open(index_path)
+
+    file_size = File.stat!(path).size
+
+    # 12 frames with a gop size of 4
+    assert %{timestamp: last_pts, gop_length: 4} = last = KeyframeIndex.lookup(index, 10_000_000)
+    assert KeyframeIndex.lookup(index, last_pts) == last
+
+    assert %{timestamp: pts, gop_length: 4} = previous = KeyframeIndex.lookup(index, last_pts - 1)
+    assert pts < last_pts
+    assert previous.size > 0 and previous.offset + previous.size <= file_size
+
+    assert KeyframeIndex.lookup(index, -1) == nil
+  end
+
+  test "snapshot from the index", %{path: path, index_path: index_path} do
+    :ok = KeyframeIndex.build(path, index_path)
+    {:ok, index} = KeyframeIndex.open(index_path)
+
+    for timestamp <- [0, 10_000_000] do
+      assert {:ok, _pts, <<0xFF, 0xD8, _rest::binary>>} =
+               snapshot = VideoProcessor.recording_snapshot(path, timestamp, index: index)
+
+      assert snapshot == VideoProcessor.recording_snapshot(path, timestamp)
+    end
+  end
+
+  test "invalid index", %{path: path, tmp_dir: tmp_dir} do
+    assert {:error, :invalid_index} = KeyframeIndex.open(path)
+    assert {:error, :invalid_index} = KeyframeIndex.open(Path.join(tmp_dir, "missing.kfi"))
+
+    assert {:error, :invalid_recording} =
+             KeyframeIndex.build(Path.join(tmp_dir, "missing.mp4"), "index.kfi")
+  end
+end
@@ -0,0 +1,45 @@
+defmodule ExNVR.AV.TestHelpers do
+  @moduledoc false
+
+  alias ExNVR.AV.{Encoder, Frame, Packet, Timelapse}
+
+  @doc """
+  A yuv420p frame of a single gray level.
+  """
+  @spec solid_yuv420p(pos_integer(), pos_integer(), byte()) :: binary()
+  def solid_yuv420p(width, height, luma) do
+    chroma = :binary.copy(<<128>>, div(width, 2) * div(height, 2))
+    :binary.copy(<<luma>>, width * height) <> chroma <> chroma
+  end
+
+  @doc """
+  Encode yuv420p frames to h264 and flush the encoder.
+
+  The options are passed to the encoder, the frames are 64x64 at 25 fps by default.
+  """
+  @spec encoded_h264([Frame.t()], keyword()) :: [Packet.t()]
+  def encoded_h264(frames, opts \\ []) do
+    opts = Keyword.merge([width: 64, height: 64, format: :yuv420p, time_base: {1, 25}], opts)
+    encoder = Encoder.new(:h264, opts)
+
+    Enum.flat_map(frames, &Encoder.encode(encoder, &1)) ++ Encoder.flush(encoder)
+  end
+
+  @doc """
+  Write a 64x48 mp4 recording of 12 frames with a keyframe every 4 frames.
+
+  The recording has the default frame rate of the timelapse, 30 fps, it lasts 0.4 seconds.
+  """
+  @spec write_recording(Path.t()) :: :ok
+  def write_recording(path) do
+    timelapse =
+      Timelapse.new(:h264, width: 64, height: 48, gop_size: 4, format: :mp4, path: path)
+
+    0..11
+    |> Enum.map(&%Frame{data: solid_yuv420p(128, 96, &1 * 20), pts: &1})
+    |> encoded_h264(width: 128, height: 96, time_base: {1, 1}, gop_size: 1)
+    |> Enum.each(&Timelapse.add(timelapse, &1.data, &1.pts))
+
+    Timelapse.finish(timelapse)
+  end
+end
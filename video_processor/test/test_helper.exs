@@ -1 +1,6 @@
-ExUnit.start()
+# the allocation tests need a NIF compiled with NVR_ALLOC_STATS=1
+exclude = if ExNVR.AV.AllocStats.enabled?(), do: [], else: [:alloc_stats]
+# run the benchmarks with `mix test --only benchmark`
+exclude = [:benchmark | exclude]
+
+ExUnit.start(exclude: exclude)
@@ -0,0 +1,72 @@
+defmodule ExNVR.AV.TimelapseTest do
+  use ExUnit.Case, async: true
+
+  alias ExNVR.AV.{Bitstream, Frame, Timelapse}
+
+  import ExNVR.AV.TestHelpers
+
+  @moduletag :tmp_dir
+
+  setup do
+    packets =
+      0..9
+      |> Enum.map(&%Frame{data: solid_yuv420p(128, 96, &1 * 20), pts: &1})
+      |> encoded_h264(width: 128, height: 96, time_base: {1, 1}, gop_size: 2)
+
+    %{packets: packets}
+  end
+
+  test "samples keyframes into an h264 stream", %{packets: packets} do
+    timelapse = Timelapse.new(:h264, width: 64, height: 48, interval: 4)
+
+    sampled = Enum.filter(packets, &Timelapse.add(timelapse, &1.data, &1.pts))
+    assert Enum.map(sampled, & &1.pts) == [0, 4, 8]
+
+    output = Timelapse.finish(timelapse)
+    assert %{width: 64, height: 48} = Bitstream.stream_info(output, :h264)
+
+    {_avcc, units} = Bitstream.to_avcc(output, :h264)
+    assert Enum.count(units, fn {type, _offset, _size} -> type in [1, 5] end) == 3
+  end
+
+  test "writes an mp4 file", %{packets: packets, tmp_dir: tmp_dir} do
+    path = Path.join(tmp_dir, "timelapse.mp4")
+    timelapse = Timelapse.new(:h264, width: 64, height: 48, format: :mp4, path: path)
+
+    Enum.each(packets, &Timelapse.add(timelapse, &1.data, &1.pts))
+
+    assert :ok = Timelapse.finish(timelapse)
+    assert <<_size::32, "ftyp", _rest::binary>> = File.read!(path)
+  end
+
+  test "fragmented mp4 in memory", %{packets: packets} do
+    timelapse = Timelapse.new(:h264, width: 64, height: 48, format: :mp4)
+    Enum.each(packets, &Timelapse.add(timelapse, &1.data, &1.pts))
+
+    assert <<_size::32, "ftyp", _rest::binary>> = Timelapse.finish(timelapse)
+
+    assert_raise ErlangError, ~r/timelapse_finished/, fn ->
+      Timelapse.add(timelapse, hd(packets).data, 0)
+    end
+  end
+
+  test "keyframes still in the decoder are part of the timelapse", %{packets: packets} do
+    timelapse = Timelapse.new(:h264, width: 64, height: 48)
+    assert Timelapse.add(timelapse, hd(packets).data, 0)
+
+    output = Timelapse.finish(timelapse)
+
+    {_avcc, units} = Bitstream.to_avcc(output, :h264)
+    assert Enum.count(units, fn {type, _offset, _size} -> type in [1, 5] end) == 1
+  end
+
+  test "raises on empty or invalid timelapse" do
+    assert_raise ErlangError, ~r/empty_timelapse/, fn ->
+      :h264 |> Timelapse.new() |> Timelapse.finish()
+    end
+
+    assert_raise ErlangError, ~r/failed_to_init_timelapse/, fn ->
+      Timelapse.new(:h264, width: 63)
+    end
+  end
+end
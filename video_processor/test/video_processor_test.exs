@@ -1,7 +1,9 @@
 defmodule ExNVR.AV.VideoProcessorTest do
   use ExUnit.Case, async: true
 
-  alias ExNVR.AV.VideoProcessor
+  alias ExNVR.AV.{Frame, VideoProcessor}
+
+  import ExNVR.AV.TestHelpers
 
   describe "new_converter/1" do
     test "new converter" do
@@ -71,4 +73,556 @@ defmodule ExNVR.AV.VideoProcessorTest do
       end)
     end
   end
+
+  describe "convert/2 without resizing" do
+    setup do
+      data = File.read!("test/fixtures/encoder/frame_360x240.yuv")
+      options = [in_width: 360, in_height: 240, out_width: -1, out_height: -1]
+
+      %{data: data, options: options}
+    end
+
+    test "matches swscale", %{data: data, options: options} do
+      for out_format <- [:rgb24, :bgr24] do
+        options = [in_format: :yuv420p, out_format: out_format] ++ options
+        assert_close(convert(data, options, true), convert(data, options, false))
+      end
+    end
+
+    test "converts nv12", %{data: data, options: options} do
+      chroma_size = div(360 * 240, 4)
+      <<luma::binary-size(360 * 240), u::binary-size(chroma_size), v::binary>> = data
+      nv12 = luma <> interleave(u, v)
+
+      options = [out_format: :rgb24] ++ options
+      converted = convert(nv12, [in_format: :nv12] ++ options, true)
+
+      assert converted == convert(data, [in_format: :yuv420p] ++ options, true)
+      assert_close(converted, convert(data, [in_format: :yuv420p] ++ options, false))
+    end
+
+    @tag :benchmark
+    test "is faster than swscale", %{data: data, options: options} do
+      options = [in_format: :yuv420p, out_format: :rgb24] ++ options
+      fast = VideoProcessor.new_converter([fast_path?: true] ++ options)
+      swscale = VideoProcessor.new_converter([fast_path?: false] ++ options)
+
+      fast_time = measure(fn -> VideoProcessor.convert(fast, data) end)
+      swscale_time = measure(fn -> VideoProcessor.convert(swscale, data) end)
+
+      IO.puts("yuv420p -> rgb24 360x240: #{fast_time}us, swscale #{swscale_time}us")
+      assert fast_time < swscale_time
+    end
+  end
+
+  describe "convert/2 with power of two ratios" do
+    setup do
+      %{
+        data: File.read!("test/fixtures/encoder/frame_360x240.yuv"),
+        options: [in_width: 360, in_height: 240, in_format: :yuv420p]
+      }
+    end
+
+    test "averages blocks of pixels", %{data: data, options: options} do
+      converted =
+        convert(data, options ++ [out_width: 90, out_height: 60, out_format: :yuv420p], true)
+
+      assert byte_size(converted) == div(90 * 60 * 3, 2)
+      assert binary_part(converted, 0, 90 * 60) == box_mean(data, 360, 90, 60, 4)
+    end
+
+    test "scales what's left", %{data: data, options: options} do
+      options = options ++ [out_width: 120, out_height: 80, out_format: :rgb24]
+
+      converted = convert(data, options, true)
+      expected = convert(data, options, false)
+
+      assert byte_size(converted) == 120 * 80 * 3
+
+      diff =
+        Enum.zip_with(
+          :binary.bin_to_list(converted),
+          :binary.bin_to_list(expected),
+          &abs(&1 - &2)
+        )
+
+      assert Enum.sum(diff) / length(diff) < 2
+    end
+
+    @tag :benchmark
+    test "is faster than swscale", %{data: data, options: options} do
+      options = options ++ [out_width: 90, out_height: 60, out_format: :yuv420p]
+      fast = VideoProcessor.new_converter([fast_path?: true] ++ options)
+      swscale = VideoProcessor.new_converter([fast_path?: false] ++ options)
+
+      fast_time = measure(fn -> VideoProcessor.convert(fast, data) end)
+      swscale_time = measure(fn -> VideoProcessor.convert(swscale, data) end)
+
+      IO.puts("yuv420p 360x240 -> 90x60: #{fast_time}us, swscale #{swscale_time}us")
+      assert fast_time < swscale_time
+    end
+  end
+
+  describe "convert_many/3" do
+    setup do
+      %{
+        data: File.read!("test/fixtures/encoder/frame_360x240.yuv"),
+        options: [
+          in_width: 360,
+          in_height: 240,
+          in_format: :yuv420p,
+          out_width: 180,
+          out_height: 180,
+          out_format: :rgb24,
+          pad?: true
+        ]
+      }
+    end
+
+    test "converts all the frames in order", %{data: data, options: options} do
+      chroma = binary_part(data, 360 * 240, 360 * 120)
+      frames = for idx <- 0..99, do: :binary.copy(<<idx>>, 360 * 240) <> chroma
+      converter = VideoProcessor.new_converter(options)
+
+      expected = Enum.map(frames, &VideoProcessor.convert(converter, &1))
+
+      assert VideoProcessor.convert_many(converter, frames, threads: 4) == expected
+      assert VideoProcessor.convert_many(converter, frames, threads: 1) == expected
+    end
+
+    test "raises on truncated frames", %{data: data, options: options} do
+      converter = VideoProcessor.new_converter(options)
+
+      assert_raise ErlangError, ~r/invalid_frame_size/, fn ->
+        VideoProcessor.convert_many(converter, [data, binary_part(data, 0, 100)])
+      end
+    end
+  end
+
+  describe "convert_rois/2" do
+    setup do
+      %{
+        data: File.read!("test/fixtures/encoder/frame_360x240.yuv"),
+        options: [in_width: 360, in_height: 240, in_format: :yuv420p]
+      }
+    end
+
+    test "scales each region to its own size", %{data: data, options: options} do
+      rois = [
+        %{x: 0, y: 0, width: 120, height: 80, out_width: 60, out_height: 40},
+        %{x: 121, y: 41, width: 100, height: 60}
+      ]
+
+      converter =
+        VideoProcessor.new_roi_converter(options ++ [out_format: :rgb24, rois: rois])
+
+      assert [first, second] = VideoProcessor.convert_rois(converter, data)
+      assert byte_size(first) == 60 * 40 * 3
+      # the second region is aligned on the chroma samples
+      assert byte_size(second) == 102 * 62 * 3
+    end
+
+    test "crops without scaling", %{data: data, options: options} do
+      rois = [%{x: 60, y: 40, width: 120, height: 60}]
+
+      converter =
+        VideoProcessor.new_roi_converter(options ++ [out_format: :yuv420p, rois: rois])
+
+      crop = fn plane, width, x, y, w, h ->
+        for row <- y..(y + h - 1), into: <<>>, do: binary_part(plane, row * width + x, w)
+      end
+
+      y_plane = binary_part(data, 0, 360 * 240)
+      u_plane = binary_part(data, 360 * 240, 180 * 120)
+      v_plane = binary_part(data, 360 * 240 + 180 * 120, 180 * 120)
+
+      expected =
+        crop.(y_plane, 360, 60, 40, 120, 60) <>
+          crop.(u_plane, 180, 30, 20, 60, 30) <> crop.(v_plane, 180, 30, 20, 60, 30)
+
+      assert VideoProcessor.convert_rois(converter, data) == [expected]
+    end
+
+    test "raises on invalid regions", %{options: options} do
+      assert_raise ErlangError, ~r/failed_to_init_converter/, fn ->
+        VideoProcessor.new_roi_converter(
+          options ++ [out_format: :rgb24, rois: [%{x: 300, y: 0, width: 100, height: 10}]]
+        )
+      end
+
+      assert_raise ErlangError, ~r/invalid_rois/, fn ->
+        VideoProcessor.new_roi_converter(options ++ [out_format: :rgb24, rois: []])
+      end
+    end
+
+    test "raises on truncated frames and plain conversions", %{data: data, options: options} do
+      rois = [%{x: 0, y: 0, width: 10, height: 10}]
+      converter = VideoProcessor.new_roi_converter(options ++ [out_format: :rgb24, rois: rois])
+
+      assert_raise ErlangError, ~r/invalid_frame_size/, fn ->
+        VideoProcessor.convert_rois(converter, binary_part(data, 0, 100))
+      end
+
+      assert_raise ErlangError, ~r/invalid_converter/, fn ->
+        VideoProcessor.convert(converter, data)
+      end
+    end
+  end
+
+  describe "encode_to_jpeg/2" do
+    setup do
+      data = File.read!("test/fixtures/encoder/frame_360x240.yuv")
+      %{frame: Frame.new(data, format: :yuv420p, width: 360, height: 240, pts: 0)}
+    end
+
+    test "encodes yuv420p frames", %{frame: frame} do
+      assert <<0xFF, 0xD8, _rest::binary>> = jpeg = VideoProcessor.encode_to_jpeg(frame)
+      assert jpeg_size(jpeg) == {360, 240}
+      assert :binary.match(jpeg, "CS=ITU601") == :nomatch
+
+      full_range = VideoProcessor.encode_to_jpeg(frame, color_range: :full, threads: 2)
+      assert jpeg_size(full_range) == {360, 240}
+
+      limited_range = VideoProcessor.encode_to_jpeg(frame, color_range: :limited)
+      assert :binary.match(limited_range, "CS=ITU601") != :nomatch
+    end
+
+    test "lower quality gives smaller images", %{frame: frame} do
+      best = VideoProcessor.encode_to_jpeg(frame, quality: 2)
+      worst = VideoProcessor.encode_to_jpeg(frame, quality: 31)
+
+      assert byte_size(worst) < byte_size(best)
+    end
+
+    test "fits the image in the maximum size", %{frame: frame} do
+      best = VideoProcessor.encode_to_jpeg(frame, quality: 2)
+      worst = VideoProcessor.encode_to_jpeg(frame, quality: 31)
+      max_size = div(byte_size(best) + byte_size(worst), 2)
+
+      jpeg = VideoProcessor.encode_to_jpeg(frame, max_size: max_size)
+      assert byte_size(jpeg) <= max_size
+      assert jpeg_size(jpeg) == {360, 240}
+
+      assert VideoProcessor.encode_to_jpeg(frame, max_size: 1) == worst
+    end
+
+    test "converts other formats", %{frame: frame} do
+      options = [
+        in_width: 360,
+        in_height: 240,
+        in_format: :yuv420p,
+        out_width: 360,
+        out_height: 240,
+        out_format: :rgb24,
+        pad?: false
+      ]
+
+      rgb = convert(frame.data, options, true)
+      frame = Frame.new(rgb, format: :rgb24, width: 360, height: 240, pts: 0)
+
+      assert jpeg_size(VideoProcessor.encode_to_jpeg(frame)) == {360, 240}
+    end
+
+    test "raises on invalid options", %{frame: frame} do
+      assert_raise ErlangError, ~r/couldnt_read_value/, fn ->
+        VideoProcessor.encode_to_jpeg(frame, quality: 32)
+      end
+
+      assert_raise ErlangError, ~r/invalid_frame/, fn ->
+        VideoProcessor.encode_to_jpeg(%{frame | width: 100})
+      end
+    end
+  end
+
+  describe "set_privacy_mask/3" do
+    setup do
+      data = File.read!("test/fixtures/encoder/frame_360x240.yuv")
+
+      converter =
+        VideoProcessor.new_converter(
+          in_width: 360,
+          in_height: 240,
+          in_format: :yuv420p,
+          out_width: 360,
+          out_height: 240,
+          out_format: :yuv420p
+        )
+
+      %{data: data, converter: converter, rect: %{x: 40, y: 20, width: 100, height: 60}}
+    end
+
+    test "fills the regions with black", %{data: data, converter: converter, rect: rect} do
+      unmasked = VideoProcessor.convert(converter, data)
+
+      assert :ok = VideoProcessor.set_privacy_mask(converter, [rect])
+      masked = VideoProcessor.convert(converter, data)
+
+      <<y::binary-size(360 * 240), u::binary-size(180 * 120), _v::binary>> = masked
+
+      for row <- 0..239 do
+        line = binary_part(y, row * 360, 360)
+
+        if row in 20..79 do
+          assert binary_part(line, 40, 100) == :binary.copy(<<16>>, 100)
+          assert binary_part(line, 0, 40) == binary_part(unmasked, row * 360, 40)
+          assert binary_part(line, 140, 220) == binary_part(unmasked, row * 360 + 140, 220)
+        else
+          assert line == binary_part(unmasked, row * 360, 360)
+        end
+      end
+
+      for row <- 10..39 do
+        assert binary_part(u, row * 180 + 20, 50) == :binary.copy(<<128>>, 50)
+      end
+
+      assert :ok = VideoProcessor.set_privacy_mask(converter, [])
+      assert VideoProcessor.convert(converter, data) == unmasked
+    end
+
+    test "pixelates polygons", %{data: data, converter: converter} do
+      square = %{points: [{40, 20}, {80, 20}, {80, 60}, {40, 60}]}
+      VideoProcessor.set_privacy_mask(converter, [square], mode: :pixelate, block_size: 10)
+
+      <<y::binary-size(360 * 240), _rest::binary>> = VideoProcessor.convert(converter, data)
+
+      for block_y <- [20, 30, 40, 50], block_x <- [40, 50, 60, 70] do
+        block =
+          for row <- block_y..(block_y + 9), into: <<>> do
+            binary_part(y, row * 360 + block_x, 10)
+          end
+
+        <<first, _rest::binary>> = block
+        assert block == :binary.copy(<<first>>, 100)
+      end
+    end
+
+    test "masks rgb outputs of all the workers", %{data: data, rect: rect} do
+      converter =
+        VideoProcessor.new_converter(
+          in_width: 360,
+          in_height: 240,
+          in_format: :yuv420p,
+          out_width: 180,
+          out_height: 120,
+          out_format: :rgb24
+        )
+
+      VideoProcessor.set_privacy_mask(converter, [rect])
+
+      for rgb <- VideoProcessor.convert_many(converter, List.duplicate(data, 4), threads: 2) do
+        # the rectangle is scaled with the frame
+        for row <- 10..39 do
+          assert binary_part(rgb, row * 540 + 60, 150) == :binary.copy(<<0>>, 150)
+        end
+      end
+    end
+
+    test "raises on invalid shapes", %{converter: converter} do
+      assert_raise ErlangError, ~r/invalid_privacy_mask/, fn ->
+        VideoProcessor.set_privacy_mask(converter, [%{points: [{0, 0}, {10, 10}]}])
+      end
+
+      assert_raise ErlangError, ~r/invalid_privacy_mask/, fn ->
+        VideoProcessor.set_privacy_mask(converter, [%{points: [{0, 0}, {10, 10}, {0, 10}]}],
+          block_size: 65
+        )
+      end
+    end
+  end
+
+  describe "set_label_text/3" do
+    setup do
+      data = File.read!("test/fixtures/encoder/frame_360x240.yuv")
+
+      converter =
+        VideoProcessor.new_converter(
+          in_width: 360,
+          in_height: 240,
+          in_format: :yuv420p,
+          out_width: 360,
+          out_height: 240,
+          out_format: :yuv420p
+        )
+
+      %{data: data, converter: converter}
+    end
+
+    test "draws the text in the label region", %{data: data, converter: converter} do
+      plain = VideoProcessor.convert(converter, data)
+
+      # glyphs of 16 pixels are 9 pixels wide, "CAM 1" covers columns 20 to 64
+      label = VideoProcessor.add_text_label(converter, x: 20, y: 30, size: 16)
+      assert :ok = VideoProcessor.set_label_text(converter, label, "CAM 1")
+      <<y::binary-size(360 * 240), _rest::binary>> = VideoProcessor.convert(converter, data)
+
+      for row <- 0..239 do
+        line = binary_part(y, row * 360, 360)
+
+        if row in 30..45 do
+          assert binary_part(line, 0, 20) == binary_part(plain, row * 360, 20)
+          assert binary_part(line, 65, 295) == binary_part(plain, row * 360 + 65, 295)
+        else
+          assert line == binary_part(plain, row * 360, 360)
+        end
+      end
+
+      assert binary_part(y, 30 * 360 + 20, 45) != binary_part(plain, 30 * 360 + 20, 45)
+
+      VideoProcessor.set_label_text(converter, label, "CAM 2")
+      <<updated::binary-size(360 * 240), _rest::binary>> = VideoProcessor.convert(converter, data)
+
+      label_rows = fn frame, x, width ->
+        for row <- 30..45, into: <<>>, do: binary_part(frame, row * 360 + x, width)
+      end
+
+      assert label_rows.(updated, 20, 36) == label_rows.(y, 20, 36)
+      assert label_rows.(updated, 56, 9) != label_rows.(y, 56, 9)
+
+      VideoProcessor.set_label_text(converter, label, "")
+      assert VideoProcessor.convert(converter, data) == plain
+    end
+
+    test "draws the labels on all the workers", %{data: data} do
+      converter =
+        VideoProcessor.new_converter(
+          in_width: 360,
+          in_height: 240,
+          in_format: :yuv420p,
+          out_width: 180,
+          out_height: 120,
+          out_format: :rgb24
+        )
+
+      [plain | _rest] = VideoProcessor.convert_many(converter, [data])
+
+      label = VideoProcessor.add_text_label(converter, size: 12, background?: false)
+      VideoProcessor.set_label_text(converter, label, "12:00:00")
+
+      for rgb <- VideoProcessor.convert_many(converter, List.duplicate(data, 4), threads: 2) do
+        assert binary_part(rgb, 0, 540 * 12) != binary_part(plain, 0, 540 * 12)
+        assert binary_part(rgb, 540 * 12, 540 * 108) == binary_part(plain, 540 * 12, 540 * 108)
+      end
+    end
+
+    test "raises on invalid labels", %{converter: converter} do
+      assert_raise ErlangError, ~r/invalid_text_label/, fn ->
+        VideoProcessor.add_text_label(converter, size: 129)
+      end
+
+      assert_raise ErlangError, ~r/invalid_text_label/, fn ->
+        VideoProcessor.set_label_text(converter, 3, "text")
+      end
+    end
+  end
+
+  describe "mosaic/3" do
+    setup do
+      %{keyframe: File.read!("test/fixtures/decoder/sample.h264")}
+    end
+
+    test "tiles keyframes into a single jpeg", %{keyframe: keyframe} do
+      jpeg = VideoProcessor.mosaic(:h264, List.duplicate(keyframe, 3), columns: 2)
+
+      assert <<0xFF, 0xD8, _rest::binary>> = jpeg
+      assert jpeg_size(jpeg) == {320, 180}
+
+      jpeg =
+        VideoProcessor.mosaic(:h264, [keyframe],
+          columns: 3,
+          rows: 2,
+          tile_width: 64,
+          tile_height: 36
+        )
+
+      assert jpeg_size(jpeg) == {192, 72}
+    end
+
+    test "invalid tile size raises", %{keyframe: keyframe} do
+      assert_raise ErlangError, ~r/invalid_mosaic_config/, fn ->
+        VideoProcessor.mosaic(:h264, [keyframe], tile_width: 81)
+      end
+    end
+  end
+
+  describe "recording_snapshot/3" do
+    @describetag :tmp_dir
+
+    setup %{tmp_dir: tmp_dir} do
+      path = Path.join(tmp_dir, "recording.mp4")
+      :ok = write_recording(path)
+
+      %{path: path}
+    end
+
+    test "get a jpeg snapshot", %{path: path} do
+      assert {:ok, before_pts, jpeg} = VideoProcessor.recording_snapshot(path, 200_000)
+      assert <<0xFF, 0xD8, _rest::binary>> = jpeg
+      assert jpeg_size(jpeg) == {64, 48}
+
+      assert {:ok, precise_pts, _jpeg} =
+               VideoProcessor.recording_snapshot(path, 200_000, method: :precise)
+
+      assert precise_pts > before_pts
+    end
+
+    test "get the decoded frame", %{path: path} do
+      assert {:ok, %Frame{width: 64, height: 48, format: :yuv420p}} =
+               VideoProcessor.recording_snapshot(path, 100_000, format: :frame)
+    end
+
+    test "invalid recording", %{path: path, tmp_dir: tmp_dir} do
+      assert {:error, :invalid_recording} =
+               VideoProcessor.recording_snapshot(Path.join(tmp_dir, "missing.mp4"), 0)
+
+      assert {:error, :couldnt_read_value} =
+               VideoProcessor.recording_snapshot(path, 0, method: :after)
+    end
+  end
+
+  defp jpeg_size(jpeg) do
+    {pos, _len} = :binary.match(jpeg, <<0xFF, 0xC0>>)
+    <<_skip::binary-size(pos + 5), height::16, width::16, _rest::binary>> = jpeg
+    {width, height}
+  end
+
+  defp convert(data, options, fast_path?) do
+    options
+    |> Keyword.put(:fast_path?, fast_path?)
+    |> VideoProcessor.new_converter()
+    |> VideoProcessor.convert(data)
+  end
+
+  defp interleave(u, v) do
+    for {a, b} <- Enum.zip(:binary.bin_to_list(u), :binary.bin_to_list(v)),
+        into: <<>>,
+        do: <<a, b>>
+  end
+
+  defp box_mean(data, stride, width, height, factor) do
+    for y <- 0..(height - 1), x <- 0..(width - 1), into: <<>> do
+      sum =
+        for j <- 0..(factor - 1), i <- 0..(factor - 1), reduce: 0 do
+          sum -> sum + :binary.at(data, (y * factor + j) * stride + x * factor + i)
+        end
+
+      <<div(sum + div(factor * factor, 2), factor * factor)>>
+    end
+  end
+
+  # the kernels round differently than swscale
+  defp assert_close(actual, expected) do
+    assert byte_size(actual) == byte_size(expected)
+
+    diffs =
+      Enum.zip_with(:binary.bin_to_list(actual), :binary.bin_to_list(expected), &abs(&1 - &2))
+
+    assert Enum.max(diffs) <= 5
+    assert Enum.sum(diffs) / length(diffs) < 1
+  end
+
+  defp measure(fun) do
+    Enum.each(1..20, fn _idx -> fun.() end)
+    {time, _result} = :timer.tc(fn -> Enum.each(1..200, fn _idx -> fun.() end) end)
+    div(time, 200)
+  end
 end